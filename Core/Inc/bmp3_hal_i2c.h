@@ -16,14 +16,10 @@
 /** STM32 port and pin configs. ***********************************************/
 
 extern I2C_HandleTypeDef hi2c1;
-extern TIM_HandleTypeDef htim2;
 
 // I2C.
 #define BMP3_HI2C hi2c1
 
-// Timer for signals.
-#define BMP3_HTIM htim2
-
 /** BMP390 SDO I2C address selection. *****************************************/
 
 // GPIO/BMP390 pin state.
@@ -14,7 +14,25 @@
 
 /** Definitions. **************************************************************/
 
-#define MAX_SIGNALS_PER_MESSAGE 8 // Maximum signals allowed per message.
+#define MAX_SIGNALS_PER_MESSAGE 16 // Maximum signals allowed per message.
+
+// bxCAN filter banks 0 to 27 are shared, CAN2 (slave) starts at this bank.
+// Must match the generate_can_defs.py --filter-banks (banks per bus) argument.
+#define CAN_FILTER_SLAVE_START_BANK 14
+
+#define CAN_TX_QUEUE_SIZE 32   // Software TX queue depth per bus (frames).
+#define CAN_TX_MAILBOX_COUNT 3 // bxCAN hardware TX mailboxes per bus.
+#define CAN_RX_RING_SIZE 64    // Deferred RX ring size (power of 2, frames).
+
+#define CAN_MONITOR_PERIOD_MS 10        // can_monitor_update task period (ms).
+#define CAN_MONITOR_WINDOW_MS 1000      // Frame rate and bus load window (ms).
+#define CAN_BUS_OFF_BACKOFF_MIN_MS 10   // First bus-off recovery delay (ms).
+#define CAN_BUS_OFF_BACKOFF_MAX_MS 1000 // Maximum bus-off recovery delay (ms).
+#define CAN_BUS_OFF_STABLE_MS 1000      // Bus-off free time to reset backoff.
+
+#define CAN_REDUNDANCY_DEDUP_US 5000 // Mirrored RX duplicate window (us).
+#define CAN_REDUNDANCY_SILENT_MS 500 // No RX while the other bus has RX (ms).
+#define CAN_REDUNDANCY_RX_SLOTS 8    // Mirrored RX message IDs tracked.
 
 /** STM32 port and pin configs. ***********************************************/
 
@@ -29,6 +47,9 @@ extern CAN_HandleTypeDef hcan2;
  * Two distinct handlers are defined:
  *   1. can_rx_handler_t: For decoding received CAN messages.
  *   2. can_tx_handler_t: For encoding data into CAN messages for transmission.
+ *
+ * Receive handlers get header->Timestamp set to the can_time_us time captured
+ * in the RX interrupt, instead of the bxCAN time-triggered mode counter.
  */
 typedef void (*can_rx_handler_t)(CAN_RxHeaderTypeDef *header, uint8_t *data);
 typedef void (*can_tx_handler_t)(uint8_t *data_out);
@@ -41,22 +62,65 @@ typedef enum {
   CAN_BIG_ENDIAN = 1     // Big Endian byte order.
 } can_byte_order_t;
 
+/**
+ * @brief Enumeration for CAN signal value types (DBC SIG_VALTYPE_).
+ */
+typedef enum {
+  CAN_VALUE_INTEGER = 0, // Integer, signed or unsigned (scale and offset).
+  CAN_VALUE_FLOAT32 = 1, // IEEE 754 single precision (32-bit signal).
+  CAN_VALUE_FLOAT64 = 2  // IEEE 754 double precision (64-bit, receive only).
+} can_value_type_t;
+
+/**
+ * @brief Enumeration for CAN signal multiplexing (DBC M and m<value>).
+ */
+typedef enum {
+  CAN_MUX_NONE = 0,       // Always present.
+  CAN_MUX_SWITCH = 1,     // Multiplexer switch signal (M).
+  CAN_MUX_MULTIPLEXED = 2 // Present when the switch equals mux_value (m).
+} can_mux_type_t;
+
+/**
+ * @brief Struct defining one value table entry (DBC VAL_).
+ */
+typedef struct {
+  int32_t value;           // Raw signal value.
+  const char *description; // Value description.
+} can_value_description_t;
+
+/**
+ * @brief Enumeration for CAN message send types (DBC GenMsgSendType).
+ */
+typedef enum {
+  CAN_SEND_NONE = 0,            // Not sent by the periodic TX scheduler.
+  CAN_SEND_CYCLIC,              // Sent every cycle_time_ms.
+  CAN_SEND_ON_CHANGE,           // Sent on data change, min_interval_ms apart.
+  CAN_SEND_CYCLIC_AND_ON_CHANGE // Sent on both of the above.
+} can_send_type_t;
+
 /**
  * @brief Struct defining a CAN message signal.
  *
  * This struct describes an individual signal within a CAN message.
  * It includes fields for bit-position, length, scaling, and validation.
- * An optional name field aids in debugging and logging.
+ * An optional name field aids in debugging and logging. For CAN_BIG_ENDIAN
+ * (Motorola) signals start_bit is the most significant bit, as in the DBC.
  */
 typedef struct {
   const char *name;            // Optional signal identifier (for debugging).
   uint8_t start_bit;           // Start bit-position (0-63 for 8-byte CAN).
   uint8_t bit_length;          // Length of the signal in bits.
   can_byte_order_t byte_order; // Byte order: little or big endian.
+  uint8_t is_signed;           // Two's complement raw value (DBC -).
+  can_value_type_t value_type; // Integer or IEEE float raw value.
+  can_mux_type_t mux_type;     // Multiplexing role.
+  uint16_t mux_value;          // Switch value when CAN_MUX_MULTIPLEXED.
   float scale;     // Scaling factor to convert raw value to physical value.
   float offset;    // Offset to apply after scaling.
   float min_value; // Minimum physical value (optional validation).
   float max_value; // Maximum physical value (optional validation).
+  const can_value_description_t *value_table; // Optional value table.
+  uint8_t value_count;                        // Value table entries.
 } can_signal_t;
 
 /**
@@ -74,13 +138,112 @@ typedef struct {
   can_rx_handler_t rx_handler; // Function pointer for receiving (decoding).
   can_tx_handler_t tx_handler; // Function pointer for transmitting (encoding).
   can_signal_t signals[MAX_SIGNALS_PER_MESSAGE]; // Statically allocation.
-  uint8_t signal_count; // Number of valid signals in the array.
+  uint8_t signal_count;      // Number of valid signals in the array.
+  can_send_type_t send_type; // Periodic TX scheduler send type.
+  uint16_t cycle_time_ms;    // Cyclic period (DBC GenMsgCycleTime).
+  uint16_t start_delay_ms;   // Cyclic phase offset (GenMsgStartDelayTime).
+  uint16_t min_interval_ms;  // Minimum on-change interval (GenMsgDelayTime).
+  uint8_t redundant;         // Mirrored on CAN1 and CAN2 (NerveRedundant).
 } can_message_t;
 
+/**
+ * @brief Struct defining a 16-bit scale bxCAN acceptance filter bank.
+ *
+ * Generated from the DBC by the filter planner in generate_can_defs.py for all
+ * messages with an rx_handler. Fields map directly to CAN_FilterTypeDef:
+ *   - ID list mode: 4 standard IDs in the 4 words.
+ *   - ID mask mode: 2 ID/mask pairs (id_low/mask_id_low, id_high/mask_id_high).
+ */
+typedef struct {
+  uint32_t filter_mode;         // CAN_FILTERMODE_IDLIST or *_IDMASK.
+  uint32_t filter_fifo;         // CAN_FILTER_FIFO0 or CAN_FILTER_FIFO1.
+  uint16_t filter_id_low;       // FR1 lower 16 bits.
+  uint16_t filter_mask_id_low;  // FR1 upper 16 bits.
+  uint16_t filter_id_high;      // FR2 lower 16 bits.
+  uint16_t filter_mask_id_high; // FR2 upper 16 bits.
+} can_filter_bank_t;
+
+/**
+ * @brief Struct holding software TX queue statistics for one CAN bus.
+ */
+typedef struct {
+  uint32_t queued;          // Frames accepted for transmission.
+  uint32_t sent;            // Frames transmitted successfully.
+  uint32_t dropped;         // Frames dropped (queue full or transmit error).
+  uint32_t requeued;        // Frames aborted or lost arbitration, requeued.
+  uint16_t high_water;      // Maximum software queue depth observed.
+  uint32_t latency_last_us; // Queue to transmit complete latency, last frame.
+  uint32_t latency_max_us;  // Queue to transmit complete latency, maximum.
+} can_tx_stats_t;
+
+/**
+ * @brief Enumeration for the bxCAN fault confinement state.
+ */
+typedef enum {
+  CAN_ERROR_ACTIVE = 0,  // TEC and REC below the warning limit (96).
+  CAN_ERROR_WARNING = 1, // TEC or REC at or above the warning limit (96).
+  CAN_ERROR_PASSIVE = 2, // TEC or REC above 127.
+  CAN_BUS_OFF = 3        // TEC above 255, disconnected from the bus.
+} can_error_state_t;
+
+/**
+ * @brief Struct holding the bus load and error state monitor of one CAN bus.
+ *
+ * Frame rates and bus load are measured over CAN_MONITOR_WINDOW_MS. Bus load
+ * is estimated from the DLC of every frame transmitted or accepted by the
+ * filters, with worst case bit stuffing. Last error code uses the bxCAN LEC
+ * values: 1 stuff, 2 form, 3 acknowledgment, 4 bit recessive, 5 bit dominant,
+ * 6 CRC error.
+ */
+typedef struct {
+  uint16_t tx_fps;               // Frames transmitted per second.
+  uint16_t rx_fps;               // Frames received per second.
+  float bus_load_percent;        // Estimated bus load (%).
+  uint8_t tec;                   // Transmit error counter.
+  uint8_t rec;                   // Receive error counter.
+  can_error_state_t error_state; // Fault confinement state.
+  uint8_t last_error_code;       // Last non-zero LEC (0 if none yet).
+  uint16_t bus_off_count;        // Bus-off events since start.
+  uint16_t recovery_backoff_ms;  // Current bus-off recovery backoff.
+} can_bus_status_t;
+
+/**
+ * @brief Struct holding the dual bus redundancy state and statistics.
+ */
+typedef struct {
+  uint8_t primary_bus;             // TX bus of non-mirrored messages (0, 1).
+  uint8_t bus_ok[2];               // Bus health, not bus-off and not silent.
+  uint32_t mirrored;               // Frames queued on both buses.
+  uint32_t duplicates;             // Mirrored RX copies dropped.
+  uint32_t skew_us_last;           // Mirrored RX copy arrival skew, last.
+  uint32_t skew_us_max;            // Mirrored RX copy arrival skew, maximum.
+  uint32_t failovers;              // Primary bus switches.
+  uint32_t failover_time_ms_last;  // Bus failure to switch over time, last.
+  uint32_t failover_time_ms_max;   // Bus failure to switch over time, maximum.
+} can_redundancy_stats_t;
+
+/**
+ * @brief Struct holding deferred RX statistics for both CAN buses.
+ */
+typedef struct {
+  uint32_t received;      // Frames moved from hardware FIFOs into the ring.
+  uint32_t dispatched;    // Frames handed to process_can_message.
+  uint32_t ring_overflow; // Frames lost due to a full RX ring.
+  uint32_t fifo_overrun;  // Frames lost due to a hardware RX FIFO overrun.
+  uint16_t high_water;    // Maximum RX ring depth observed.
+} can_rx_stats_t;
+
 /** User implementations of STM32 CAN NVIC HAL (overwriting HAL). *************/
 
 void HAL_CAN_RxFifo0MsgPendingCallback_can(CAN_HandleTypeDef *hcan);
 void HAL_CAN_RxFifo1MsgPendingCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox0CompleteCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox1CompleteCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox2CompleteCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox0AbortCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox1AbortCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_TxMailbox2AbortCallback_can(CAN_HandleTypeDef *hcan);
+void HAL_CAN_ErrorCallback_can(CAN_HandleTypeDef *hcan);
 
 /** Public functions. *********************************************************/
 
@@ -114,26 +277,204 @@ uint32_t float_to_raw(float physical_value, const can_signal_t *signal);
  */
 uint32_t double_to_raw(double physical_value, const can_signal_t *signal);
 
+/**
+ * @brief Decode a signal from a CAN payload to its physical value.
+ *
+ * Signed signals are sign-extended and IEEE float signals reinterpreted before
+ * scale and offset are applied.
+ *
+ * @param signal Signal definition.
+ * @param data CAN payload (8 bytes).
+ *
+ * @return Physical value.
+ */
+float decode_signal(const can_signal_t *signal, const uint8_t *data);
+
+/**
+ * @brief Extract the raw (sign-extended if signed) value of a signal.
+ *
+ * @param signal Signal definition.
+ * @param data CAN payload (8 bytes).
+ *
+ * @return Raw value, IEEE float signals as their bit pattern.
+ */
+int64_t can_signal_raw(const can_signal_t *signal, const uint8_t *data);
+
+/**
+ * @brief Check if a signal is present in a received multiplexed payload.
+ *
+ * @param msg Message definition.
+ * @param signal Signal definition within msg.
+ * @param data CAN payload (8 bytes).
+ *
+ * @return 1 if not multiplexed or the multiplexer switch selects it, else 0.
+ */
+uint8_t can_signal_present(const can_message_t *msg,
+                           const can_signal_t *signal, const uint8_t *data);
+
+/**
+ * @brief Look up the value table description of a raw signal value.
+ *
+ * @param signal Signal definition.
+ * @param raw Raw signal value.
+ *
+ * @return Description, or 0 if the signal has no entry for raw.
+ */
+const char *can_signal_value_description(const can_signal_t *signal,
+                                         int32_t raw);
+
+/**
+ * @brief Get the CAN timestamp time base (systime_us32).
+ *
+ * @return System time low 32 bits (us), wraps every 2^32 us.
+ */
+uint32_t can_time_us(void);
+
+/**
+ * @brief Called in the TX interrupt when a frame was transmitted.
+ *
+ * Weak no-op, to be overridden by user code (e.g. to send a time sync follow
+ * up with the exact transmit time). Must be short, runs in interrupt context.
+ *
+ * @param h_can_x CAN bus the frame was transmitted on.
+ * @param std_id Standard CAN ID of the frame.
+ * @param data Frame payload, to tell apart frames sharing an ID.
+ * @param timestamp_us can_time_us time captured in the TX interrupt.
+ */
+void can_tx_complete(const CAN_HandleTypeDef *h_can_x, uint32_t std_id,
+                     const uint8_t *data, uint32_t timestamp_us);
+
 /**
  * @brief Initialize CAN.
  */
 void can_init(void);
 
+/**
+ * @brief Queue a raw standard ID CAN frame for transmission on h_can_x.
+ *
+ * Frames go straight to a free TX mailbox when the software queue is empty,
+ * otherwise they are queued in CAN ID priority order and sent from the TX
+ * mailbox complete interrupt. If all mailboxes hold lower priority frames, the
+ * lowest priority mailbox is aborted and requeued to avoid priority inversion.
+ *
+ * @param h_can_x STM32 CAN_HandleTypeDef type to decide which CAN bus to use.
+ * @param std_id Standard (11-bit) CAN ID.
+ * @param dlc Data Length Code (0-8).
+ * @param data Frame payload, dlc bytes are used.
+ *
+ * @return HAL_OK if queued, HAL_ERROR if dlc is over 8 or dropped due to a
+ *         full queue.
+ */
+HAL_StatusTypeDef can_send_raw(CAN_HandleTypeDef *h_can_x, uint32_t std_id,
+                               uint8_t dlc, const uint8_t *data);
+
+/**
+ * @brief Get the free space of the software TX queue of a CAN bus.
+ *
+ * @param h_can_x STM32 CAN_HandleTypeDef type to decide which CAN bus to use.
+ *
+ * @return Frames that can be queued before can_send_raw drops.
+ */
+uint16_t can_tx_queue_free(const CAN_HandleTypeDef *h_can_x);
+
+/**
+ * @brief Process received CAN frames deferred from the RX interrupts.
+ *
+ * The RX interrupts only drain the hardware FIFOs into a lock-free ring with a
+ * system time timestamp (can_time_us). This function decodes and dispatches the
+ * frames to their rx_handler in thread context, intended to run as a scheduler
+ * task.
+ */
+void can_rx_process(void);
+
+/**
+ * @brief Get the deferred RX statistics.
+ *
+ * @return Pointer to the live RX statistics.
+ */
+const can_rx_stats_t *can_rx_get_stats(void);
+
+/**
+ * @brief Get the software TX queue statistics of a CAN bus.
+ *
+ * @param h_can_x STM32 CAN_HandleTypeDef type to decide which CAN bus to use.
+ *
+ * @return Pointer to the live TX statistics of the bus.
+ */
+const can_tx_stats_t *can_tx_get_stats(const CAN_HandleTypeDef *h_can_x);
+
+/**
+ * @brief Update the bus load and error state monitor of both CAN buses.
+ *
+ * Samples the bxCAN error status register, latches the last error code and
+ * recovers from bus-off by restarting the controller after a backoff that
+ * doubles on every consecutive bus-off (CAN_BUS_OFF_BACKOFF_MIN_MS to
+ * CAN_BUS_OFF_BACKOFF_MAX_MS). Intended to run as a scheduler task every
+ * CAN_MONITOR_PERIOD_MS.
+ */
+void can_monitor_update(void);
+
+/**
+ * @brief Get the bus load and error state monitor of a CAN bus.
+ *
+ * @param h_can_x STM32 CAN_HandleTypeDef type to decide which CAN bus to use.
+ *
+ * @return Pointer to the live monitor status of the bus.
+ */
+const can_bus_status_t *can_get_bus_status(const CAN_HandleTypeDef *h_can_x);
+
+/**
+ * @brief Get the dual bus redundancy state and statistics.
+ *
+ * @return Pointer to the live redundancy statistics.
+ */
+const can_redundancy_stats_t *can_redundancy_get_stats(void);
+
+/**
+ * @brief Pack raw signal values into a CAN payload.
+ *
+ * For multiplexed messages only the signals selected by the multiplexer switch
+ * value are packed. Used by can_send_message_raw32 and the XBee telemetry.
+ *
+ * @param msg Pointer to the static CAN message definition.
+ * @param signal_values Array of raw values for each signal in the message.
+ * @param data CAN payload (8 bytes, unused bits 0).
+ */
+void can_pack_message_raw32(const can_message_t *msg,
+                            const uint32_t signal_values[], uint8_t data[8]);
+
+/**
+ * @brief Send uint32_t data CAN message with can_message_t reference.
+ *
+ * With NERVE_CAN_REDUNDANCY, redundant messages are mirrored on every healthy
+ * bus and other messages are sent on the primary bus, which fails over to the
+ * other bus on bus-off or silence (see can_monitor_update). Otherwise all
+ * messages are sent on CAN1.
+ *
+ * @param msg Pointer to the static CAN message definition.
+ * @param signal_values Array of raw values for each signal in the message.
+ *
+ * @return HAL_OK if queued on every selected bus, otherwise HAL_ERROR.
+ */
+HAL_StatusTypeDef can_send_message(const can_message_t *msg,
+                                   const uint32_t signal_values[]);
+
 /**
  * @brief Send uint32_t data CAN message on h_can_x with can_message_t
  * reference.
  *
  * This function takes a pointer to a can_message_t definition and an array of
  * uint32_t type elements (one per signal in the message). These values are the
- * converted physical values based on the DBC.
+ * converted physical values based on the DBC. For multiplexed messages only the
+ * signals selected by the multiplexer switch value are packed.
  *
  * @param h_can_x STM32 CAN_HandleTypeDef type to decide which CAN bus to use.
  * @param msg Pointer to the static CAN message definition.
  * @param signal_values Array of physical values for each signal in the message.
  *                      The array length must equal msg->signal_count.
  *
- * @return HAL_StatusTypeDef HAL status indicating whether the transmission
- *         was successful.
+ * @return HAL_StatusTypeDef HAL status indicating whether the message was
+ *         queued for transmission, see can_send_raw.
  *
  * @example
  * ```
@@ -5,7 +5,32 @@
 
 #include "can.h"
 
+#define DBC_MESSAGE_TIME_SYNC 0
+#define DBC_MESSAGE_STATE 1
+#define DBC_MESSAGE_BAROMETRIC 2
+#define DBC_MESSAGE_GPS1 3
+#define DBC_MESSAGE_GPS2 4
+#define DBC_MESSAGE_GPS3 5
+#define DBC_MESSAGE_IMU1 6
+#define DBC_MESSAGE_IMU2 7
+#define DBC_MESSAGE_IMU3 8
+#define DBC_MESSAGE_IMU4 9
+#define DBC_MESSAGE_IMU5 10
+#define DBC_MESSAGE_IMU6 11
+#define DBC_MESSAGE_COMMAND_A 12
+#define DBC_MESSAGE_RTC 13
+#define DBC_MESSAGE_CAN1_STATUS 14
+#define DBC_MESSAGE_CAN2_STATUS 15
+#define DBC_MESSAGE_ISOTP_REQUEST 16
+#define DBC_MESSAGE_ISOTP_RESPONSE 17
+
 extern const can_message_t dbc_messages[];
 extern const int dbc_message_count;
 
+extern const can_filter_bank_t dbc_filter_banks[];
+extern const int dbc_filter_bank_count;
+
+void can_rx_command_a(CAN_RxHeaderTypeDef *header, uint8_t *data);
+void can_rx_isotp_request(CAN_RxHeaderTypeDef *header, uint8_t *data);
+
 #endif // CAN_NERVE_H
@@ -30,8 +30,29 @@
 // Full telemetry flood on CAN bus intended for debug/development purposes.
 //#define NERVE_DEBUG_FULL_CAN_TELEMETRY
 
+// Accept all CAN frames (not only DBC RX messages) so the CAN bus monitor load
+// and frame rates cover all traffic on a shared bus, at extra interrupt cost.
+//#define NERVE_CAN_MONITOR_ACCEPT_ALL
+
+// Dual bus CAN redundancy: mirror DBC NerveRedundant messages on CAN1 and CAN2,
+// deduplicate them on receive and fail over on bus-off or a silent bus.
+//#define NERVE_CAN_REDUNDANCY
+
+// SD card write benchmark at boot before the flight log starts (blocking, tens
+// of seconds), results in SDBENCH.CSV, see sd_bench.h.
+//#define NERVE_SD_BENCHMARK
+
+// Floating point hot path benchmark (PID, CAN encode, GPS parse) at boot before
+// the flight log starts, results in FPUBENCH.CSV tagged with the build float
+// ABI (NERVE_FLOAT_ABI, CMakeLists.txt), see fpu_bench.h.
+//#define NERVE_FPU_BENCHMARK
+
 // Full reset of GPS prior to initialization, triggers cold start.
 // The 3.3 V backup cell powers the RTC and u-blox ephemeris RAM normally.
 //#define NERVE_GPS_COLD_START
 
+// u-blox TIMEPULSE wired to PA5 (TIM2_CH1), GNSS time syncs on its edges (us)
+// instead of the NMEA sentence timing (ms), see gnss_time.h.
+//#define NERVE_GPS_TIMEPULSE
+
 #endif
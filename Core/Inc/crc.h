@@ -11,6 +11,13 @@
 
 #include "stm32f4xx_hal.h"
 
+/** Definitions. **************************************************************/
+
+#define CRC16_CCITT_INIT 0xFFFF // CRC-16/CCITT-FALSE initial value.
+
+// Minimum buffer length (bytes) to use the hardware CRC unit for CRC-32.
+#define CRC32_HW_MIN_LENGTH 64
+
 /** Public functions. *********************************************************/
 
 /**
@@ -21,10 +28,10 @@
  *
  * @return Updated CRC value.
  */
-static inline uint8_t crc8_dvb_s2_update(uint8_t crc, uint8_t data);
+uint8_t crc8_dvb_s2_update(uint8_t crc, uint8_t data);
 
 /**
- * @brief Calculate CRC-8 (DVB-S2) for an entire buffer (bitwise method).
+ * @brief Calculate CRC-8 (DVB-S2) for an entire buffer (table method).
  *
  * @param data Pointer to the input data.
  * @param length Number of bytes in the data buffer.
@@ -33,4 +40,66 @@ static inline uint8_t crc8_dvb_s2_update(uint8_t crc, uint8_t data);
  */
 uint8_t crc8_dvb_s2(const uint8_t *data, size_t length);
 
+/**
+ * @brief Update CRC-16 (CCITT-FALSE, polynomial 0x1021) with a buffer.
+ *
+ * Slice-by-4 table method.
+ *
+ * @param crc Previous CRC value, CRC16_CCITT_INIT to start.
+ * @param data Pointer to the input data.
+ * @param length Number of bytes in the data buffer.
+ *
+ * @return Updated CRC value.
+ */
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Calculate CRC-16 (CCITT-FALSE) for an entire buffer.
+ *
+ * @param data Pointer to the input data.
+ * @param length Number of bytes in the data buffer.
+ *
+ * @return CRC-16 result.
+ */
+uint16_t crc16_ccitt(const uint8_t *data, size_t length);
+
+/**
+ * @brief Update CRC-32 (ISO-HDLC, as zlib and Ethernet) with a buffer.
+ *
+ * Slice-by-4 table method, except when starting (crc 0) with at least
+ * CRC32_HW_MIN_LENGTH bytes, which uses the hardware CRC unit. The hardware
+ * unit is shared and not reentrant, do not call from interrupts with such
+ * buffers (use crc32_sw_update).
+ *
+ * @param crc Previous CRC-32 result, 0 to start.
+ * @param data Pointer to the input data.
+ * @param length Number of bytes in the data buffer.
+ *
+ * @return Updated CRC-32 result.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Update CRC-32 (ISO-HDLC) with a buffer, software only.
+ *
+ * Same as crc32_update without the hardware CRC unit, safe in interrupts.
+ *
+ * @param crc Previous CRC-32 result, 0 to start.
+ * @param data Pointer to the input data.
+ * @param length Number of bytes in the data buffer.
+ *
+ * @return Updated CRC-32 result.
+ */
+uint32_t crc32_sw_update(uint32_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Calculate CRC-32 (ISO-HDLC) for an entire buffer.
+ *
+ * @param data Pointer to the input data.
+ * @param length Number of bytes in the data buffer.
+ *
+ * @return CRC-32 result.
+ */
+uint32_t crc32(const uint8_t *data, size_t length);
+
 #endif
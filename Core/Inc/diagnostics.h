@@ -13,7 +13,7 @@
 
 /** Public variables. *********************************************************/
 
-extern uint8_t can_fault_count;
+extern uint32_t can_fault_count;
 extern uint8_t bmp390_fault_count;
 extern uint8_t bno085_fault_count;
 extern uint8_t gps_fault_count;
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * @file fpu_bench.h
+ * @brief Floating point hot path benchmark (PID, CAN encode, GPS parse).
+ *******************************************************************************
+ */
+
+#ifndef NERVE__FPU_BENCH_H
+#define NERVE__FPU_BENCH_H
+
+/** Includes. *****************************************************************/
+
+#include "ff.h"
+#include <stdint.h>
+
+/** Definitions. **************************************************************/
+
+#define FPU_BENCH_FILE_NAME "FPUBENCH.CSV" // Results.
+
+#define FPU_BENCH_CALLS 1000 // Timed calls per path.
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for the benchmarked paths.
+ */
+typedef enum {
+  FPU_BENCH_PID = 0,    // pid_update, one controller.
+  FPU_BENCH_CAN_ENCODE, // float_to_raw and pack of one DBC message (imu1).
+  FPU_BENCH_GPS_PARSE,  // ublox_parse_nmea, GNGGA and GNRMC alternating.
+  FPU_BENCH_PATH_COUNT
+} fpu_bench_path_t;
+
+/**
+ * @brief Struct holding one path result.
+ */
+typedef struct {
+  uint32_t calls;        // Timed calls.
+  uint32_t min_cycles;   // Fastest call (CPU cycles).
+  uint32_t max_cycles;   // Slowest call (CPU cycles).
+  uint64_t total_cycles; // Sum of the call cycles.
+} fpu_bench_result_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Benchmark one path (blocking, milliseconds).
+ *
+ * Each call is timed with the DWT cycle counter (systime_init), interrupts
+ * masked, call overhead included. GPS parse fills a private ublox_data_t
+ * (nothing logged, sent or reported to the GNSS time, gps_data untouched).
+ *
+ * @param path Path to benchmark.
+ * @param result Pointer to the result.
+ */
+void fpu_bench_path(fpu_bench_path_t path, fpu_bench_result_t *result);
+
+/**
+ * @brief Benchmark all paths and write the results to FPU_BENCH_FILE_NAME.
+ *
+ * One CSV row per path, tagged with the floating point ABI of the build
+ * (hard, softfp or soft), so builds of each NERVE_FLOAT_ABI compare.
+ *
+ * @return FR_OK if the results were written, else the FatFs error.
+ */
+FRESULT fpu_bench_run(void);
+
+#endif
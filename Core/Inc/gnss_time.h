@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * @file gnss_time.h
+ * @brief GNSS disciplined time: UTC from the system time, RTC set from GNSS.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__GNSS_TIME_H
+#define NERVE__GNSS_TIME_H
+
+/** Includes. *****************************************************************/
+
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_hal_tim.h"
+#include "systime.h"
+#include "ublox_hal_uart.h"
+
+/** STM32 port and pin configs. ***********************************************/
+
+// u-blox TIMEPULSE input capture (NERVE_GPS_TIMEPULSE), on the system time low
+// word timer so a capture is the systime_us32 of the edge.
+#define GNSS_TIME_PPS_HTIM SYSTIME_HTIM
+#define GNSS_TIME_PPS_CHANNEL TIM_CHANNEL_1
+#define GNSS_TIME_PPS_FLAG TIM_FLAG_CC1
+#define GNSS_TIME_PPS_OVERCAPTURE_FLAG TIM_FLAG_CC1OF
+#define GNSS_TIME_PPS_PORT GPIOA
+#define GNSS_TIME_PPS_PIN GPIO_PIN_5
+#define GNSS_TIME_PPS_AF GPIO_AF1_TIM2
+
+/** Definitions. **************************************************************/
+
+#define GNSS_TIME_PROCESS_PERIOD_MS 10 // gnss_time_process task period (ms).
+
+// NMEA only: RMC sentence start ('$') after its epoch (us), the u-blox output
+// latency. Calibrate with TIMEPULSE wired, see nmea_latency_us.
+#define GNSS_TIME_NMEA_LATENCY_US 30000
+
+#define GNSS_TIME_PPS_MATCH_US 500000      // RMC start after TIMEPULSE (us).
+#define GNSS_TIME_PPS_TIMEOUT_US 3000000   // No TIMEPULSE, NMEA syncs (us).
+#define GNSS_TIME_STEP_US 100000           // Offset restarting the drift (us).
+#define GNSS_TIME_DRIFT_WINDOW_US 60000000 // Drift measurement interval (us).
+#define GNSS_TIME_DRIFT_FILTER 4           // Drift filter gain, 1 / 2^n.
+
+// Largest plausible system time rate error (ppb, 500 ppm), a measured or step
+// implied rate beyond it is not learned. GNSS_TIME_RATE_FAULT_COUNT in a row
+// latch rate_fault (GPS fault).
+#define GNSS_TIME_DRIFT_MAX_PPB 500000
+#define GNSS_TIME_RATE_FAULT_COUNT 3
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for the GNSS time sync sources.
+ */
+typedef enum {
+  GNSS_TIME_NONE = 0, // Not synced.
+  GNSS_TIME_NMEA,     // RMC time, latency compensated (ms accuracy).
+  GNSS_TIME_PPS       // TIMEPULSE input capture (us accuracy).
+} gnss_time_source_t;
+
+/**
+ * @brief Struct holding GNSS time statistics.
+ */
+typedef struct {
+  gnss_time_source_t source; // Source of the last sync.
+  uint32_t syncs;            // Sync points applied (1 Hz).
+  uint32_t steps;            // Syncs off by GNSS_TIME_STEP_US or more.
+  uint32_t pps_edges;        // TIMEPULSE edges captured.
+  uint32_t pps_overcaptures; // TIMEPULSE edges lost (not read in time).
+  uint32_t rtc_sets;         // RTC set from GNSS time.
+  int32_t offset_us;         // Last sync, predicted minus GNSS UTC (us).
+  int32_t offset_max_us;     // Largest |offset_us| since the first sync.
+  int32_t drift_ppb;         // System time rate error (ppb, positive: fast).
+  int32_t nmea_latency_us;   // Last RMC start after its TIMEPULSE (us).
+  uint32_t rate_errors;      // Rates over GNSS_TIME_DRIFT_MAX_PPB.
+  uint8_t rate_fault;        // Latched, rate error persists (GPS fault).
+  uint64_t last_sync_us;     // System time of the last sync point.
+} gnss_time_stats_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Start the TIMEPULSE input capture (NERVE_GPS_TIMEPULSE).
+ */
+void gnss_time_init(void);
+
+/**
+ * @brief Report the UTC epoch of a valid RMC sentence.
+ *
+ * Called by the u-blox driver (UART interrupt) with gps_data updated, only
+ * whole seconds are used.
+ *
+ * @param data GPS data holding the RMC date and time.
+ * @param start_us Sentence start ('$' start bit) systime_us32.
+ */
+void gnss_time_nmea(const ublox_data_t *data, uint32_t start_us);
+
+/**
+ * @brief Apply the GNSS sync points and keep the RTC on GNSS time.
+ *
+ * Each whole second RMC epoch is a sync point: at its TIMEPULSE edge when
+ * captured, else at the sentence start less GNSS_TIME_NMEA_LATENCY_US. The
+ * system time rate error (drift) is measured between sync points
+ * GNSS_TIME_DRIFT_WINDOW_US apart or re-seeded from a step, learned only within
+ * GNSS_TIME_DRIFT_MAX_PPB (else counted in rate_errors). Each sync point is
+ * logged (LOG_RECORD_GNSS_TIME) so log timestamps convert to UTC. The RTC is
+ * set on a UTC second boundary when its seconds differ. Intended to run as a
+ * GNSS_TIME_PROCESS_PERIOD_MS scheduler task.
+ */
+void gnss_time_process(void);
+
+/**
+ * @brief Convert a system time to UTC.
+ *
+ * Safe in interrupts.
+ *
+ * @param sys_us System time (systime_us).
+ * @param utc_us Pointer to the UTC (us since 1970-01-01 00:00:00).
+ *
+ * @return 1 if synced (utc_us set), otherwise 0.
+ */
+uint8_t gnss_time_utc_us(uint64_t sys_us, int64_t *utc_us);
+
+/**
+ * @brief Get the GNSS time statistics.
+ *
+ * @return Pointer to the live statistics.
+ */
+const gnss_time_stats_t *gnss_time_get_stats(void);
+
+#endif
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * @file isotp.h
+ * @brief ISO-TP (ISO 15765-2) transport layer over the CAN driver.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__ISOTP_H
+#define NERVE__ISOTP_H
+
+/** Includes. *****************************************************************/
+
+#include "stm32f4xx_hal.h"
+
+/** Definitions. **************************************************************/
+
+#define ISOTP_CAN_HANDLE hcan1 // CAN bus used for ISO-TP.
+
+#define ISOTP_RX_BUFFER_SIZE 4095 // Maximum received message (classic FF_DL).
+#define ISOTP_RX_BLOCK_SIZE 16    // Flow control block size sent (0: no limit).
+#define ISOTP_RX_STMIN 0          // Flow control STmin sent (raw, 0-127 ms).
+
+#define ISOTP_TIMEOUT_MS 1000    // N_Bs and N_Cr timeouts (ms).
+#define ISOTP_MAX_WFT 10         // Maximum consecutive flow control waits.
+#define ISOTP_TX_QUEUE_RESERVE 8 // TX queue frames kept free for telemetry.
+#define ISOTP_PADDING 0xCC       // Padding byte, all frames are 8 bytes.
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Struct holding ISO-TP statistics.
+ */
+typedef struct {
+  uint32_t rx_messages; // Messages received completely.
+  uint32_t tx_messages; // Messages transmitted completely.
+  uint32_t rx_errors;   // Receptions aborted (timeout, sequence, overflow).
+  uint32_t tx_errors;   // Transmissions aborted (timeout, overflow, waits).
+} isotp_stats_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Start a non-blocking ISO-TP transmission.
+ *
+ * Single frames are queued immediately. Longer messages send a first frame and
+ * the remaining consecutive frames are queued by isotp_process as the flow
+ * control (block size, STmin) and the CAN TX queue allow.
+ *
+ * @param data Message data, must remain valid until the transmission is done.
+ * @param length Message length (1-4095 bytes).
+ *
+ * @return HAL_OK if started, HAL_BUSY if a transmission is in progress,
+ *         HAL_ERROR for an invalid length or a full CAN TX queue.
+ */
+HAL_StatusTypeDef isotp_send(const uint8_t *data, uint16_t length);
+
+/**
+ * @brief Check if an ISO-TP transmission is in progress.
+ *
+ * @return 1 if busy, otherwise 0.
+ */
+uint8_t isotp_tx_busy(void);
+
+/**
+ * @brief Run the ISO-TP transmit pacing and timeouts.
+ *
+ * Intended to run as a 1 ms scheduler task.
+ */
+void isotp_process(void);
+
+/**
+ * @brief Called when an ISO-TP message was received completely.
+ *
+ * Weak no-op, to be overridden by user code. The data is only valid for the
+ * duration of the call.
+ *
+ * @param data Received message data.
+ * @param length Received message length.
+ */
+void isotp_rx_complete(const uint8_t *data, uint16_t length);
+
+/**
+ * @brief Get the ISO-TP statistics.
+ *
+ * @return Pointer to the live statistics.
+ */
+const isotp_stats_t *isotp_get_stats(void);
+
+#endif
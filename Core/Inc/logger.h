@@ -0,0 +1,410 @@
+/*******************************************************************************
+ * @file logger.h
+ * @brief Binary flight logger on the SD card.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__LOGGER_H
+#define NERVE__LOGGER_H
+
+/** Includes. *****************************************************************/
+
+#include "ff.h"
+#include "stm32f4xx_hal.h"
+
+/** Definitions. **************************************************************/
+
+// Buffer (log block) size, each block is one DMA write. Multiple of the 512 B
+// sector and not above the cluster size (one write per f_write).
+#define LOG_BUFFER_SIZE 8192
+
+// Ring of log blocks, one filled while the others wait for the card (write in
+// flight, SD latency, card removed until remounted).
+#define LOG_BUFFER_COUNT 6
+
+// Pre-allocated contiguous file size (f_expand), streamed with raw multi-block
+// sector writes (no FAT updates until closed). 0 to always use f_write.
+#define LOG_PREALLOCATE_SIZE (64UL * 1024 * 1024)
+
+// Clusters allocated or released per background step (pre-allocating, closing
+// and deleting files, in bytes), bounds the FAT updates of each step.
+#define LOG_ALLOCATION_STEP (1024UL * 1024)
+
+#define LOG_PROCESS_PERIOD_MS 10 // logger_process task period (ms).
+#define LOG_FLUSH_PERIOD_MS 400  // Partial block written after (ms).
+
+// f_sync once this many bytes were written with f_write since the last sync
+// (not pre-allocated, raw sector writes need no sync).
+#define LOG_SYNC_DIRTY_BYTES (2 * LOG_BUFFER_SIZE)
+
+// Session directory per logger_start, named from the RTC date and time, else
+// the GPS date and time, else LOG_SESSION_NO_TIME (suffix _1 to _99 if taken).
+// Sessions are listed in start order in the index file.
+#define LOG_SESSION_NAME "%04u%02u%02u_%02u%02u%02u" // YYYYMMDD_HHMMSS.
+#define LOG_SESSION_NO_TIME "NOTIME"
+#define LOG_INDEX_FILE_NAME "SESSIONS.TXT"
+
+// Log file name in the session directory, numbered from 000.
+#define LOG_FILE_NAME "LOG%03u.BIN"
+
+// Rotation to the next log file (pre-created in the background), 0 disables.
+#define LOG_ROTATE_SIZE LOG_PREALLOCATE_SIZE    // File size (bytes).
+#define LOG_ROTATE_PERIOD_MS (10UL * 60 * 1000) // File duration (ms).
+
+// Oldest sessions are deleted (never the current one) below this free space.
+#define LOG_MIN_FREE_BYTES (256ULL * 1024 * 1024)
+
+// First block of each file, holding the schema records.
+#define LOG_SCHEMA_BLOCK_SIZE 1024
+
+// Index block (one sector) after every LOG_INDEX_INTERVAL bytes of data blocks,
+// listing their file offsets and first timestamps. The last index block is the
+// file footer, written on close.
+#define LOG_INDEX_INTERVAL (64UL * 1024)
+
+// Compress the streams (record types) with a codec in the schema table, each
+// can be disabled with logger_set_compression. 0 stores every record raw.
+#define LOG_COMPRESSION 1
+#define LOG_CODEC_MAX_FIELDS 5 // Fixed point fields per compressed record.
+
+#define LOG_BLOCK_MAGIC "NLOG"   // Block header magic.
+#define LOG_FILE_VERSION 3       // File format version.
+#define LOG_BLOCK_HEADER_SIZE 20 // sizeof(log_block_header_t).
+#define LOG_RECORD_HEADER_SIZE 6 // Type (1), length (1), timestamp (4).
+#define LOG_RECORD_COMPRESSED 0x80 // Record type flag, compressed payload.
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for log record types.
+ *
+ * Each type (except LOG_RECORD_SCHEMA) is described by a schema record at the
+ * start of the file, adding a type only needs a new entry here, in the schema
+ * table (logger.c) and its payload struct.
+ *
+ * Streams of float fields holding fixed point sensor values (e.g. the BNO085
+ * Q points) are compressed when the schema table gives their fraction bits:
+ * each field as a delta to the previous record of the stream in the block,
+ * zigzag and varint encoded, with LOG_RECORD_COMPRESSED set in the type. The
+ * first record of a stream in each block is a delta to 0, so blocks decode on
+ * their own. A record not exact in fixed point is stored raw.
+ */
+typedef enum {
+  LOG_RECORD_SCHEMA = 0,     // Record type description.
+  LOG_RECORD_IMU_QUATERNION, // log_imu_quaternion_t.
+  LOG_RECORD_IMU_GYRO,       // log_vector3_t, rad/s.
+  LOG_RECORD_IMU_ACCEL,      // log_vector3_t, m/s^2.
+  LOG_RECORD_IMU_LIN_ACCEL,  // log_vector3_t, m/s^2.
+  LOG_RECORD_IMU_GRAVITY,    // log_vector3_t, m/s^2.
+  LOG_RECORD_BAROMETRIC,     // log_barometric_t.
+  LOG_RECORD_GPS,            // log_gps_t.
+  LOG_RECORD_CAN_FRAME,      // log_can_frame_t.
+  LOG_RECORD_INDEX,          // log_index_t, first record of an index block.
+  LOG_RECORD_INDEX_ENTRY,    // log_index_entry_t.
+  LOG_RECORD_GNSS_TIME,      // log_gnss_time_t, system time to UTC.
+  LOG_RECORD_RTC_TIME,       // log_rtc_time_t, system time to RTC time.
+  LOG_RECORD_TYPE_COUNT
+} log_record_type_t;
+
+/**
+ * @brief Struct defining a block header, followed by whole records.
+ *
+ * The file is a sequence of sector aligned blocks (schema block, then
+ * LOG_BUFFER_SIZE data blocks and one sector index blocks), each
+ * self-delimiting and CRC protected: a block lost or torn by a power loss only
+ * loses its own records. The first block starts with the schema records.
+ */
+typedef struct {
+  char magic[4];     // LOG_BLOCK_MAGIC.
+  uint8_t version;   // LOG_FILE_VERSION.
+  uint8_t sectors;   // Block size (512 B sectors).
+  uint16_t length;   // Bytes used (header and records), rest is padding.
+  uint32_t sequence; // Block sequence number, 0 for the first block.
+  uint32_t log_id;   // Log identifier (start systime_us32), rejects stale data.
+  uint32_t crc;      // CRC-32 (ISO-HDLC) of the used bytes, this field 0.
+} log_block_header_t;
+
+/**
+ * @brief Struct defining a rotation vector record.
+ */
+typedef struct {
+  float i;            // Quaternion i.
+  float j;            // Quaternion j.
+  float k;            // Quaternion k.
+  float real;         // Quaternion real.
+  float accuracy_rad; // Heading accuracy estimate (rad).
+} log_imu_quaternion_t;
+
+/**
+ * @brief Struct defining a 3 axis vector record.
+ */
+typedef struct {
+  float x;
+  float y;
+  float z;
+} log_vector3_t;
+
+/**
+ * @brief Struct defining a barometric record.
+ */
+typedef struct {
+  float pressure;    // Pressure (Pa).
+  float temperature; // Temperature (deg C).
+} log_barometric_t;
+
+/**
+ * @brief Struct defining a GPS record.
+ */
+typedef struct {
+  float latitude;       // Latitude in decimal degrees.
+  float longitude;      // Longitude in decimal degrees.
+  float altitude_m;     // Altitude in meters.
+  float geoid_sep_m;    // Geoid separation.
+  float speed_knots;    // Speed over the ground in knots.
+  float course_deg;     // Course over ground in degrees.
+  float hdop;           // Horizontal Dilution of Precision (HDOP).
+  uint8_t position_fix; // nmea_position_fix_t.
+  uint8_t satellites;   // Number of Satellites.
+  uint8_t reserved[2];  // Reserved, 0.
+} log_gps_t;
+
+/**
+ * @brief Struct defining a CAN frame record.
+ */
+typedef struct {
+  uint16_t std_id; // Standard CAN ID.
+  uint8_t flags;   // Bit 0: bus (0: CAN1, 1: CAN2), bit 1: transmitted.
+  uint8_t dlc;     // Data Length Code.
+  uint8_t data[8]; // Payload.
+} log_can_frame_t;
+
+#define LOG_CAN_FLAG_CAN2 0x01 // log_can_frame_t flags, received on CAN2.
+#define LOG_CAN_FLAG_TX 0x02   // log_can_frame_t flags, transmitted frame.
+
+/**
+ * @brief Struct defining a GNSS time sync record, one per sync point.
+ *
+ * A record timestamp t (systime_us32) of the log is UTC
+ * utc_us + d - d * drift_ppb / 10^9, with d = (int32_t)(t - sys_us), using
+ * the closest sync record.
+ */
+typedef struct {
+  int64_t utc_us;      // UTC at sys_us (us since 1970-01-01 00:00:00).
+  uint32_t sys_us;     // Sync point system time (systime_us32).
+  int32_t drift_ppb;   // System time rate error (ppb, positive: fast).
+  int32_t offset_us;   // Predicted minus GNSS UTC at the sync point (us).
+  uint8_t source;      // gnss_time_source_t.
+  uint8_t reserved[3]; // Reserved, 0.
+} log_gnss_time_t;
+
+/**
+ * @brief Struct defining an RTC time record, one per get_epoch_us anchor move.
+ *
+ * A record timestamp t (systime_us32) of the log is RTC time
+ * epoch_us + (int32_t)(t - sys_us), using the closest RTC time record.
+ */
+typedef struct {
+  int64_t epoch_us; // RTC time at sys_us (us since 1970-01-01 00:00:00).
+  uint32_t sys_us;  // Anchor system time (systime_us32).
+  int32_t step_us;  // Anchor move (us), 0 for the first.
+} log_rtc_time_t;
+
+/**
+ * @brief Struct defining an index block record, followed by the index entries.
+ *
+ * Index blocks are chained from the footer (last block of a closed file) back
+ * to the first, so a reader finds every entry without scanning the file.
+ */
+typedef struct {
+  uint32_t previous;   // File offset of the previous index block, 0 if first.
+  uint8_t footer;      // 1 for the last index block, written on close.
+  uint8_t reserved[3]; // Reserved, 0.
+} log_index_t;
+
+/**
+ * @brief Struct defining an index entry record, one per data block.
+ *
+ * The record timestamp is the timestamp of the first record in the block.
+ */
+typedef struct {
+  uint32_t sequence; // Block sequence number.
+  uint32_t offset;   // Block file offset (bytes).
+} log_index_entry_t;
+
+/**
+ * @brief Struct holding logger statistics.
+ */
+typedef struct {
+  uint32_t records;      // Records buffered.
+  uint32_t bytes;        // Bytes written to the file.
+  uint32_t dropped;      // Records dropped (buffer full).
+  uint32_t write_errors; // f_write or f_sync failures.
+  uint32_t high_water;   // Maximum buffered bytes (all buffers).
+  uint32_t write_ms_max; // Longest buffer write, queued to completed (ms).
+  uint32_t call_us_max;  // Longest logger_process blocking (us).
+  uint32_t queue_us_max; // Longest logger_process queuing a block (us).
+  uint32_t blocks;       // Blocks written.
+  uint32_t syncs;        // f_sync calls (dirty byte budget).
+  uint32_t unaligned;    // SD sectors copied for unaligned buffers (all users).
+  uint32_t files;        // Log files started (rotation).
+  uint32_t deleted;      // Files of old sessions deleted (free space).
+  uint32_t suspends;     // Files abandoned (card removed or failing).
+  uint8_t raw;           // Streaming to the pre-allocated sectors.
+  uint8_t online;        // Writing to the card, else buffering in RAM.
+  uint8_t pending;       // Sealed blocks waiting for the card.
+} logger_stats_t;
+
+/**
+ * @brief Struct holding per stream (record type) statistics.
+ *
+ * Compression ratio: raw_bytes / bytes. Cycles per record: cycles / records.
+ */
+typedef struct {
+  uint32_t records;    // Records buffered.
+  uint32_t compressed; // Records buffered compressed.
+  uint32_t raw_bytes;  // Record bytes (header and payload) before compression.
+  uint32_t bytes;      // Record bytes buffered.
+  uint64_t cycles;     // DWT cycles in logger_write, buffered records.
+  uint32_t cycles_max; // Longest logger_write (DWT cycles).
+} logger_stream_stats_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Start buffering records in RAM, without the SD card.
+ *
+ * Records are kept in the LOG_BUFFER_COUNT blocks until logger_start writes
+ * them to the card, further records are dropped once all blocks are full.
+ */
+void logger_init(void);
+
+/**
+ * @brief One bounded step starting a logging session (SD card mounted).
+ *
+ * A new session deletes the oldest sessions below LOG_MIN_FREE_BYTES, rewrites
+ * the index, creates the session directory (listed in LOG_INDEX_FILE_NAME) and
+ * its first LOG_FILE_NAME, each step one phase (or one LOG_ALLOCATION_STEP of
+ * deleting or pre-allocating). Each file is pre-allocated with
+ * LOG_PREALLOCATE_SIZE contiguous bytes (falls back to f_write if no contiguous
+ * space) and starts with a schema block.
+ *
+ * After logger_suspend (card remounted), the session continues with its next
+ * file, without deleting sessions or rewriting the index (a new session if the
+ * directory is gone, e.g. another card), and the records buffered meanwhile
+ * are written first, in order.
+ *
+ * @param result Pointer to the result, FR_OK or the FatFs error once done.
+ *
+ * @return 1 once started or failed (result), 0 while starting.
+ */
+uint8_t logger_start_step(FRESULT *result);
+
+/**
+ * @brief Start a logging session, logger_start_step until done (blocking).
+ *
+ * @return FR_OK if logging started, else the FatFs error.
+ */
+FRESULT logger_start(void);
+
+/**
+ * @brief Flush the buffered records and close the log files (blocking).
+ *
+ * Each file ends with its footer (last index block), the unused pre-allocated
+ * space is released (files truncated). Records buffered while suspended are
+ * discarded.
+ */
+void logger_stop(void);
+
+/**
+ * @brief Abandon the log files without accessing the card (removed or
+ * failing), records are buffered in RAM until the next logger_start.
+ *
+ * The files are left as after a power loss (no footer, see recover_log.py),
+ * the block being written is written again to the next file. The caller
+ * releases the card and remounts it before logger_start (see storage.h).
+ */
+void logger_suspend(void);
+
+/**
+ * @brief Check if logging is active.
+ *
+ * @return 1 if records are buffered (started or suspended), otherwise 0.
+ */
+uint8_t logger_active(void);
+
+/**
+ * @brief Buffer one timestamped record.
+ *
+ * Non-blocking, safe in interrupts (masked for the encoding and copy). The
+ * record is timestamped with systime_us32 (system time low 32 bits), the same
+ * time base as the sensor sample, CAN and time sync timestamps.
+ *
+ * @param type Record type.
+ * @param payload Record payload (the type's payload struct).
+ * @param length Payload length (bytes).
+ *
+ * @return 1 if buffered, 0 if not logging or dropped (buffer full).
+ */
+uint8_t logger_write(log_record_type_t type, const void *payload,
+                     uint8_t length);
+
+/**
+ * @brief Buffer one record with an explicit timestamp.
+ *
+ * Same as logger_write, for events timestamped when they happened (e.g. CAN
+ * frames in the RX and TX interrupts, IMU samples at the sensor).
+ *
+ * @param type Record type.
+ * @param payload Record payload (the type's payload struct).
+ * @param length Payload length (bytes).
+ * @param timestamp_us Event systime_us32 timestamp.
+ *
+ * @return 1 if buffered, 0 if not logging or dropped (buffer full).
+ */
+uint8_t logger_write_at(log_record_type_t type, const void *payload,
+                        uint8_t length, uint32_t timestamp_us);
+
+/**
+ * @brief Queue full buffers to the file and release written ones.
+ *
+ * Never waits on a data write: a full block (or a partial one after
+ * LOG_FLUSH_PERIOD_MS) is sealed, the oldest sealed block is queued (SDIO DMA,
+ * queue_us_max) once the previous write completed (DMA callback and card
+ * ready). Nothing is written while suspended. With no block to write, one
+ * background step runs: writing an index block (DMA), or closing the previous
+ * file, deleting an old session file or pre-creating the next file, each split
+ * in bounded steps (LOG_ALLOCATION_STEP). These steps still block for their
+ * FAT and directory sector accesses (milliseconds, counted in call_us_max).
+ * Intended to run as a LOG_PROCESS_PERIOD_MS scheduler task.
+ */
+void logger_process(void);
+
+/**
+ * @brief Get the logger statistics.
+ *
+ * @return Pointer to the live statistics.
+ */
+const logger_stats_t *logger_get_stats(void);
+
+/**
+ * @brief Get the statistics of one stream (record type).
+ *
+ * @param type Record type.
+ *
+ * @return Pointer to the live statistics, NULL if not a record type.
+ */
+const logger_stream_stats_t *logger_get_stream_stats(log_record_type_t type);
+
+/**
+ * @brief Enable or disable compression of one stream (enabled by default).
+ *
+ * Takes effect from the next record, both kinds decode from the same file.
+ *
+ * @param type Record type.
+ * @param enable 1 to compress, 0 to store raw.
+ *
+ * @return 1 if the stream has a codec, otherwise 0 (always raw).
+ */
+uint8_t logger_set_compression(log_record_type_t type, uint8_t enable);
+
+#endif
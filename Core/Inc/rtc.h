@@ -11,6 +11,10 @@
 
 #include "stm32f4xx_hal.h"
 
+/** Definitions. **************************************************************/
+
+#define RTC_SET_MARKER 0x2345 // RTC_BKP_DR1 value once the date was set.
+
 /** STM32 port and pin configs. ***********************************************/
 
 extern RTC_HandleTypeDef hrtc;
@@ -37,11 +41,50 @@ void set_date(uint8_t year, uint8_t month, uint8_t date, uint8_t day);
 void set_time(uint8_t hours, uint8_t minutes, uint8_t seconds);
 
 /**
- * @brief Get RTC date.
+ * @brief Get the RTC date and time.
+ *
+ * @param date Pointer to the date (binary).
+ * @param time Pointer to the time (binary).
+ *
+ * @return 1 if the date was set (backup register marker), otherwise 0.
+ */
+uint8_t get_date_time(RTC_DateTypeDef *date, RTC_TimeTypeDef *time);
+
+/**
+ * @brief Get the RTC time with sub-second resolution.
+ *
+ * The RTC seconds and sub-second register (1 / (SynchPrediv + 1) s, 3.9 ms)
+ * bound the time, the system time (systime_us) interpolates within a count.
+ * The system time anchor moves by the least amount keeping the time within the
+ * count read (RTC set, LSE vs HSE drift), each move is logged
+ * (LOG_RECORD_RTC_TIME) so log timestamps convert to RTC time. Not interrupt
+ * safe (RTC shadow registers).
+ *
+ * @param epoch_us Pointer to the time (us since 1970-01-01 00:00:00 UTC).
+ *
+ * @return 1 if the date was set (backup register marker), otherwise 0.
+ */
+uint8_t get_epoch_us(int64_t *epoch_us);
+
+/**
+ * @brief Convert an RTC date and time to Unix time.
+ *
+ * @param date Date (binary, year 00-99 -> 2000-2099).
+ * @param time Time (binary).
+ *
+ * @return Seconds since 1970-01-01 00:00:00 UTC.
+ */
+int64_t date_time_to_epoch(const RTC_DateTypeDef *date,
+                           const RTC_TimeTypeDef *time);
+
+/**
+ * @brief Convert Unix time to an RTC date and time.
  *
- * @param time Character based time value.
- * @param date Character based date value.
+ * @param seconds Seconds since 1970-01-01 00:00:00 UTC (years 2000-2099).
+ * @param date Pointer to the date (binary, with the weekday).
+ * @param time Pointer to the time (binary).
  */
-void get_time_date(char *time, char *date);
+void epoch_to_date_time(int64_t seconds, RTC_DateTypeDef *date,
+                        RTC_TimeTypeDef *time);
 
 #endif
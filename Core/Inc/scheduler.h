@@ -1,6 +1,6 @@
 /*******************************************************************************
  * @file scheduler.h
- * @brief Scheduler: Manages real time scheduling via DWT.
+ * @brief Scheduler: Manages real time scheduling via the system time.
  *******************************************************************************
  */
 
@@ -13,14 +13,7 @@
 
 /** Definitions. **************************************************************/
 
-// Ensure DWT utilization is possible.
-#if defined(DWT)
-// Init exists.
-#else
-#warning "DWT not available, scheduler timing disabled."
-#endif
-
-#define MAX_TASKS 10
+#define MAX_TASKS 16 // Spare slots over the tasks added in init.c.
 
 /** Public types. *************************************************************/
 
@@ -33,29 +26,29 @@ typedef void (*task_function_t)(void);
  * @brief Structure to hold task information.
  *
  * task_function: A function pointer to the task that needs to be executed.
- * period_cyc: The period of the task in terms of CPU cycles.
- *  This is calculated by converting the desired period in milliseconds to CPU
- *  cycles using the formula period_cyc = period_ms * CPU_CYCLES_PER_MS.
- * next_execution_cyc: The absolute CPU cycle count at which the task is next
- *  scheduled to run. This is used to determine when the task should be executed
- *  based on the DWT cycle counter.
+ * period_us: The period of the task in microseconds (period_ms * 1000).
+ * next_execution_us: The absolute system time (systime_us) at which the task is
+ *  next scheduled to run, 64-bit so periods of any length never wrap.
  */
 typedef struct {
   task_function_t task_function; // Pointer to the task function.
-  uint32_t period_cyc;           // Task execution period in CPU cycles.
-  uint32_t next_execution_cyc;   // Next execution time in CPU cycles.
+  uint32_t period_us;            // Task execution period in us.
+  uint64_t next_execution_us;    // Next execution system time in us.
 } task_t;
 
 /** Public functions. *********************************************************/
 
 /**
- * @brief Initialize scheduler which utilized DWT.
+ * @brief Initialize the scheduler (system time started by systime_init).
  */
 void scheduler_init(void);
 
 /**
  * Function to add tasks to the scheduler.
  *
+ * Adding more than MAX_TASKS tasks is a configuration error and calls
+ * Error_Handler (does not return).
+ *
  * @param task_function task_function_t to add as a task.
  * @param period_ms Task execution period in milliseconds.
  */
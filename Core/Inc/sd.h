@@ -50,14 +50,69 @@ extern Disk_drvTypeDef disk;
  */
 uint8_t sdio_card_detected();
 
+/**
+ * @brief One bounded step of the SD card power-up, SDIO 1-bit then 4-bit bus.
+ *
+ * The HAL_SD_Init sequence split in steps, so a slow card never blocks: power
+ * on, CMD0 and CMD8 after the power-up delay, one CMD55 and ACMD41 per step
+ * until the card is ready (at most 1 s), identification and
+ * select, then the 4-bit bus. Each step is a few SDIO commands, at most about
+ * 2 ms (identification at the < 400 kHz clock). Never halts, a missing or
+ * failing card returns an error and can be initialized again after
+ * sdio_eject_sd.
+ *
+ * @param file_result Pointer to the result, FR_OK or the error once done.
+ *
+ * @return 1 once initialized or failed (file_result), 0 while initializing.
+ */
+uint8_t sdio_init_sd_step(FRESULT *file_result);
+
+/**
+ * @brief Initializes the SD card, sdio_init_sd_step until done (blocking, card
+ * power-up).
+ *
+ * @param file_result Pointer to the result variable.
+ */
+void sdio_init_sd(FRESULT *file_result);
+
+/**
+ * @brief Mounts the filesystem of the initialized SD card (sdio_init_sd), the
+ * volume is read now (blocking, boot sector and FSINFO, up to 3 sector reads).
+ *
+ * @param file_result Pointer to the result variable.
+ * @param SDFatFs Pointer to the FATFS object.
+ */
+void sdio_mount_volume_sd(FRESULT *file_result, FATFS *SDFatFs);
+
 /**
  * @brief Mounts the SD card filesystem.
  *
+ * Initializes the card (SDIO 4-bit) and reads the volume (blocking, card
+ * power-up): sdio_init_sd then sdio_mount_volume_sd. Never halts, a missing or
+ * failing card returns an error and can be mounted again after sdio_eject_sd.
+ *
  * @param file_result Pointer to the result variable.
  * @param SDFatFs Pointer to the FATFS object.
  */
 void sdio_mount_sd(FRESULT *file_result, FATFS *SDFatFs);
 
+/**
+ * @brief Releases a removed or failing SD card without accessing it.
+ *
+ * The write in flight is dropped, the filesystem unregistered (open files are
+ * invalid) and the SDIO de-initialized (powered off, DMA stopped).
+ *
+ * @param SDFatFs Pointer to the FATFS object.
+ */
+void sdio_eject_sd(FATFS *SDFatFs);
+
+/**
+ * @brief Check if the mounted card answers its status (CMD13, non-blocking).
+ *
+ * @return 1 if in a data transfer state, otherwise 0 (removed or failed).
+ */
+uint8_t sdio_card_responding(void);
+
 /**
  * @brief Unmounts the SD card filesystem.
  *
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * @file sd_bench.h
+ * @brief SD card write throughput and latency benchmark.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__SD_BENCH_H
+#define NERVE__SD_BENCH_H
+
+/** Includes. *****************************************************************/
+
+#include "ff.h"
+#include <stdint.h>
+
+/** Definitions. **************************************************************/
+
+#define SD_BENCH_FILE_NAME "SDBENCH.CSV"      // Results.
+#define SD_BENCH_DATA_FILE_NAME "SDBENCH.DAT" // Written, deleted after.
+
+#define SD_BENCH_BYTES (512UL * 1024) // Bytes written per configuration.
+#define SD_BENCH_MIN_WRITE 512        // Smallest write size (bytes).
+#define SD_BENCH_MAX_WRITE 32768      // Largest write size (bytes).
+#define SD_BENCH_MAX_SAMPLES (SD_BENCH_BYTES / SD_BENCH_MIN_WRITE)
+
+// Also benchmark buffers not 4 byte aligned, copied a sector at a time through
+// the sd_diskio.c scratch buffer (ENABLE_SCRATCH_BUFFER).
+#ifndef SD_BENCH_UNALIGNED_BUFFERS
+#define SD_BENCH_UNALIGNED_BUFFERS 1
+#endif
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for the benchmarked write paths.
+ */
+typedef enum {
+  SD_BENCH_APPEND = 0,   // f_write to a new file (clusters allocated).
+  SD_BENCH_PREALLOCATED, // f_write to a pre-allocated file (f_expand).
+  SD_BENCH_RAW,          // disk_write to the pre-allocated file sectors.
+  SD_BENCH_MODE_COUNT
+} sd_bench_mode_t;
+
+/**
+ * @brief Enumeration for the benchmarked buffer and file alignments.
+ */
+typedef enum {
+  SD_BENCH_ALIGNED = 0,      // 4 byte aligned buffer, sector aligned file.
+  SD_BENCH_FILE_OFFSET,      // File position 1 byte past a sector boundary.
+  SD_BENCH_UNALIGNED_BUFFER, // Buffer 1 byte past a 4 byte boundary.
+  SD_BENCH_ALIGNMENT_COUNT
+} sd_bench_alignment_t;
+
+/**
+ * @brief Struct holding one benchmark configuration result.
+ */
+typedef struct {
+  uint32_t writes;   // Writes (f_write or disk_write calls).
+  uint32_t bytes;    // Bytes written.
+  uint32_t total_us; // Sum of the write latencies (us).
+  uint32_t p50_us;   // Median write latency (us).
+  uint32_t p90_us;   // 90th percentile write latency (us).
+  uint32_t p99_us;   // 99th percentile write latency (us).
+  uint32_t max_us;   // Maximum write latency (us).
+  uint32_t close_us; // f_close latency (us).
+  uint32_t scratch;  // Sectors copied through the sd_diskio scratch buffer.
+} sd_bench_result_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Benchmark one configuration (SD card mounted, blocking).
+ *
+ * Writes SD_BENCH_BYTES to SD_BENCH_DATA_FILE_NAME in writes of the given size,
+ * each write timed with can_time_us.
+ *
+ * @param mode Write path.
+ * @param alignment Buffer and file alignment.
+ * @param size Write size (bytes), sector multiple for SD_BENCH_RAW.
+ * @param result Pointer to the result.
+ *
+ * @return FR_OK if completed, FR_INVALID_PARAMETER if not supported, else the
+ * FatFs error.
+ */
+FRESULT sd_bench_config(sd_bench_mode_t mode, sd_bench_alignment_t alignment,
+                        uint32_t size, sd_bench_result_t *result);
+
+/**
+ * @brief Run all configurations and write the results to SD_BENCH_FILE_NAME.
+ *
+ * One CSV row per write path, alignment and write size (SD_BENCH_MIN_WRITE to
+ * SD_BENCH_MAX_WRITE, powers of 2). Blocking, tens of seconds.
+ *
+ * @return FR_OK if the results were written, else the FatFs error.
+ */
+FRESULT sd_bench_run(void);
+
+#endif
@@ -15,21 +15,16 @@
 #include "sh2_hal.h"
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_spi.h"
-#include "stm32f4xx_hal_tim.h"
 
 /** STM32 port and pin configs. ***********************************************/
 
 extern SPI_HandleTypeDef hspi2;
-extern TIM_HandleTypeDef htim5;
 
 // SPI.
 #define SH2_HSPI hspi2
 #define SH2_CSN_PORT GPIOC
 #define SH2_CSN_PIN GPIO_PIN_6
 
-// Timer for signals.
-#define SH2_HTIM htim5
-
 // GPIO_EXTI for INTN.
 #define SH2_INTN_EXTI_IRQ EXTI0_IRQn
 #define SH2_INTN_PORT GPIOC
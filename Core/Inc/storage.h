@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * @file storage.h
+ * @brief Storage manager: SD card hot-plug, background remount and logging.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__STORAGE_H
+#define NERVE__STORAGE_H
+
+/** Includes. *****************************************************************/
+
+#include "ff.h"
+#include "stm32f4xx_hal.h"
+
+/** Definitions. **************************************************************/
+
+#define STORAGE_PROCESS_PERIOD_MS 10 // storage_process task period (ms).
+#define STORAGE_DEBOUNCE_MS 250      // Card detect stable for (ms).
+
+// Failed mount or start retried after STORAGE_RETRY_MS, doubled per failure
+// up to STORAGE_RETRY_MAX_MS (card inserted, not usable).
+#define STORAGE_RETRY_MS 1000
+#define STORAGE_RETRY_MAX_MS (30UL * 1000)
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for the storage manager states.
+ *
+ * Each storage_process call runs one bounded step, so the SD steps (each card
+ * power-up step, volume mount, each logger_start_step) never run back to back.
+ */
+typedef enum {
+  STORAGE_ABSENT = 0, // No card (debounced), records buffered in RAM.
+  STORAGE_INIT,       // Card inserted, card power-up in steps.
+  STORAGE_MOUNT,      // Card initialized, volume mount next.
+  STORAGE_START,      // Mounted, logging (re)start in steps.
+  STORAGE_MOUNTED,    // Logging to the card.
+  STORAGE_FAULT       // Released after a failure, retried after a backoff.
+} storage_state_t;
+
+/**
+ * @brief Struct holding storage manager statistics.
+ */
+typedef struct {
+  storage_state_t state; // Current state.
+  uint32_t insertions;   // Card insertions (debounced).
+  uint32_t removals;     // Card removals (debounced).
+  uint32_t mounts;       // Logging (re)started on the card.
+  uint32_t failures;     // Failed mount or start steps.
+  uint32_t faults;       // Card not responding after write errors.
+  FRESULT last_error;    // Last mount or start error.
+  uint32_t call_us_max;  // Longest storage_process call (us).
+  uint32_t mount_us_max; // Longest volume mount, blocking (us).
+} storage_stats_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Start buffering log records, the card is mounted by storage_process.
+ */
+void storage_init(void);
+
+/**
+ * @brief Debounce card detect and step the storage state machine.
+ *
+ * A removed card, or one not answering (CMD13) after logger write errors, is
+ * released without being accessed and the logger suspended (records buffered
+ * in RAM). An inserted card is mounted and logging restarted, the buffered
+ * records written first. Never halts: failures are retried with a backoff.
+ * Intended to run as a STORAGE_PROCESS_PERIOD_MS scheduler task.
+ */
+void storage_process(void);
+
+/**
+ * @brief Flush and close the flight log, then unmount the card (blocking).
+ */
+void storage_deinit(void);
+
+/**
+ * @brief Get the storage manager statistics.
+ *
+ * @return Pointer to the live statistics.
+ */
+const storage_stats_t *storage_get_stats(void);
+
+#endif
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * @file systime.h
+ * @brief System time: 64-bit monotonic 1 us time base shared by all modules.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__SYSTIME_H
+#define NERVE__SYSTIME_H
+
+/** Includes. *****************************************************************/
+
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_hal_tim.h"
+
+/** STM32 port and pin configs. ***********************************************/
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim5;
+
+// Free running 32-bit 1 us timer, low word (TRGO on overflow). PSC 89 on the
+// 90 MHz APB1 timer clock, checked by systime_init.
+#define SYSTIME_HTIM htim2
+
+// 32-bit timer clocked by SYSTIME_HTIM overflows (slave, external clock mode 1
+// on ITR0 = TIM2 TRGO), high word.
+#define SYSTIME_HIGH_HTIM htim5
+
+/** Definitions. **************************************************************/
+
+#define SYSTIME_TICK_HZ 1000000U // Low word count rate (1 us).
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Start the time base from 0, cascading the two 32-bit timers.
+ *
+ * Also enables the DWT cycle counter (cycle profiling). Must run before any
+ * other module reads the time. Halts (Error_Handler) if the SYSTIME_HTIM clock
+ * and prescaler do not give SYSTIME_TICK_HZ.
+ */
+void systime_init(void);
+
+/**
+ * @brief Get the system time.
+ *
+ * Lock-free and safe in interrupts (timer registers only, no shared state).
+ *
+ * @return Monotonic time since systime_init (us), never wraps.
+ */
+uint64_t systime_us(void);
+
+/**
+ * @brief Get the low 32 bits of the system time (one register read).
+ *
+ * For intervals (unsigned difference) and 32-bit timestamps (CAN, log
+ * records), same time base as systime_us.
+ *
+ * @return Time (us), wraps every 2^32 us (~71 minutes).
+ */
+uint32_t systime_us32(void);
+
+#endif
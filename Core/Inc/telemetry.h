@@ -7,18 +7,57 @@
 #ifndef NERVE__TELEMETRY_H
 #define NERVE__TELEMETRY_H
 
+/** Includes. *****************************************************************/
+
+#include "stm32f4xx_hal.h"
+
+/** Definitions. **************************************************************/
+
+// CAN TX scheduler task period (ms), the DBC phase offset resolution.
+#define TELEMETRY_CAN_TICK_MS 1
+
+// XBee telemetry task period (ms) and payload size (bytes), whole DBC frames.
+#define TELEMETRY_XBEE_PERIOD_MS 50
+#define TELEMETRY_XBEE_PAYLOAD_SIZE 96
+
+/** Public variables. *********************************************************/
+
+// DWT cycles spent encoding and queueing one telemetry CAN message.
+extern uint32_t telemetry_can_tx_cycles_last;
+extern uint32_t telemetry_can_tx_cycles_max;
+
 /** Public functions. *********************************************************/
 
-void can_tx_state(void);
-void can_tx_barometric(void);
-void can_tx_gps1(void);
-void can_tx_gps2(void);
-void can_tx_gps3(void);
-void can_tx_imu1(void);
-void can_tx_imu2(void);
-void can_tx_imu3(void);
-void can_tx_imu4(void);
-void can_tx_imu5(void);
-void can_tx_rtc(void);
+/**
+ * @brief Initialize the CAN TX scheduler phase offsets from the DBC.
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Encode and transmit one telemetry message immediately.
+ *
+ * @param message_index DBC message index (DBC_MESSAGE_*).
+ */
+void can_tx_telemetry(uint8_t message_index);
+
+/**
+ * @brief CAN TX scheduler, transmit all due telemetry messages.
+ *
+ * Cyclic messages are sent every DBC GenMsgCycleTime at their phase offset,
+ * on-change messages when their encoded data changes, at most once per
+ * GenMsgDelayTime. Runs as a scheduler task every TELEMETRY_CAN_TICK_MS.
+ */
+void can_tx_telemetry_due(void);
+
+/**
+ * @brief Transmit the next telemetry messages over XBee (binary).
+ *
+ * The telemetry messages are DBC encoded as on CAN and sent in turn, as many
+ * as fit TELEMETRY_XBEE_PAYLOAD_SIZE. Each is a 16-bit little endian header
+ * (standard ID bits 0-10, DLC bits 12-15) then its DLC payload bytes, so the
+ * ground station decodes with the same DBC. Runs as a scheduler task every
+ * TELEMETRY_XBEE_PERIOD_MS.
+ */
+void xbee_tx_telemetry(void);
 
 #endif
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * @file time_sync.h
+ * @brief Two-step CAN time synchronization master.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__TIME_SYNC_H
+#define NERVE__TIME_SYNC_H
+
+/** Includes. *****************************************************************/
+
+#include "stm32f4xx_hal.h"
+
+/** Definitions. **************************************************************/
+
+#define TIME_SYNC_CAN_HANDLE hcan1 // CAN bus the time sync is mastered on.
+
+#define TIME_SYNC_TICK_MS 1 // time_sync_process task period (ms).
+
+// Multiplexer (time_sync_type) values.
+#define TIME_SYNC_TYPE_SYNC 0      // SYNC, coarse time when queued.
+#define TIME_SYNC_TYPE_FOLLOW_UP 1 // FOLLOW_UP, SYNC transmit time.
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Struct holding time sync statistics.
+ */
+typedef struct {
+  uint32_t syncs;         // SYNC frames queued.
+  uint32_t follow_ups;    // FOLLOW_UP frames queued.
+  uint32_t missed;        // SYNC frames not transmitted within a period.
+  uint32_t last_sync_us;  // Transmit time of the last SYNC (can_time_us).
+  uint32_t tx_latency_us; // Last SYNC queue to transmit latency (us).
+} time_sync_stats_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Initialize the time sync schedule from the DBC message attributes.
+ */
+void time_sync_init(void);
+
+/**
+ * @brief Send SYNC on its DBC cycle time and FOLLOW_UP once SYNC was sent.
+ *
+ * Intended to run as a TIME_SYNC_TICK_MS scheduler task.
+ */
+void time_sync_process(void);
+
+/**
+ * @brief Get the time sync statistics.
+ *
+ * @return Pointer to the live statistics.
+ */
+const time_sync_stats_t *time_sync_get_stats(void);
+
+#endif
@@ -73,6 +73,8 @@ typedef struct {
   uint8_t hour;       // RTC time, hour from GPS satellite.
   uint8_t minute;     // RTC time, minute from GPS satellite.
   uint8_t second;     // RTC time, second from GPS satellite.
+  // UTC time, millisecond from GPS satellite (0 at whole second epochs).
+  uint16_t millisecond;
   float latitude;     // Latitude in decimal degrees.
   char lat_dir;       // Latitude direction (N/S).
   float longitude;    // Longitude in decimal degrees.
@@ -87,6 +89,16 @@ typedef struct {
   float hdop;         // Horizontal Dilution of Precision (HDOP).
 } ublox_data_t;
 
+/**
+ * @brief Enumeration for the ublox_parse_nmea results.
+ */
+typedef enum {
+  UBLOX_SENTENCE_IGNORED = 0, // Not GNGGA or GNRMC.
+  UBLOX_SENTENCE_INVALID,     // Checksum or field error, data partial.
+  UBLOX_SENTENCE_GGA,         // GNGGA parsed into data.
+  UBLOX_SENTENCE_RMC          // GNRMC parsed into data.
+} ublox_sentence_t;
+
 /** Public variables. *********************************************************/
 
 extern ublox_data_t gps_data;
@@ -98,6 +110,31 @@ void USART2_IRQHandler_ublox(UART_HandleTypeDef *huart);
 
 /** Public functions. *********************************************************/
 
+/**
+ * @brief Parse one NMEA sentence into GPS data only (GNGGA and GNRMC).
+ *
+ * No logging, telemetry or GNSS time sync point (ublox_parse_sentence), so
+ * sentences can be replayed into a local ublox_data_t (fpu_bench.h).
+ *
+ * @param sentence Null-terminated NMEA sentence, '$' to the line end.
+ * @param data GPS data to update, partially updated on invalid sentences.
+ *
+ * @return Sentence type parsed, or why not.
+ */
+ublox_sentence_t ublox_parse_nmea(const char *sentence, ublox_data_t *data);
+
+/**
+ * @brief Parse one received NMEA sentence and apply it.
+ *
+ * Called by the UART interrupt for each received sentence: ublox_parse_nmea,
+ * then logs the GPS data, reports GNRMC epochs to the GNSS time and sends the
+ * GPS telemetry (NERVE_DEBUG_FULL_CAN_TELEMETRY). Invalid sentences raise the
+ * GPS fault.
+ *
+ * @param sentence Null-terminated NMEA sentence, '$' to the line end.
+ */
+void ublox_parse_sentence(const char *sentence);
+
 /**
  * @brief Initialize the u-blox module.
  */
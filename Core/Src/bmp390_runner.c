@@ -7,9 +7,11 @@
 /** Includes. *****************************************************************/
 
 #include "bmp390_runner.h"
+#include "logger.h"
 
 #include "configuration.h"
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
+#include "can_nerve.h"
 #include "telemetry.h"
 #endif
 
@@ -154,8 +156,11 @@ void bmp390_get_data(void) {
         bmp390_temperature = temperature_sum / (float)fifo.parsed_frames;
         bmp390_pressure = pressure_sum / (float)fifo.parsed_frames;
 
+        const log_barometric_t record = {bmp390_pressure, bmp390_temperature};
+        logger_write(LOG_RECORD_BAROMETRIC, &record, sizeof(record));
+
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-        can_tx_barometric();
+        can_tx_telemetry(DBC_MESSAGE_BAROMETRIC);
 #endif
 
         if (status.intr.fifo_full == BMP3_ENABLE) {
@@ -7,6 +7,7 @@
 /** Includes. *****************************************************************/
 
 #include "bmp3_hal_i2c.h"
+#include "systime.h"
 #include <stdint.h>
 #include <stdio.h>
 
@@ -14,17 +15,6 @@
 
 static uint8_t device_address; // Device I2C address.
 
-/** Private functions. ********************************************************/
-
-/**
- * @brief Get the current time in us.
- *
- * TODO: NOTE: Currently, no timer overflow handling!
- */
-static uint32_t bmp3_time_now_us(void) {
-  return __HAL_TIM_GET_COUNTER(&BMP3_HTIM);
-}
-
 /** Public functions. *********************************************************/
 
 BMP3_INTF_RET_TYPE bmp3_interface_init(struct bmp3_dev *bmp3, uint8_t intf) {
@@ -41,9 +31,6 @@ BMP3_INTF_RET_TYPE bmp3_interface_init(struct bmp3_dev *bmp3, uint8_t intf) {
       return BMP3_ERR_FATAL;
     }
 
-    // Start hardware (timer).
-    HAL_TIM_Base_Start(&BMP3_HTIM);
-
     bmp3->delay_us = bmp3_delay_us;
     bmp3->intf_ptr = &device_address;
 
@@ -91,9 +78,9 @@ BMP3_INTF_RET_TYPE bmp3_i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
 void bmp3_delay_us(uint32_t period, void *intf_ptr) {
   (void)intf_ptr;
 
-  volatile uint32_t now = bmp3_time_now_us();
+  volatile uint32_t now = systime_us32();
   const uint32_t start = now;
   while ((now - start) < period) {
-    now = bmp3_time_now_us();
+    now = systime_us32();
   }
 }
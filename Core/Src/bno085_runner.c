@@ -10,9 +10,11 @@
 /** Includes. *****************************************************************/
 
 #include "bno085_runner.h"
+#include "logger.h"
 
 #include "configuration.h"
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
+#include "can_nerve.h"
 #include "telemetry.h"
 #endif
 
@@ -135,6 +137,15 @@ static void general_event_handler(void *cookie, sh2_AsyncEvent_t *pEvent) {
   }
 }
 
+/**
+ * @brief Log a 3 axis vector sensor report at its sample time.
+ */
+static void log_vector3(log_record_type_t type, float x, float y, float z,
+                        uint32_t timestamp_us) {
+  const log_vector3_t record = {x, y, z};
+  logger_write_at(type, &record, sizeof(record), timestamp_us);
+}
+
 /**
  * @brief Handle sensor events from the sensor hub.
  */
@@ -149,8 +160,9 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     return;
   }
 
-  // Get HAL associated SH2 timer value via:
-  // double timestamp_sec = (double)value.timestamp / 1000000.0;
+  // Sample time: INTN system time less the sensor reported delay, its low 32
+  // bits are systime_us32 (sh2_hal_spi.c).
+  const uint32_t timestamp_us = (uint32_t)value.timestamp;
 
   switch (value.sensorId) {
   case SH2_ROTATION_VECTOR:
@@ -162,8 +174,15 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     bno085_quaternion_accuracy_deg =
         value.un.rotationVector.accuracy * (float)RAD_TO_DEG;
 
+    const log_imu_quaternion_t quaternion = {
+        bno085_quaternion_i, bno085_quaternion_j, bno085_quaternion_k,
+        bno085_quaternion_real, bno085_quaternion_accuracy_rad};
+    logger_write_at(LOG_RECORD_IMU_QUATERNION, &quaternion, sizeof(quaternion),
+                    timestamp_us);
+
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-    can_tx_imu1();
+    can_tx_telemetry(DBC_MESSAGE_IMU1);
+    can_tx_telemetry(DBC_MESSAGE_IMU6);
 #endif
 
     break;
@@ -171,9 +190,11 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     bno085_gyro_x = value.un.gyroscope.x;
     bno085_gyro_y = value.un.gyroscope.y;
     bno085_gyro_z = value.un.gyroscope.z;
+    log_vector3(LOG_RECORD_IMU_GYRO, bno085_gyro_x, bno085_gyro_y,
+                bno085_gyro_z, timestamp_us);
 
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-    can_tx_imu2();
+    can_tx_telemetry(DBC_MESSAGE_IMU2);
 #endif
 
     break;
@@ -181,9 +202,11 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     bno085_accel_x = value.un.accelerometer.x;
     bno085_accel_y = value.un.accelerometer.y;
     bno085_accel_z = value.un.accelerometer.z;
+    log_vector3(LOG_RECORD_IMU_ACCEL, bno085_accel_x, bno085_accel_y,
+                bno085_accel_z, timestamp_us);
 
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-    can_tx_imu3();
+    can_tx_telemetry(DBC_MESSAGE_IMU3);
 #endif
 
     break;
@@ -191,9 +214,11 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     bno085_lin_accel_x = value.un.linearAcceleration.x;
     bno085_lin_accel_y = value.un.linearAcceleration.y;
     bno085_lin_accel_z = value.un.linearAcceleration.z;
+    log_vector3(LOG_RECORD_IMU_LIN_ACCEL, bno085_lin_accel_x,
+                bno085_lin_accel_y, bno085_lin_accel_z, timestamp_us);
 
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-    can_tx_imu4();
+    can_tx_telemetry(DBC_MESSAGE_IMU4);
 #endif
 
     break;
@@ -201,9 +226,11 @@ static void sensor_report_handler(void *cookie, sh2_SensorEvent_t *pEvent) {
     bno085_gravity_x = value.un.gravity.x;
     bno085_gravity_y = value.un.gravity.y;
     bno085_gravity_z = value.un.gravity.z;
+    log_vector3(LOG_RECORD_IMU_GRAVITY, bno085_gravity_x, bno085_gravity_y,
+                bno085_gravity_z, timestamp_us);
 
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-    can_tx_imu5();
+    can_tx_telemetry(DBC_MESSAGE_IMU5);
 #endif
 
     break;
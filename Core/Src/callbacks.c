@@ -40,3 +40,31 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan) {
 void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan) {
   HAL_CAN_RxFifo1MsgPendingCallback_can(hcan);
 }
+
+void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox0CompleteCallback_can(hcan);
+}
+
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox1CompleteCallback_can(hcan);
+}
+
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox2CompleteCallback_can(hcan);
+}
+
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox0AbortCallback_can(hcan);
+}
+
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox1AbortCallback_can(hcan);
+}
+
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_TxMailbox2AbortCallback_can(hcan);
+}
+
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_ErrorCallback_can(hcan);
+}
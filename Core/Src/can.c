@@ -9,14 +9,111 @@
 #include "can.h"
 #include "can_nerve.h"
 #include "diagnostics.h"
-#include "math.h"
+#include "logger.h"
+#include "systime.h"
+#include <string.h>
+
+#include "configuration.h"
+
+/** Definitions. **************************************************************/
+
+#if (CAN_RX_RING_SIZE & (CAN_RX_RING_SIZE - 1)) != 0
+#error "CAN_RX_RING_SIZE must be a power of 2."
+#endif
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Struct holding a queued CAN TX frame.
+ */
+typedef struct {
+  uint32_t std_id;     // Standard CAN ID, lower ID is higher priority.
+  uint32_t sequence;   // Queue order to keep FIFO order for equal IDs.
+  uint32_t enqueue_us; // can_time_us when queued (latency tracking).
+  uint8_t dlc;         // Data Length Code.
+  uint8_t data[8];     // Payload.
+} can_tx_frame_t;
+
+/**
+ * @brief Struct holding the software TX queue state of one CAN bus.
+ *
+ * The queue is a binary min-heap ordered by (std_id, sequence). Frames loaded
+ * into hardware mailboxes are shadowed so aborted frames can be requeued.
+ */
+typedef struct {
+  can_tx_frame_t heap[CAN_TX_QUEUE_SIZE];       // Pending frames.
+  uint16_t count;                               // Pending frame count.
+  uint32_t sequence;                            // Next sequence number.
+  can_tx_frame_t mailbox[CAN_TX_MAILBOX_COUNT]; // Frames in TX mailboxes.
+  uint8_t mailbox_used;                         // Bitmask of used mailboxes.
+  uint8_t mailbox_aborting;                     // Bitmask of aborts pending.
+  can_tx_stats_t stats;                         // Statistics.
+} can_tx_queue_t;
+
+/**
+ * @brief Struct holding a received CAN frame deferred to thread context.
+ */
+typedef struct {
+  CAN_RxHeaderTypeDef header; // Received header, Timestamp is can_time_us.
+  uint8_t data[8];            // Received payload.
+  uint8_t bus;                // Bus index, 0: CAN1, 1: CAN2.
+} can_rx_frame_t;
+
+/**
+ * @brief Struct holding the monitor state of one CAN bus.
+ *
+ * Frame and bit counters are written by the TX and RX interrupts only, the
+ * window snapshots and status by can_monitor_update only.
+ */
+typedef struct {
+  uint32_t tx_frames;        // Frames transmitted (interrupt counter).
+  uint32_t rx_frames;        // Frames received (interrupt counter).
+  uint32_t bits;             // Estimated TX and RX bits (interrupt counter).
+  uint32_t window_start_ms;  // Current measurement window start.
+  uint32_t window_tx_frames; // tx_frames at the window start.
+  uint32_t window_rx_frames; // rx_frames at the window start.
+  uint32_t window_bits;      // bits at the window start.
+  uint32_t bitrate;          // Nominal bitrate (bit/s) from the bit timing.
+  uint8_t bus_off;           // Bus-off state seen on the previous update.
+  uint32_t bus_off_ms;       // Time of the last bus-off event.
+  uint32_t recover_at_ms;    // Time of the next bus-off recovery attempt.
+  uint32_t last_rx_frames;   // rx_frames on the previous update.
+  uint32_t last_rx_ms;       // Time RX frames were last seen.
+  uint32_t fail_ms;          // Time of the last bus failure (redundancy).
+  can_bus_status_t status;   // Published status.
+} can_monitor_t;
+
+/**
+ * @brief Struct holding the last accepted copy of a mirrored RX message.
+ */
+typedef struct {
+  uint32_t std_id;       // Standard CAN ID.
+  uint32_t timestamp_us; // can_time_us of the accepted copy.
+  uint8_t used;          // Copy not yet paired with its mirror.
+  uint8_t bus;           // Bus index the copy was received on.
+  uint8_t dlc;           // Data Length Code.
+  uint8_t data[8];       // Payload.
+} can_rx_dedup_slot_t;
 
 /** Private variables. ********************************************************/
 
-// Transmit variables.
-CAN_TxHeaderTypeDef tx_header;
-uint8_t tx_buffer[8];
-uint32_t tx_mailbox;
+static CAN_HandleTypeDef *const buses[2] = {&hcan1, &hcan2};
+static can_monitor_t monitors[2]; // Index 0: CAN1, index 1: CAN2.
+
+// Dual bus redundancy (NERVE_CAN_REDUNDANCY).
+static can_redundancy_stats_t redundancy = {.bus_ok = {1, 1}};
+#ifdef NERVE_CAN_REDUNDANCY
+static can_rx_dedup_slot_t rx_dedup[CAN_REDUNDANCY_RX_SLOTS];
+static uint8_t rx_dedup_next = 0; // Next slot to evict.
+#endif
+
+static can_tx_queue_t tx_queues[2]; // Index 0: CAN1, index 1: CAN2.
+
+// Single producer (RX interrupts, same NVIC priority) single consumer ring.
+static can_rx_frame_t rx_ring[CAN_RX_RING_SIZE];
+static volatile uint32_t rx_ring_head = 0; // Written by RX interrupts only.
+static volatile uint32_t rx_ring_tail = 0; // Written by can_rx_process only.
+static can_rx_stats_t rx_stats = {0};
 
 /** Private functions. ********************************************************/
 
@@ -53,6 +150,49 @@ void process_can_message(CAN_RxHeaderTypeDef *header, uint8_t *data) {
   }
 }
 
+/**
+ * @brief Payload bit position (byte * 8 + bit) of a signal bit.
+ *
+ * Bit 0 is the least significant bit of the raw value. Intel signals count up
+ * from start_bit (the LSB). Motorola signals start at start_bit (the MSB) and
+ * continue from bit 0 of a byte to bit 7 of the next byte (DBC sawtooth).
+ *
+ * @param signal Pointer to the CAN signal configuration.
+ * @param bit Raw value bit index.
+ *
+ * @return Payload bit position.
+ */
+static inline uint32_t signal_bit_position(const can_signal_t *signal,
+                                           uint32_t bit) {
+  if (signal->byte_order == CAN_LITTLE_ENDIAN) {
+    return signal->start_bit + bit;
+  }
+
+  // Motorola: walk a big endian (MSB first) linear numbering.
+  const uint32_t start = signal->start_bit;
+  const uint32_t linear = (start / 8) * 8 + (7 - start % 8) +
+                          (signal->bit_length - 1 - bit);
+  return (linear / 8) * 8 + (7 - linear % 8);
+}
+
+int64_t can_signal_raw(const can_signal_t *signal, const uint8_t *data) {
+  uint64_t raw_value = 0;
+
+  // Extract raw bits from the CAN message payload.
+  for (uint32_t bit = 0; bit < signal->bit_length; bit++) {
+    const uint32_t bit_pos = signal_bit_position(signal, bit);
+    raw_value |= (uint64_t)((data[bit_pos / 8] >> (bit_pos % 8)) & 0x1U) << bit;
+  }
+
+  // Sign extend two's complement values.
+  if (signal->is_signed && signal->bit_length < 64 &&
+      (raw_value >> (signal->bit_length - 1)) & 0x1U) {
+    raw_value |= ~0ULL << signal->bit_length;
+  }
+
+  return (int64_t)raw_value;
+}
+
 /**
  * @brief Extract a signal value from a CAN message payload.
  *
@@ -66,25 +206,24 @@ void process_can_message(CAN_RxHeaderTypeDef *header, uint8_t *data) {
  * @return The decoded physical signal value.
  */
 float decode_signal(const can_signal_t *signal, const uint8_t *data) {
-  uint64_t raw_value = 0;
-
-  // Extract raw bits from the CAN message payload.
-  for (int i = 0; i < signal->bit_length; i++) {
-    int bit_position = signal->start_bit + i;
-    int byte_index = bit_position / 8;
-    int bit_index = bit_position % 8;
+  const int64_t raw_value = can_signal_raw(signal, data);
+  float value;
 
-    // Use the enumerated constant for byte order.
-    if (signal->byte_order == CAN_BIG_ENDIAN) {
-      raw_value |= ((data[byte_index] >> (7 - bit_index)) & 0x1)
-                   << (signal->bit_length - 1 - i);
-    } else { // CAN_LITTLE_ENDIAN.
-      raw_value |= ((data[byte_index] >> bit_index) & 0x1) << i;
-    }
+  if (signal->value_type == CAN_VALUE_FLOAT32) {
+    const uint32_t bits = (uint32_t)raw_value;
+    memcpy(&value, &bits, sizeof(value));
+  } else if (signal->value_type == CAN_VALUE_FLOAT64) {
+    double wide;
+    memcpy(&wide, &raw_value, sizeof(wide));
+    value = (float)wide;
+  } else if (signal->is_signed) {
+    value = (float)raw_value;
+  } else {
+    value = (float)(uint64_t)raw_value;
   }
 
   // Convert raw value to physical value by applying scale and offset.
-  return ((float)raw_value * signal->scale) + signal->offset;
+  return (value * signal->scale) + signal->offset;
 }
 
 /**
@@ -96,48 +235,535 @@ float decode_signal(const can_signal_t *signal, const uint8_t *data) {
  */
 static void pack_signal_raw32(const can_signal_t *signal, uint8_t *data,
                               uint32_t raw_value) {
-  // Mask off any bits above bit_length.
-  if (signal->bit_length < 32) {
-    raw_value &= ((1UL << signal->bit_length) - 1UL);
-  }
+  // Signals wider than 32 bits are sign or zero extended.
+  const uint32_t fill = (signal->is_signed && (raw_value >> 31)) ? 1U : 0U;
 
   // Pack each bit into data[].
   for (uint32_t bit = 0; bit < signal->bit_length; ++bit) {
-    // Determine the absolute bit position in the 64‑bit CAN payload.
-    uint32_t bit_pos = (signal->byte_order == CAN_LITTLE_ENDIAN)
-                           ? (signal->start_bit + bit)  // Intel/little‑endian.
-                           : (signal->start_bit - bit); // Motorola/big‑endian.
+    const uint32_t bit_pos = signal_bit_position(signal, bit);
+    const uint8_t raw_bit = bit < 32 ? (raw_value >> bit) & 0x1U : fill;
+    data[bit_pos / 8] |= (uint8_t)(raw_bit << (bit_pos % 8));
+  }
+}
+
+/**
+ * @brief Convert a normalized (raw units) value to the raw signal encoding.
+ *
+ * Single precision only (FPv4-SP hardware), rounds half away from zero.
+ *
+ * @param normalized Value after offset and scale removal.
+ * @param signal Pointer to the signal definition.
+ *
+ * @return Raw uint32_t data (two's complement or IEEE 754 if configured).
+ */
+static uint32_t normalized_to_raw(float normalized,
+                                  const can_signal_t *signal) {
+  if (signal->value_type == CAN_VALUE_FLOAT32) {
+    uint32_t bits;
+    memcpy(&bits, &normalized, sizeof(bits));
+    return bits;
+  }
+  if (signal->is_signed) {
+    return (uint32_t)(int32_t)(normalized +
+                               (normalized < 0.0f ? -0.5f : 0.5f));
+  }
+  if (normalized <= 0.0f) {
+    return 0;
+  }
+  return (uint32_t)(normalized + 0.5f);
+}
+
+/**
+ * @brief Get the TX queue of a CAN bus.
+ */
+static can_tx_queue_t *tx_queue_of(const CAN_HandleTypeDef *hcan) {
+  return (hcan->Instance == CAN2) ? &tx_queues[1] : &tx_queues[0];
+}
+
+/**
+ * @brief Log a received or transmitted frame.
+ */
+static void log_frame(const CAN_HandleTypeDef *hcan, uint8_t tx,
+                      uint32_t std_id, uint8_t dlc, const uint8_t *data,
+                      uint32_t timestamp_us) {
+  log_can_frame_t record = {.std_id = (uint16_t)std_id, .dlc = dlc};
+
+  record.flags = (hcan->Instance == CAN2) ? LOG_CAN_FLAG_CAN2 : 0;
+  record.flags |= tx ? LOG_CAN_FLAG_TX : 0;
+  memcpy(record.data, data, dlc > 8 ? 8 : dlc);
+  logger_write_at(LOG_RECORD_CAN_FRAME, &record, sizeof(record), timestamp_us);
+}
+
+/**
+ * @brief Get the monitor of a CAN bus.
+ */
+static can_monitor_t *monitor_of(const CAN_HandleTypeDef *hcan) {
+  return (hcan->Instance == CAN2) ? &monitors[1] : &monitors[0];
+}
+
+/**
+ * @brief Worst case length of a standard data frame including bit stuffing.
+ *
+ * SOF through CRC (34 + 8 * DLC bits) are subject to stuffing, 1 stuff bit per
+ * 4 bits worst case, followed by 13 unstuffed bits (CRC delimiter, ACK, EOF and
+ * interframe space). Must match frame_bits in generate_can_defs.py.
+ */
+static inline uint32_t frame_bits(uint8_t dlc) {
+  const uint32_t stuffed = 34U + 8U * dlc;
+  return stuffed + (stuffed - 1U) / 4U + 13U;
+}
+
+/**
+ * @brief Nominal bitrate of a CAN bus from its bit timing configuration.
+ */
+static uint32_t bitrate_of(const CAN_HandleTypeDef *hcan) {
+  const uint32_t tq_per_bit =
+      1U + ((hcan->Init.TimeSeg1 >> CAN_BTR_TS1_Pos) + 1U) +
+      ((hcan->Init.TimeSeg2 >> CAN_BTR_TS2_Pos) + 1U);
+  return HAL_RCC_GetPCLK1Freq() / (hcan->Init.Prescaler * tq_per_bit);
+}
+
+/**
+ * @brief Restart a CAN bus controller to leave bus-off.
+ *
+ * Pending mailboxes are aborted (and requeued by the abort callbacks), the
+ * controller then rejoins after 128 occurrences of 11 recessive bits.
+ */
+static void bus_off_recover(CAN_HandleTypeDef *hcan) {
+  HAL_CAN_AbortTxRequest(hcan, CAN_TX_MAILBOX0 | CAN_TX_MAILBOX1 |
+                                   CAN_TX_MAILBOX2);
+  HAL_CAN_Stop(hcan);
+  HAL_CAN_Start(hcan);
+}
+
+/**
+ * @brief Update the monitor of one CAN bus.
+ */
+static void monitor_update(CAN_HandleTypeDef *hcan, uint32_t now_ms) {
+  can_monitor_t *m = monitor_of(hcan);
+  can_bus_status_t *status = &m->status;
+  const uint32_t esr = hcan->Instance->ESR;
+  const uint8_t lec = (uint8_t)((esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos);
+
+  // Error counters, state and last error code (7 is software set, unused).
+  status->tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+  status->rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+  if (lec != 0 && lec != 7) {
+    status->last_error_code = lec;
+  }
+  if (esr & CAN_ESR_BOFF) {
+    status->error_state = CAN_BUS_OFF;
+  } else if (esr & CAN_ESR_EPVF) {
+    status->error_state = CAN_ERROR_PASSIVE;
+  } else if (esr & CAN_ESR_EWGF) {
+    status->error_state = CAN_ERROR_WARNING;
+  } else {
+    status->error_state = CAN_ERROR_ACTIVE;
+  }
 
-    uint32_t byte_index = bit_pos / 8;
-    uint32_t bit_index = bit_pos % 8;
+  // Bus-off recovery with exponential backoff.
+  if (status->error_state == CAN_BUS_OFF) {
+    if (!m->bus_off) {
+      m->bus_off = 1;
+      m->bus_off_ms = now_ms;
+      m->recover_at_ms = now_ms + status->recovery_backoff_ms;
+      status->bus_off_count++;
+      can_fault();
+    } else if ((int32_t)(now_ms - m->recover_at_ms) >= 0) {
+      bus_off_recover(hcan);
+      m->bus_off = 0;
+      if (status->recovery_backoff_ms < CAN_BUS_OFF_BACKOFF_MAX_MS / 2) {
+        status->recovery_backoff_ms *= 2;
+      } else {
+        status->recovery_backoff_ms = CAN_BUS_OFF_BACKOFF_MAX_MS;
+      }
+    }
+  } else if (now_ms - m->bus_off_ms >= CAN_BUS_OFF_STABLE_MS) {
+    status->recovery_backoff_ms = CAN_BUS_OFF_BACKOFF_MIN_MS;
+  }
+
+  // Frame rates and bus load over the measurement window.
+  const uint32_t elapsed_ms = now_ms - m->window_start_ms;
+  if (elapsed_ms >= CAN_MONITOR_WINDOW_MS) {
+    const uint32_t tx_frames = m->tx_frames;
+    const uint32_t rx_frames = m->rx_frames;
+    const uint32_t bits = m->bits;
 
-    // Extract the next raw bit, then OR it into the right place.
-    uint8_t raw_bit = (raw_value >> bit) & 0x1U;
-    data[byte_index] |= (raw_bit << bit_index);
+    status->tx_fps =
+        (uint16_t)((tx_frames - m->window_tx_frames) * 1000U / elapsed_ms);
+    status->rx_fps =
+        (uint16_t)((rx_frames - m->window_rx_frames) * 1000U / elapsed_ms);
+    status->bus_load_percent = (float)(bits - m->window_bits) * 100000.0f /
+                               ((float)m->bitrate * (float)elapsed_ms);
+
+    m->window_start_ms = now_ms;
+    m->window_tx_frames = tx_frames;
+    m->window_rx_frames = rx_frames;
+    m->window_bits = bits;
   }
 }
 
-/** User implementations of STM32 CAN NVIC HAL (overwriting HAL). *************/
+/**
+ * @brief CAN TX frame priority compare, true if a is sent before b.
+ */
+static inline int tx_frame_before(const can_tx_frame_t *a,
+                                  const can_tx_frame_t *b) {
+  if (a->std_id != b->std_id) {
+    return a->std_id < b->std_id;
+  }
+  return (int32_t)(a->sequence - b->sequence) < 0;
+}
 
-void HAL_CAN_RxFifo0MsgPendingCallback_can(CAN_HandleTypeDef *hcan) {
-  CAN_RxHeaderTypeDef rx_header;
-  uint8_t rx_data[8];
+/**
+ * @brief Push a frame onto the TX heap (caller ensures space, IRQs masked).
+ */
+static void tx_heap_push(can_tx_queue_t *q, const can_tx_frame_t *frame) {
+  uint16_t i = q->count++;
+
+  // Sift up.
+  while (i > 0) {
+    uint16_t parent = (i - 1) / 2;
+    if (!tx_frame_before(frame, &q->heap[parent])) {
+      break;
+    }
+    q->heap[i] = q->heap[parent];
+    i = parent;
+  }
+  q->heap[i] = *frame;
+
+  if (q->count > q->stats.high_water) {
+    q->stats.high_water = q->count;
+  }
+}
+
+/**
+ * @brief Pop the highest priority frame off the TX heap (IRQs masked).
+ */
+static void tx_heap_pop(can_tx_queue_t *q, can_tx_frame_t *frame) {
+  *frame = q->heap[0];
+  const can_tx_frame_t last = q->heap[--q->count];
+  uint16_t i = 0;
+
+  // Sift down.
+  while (1) {
+    uint16_t child = 2 * i + 1;
+    if (child >= q->count) {
+      break;
+    }
+    if (child + 1 < q->count &&
+        tx_frame_before(&q->heap[child + 1], &q->heap[child])) {
+      child++;
+    }
+    if (!tx_frame_before(&q->heap[child], &last)) {
+      break;
+    }
+    q->heap[i] = q->heap[child];
+    i = child;
+  }
+  q->heap[i] = last;
+}
+
+/**
+ * @brief Move queued frames into free TX mailboxes (IRQs masked).
+ *
+ * If no mailbox is free and the next queued frame has a higher priority than
+ * the lowest priority pending mailbox, that mailbox is aborted. The abort
+ * callback then requeues its frame and refills the mailbox.
+ */
+static void tx_queue_fill(CAN_HandleTypeDef *hcan, can_tx_queue_t *q) {
+  CAN_TxHeaderTypeDef header = {.IDE = CAN_ID_STD, .RTR = CAN_RTR_DATA};
+  uint32_t mailbox_bit;
+
+  while (q->count > 0 && HAL_CAN_GetTxMailboxesFreeLevel(hcan) > 0) {
+    header.StdId = q->heap[0].std_id;
+    header.DLC = q->heap[0].dlc;
+    if (HAL_CAN_AddTxMessage(hcan, &header, q->heap[0].data, &mailbox_bit) !=
+        HAL_OK) {
+      break;
+    }
+    for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+      if (mailbox_bit == (CAN_TX_MAILBOX0 << m)) {
+        tx_heap_pop(q, &q->mailbox[m]);
+        q->mailbox_used |= (1U << m);
+        break;
+      }
+    }
+  }
+
+  if (q->count == 0 || q->mailbox_aborting != 0) {
+    return;
+  }
+
+  // Find the lowest priority pending mailbox.
+  int8_t lowest = -1;
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if ((q->mailbox_used & (1U << m)) &&
+        (lowest < 0 || tx_frame_before(&q->mailbox[lowest], &q->mailbox[m]))) {
+      lowest = (int8_t)m;
+    }
+  }
+  if (lowest >= 0 && q->heap[0].std_id < q->mailbox[lowest].std_id) {
+    q->mailbox_aborting |= (1U << lowest);
+    HAL_CAN_AbortTxRequest(hcan, CAN_TX_MAILBOX0 << lowest);
+  }
+}
+
+/**
+ * @brief Release a TX mailbox after completion, abort or error (in ISR).
+ *
+ * @param hcan CAN handle of the interrupting bus.
+ * @param m Mailbox index (0-2).
+ * @param sent Frame was transmitted successfully.
+ * @param requeue Frame was not transmitted and should be queued again.
+ */
+static void tx_mailbox_release(CAN_HandleTypeDef *hcan, uint8_t m,
+                               uint8_t sent, uint8_t requeue) {
+  can_tx_queue_t *q = tx_queue_of(hcan);
+  const uint8_t bit = (uint8_t)(1U << m);
+
+  if ((q->mailbox_used & bit) == 0) {
+    return; // Mailbox not loaded by the queue.
+  }
+  q->mailbox_used &= (uint8_t)~bit;
+  q->mailbox_aborting &= (uint8_t)~bit;
+
+  if (sent) {
+    const uint32_t timestamp_us = can_time_us();
+    can_tx_complete(hcan, q->mailbox[m].std_id, q->mailbox[m].data,
+                    timestamp_us);
+    log_frame(hcan, 1, q->mailbox[m].std_id, q->mailbox[m].dlc,
+              q->mailbox[m].data, timestamp_us);
+    const uint32_t latency_us = timestamp_us - q->mailbox[m].enqueue_us;
+    can_monitor_t *monitor = monitor_of(hcan);
+    q->stats.sent++;
+    q->stats.latency_last_us = latency_us;
+    monitor->tx_frames++;
+    monitor->bits += frame_bits(q->mailbox[m].dlc);
+    if (latency_us > q->stats.latency_max_us) {
+      q->stats.latency_max_us = latency_us;
+    }
+  } else if (requeue && q->count < CAN_TX_QUEUE_SIZE) {
+    q->stats.requeued++;
+    tx_heap_push(q, &q->mailbox[m]);
+  } else {
+    q->stats.dropped++;
+    can_fault();
+  }
+
+  tx_queue_fill(hcan, q);
+}
 
-  // Receive the CAN message.
-  if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &rx_header, rx_data) == HAL_OK) {
-    // Process the received message.
-    process_can_message(&rx_header, rx_data);
+/**
+ * @brief Drain all pending frames from both RX FIFOs into the RX ring (in ISR).
+ *
+ * FIFO0 holds the higher priority messages (see generated filter banks) and is
+ * drained first.
+ */
+static void rx_fifo_drain(CAN_HandleTypeDef *hcan) {
+  static const uint32_t fifos[2] = {CAN_RX_FIFO0, CAN_RX_FIFO1};
+  const uint32_t timestamp_us = can_time_us();
+  can_monitor_t *monitor = monitor_of(hcan);
+
+  for (uint8_t f = 0; f < 2; f++) {
+    while (HAL_CAN_GetRxFifoFillLevel(hcan, fifos[f]) > 0) {
+      const uint32_t head = rx_ring_head;
+      const uint32_t depth = head - rx_ring_tail;
+
+      if (depth >= CAN_RX_RING_SIZE) {
+        // Ring full, release the hardware FIFO entry and count the loss.
+        CAN_RxHeaderTypeDef discard_header;
+        uint8_t discard_data[8];
+        HAL_CAN_GetRxMessage(hcan, fifos[f], &discard_header, discard_data);
+        rx_stats.ring_overflow++;
+        monitor->rx_frames++;
+        monitor->bits += frame_bits((uint8_t)discard_header.DLC);
+        continue;
+      }
+
+      can_rx_frame_t *frame = &rx_ring[head & (CAN_RX_RING_SIZE - 1)];
+      if (HAL_CAN_GetRxMessage(hcan, fifos[f], &frame->header, frame->data) !=
+          HAL_OK) {
+        break;
+      }
+      frame->header.Timestamp = timestamp_us;
+      frame->bus = (hcan->Instance == CAN2) ? 1 : 0;
+      monitor->rx_frames++;
+      monitor->bits += frame_bits((uint8_t)frame->header.DLC);
+
+      // Publish the frame only after it is fully written.
+      __DMB();
+      rx_ring_head = head + 1;
+
+      rx_stats.received++;
+      if (depth + 1 > rx_stats.high_water) {
+        rx_stats.high_water = (uint16_t)(depth + 1);
+      }
+    }
+  }
+}
+
+#ifdef NERVE_CAN_REDUNDANCY
+/**
+ * @brief Update bus health and fail over the primary bus if it failed.
+ *
+ * A bus fails when bus-off, or when silent (no RX for CAN_REDUNDANCY_SILENT_MS)
+ * while the other bus is receiving. The primary bus stays on the other bus
+ * after recovery (no fail back) to avoid toggling on an intermittent fault.
+ */
+static void redundancy_update(uint32_t now_ms) {
+  for (uint8_t b = 0; b < 2; b++) {
+    can_monitor_t *m = &monitors[b];
+    const can_monitor_t *other = &monitors[b ^ 1U];
+    const uint32_t rx_frames = m->rx_frames;
+
+    if (rx_frames != m->last_rx_frames) {
+      m->last_rx_frames = rx_frames;
+      m->last_rx_ms = now_ms;
+    }
+
+    const uint8_t silent =
+        (now_ms - m->last_rx_ms >= CAN_REDUNDANCY_SILENT_MS) &&
+        (now_ms - other->last_rx_ms < CAN_REDUNDANCY_SILENT_MS);
+    const uint8_t bus_off = m->status.error_state == CAN_BUS_OFF;
+
+    if (!bus_off && !silent) {
+      redundancy.bus_ok[b] = 1;
+    } else if (redundancy.bus_ok[b]) {
+      redundancy.bus_ok[b] = 0;
+      m->fail_ms = bus_off ? m->bus_off_ms : m->last_rx_ms;
+    }
+  }
+
+  const uint8_t p = redundancy.primary_bus;
+  if (!redundancy.bus_ok[p] && redundancy.bus_ok[p ^ 1U]) {
+    const uint32_t failover_ms = now_ms - monitors[p].fail_ms;
+
+    redundancy.primary_bus = p ^ 1U;
+    redundancy.failovers++;
+    redundancy.failover_time_ms_last = failover_ms;
+    if (failover_ms > redundancy.failover_time_ms_max) {
+      redundancy.failover_time_ms_max = failover_ms;
+    }
   }
 }
 
+/**
+ * @brief Check if a received frame is the mirror copy of a redundant message.
+ *
+ * The first copy of a redundant message is accepted, an identical copy from
+ * the other bus within CAN_REDUNDANCY_DEDUP_US is a duplicate.
+ *
+ * @return 1 if the frame is a duplicate and must be dropped, otherwise 0.
+ */
+static uint8_t rx_is_duplicate(const can_rx_frame_t *frame) {
+  const uint32_t std_id = frame->header.StdId;
+  can_rx_dedup_slot_t *slot = 0;
+  uint8_t redundant = 0;
+
+  for (int i = 0; i < dbc_message_count; i++) {
+    if ((std_id & dbc_messages[i].id_mask) == dbc_messages[i].message_id &&
+        dbc_messages[i].redundant) {
+      redundant = 1;
+      break;
+    }
+  }
+  if (!redundant) {
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < CAN_REDUNDANCY_RX_SLOTS; i++) {
+    if (rx_dedup[i].std_id == std_id) {
+      slot = &rx_dedup[i];
+      break;
+    }
+  }
+
+  if (slot && slot->used && slot->bus != frame->bus &&
+      slot->dlc == frame->header.DLC &&
+      memcmp(slot->data, frame->data, slot->dlc) == 0) {
+    const uint32_t skew_us = frame->header.Timestamp - slot->timestamp_us;
+    if (skew_us < CAN_REDUNDANCY_DEDUP_US) {
+      slot->used = 0; // Paired, the next copy starts a new pair.
+      redundancy.duplicates++;
+      redundancy.skew_us_last = skew_us;
+      if (skew_us > redundancy.skew_us_max) {
+        redundancy.skew_us_max = skew_us;
+      }
+      return 1;
+    }
+  }
+
+  if (!slot) {
+    slot = &rx_dedup[rx_dedup_next];
+    rx_dedup_next = (rx_dedup_next + 1) % CAN_REDUNDANCY_RX_SLOTS;
+  }
+  slot->std_id = std_id;
+  slot->timestamp_us = frame->header.Timestamp;
+  slot->used = 1;
+  slot->bus = frame->bus;
+  slot->dlc = (uint8_t)frame->header.DLC;
+  memcpy(slot->data, frame->data, slot->dlc);
+  return 0;
+}
+#endif
+
+/** User implementations of STM32 CAN NVIC HAL (overwriting HAL). *************/
+
+void HAL_CAN_RxFifo0MsgPendingCallback_can(CAN_HandleTypeDef *hcan) {
+  rx_fifo_drain(hcan);
+}
+
 void HAL_CAN_RxFifo1MsgPendingCallback_can(CAN_HandleTypeDef *hcan) {
-  CAN_RxHeaderTypeDef rx_header;
-  uint8_t rx_data[8];
+  rx_fifo_drain(hcan);
+}
+
+void HAL_CAN_TxMailbox0CompleteCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 0, 1, 0);
+}
+
+void HAL_CAN_TxMailbox1CompleteCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 1, 1, 0);
+}
 
-  // Receive the CAN message.
-  if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO1, &rx_header, rx_data) == HAL_OK) {
-    // Process the received message.
-    process_can_message(&rx_header, rx_data);
+void HAL_CAN_TxMailbox2CompleteCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 2, 1, 0);
+}
+
+void HAL_CAN_TxMailbox0AbortCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 0, 0, 1);
+}
+
+void HAL_CAN_TxMailbox1AbortCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 1, 0, 1);
+}
+
+void HAL_CAN_TxMailbox2AbortCallback_can(CAN_HandleTypeDef *hcan) {
+  tx_mailbox_release(hcan, 2, 0, 1);
+}
+
+void HAL_CAN_ErrorCallback_can(CAN_HandleTypeDef *hcan) {
+  // Hardware RX FIFO overruns (a 4th frame arrived before draining).
+  if (hcan->ErrorCode & (HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1)) {
+    hcan->ErrorCode &= ~(HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1);
+    rx_stats.fifo_overrun++;
+    can_fault();
+  }
+
+  // Without automatic retransmission, lost arbitration and transmit errors
+  // complete the mailbox without a complete or abort callback.
+  static const uint32_t alst[CAN_TX_MAILBOX_COUNT] = {
+      HAL_CAN_ERROR_TX_ALST0, HAL_CAN_ERROR_TX_ALST1, HAL_CAN_ERROR_TX_ALST2};
+  static const uint32_t terr[CAN_TX_MAILBOX_COUNT] = {
+      HAL_CAN_ERROR_TX_TERR0, HAL_CAN_ERROR_TX_TERR1, HAL_CAN_ERROR_TX_TERR2};
+
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if (hcan->ErrorCode & alst[m]) {
+      hcan->ErrorCode &= ~alst[m];
+      tx_mailbox_release(hcan, m, 0, 1); // Lost arbitration, try again.
+    } else if (hcan->ErrorCode & terr[m]) {
+      hcan->ErrorCode &= ~terr[m];
+      tx_mailbox_release(hcan, m, 0, 0); // Transmit error, drop.
+    }
   }
 }
 
@@ -153,10 +779,8 @@ uint32_t uint_to_raw(uint32_t physical_value, const can_signal_t *signal) {
   // Normalize into raw units (cast to float just for the calculation).
   float normalized = ((float)physical_value - signal->offset) / signal->scale;
 
-  // Round to nearest uint32_t.
-  uint32_t raw = (uint32_t)roundf(normalized);
-
-  return raw;
+  // Round to nearest raw value.
+  return normalized_to_raw(normalized, signal);
 }
 
 uint32_t float_to_raw(float physical_value, const can_signal_t *signal) {
@@ -169,79 +793,282 @@ uint32_t float_to_raw(float physical_value, const can_signal_t *signal) {
   // Normalize into raw units.
   float normalized = (physical_value - signal->offset) / signal->scale;
 
-  // Round to nearest uint32_t.
-  uint32_t raw = (uint32_t)roundf(normalized);
-
-  return raw;
+  // Round to nearest raw value.
+  return normalized_to_raw(normalized, signal);
 }
 
 uint32_t double_to_raw(double physical_value, const can_signal_t *signal) {
   // Clamp physical value into [min, max].
-  if (physical_value < signal->min_value)
-    physical_value = signal->min_value;
-  if (physical_value > signal->max_value)
-    physical_value = signal->max_value;
+  if (physical_value < (double)signal->min_value)
+    physical_value = (double)signal->min_value;
+  if (physical_value > (double)signal->max_value)
+    physical_value = (double)signal->max_value;
 
-  // Normalize into raw units.
-  double normalized = (physical_value - signal->offset) / signal->scale;
+  // Normalize into raw units (double precision, software floating point).
+  double normalized =
+      (physical_value - (double)signal->offset) / (double)signal->scale;
+
+  // Round to nearest raw value, exact past the 24-bit float mantissa.
+  if (signal->value_type == CAN_VALUE_FLOAT32) {
+    return normalized_to_raw((float)normalized, signal);
+  }
+  if (signal->is_signed) {
+    return (uint32_t)(int32_t)(normalized + (normalized < 0.0 ? -0.5 : 0.5));
+  }
+  if (normalized <= 0.0) {
+    return 0;
+  }
+  return (uint32_t)(normalized + 0.5);
+}
 
-  // Round to nearest uint32_t.
-  uint32_t raw = (uint32_t)llround(normalized);
+uint8_t can_signal_present(const can_message_t *msg,
+                           const can_signal_t *signal, const uint8_t *data) {
+  if (signal->mux_type != CAN_MUX_MULTIPLEXED) {
+    return 1;
+  }
 
-  return raw;
+  for (uint8_t i = 0; i < msg->signal_count; i++) {
+    if (msg->signals[i].mux_type == CAN_MUX_SWITCH) {
+      return can_signal_raw(&msg->signals[i], data) == signal->mux_value;
+    }
+  }
+  return 0;
+}
+
+const char *can_signal_value_description(const can_signal_t *signal,
+                                         int32_t raw) {
+  for (uint8_t i = 0; i < signal->value_count; i++) {
+    if (signal->value_table[i].value == raw) {
+      return signal->value_table[i].description;
+    }
+  }
+  return 0;
+}
+
+uint32_t can_time_us(void) { return systime_us32(); }
+
+__weak void can_tx_complete(const CAN_HandleTypeDef *h_can_x, uint32_t std_id,
+                            const uint8_t *data, uint32_t timestamp_us) {
+  (void)h_can_x;
+  (void)std_id;
+  (void)data;
+  (void)timestamp_us;
 }
 
 void can_init(void) {
-  // Configure CAN bus filters.
+  // Configure CAN bus filters, generated from the DBC for RX messages only.
   CAN_FilterTypeDef can_filter_config;
 
   can_filter_config.FilterActivation = CAN_FILTER_ENABLE; // Enable the filter.
-  can_filter_config.FilterBank = 18; // Assign filter to bank 18.
-  can_filter_config.FilterFIFOAssignment = CAN_FILTER_FIFO0; // Use FIFO0.
-  // Set filter to accept all IDs.
+  // Use 16-bit filter scale (standard IDs, 4 IDs or 2 ID/mask pairs per bank).
+  can_filter_config.FilterScale = CAN_FILTERSCALE_16BIT;
+  // Filter bank config for dual CAN setups.
+  can_filter_config.SlaveStartFilterBank = CAN_FILTER_SLAVE_START_BANK;
+
+  for (int i = 0; i < dbc_filter_bank_count; i++) {
+    const can_filter_bank_t *bank = &dbc_filter_banks[i];
+
+    can_filter_config.FilterMode = bank->filter_mode;
+    can_filter_config.FilterFIFOAssignment = bank->filter_fifo;
+    can_filter_config.FilterIdHigh = bank->filter_id_high;
+    can_filter_config.FilterIdLow = bank->filter_id_low;
+    can_filter_config.FilterMaskIdHigh = bank->filter_mask_id_high;
+    can_filter_config.FilterMaskIdLow = bank->filter_mask_id_low;
+
+    // Apply the same filter settings to both CAN1 and CAN2 banks.
+    can_filter_config.FilterBank = i;
+    HAL_CAN_ConfigFilter(&hcan1, &can_filter_config);
+    can_filter_config.FilterBank = CAN_FILTER_SLAVE_START_BANK + i;
+    HAL_CAN_ConfigFilter(&hcan2, &can_filter_config);
+  }
+
+#ifdef NERVE_CAN_MONITOR_ACCEPT_ALL
+  // Accept all standard data frames into FIFO1 (after the generated banks) so
+  // the monitor bus load covers all bus traffic, not only received messages.
+  can_filter_config.FilterMode = CAN_FILTERMODE_IDMASK;
+  can_filter_config.FilterFIFOAssignment = CAN_FILTER_FIFO1;
   can_filter_config.FilterIdHigh = 0x0000;
   can_filter_config.FilterIdLow = 0x0000;
-  // Set mask to 0 so that no bits are filtered, allow all messages.
-  can_filter_config.FilterMaskIdHigh = 0x0000;
-  can_filter_config.FilterMaskIdLow = 0x0000;
-  // Use mask mode (compare message ID with mask).
-  can_filter_config.FilterMode = CAN_FILTERMODE_IDMASK;
-  // Use 32-bit filter scale.
-  can_filter_config.FilterScale = CAN_FILTERSCALE_32BIT;
-  // Filter bank config for dual CAN setups.
-  can_filter_config.SlaveStartFilterBank = 20;
+  can_filter_config.FilterMaskIdHigh = 0x0018; // Match RTR = 0 and IDE = 0.
+  can_filter_config.FilterMaskIdLow = 0x0018;
+  if (dbc_filter_bank_count < CAN_FILTER_SLAVE_START_BANK) {
+    can_filter_config.FilterBank = dbc_filter_bank_count;
+    HAL_CAN_ConfigFilter(&hcan1, &can_filter_config);
+    can_filter_config.FilterBank =
+        CAN_FILTER_SLAVE_START_BANK + dbc_filter_bank_count;
+    HAL_CAN_ConfigFilter(&hcan2, &can_filter_config);
+  }
+#endif
 
-  // Apply filter settings to both CAN1 and CAN2.
-  HAL_CAN_ConfigFilter(&hcan1, &can_filter_config);
-  HAL_CAN_ConfigFilter(&hcan2, &can_filter_config);
+  // Bus monitors.
+  for (uint8_t b = 0; b < 2; b++) {
+    monitors[b].bitrate = bitrate_of(buses[b]);
+    monitors[b].window_start_ms = HAL_GetTick();
+    monitors[b].last_rx_ms = HAL_GetTick();
+    monitors[b].status.recovery_backoff_ms = CAN_BUS_OFF_BACKOFF_MIN_MS;
+  }
 
-  // Start CAN1 and CAN2.
+  // Start CAN1 and CAN2 (timestamps from the system time, systime_init).
   HAL_CAN_Start(&hcan1);
   HAL_CAN_Start(&hcan2);
 
-  // Enable interrupts.
-  HAL_CAN_ActivateNotification(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
-  HAL_CAN_ActivateNotification(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+  // Enable interrupts, filters split RX messages over both FIFOs by priority.
+  // TX mailbox empty (complete, abort, error) refills from the TX queue.
+  const uint32_t notifications =
+      CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING |
+      CAN_IT_RX_FIFO0_OVERRUN | CAN_IT_RX_FIFO1_OVERRUN |
+      CAN_IT_TX_MAILBOX_EMPTY;
+  HAL_CAN_ActivateNotification(&hcan1, notifications);
+  HAL_CAN_ActivateNotification(&hcan2, notifications);
+}
+
+HAL_StatusTypeDef can_send_raw(CAN_HandleTypeDef *h_can_x, uint32_t std_id,
+                               uint8_t dlc, const uint8_t *data) {
+  can_tx_queue_t *q = tx_queue_of(h_can_x);
+  HAL_StatusTypeDef status = HAL_OK;
+  can_tx_frame_t frame = {.std_id = std_id, .dlc = dlc};
+
+  if (dlc > sizeof(frame.data)) {
+    return HAL_ERROR;
+  }
+  memcpy(frame.data, data, dlc);
+
+  // Mask interrupts, the TX mailbox interrupts share the queue.
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (q->count < CAN_TX_QUEUE_SIZE) {
+    frame.sequence = q->sequence++;
+    frame.enqueue_us = can_time_us();
+    tx_heap_push(q, &frame);
+    q->stats.queued++;
+    tx_queue_fill(h_can_x, q);
+  } else {
+    q->stats.dropped++;
+    status = HAL_ERROR;
+  }
+
+  __set_PRIMASK(primask);
+
+  if (status != HAL_OK) {
+    can_fault();
+  }
+  return status;
+}
 
-  // Setup CAN general members on the transmit header.
-  tx_header.IDE = CAN_ID_STD;
-  // Remaining members (DLC and StdId) are configured per message on transmit.
+uint16_t can_tx_queue_free(const CAN_HandleTypeDef *h_can_x) {
+  return CAN_TX_QUEUE_SIZE - tx_queue_of(h_can_x)->count;
+}
+
+void can_rx_process(void) {
+  uint32_t tail = rx_ring_tail;
+
+  while (tail != rx_ring_head) {
+    // Ensure the frame contents are read after the published head.
+    __DMB();
+    can_rx_frame_t *frame = &rx_ring[tail & (CAN_RX_RING_SIZE - 1)];
+#ifdef NERVE_CAN_REDUNDANCY
+    const uint8_t duplicate = rx_is_duplicate(frame);
+#else
+    const uint8_t duplicate = 0;
+#endif
+    log_frame(buses[frame->bus], 0, frame->header.StdId,
+              (uint8_t)frame->header.DLC, frame->data,
+              frame->header.Timestamp);
+    if (!duplicate) {
+      process_can_message(&frame->header, frame->data);
+      rx_stats.dispatched++;
+    }
+
+    // Release the slot back to the RX interrupts.
+    tail++;
+    __DMB();
+    rx_ring_tail = tail;
+  }
+}
+
+const can_rx_stats_t *can_rx_get_stats(void) { return &rx_stats; }
+
+void can_monitor_update(void) {
+  const uint32_t now_ms = HAL_GetTick();
+
+  monitor_update(&hcan1, now_ms);
+  monitor_update(&hcan2, now_ms);
+#ifdef NERVE_CAN_REDUNDANCY
+  redundancy_update(now_ms);
+#endif
+}
+
+const can_bus_status_t *can_get_bus_status(const CAN_HandleTypeDef *h_can_x) {
+  return &monitor_of(h_can_x)->status;
+}
+
+const can_redundancy_stats_t *can_redundancy_get_stats(void) {
+  return &redundancy;
+}
+
+const can_tx_stats_t *can_tx_get_stats(const CAN_HandleTypeDef *h_can_x) {
+  return &tx_queue_of(h_can_x)->stats;
+}
+
+void can_pack_message_raw32(const can_message_t *msg,
+                            const uint32_t signal_values[], uint8_t data[8]) {
+  int32_t mux_value = -1;
+
+  memset(data, 0, 8);
+
+  // Multiplexed signals are only packed when selected by the switch value.
+  for (int i = 0; i < msg->signal_count; ++i) {
+    if (msg->signals[i].mux_type == CAN_MUX_SWITCH) {
+      mux_value = (int32_t)signal_values[i];
+    }
+  }
+
+  for (int i = 0; i < msg->signal_count; ++i) {
+    if (msg->signals[i].mux_type == CAN_MUX_MULTIPLEXED &&
+        msg->signals[i].mux_value != mux_value) {
+      continue;
+    }
+    pack_signal_raw32(&msg->signals[i], data, signal_values[i]);
+  }
 }
 
 HAL_StatusTypeDef can_send_message_raw32(CAN_HandleTypeDef *h_can_x,
                                          const can_message_t *msg,
                                          const uint32_t signal_values[]) {
-  uint8_t data[8] = {0};
+  uint8_t data[8];
 
-  for (int i = 0; i < msg->signal_count; ++i) {
-    pack_signal_raw32(&msg->signals[i], data, signal_values[i]);
+  can_pack_message_raw32(msg, signal_values, data);
+  return can_send_raw(h_can_x, msg->message_id, msg->dlc, data);
+}
+
+HAL_StatusTypeDef can_send_message(const can_message_t *msg,
+                                   const uint32_t signal_values[]) {
+#ifdef NERVE_CAN_REDUNDANCY
+  if (!msg->redundant) {
+    return can_send_message_raw32(buses[redundancy.primary_bus], msg,
+                                  signal_values);
   }
 
-  // Prepare the CAN transmit header.
-  tx_header.StdId = msg->message_id;
-  tx_header.IDE = CAN_ID_STD;
-  tx_header.RTR = CAN_RTR_DATA;
-  tx_header.DLC = msg->dlc;
+  // Mirror on every healthy bus, or on both if neither is healthy.
+  const uint8_t any_ok = redundancy.bus_ok[0] || redundancy.bus_ok[1];
+  HAL_StatusTypeDef status = HAL_OK;
+  uint8_t queued = 0;
 
-  return HAL_CAN_AddTxMessage(h_can_x, &tx_header, data, &tx_mailbox);
+  for (uint8_t b = 0; b < 2; b++) {
+    if (redundancy.bus_ok[b] || !any_ok) {
+      if (can_send_message_raw32(buses[b], msg, signal_values) == HAL_OK) {
+        queued++;
+      } else {
+        status = HAL_ERROR;
+      }
+    }
+  }
+  if (queued == 2) {
+    redundancy.mirrored++;
+  }
+  return status;
+#else
+  return can_send_message_raw32(&hcan1, msg, signal_values);
+#endif
 }
@@ -2,7 +2,138 @@
 
 #include "can_nerve.h"
 
+static const can_value_description_t value_table_time_sync_time_sync_type[] = {
+    {0, "Sync"},
+    {1, "Follow up"},
+};
+
+static const can_value_description_t value_table_rtc_rtc_state[] = {
+    {0, "Not set"},
+    {1, "Set"},
+};
+
+static const can_value_description_t value_table_can1_status_can1_error_state[] = {
+    {0, "Error active"},
+    {1, "Error warning"},
+    {2, "Error passive"},
+    {3, "Bus off"},
+};
+
+static const can_value_description_t value_table_can1_status_can1_last_error_code[] = {
+    {0, "No error"},
+    {1, "Stuff error"},
+    {2, "Form error"},
+    {3, "Acknowledgment error"},
+    {4, "Bit recessive error"},
+    {5, "Bit dominant error"},
+    {6, "CRC error"},
+    {7, "Software"},
+};
+
+static const can_value_description_t value_table_can2_status_can2_error_state[] = {
+    {0, "Error active"},
+    {1, "Error warning"},
+    {2, "Error passive"},
+    {3, "Bus off"},
+};
+
+static const can_value_description_t value_table_can2_status_can2_last_error_code[] = {
+    {0, "No error"},
+    {1, "Stuff error"},
+    {2, "Form error"},
+    {3, "Acknowledgment error"},
+    {4, "Bit recessive error"},
+    {5, "Bit dominant error"},
+    {6, "CRC error"},
+    {7, "Software"},
+};
+
+__weak void can_rx_command_a(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+__weak void can_rx_isotp_request(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
 const can_message_t dbc_messages[] = {
+    {
+        .name = "time_sync",
+        .message_id = 128,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 5,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 1000,
+        .start_delay_ms = 11,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 4,
+        .signals =
+            {
+                {
+                    .name = "time_sync_type",
+                    .start_bit = 0,
+                    .bit_length = 4,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_SWITCH,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 1.0f,
+                    .value_table = value_table_time_sync_time_sync_type,
+                    .value_count = 2,
+                },
+                {
+                    .name = "time_sync_sequence",
+                    .start_bit = 4,
+                    .bit_length = 4,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 15.0f,
+                },
+                {
+                    .name = "time_sync_coarse_us",
+                    .start_bit = 8,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4294967295.0f,
+                },
+                {
+                    .name = "time_sync_precise_us",
+                    .start_bit = 8,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 1,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4294967295.0f,
+                },
+            },
+    },
     {
         .name = "state",
         .message_id = 257,
@@ -10,6 +141,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 1,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC_AND_ON_CHANGE,
+        .cycle_time_ms = 1000,
+        .start_delay_ms = 12,
+        .min_interval_ms = 10,
+        .redundant = 1,
         .signal_count = 1,
         .signals =
             {
@@ -18,6 +154,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -32,6 +172,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 8,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 50,
+        .start_delay_ms = 5,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -40,6 +185,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 32,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.00566f,
                     .offset = 30000.0f,
                     .min_value = 30000.0f,
@@ -50,6 +199,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0019074f,
                     .offset = -40.0f,
                     .min_value = -40.0f,
@@ -60,6 +213,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 48,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -74,6 +231,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 8,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 200,
+        .start_delay_ms = 7,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 2,
         .signals =
             {
@@ -82,6 +244,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 32,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 4.1909516e-08f,
                     .offset = -90.0f,
                     .min_value = -90.0f,
@@ -92,6 +258,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 32,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 8.3819032e-08f,
                     .offset = -180.0f,
                     .min_value = -180.0f,
@@ -106,6 +276,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 8,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 200,
+        .start_delay_ms = 8,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 5,
         .signals =
             {
@@ -114,6 +289,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.01f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -124,6 +303,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.01f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -134,6 +317,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -144,6 +331,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 40,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -154,6 +345,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 48,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.01f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -168,6 +363,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 7,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 200,
+        .start_delay_ms = 9,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -176,6 +376,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 32,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.01f,
                     .offset = -150.0f,
                     .min_value = -150.0f,
@@ -186,6 +390,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.01f,
                     .offset = 0.0f,
                     .min_value = -327.68f,
@@ -196,6 +404,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 48,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -210,6 +422,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 8,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 10,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 4,
         .signals =
             {
@@ -218,6 +435,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 3.05185e-05f,
                     .offset = -1.0f,
                     .min_value = -1.0f,
@@ -228,6 +449,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 3.05185e-05f,
                     .offset = -1.0f,
                     .min_value = -1.0f,
@@ -238,6 +463,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 3.05185e-05f,
                     .offset = -1.0f,
                     .min_value = -1.0f,
@@ -248,6 +477,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 48,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 3.05185e-05f,
                     .offset = -1.0f,
                     .min_value = -1.0f,
@@ -262,6 +495,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 6,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 20,
+        .start_delay_ms = 1,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -270,6 +508,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0610359f,
                     .offset = -2000.0f,
                     .min_value = -2000.0f,
@@ -280,6 +522,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0610359f,
                     .offset = -2000.0f,
                     .min_value = -2000.0f,
@@ -290,6 +536,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0610359f,
                     .offset = -2000.0f,
                     .min_value = -2000.0f,
@@ -304,6 +554,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 6,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 20,
+        .start_delay_ms = 2,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -312,6 +567,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -322,6 +581,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -332,6 +595,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -346,6 +613,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 6,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 20,
+        .start_delay_ms = 3,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -354,6 +626,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -364,6 +640,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -374,6 +654,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0047889f,
                     .offset = -156.9f,
                     .min_value = -156.9f,
@@ -388,6 +672,11 @@ const can_message_t dbc_messages[] = {
         .dlc = 6,
         .rx_handler = 0,
         .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 20,
+        .start_delay_ms = 4,
+        .min_interval_ms = 0,
+        .redundant = 0,
         .signal_count = 3,
         .signals =
             {
@@ -396,6 +685,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0002994f,
                     .offset = -9.81f,
                     .min_value = -9.81f,
@@ -406,6 +699,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0002994f,
                     .offset = -9.81f,
                     .min_value = -9.81f,
@@ -416,6 +713,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 0.0002994f,
                     .offset = -9.81f,
                     .min_value = -9.81f,
@@ -423,13 +724,63 @@ const can_message_t dbc_messages[] = {
                 },
             },
     },
+    {
+        .name = "imu6",
+        .message_id = 273,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 3,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 100,
+        .start_delay_ms = 6,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 2,
+        .signals =
+            {
+                {
+                    .name = "quaternion_accuracy",
+                    .start_bit = 0,
+                    .bit_length = 16,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.0001f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 6.5535f,
+                },
+                {
+                    .name = "imu_state",
+                    .start_bit = 16,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+            },
+    },
     {
         .name = "command_a",
         .message_id = 513,
         .id_mask = 0xFFFFFFFF,
         .dlc = 8,
-        .rx_handler = 0,
+        .rx_handler = can_rx_command_a,
         .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 1,
         .signal_count = 4,
         .signals =
             {
@@ -438,6 +789,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -448,6 +803,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 16,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -458,6 +817,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 32,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -468,6 +831,10 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 48,
                     .bit_length = 16,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
@@ -479,10 +846,15 @@ const can_message_t dbc_messages[] = {
         .name = "rtc",
         .message_id = 600,
         .id_mask = 0xFFFFFFFF,
-        .dlc = 8,
+        .dlc = 6,
         .rx_handler = 0,
         .tx_handler = 0,
-        .signal_count = 8,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 1000,
+        .start_delay_ms = 13,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 3,
         .signals =
             {
                 {
@@ -490,83 +862,416 @@ const can_message_t dbc_messages[] = {
                     .start_bit = 0,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
                     .max_value = 255.0f,
+                    .value_table = value_table_rtc_rtc_state,
+                    .value_count = 2,
                 },
                 {
-                    .name = "rtc_year",
+                    .name = "rtc_epoch_s",
                     .start_bit = 8,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4294967295.0f,
+                },
+                {
+                    .name = "rtc_millisecond",
+                    .start_bit = 40,
+                    .bit_length = 10,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 999.0f,
+                },
+            },
+    },
+    {
+        .name = "can1_status",
+        .message_id = 784,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 1000,
+        .start_delay_ms = 14,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 8,
+        .signals =
+            {
+                {
+                    .name = "can1_tx_fps",
+                    .start_bit = 0,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "can1_rx_fps",
+                    .start_bit = 12,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "can1_bus_load",
+                    .start_bit = 24,
+                    .bit_length = 10,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.1f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 100.0f,
+                },
+                {
+                    .name = "can1_tec",
+                    .start_bit = 34,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
-                    .offset = 2000.0f,
-                    .min_value = 2000.0f,
-                    .max_value = 2099.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
                 },
                 {
-                    .name = "rtc_month",
-                    .start_bit = 16,
+                    .name = "can1_rec",
+                    .start_bit = 42,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
-                    .min_value = 1.0f,
-                    .max_value = 12.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "can1_error_state",
+                    .start_bit = 50,
+                    .bit_length = 2,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 3.0f,
+                    .value_table = value_table_can1_status_can1_error_state,
+                    .value_count = 4,
                 },
                 {
-                    .name = "rtc_day",
+                    .name = "can1_last_error_code",
+                    .start_bit = 52,
+                    .bit_length = 3,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 7.0f,
+                    .value_table = value_table_can1_status_can1_last_error_code,
+                    .value_count = 8,
+                },
+                {
+                    .name = "can1_bus_off_count",
+                    .start_bit = 55,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+            },
+    },
+    {
+        .name = "can2_status",
+        .message_id = 785,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 1000,
+        .start_delay_ms = 15,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 8,
+        .signals =
+            {
+                {
+                    .name = "can2_tx_fps",
+                    .start_bit = 0,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "can2_rx_fps",
+                    .start_bit = 12,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "can2_bus_load",
                     .start_bit = 24,
+                    .bit_length = 10,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.1f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 100.0f,
+                },
+                {
+                    .name = "can2_tec",
+                    .start_bit = 34,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
-                    .min_value = 1.0f,
-                    .max_value = 31.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
                 },
                 {
-                    .name = "rtc_weekday",
-                    .start_bit = 32,
+                    .name = "can2_rec",
+                    .start_bit = 42,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "can2_error_state",
+                    .start_bit = 50,
+                    .bit_length = 2,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
-                    .min_value = 1.0f,
+                    .min_value = 0.0f,
+                    .max_value = 3.0f,
+                    .value_table = value_table_can2_status_can2_error_state,
+                    .value_count = 4,
+                },
+                {
+                    .name = "can2_last_error_code",
+                    .start_bit = 52,
+                    .bit_length = 3,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
                     .max_value = 7.0f,
+                    .value_table = value_table_can2_status_can2_last_error_code,
+                    .value_count = 8,
                 },
                 {
-                    .name = "rtc_hour",
-                    .start_bit = 40,
+                    .name = "can2_bus_off_count",
+                    .start_bit = 55,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
-                    .max_value = 23.0f,
+                    .max_value = 255.0f,
                 },
+            },
+    },
+    {
+        .name = "isotp_request",
+        .message_id = 2016,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = can_rx_isotp_request,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 2,
+        .signals =
+            {
                 {
-                    .name = "rtc_minute",
-                    .start_bit = 48,
+                    .name = "isotp_request_pci",
+                    .start_bit = 0,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "isotp_request_payload",
+                    .start_bit = 8,
+                    .bit_length = 56,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
-                    .max_value = 59.0f,
+                    .max_value = 0.0f,
                 },
+            },
+    },
+    {
+        .name = "isotp_response",
+        .message_id = 2024,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 2,
+        .signals =
+            {
                 {
-                    .name = "rtc_second",
-                    .start_bit = 56,
+                    .name = "isotp_response_pci",
+                    .start_bit = 0,
                     .bit_length = 8,
                     .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
                     .scale = 1.0f,
                     .offset = 0.0f,
                     .min_value = 0.0f,
-                    .max_value = 59.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "isotp_response_payload",
+                    .start_bit = 8,
+                    .bit_length = 56,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 0.0f,
                 },
             },
     },
 };
 
 const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);
+
+const can_filter_bank_t dbc_filter_banks[] = {
+    {
+        .filter_mode = CAN_FILTERMODE_IDLIST,
+        .filter_fifo = CAN_FILTER_FIFO0,
+        .filter_id_low = 0x4020,
+        .filter_mask_id_low = 0xFC00,
+        .filter_id_high = 0xFC00,
+        .filter_mask_id_high = 0xFC00,
+    },
+};
+
+const int dbc_filter_bank_count = 1;
@@ -10,7 +10,7 @@
 
 /** Public variables. *********************************************************/
 
-uint8_t can_fault_count = 0;
+uint32_t can_fault_count = 0; // See can_get_bus_status for bus details.
 uint8_t bmp390_fault_count = 0;
 uint8_t bno085_fault_count = 0;
 uint8_t gps_fault_count = 0;
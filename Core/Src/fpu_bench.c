@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * @file fpu_bench.c
+ * @brief Floating point hot path benchmark (PID, CAN encode, GPS parse).
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "fpu_bench.h"
+#include "can.h"
+#include "can_nerve.h"
+#include "pid.h"
+#include "stm32f4xx_hal.h"
+#include "ublox_hal_uart.h"
+#include <stdio.h>
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+#if defined(__ARM_PCS_VFP)
+#define FPU_BENCH_FLOAT_ABI "hard" // FPU instructions, FPU registers.
+#elif defined(__ARM_FP)
+#define FPU_BENCH_FLOAT_ABI "softfp" // FPU instructions, core registers.
+#else
+#define FPU_BENCH_FLOAT_ABI "soft" // Library calls.
+#endif
+
+#define FPU_BENCH_INPUTS 8 // Input table size.
+
+/** Private variables. ********************************************************/
+
+static const char *const path_names[FPU_BENCH_PATH_COUNT] = {
+    [FPU_BENCH_PID] = "pid",
+    [FPU_BENCH_CAN_ENCODE] = "can_encode",
+    [FPU_BENCH_GPS_PARSE] = "gps_parse",
+};
+
+// Measurements and signal values, changing every call.
+static const float inputs[FPU_BENCH_INPUTS] = {
+    0.0f, 0.125f, -0.5f, 0.7071f, -0.9999f, 0.333f, -0.05f, 1.0f,
+};
+
+// Parsed only (ublox_parse_nmea), nothing logged or sent.
+static const char *const sentences[] = {
+    "$GNGGA,123519.00,4916.45123,N,12311.12345,W,1,08,0.9,545.4,M,-16.9,M,,"
+    "*45\r\n",
+    "$GNRMC,123519.00,V,4916.45123,N,12311.12345,W,22.4,84.4,230394,,,A,V"
+    "*3B\r\n",
+};
+
+static pid_controller_t pid = {
+    .k_p = 2.0f,
+    .k_i = 0.5f,
+    .k_d = 0.25f,
+    .tau = 0.02f,
+    .output_min = -10.0f,
+    .output_max = 10.0f,
+    .integral_min = -5.0f,
+    .integral_max = 5.0f,
+    .T = 0.01f,
+};
+
+// GPS parse output, gps_data is left to the UART interrupt.
+static ublox_data_t gps_bench_data;
+
+// Results kept (not optimized out).
+static volatile float pid_out;
+static volatile uint32_t sink;
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief One pid_update call.
+ */
+static void call_pid(uint32_t index) {
+  pid_out = pid_update(&pid, 0.5f, inputs[index % FPU_BENCH_INPUTS]);
+}
+
+/**
+ * @brief Encode one DBC message as telemetry does (float_to_raw and pack).
+ */
+static void call_can_encode(uint32_t index) {
+  const can_message_t *msg = &dbc_messages[DBC_MESSAGE_IMU1];
+  uint32_t raw[MAX_SIGNALS_PER_MESSAGE];
+  uint8_t data[8];
+
+  for (uint8_t i = 0; i < msg->signal_count; i++) {
+    raw[i] = float_to_raw(inputs[(index + i) % FPU_BENCH_INPUTS],
+                          &msg->signals[i]);
+  }
+  can_pack_message_raw32(msg, raw, data);
+  sink = data[0];
+}
+
+/**
+ * @brief Parse one NMEA sentence into gps_bench_data, without side effects.
+ */
+static void call_gps_parse(uint32_t index) {
+  ublox_parse_nmea(sentences[index % 2], &gps_bench_data);
+  sink = gps_bench_data.satellites;
+}
+
+/**
+ * @brief Write and flush one formatted results row.
+ */
+static FRESULT write_row(FIL *file, const char *row) {
+  UINT written = 0;
+  const UINT length = (UINT)strlen(row);
+  FRESULT result = f_write(file, row, length, &written);
+
+  if (result == FR_OK && written != length) {
+    result = FR_DENIED; // Card full.
+  }
+  if (result == FR_OK) {
+    result = f_sync(file); // Keep completed rows if interrupted.
+  }
+  return result;
+}
+
+/** Public functions. *********************************************************/
+
+void fpu_bench_path(fpu_bench_path_t path, fpu_bench_result_t *result) {
+  void (*call)(uint32_t index) = call_pid;
+
+  if (path == FPU_BENCH_CAN_ENCODE) {
+    call = call_can_encode;
+  } else if (path == FPU_BENCH_GPS_PARSE) {
+    call = call_gps_parse;
+  }
+
+  memset(result, 0, sizeof(*result));
+  result->min_cycles = UINT32_MAX;
+  pid_init(&pid);
+
+  for (uint32_t i = 0; i < FPU_BENCH_CALLS; i++) {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t start = DWT->CYCCNT;
+    call(i);
+    const uint32_t cycles = DWT->CYCCNT - start;
+    __set_PRIMASK(primask);
+
+    result->calls++;
+    result->total_cycles += cycles;
+    if (cycles < result->min_cycles) {
+      result->min_cycles = cycles;
+    }
+    if (cycles > result->max_cycles) {
+      result->max_cycles = cycles;
+    }
+  }
+}
+
+FRESULT fpu_bench_run(void) {
+  FIL file;
+  char row[128];
+  fpu_bench_result_t result;
+
+  FRESULT res = f_open(&file, FPU_BENCH_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+  if (res != FR_OK) {
+    return res;
+  }
+  res = write_row(&file, "path,float_abi,cpu_hz,calls,min_cycles,mean_cycles,"
+                         "max_cycles,mean_ns\n");
+
+  for (uint8_t path = 0; path < FPU_BENCH_PATH_COUNT && res == FR_OK; path++) {
+    fpu_bench_path(path, &result);
+
+    // Integer only, the same in every floating point ABI build.
+    const uint32_t mean_cycles = (uint32_t)(result.total_cycles / result.calls);
+    const uint32_t mean_ns =
+        (uint32_t)(result.total_cycles * 1000000000ULL /
+                   ((uint64_t)result.calls * SystemCoreClock));
+    snprintf(row, sizeof(row), "%s,%s,%lu,%lu,%lu,%lu,%lu,%lu\n",
+             path_names[path], FPU_BENCH_FLOAT_ABI,
+             (unsigned long)SystemCoreClock, (unsigned long)result.calls,
+             (unsigned long)result.min_cycles, (unsigned long)mean_cycles,
+             (unsigned long)result.max_cycles, (unsigned long)mean_ns);
+    res = write_row(&file, row);
+  }
+
+  const FRESULT close_res = f_close(&file);
+  return (res != FR_OK) ? res : close_res;
+}
@@ -0,0 +1,313 @@
+/*******************************************************************************
+ * @file gnss_time.c
+ * @brief GNSS disciplined time: UTC from the system time, RTC set from GNSS.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "gnss_time.h"
+#include "diagnostics.h"
+#include "logger.h"
+#include "rtc.h"
+
+#include "configuration.h"
+
+/** Definitions. **************************************************************/
+
+#define US_PER_S 1000000LL
+
+// RTC compared to UTC mid second only, away from both second boundaries.
+#define RTC_CHECK_FROM_US 250000
+#define RTC_CHECK_TO_US 750000
+
+/** Private variables. ********************************************************/
+
+static gnss_time_stats_t stats = {0};
+
+// Last RMC epoch, written by the UART interrupt.
+static volatile uint8_t epoch_pending = 0;
+static int64_t epoch_utc_us = 0;
+static uint64_t epoch_sys_us = 0; // Sentence start.
+static int64_t epoch_last_utc_us = 0;
+
+// UTC = ref_utc_us + d - d * drift_ppb / 10^9, d = sys - ref_sys_us. Written
+// with IRQs masked so interrupts read a consistent model.
+static uint8_t synced = 0;
+static uint64_t ref_sys_us = 0;
+static int64_t ref_utc_us = 0;
+
+static uint8_t drift_measured = 0;
+static uint64_t drift_sys_us = 0; // Drift measurement start.
+static int64_t drift_utc_us = 0;
+static uint8_t rate_errors_run = 0; // Consecutive rate errors.
+
+static uint64_t pps_us = 0;      // Last TIMEPULSE edge, not matched yet.
+static uint8_t pps_pending = 0;  // pps_us not matched to an RMC epoch.
+static uint64_t pps_sync_us = 0; // Last TIMEPULSE sync point, 0 if none.
+
+static uint8_t rtc_due = 0;       // RTC to be set on the next UTC second.
+static int64_t rtc_checked_s = 0; // Last UTC second the RTC was compared.
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief System time of a recent systime_us32 (within 2^32 us).
+ */
+static uint64_t extend(uint32_t time_us) {
+  const uint64_t now_us = systime_us();
+  return now_us - (uint32_t)((uint32_t)now_us - time_us);
+}
+
+/**
+ * @brief UTC of a system time with the current model.
+ */
+static int64_t to_utc(uint64_t sys_us) {
+  const int64_t elapsed_us = (int64_t)(sys_us - ref_sys_us);
+  return ref_utc_us + elapsed_us - elapsed_us * stats.drift_ppb / 1000000000LL;
+}
+
+/**
+ * @brief Check a measured rate error against GNSS_TIME_DRIFT_MAX_PPB.
+ *
+ * A rate beyond any oscillator (a broken time base or clock tree) is not
+ * learned, GNSS_TIME_RATE_FAULT_COUNT in a row latch rate_fault.
+ *
+ * @return 1 if plausible, otherwise 0 (counted in rate_errors).
+ */
+static uint8_t rate_plausible(int64_t rate_ppb) {
+  if (rate_ppb <= GNSS_TIME_DRIFT_MAX_PPB &&
+      rate_ppb >= -GNSS_TIME_DRIFT_MAX_PPB) {
+    rate_errors_run = 0;
+    return 1;
+  }
+  stats.rate_errors++;
+  if (++rate_errors_run >= GNSS_TIME_RATE_FAULT_COUNT && !stats.rate_fault) {
+    stats.rate_fault = 1;
+    gps_fault();
+  }
+  return 0;
+}
+
+/**
+ * @brief Rate error (ppb) of an interval, over 100 % clamped to +-10^9.
+ */
+static int64_t rate_ppb(int64_t error_us, int64_t elapsed_us) {
+  const int64_t magnitude_us = error_us < 0 ? -error_us : error_us;
+  if (elapsed_us <= 0 || magnitude_us >= elapsed_us) {
+    return error_us < 0 ? -1000000000LL : 1000000000LL; // No overflow.
+  }
+  return error_us * 1000000000LL / elapsed_us;
+}
+
+/**
+ * @brief Apply a sync point, system time sys_us is UTC utc_us.
+ */
+static void sync(uint64_t sys_us, int64_t utc_us, gnss_time_source_t source) {
+  int32_t drift_ppb = stats.drift_ppb;
+
+  if (synced) {
+    int64_t offset_us = to_utc(sys_us) - utc_us;
+    if (offset_us >= GNSS_TIME_STEP_US || offset_us <= -GNSS_TIME_STEP_US) {
+      stats.steps++;
+      // The drift window restarts on every step, so a rate error making every
+      // sync a step is learned from the step: offset since the last sync.
+      const int64_t seeded_ppb =
+          drift_ppb + rate_ppb(offset_us, (int64_t)(sys_us - ref_sys_us));
+      if (rate_plausible(seeded_ppb)) {
+        drift_ppb = (int32_t)seeded_ppb;
+        drift_measured = 1;
+      }
+      drift_sys_us = sys_us; // Restart the drift measurement from here.
+      drift_utc_us = utc_us;
+    } else if (sys_us - drift_sys_us >= GNSS_TIME_DRIFT_WINDOW_US) {
+      const int64_t utc_elapsed_us = utc_us - drift_utc_us;
+      const int64_t sys_elapsed_us = (int64_t)(sys_us - drift_sys_us);
+      const int64_t measured_ppb =
+          rate_ppb(sys_elapsed_us - utc_elapsed_us, utc_elapsed_us);
+      if (rate_plausible(measured_ppb)) {
+        if (drift_measured) {
+          drift_ppb += ((int32_t)measured_ppb - drift_ppb) /
+                       (1 << GNSS_TIME_DRIFT_FILTER);
+        } else {
+          drift_ppb = (int32_t)measured_ppb; // First measurement.
+        }
+        drift_measured = 1;
+      }
+      drift_sys_us = sys_us;
+      drift_utc_us = utc_us;
+    }
+
+    if (offset_us > INT32_MAX) {
+      offset_us = INT32_MAX;
+    } else if (offset_us < -INT32_MAX) {
+      offset_us = -INT32_MAX;
+    }
+    stats.offset_us = (int32_t)offset_us;
+    const int32_t magnitude_us =
+        (int32_t)(offset_us < 0 ? -offset_us : offset_us);
+    if (magnitude_us > stats.offset_max_us) {
+      stats.offset_max_us = magnitude_us;
+    }
+  } else {
+    drift_sys_us = sys_us;
+    drift_utc_us = utc_us;
+  }
+
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  ref_sys_us = sys_us;
+  ref_utc_us = utc_us;
+  stats.drift_ppb = drift_ppb;
+  synced = 1;
+  __set_PRIMASK(primask);
+
+  stats.source = source;
+  stats.syncs++;
+  stats.last_sync_us = sys_us;
+
+  const log_gnss_time_t record = {
+      .utc_us = utc_us,
+      .sys_us = (uint32_t)sys_us,
+      .drift_ppb = stats.drift_ppb,
+      .offset_us = stats.offset_us,
+      .source = (uint8_t)source,
+  };
+  logger_write(LOG_RECORD_GNSS_TIME, &record, sizeof(record));
+}
+
+/**
+ * @brief Read a captured TIMEPULSE edge.
+ */
+static void pps_poll(void) {
+#ifdef NERVE_GPS_TIMEPULSE
+  if (!__HAL_TIM_GET_FLAG(&GNSS_TIME_PPS_HTIM, GNSS_TIME_PPS_FLAG)) {
+    return;
+  }
+  // Reading the capture clears the flag.
+  const uint32_t capture = HAL_TIM_ReadCapturedValue(&GNSS_TIME_PPS_HTIM,
+                                                     GNSS_TIME_PPS_CHANNEL);
+  if (__HAL_TIM_GET_FLAG(&GNSS_TIME_PPS_HTIM, GNSS_TIME_PPS_OVERCAPTURE_FLAG)) {
+    __HAL_TIM_CLEAR_FLAG(&GNSS_TIME_PPS_HTIM, GNSS_TIME_PPS_OVERCAPTURE_FLAG);
+    stats.pps_overcaptures++;
+  }
+  pps_us = extend(capture);
+  pps_pending = 1;
+  stats.pps_edges++;
+#endif
+}
+
+/**
+ * @brief Set the RTC on a UTC second boundary when its seconds differ.
+ */
+static void rtc_update(void) {
+  int64_t utc_us;
+  if (!gnss_time_utc_us(systime_us(), &utc_us)) {
+    return;
+  }
+  const int64_t second = utc_us / US_PER_S;
+  const int32_t fraction_us = (int32_t)(utc_us % US_PER_S);
+  RTC_DateTypeDef date;
+  RTC_TimeTypeDef time;
+
+  if (rtc_due) {
+    // First task run of the second, the RTC second starts when set.
+    if (fraction_us < GNSS_TIME_PROCESS_PERIOD_MS * 1000) {
+      epoch_to_date_time(second, &date, &time);
+      set_time(time.Hours, time.Minutes, time.Seconds);
+      set_date(date.Year, date.Month, date.Date, date.WeekDay);
+      rtc_due = 0;
+      stats.rtc_sets++;
+    }
+    return;
+  }
+
+  if (second != rtc_checked_s && fraction_us >= RTC_CHECK_FROM_US &&
+      fraction_us < RTC_CHECK_TO_US) {
+    rtc_checked_s = second;
+    if (!get_date_time(&date, &time) ||
+        date_time_to_epoch(&date, &time) != second) {
+      rtc_due = 1;
+    }
+  }
+}
+
+/** Public functions. *********************************************************/
+
+void gnss_time_init(void) {
+#ifdef NERVE_GPS_TIMEPULSE
+  GPIO_InitTypeDef gpio = {0};
+  gpio.Pin = GNSS_TIME_PPS_PIN;
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_PULLDOWN;
+  gpio.Speed = GPIO_SPEED_FREQ_LOW;
+  gpio.Alternate = GNSS_TIME_PPS_AF;
+  HAL_GPIO_Init(GNSS_TIME_PPS_PORT, &gpio);
+
+  // Rising edge at the top of each UTC second (u-blox default TIMEPULSE).
+  TIM_IC_InitTypeDef input_capture = {0};
+  input_capture.ICPolarity = TIM_ICPOLARITY_RISING;
+  input_capture.ICSelection = TIM_ICSELECTION_DIRECTTI;
+  input_capture.ICPrescaler = TIM_ICPSC_DIV1;
+  input_capture.ICFilter = 0x3; // 8 timer clocks stable, glitch filter.
+  HAL_TIM_IC_ConfigChannel(&GNSS_TIME_PPS_HTIM, &input_capture,
+                           GNSS_TIME_PPS_CHANNEL);
+  HAL_TIM_IC_Start(&GNSS_TIME_PPS_HTIM, GNSS_TIME_PPS_CHANNEL);
+#endif
+}
+
+void gnss_time_nmea(const ublox_data_t *data, uint32_t start_us) {
+  if (data->millisecond != 0 || data->month == 0 || data->day == 0) {
+    return; // Whole seconds only, date known.
+  }
+
+  const RTC_DateTypeDef date = {
+      .Year = data->year, .Month = data->month, .Date = data->day};
+  const RTC_TimeTypeDef time = {
+      .Hours = data->hour, .Minutes = data->minute, .Seconds = data->second};
+  epoch_utc_us = date_time_to_epoch(&date, &time) * US_PER_S;
+  epoch_sys_us = extend(start_us);
+  epoch_pending = 1;
+}
+
+void gnss_time_process(void) {
+  pps_poll();
+
+  if (epoch_pending) {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const int64_t utc_us = epoch_utc_us;
+    const uint64_t start_us = epoch_sys_us;
+    epoch_pending = 0;
+    __set_PRIMASK(primask);
+
+    // RMC parsed again (DMA complete and line idle) is the same epoch.
+    if (utc_us != epoch_last_utc_us) {
+      epoch_last_utc_us = utc_us;
+
+      if (pps_pending && start_us >= pps_us &&
+          start_us - pps_us < GNSS_TIME_PPS_MATCH_US) {
+        // RMC of the second the TIMEPULSE edge started.
+        stats.nmea_latency_us = (int32_t)(start_us - pps_us);
+        pps_pending = 0;
+        pps_sync_us = pps_us;
+        sync(pps_us, utc_us, GNSS_TIME_PPS);
+      } else if (pps_sync_us == 0 ||
+                 start_us - pps_sync_us >= GNSS_TIME_PPS_TIMEOUT_US) {
+        sync(start_us - GNSS_TIME_NMEA_LATENCY_US, utc_us, GNSS_TIME_NMEA);
+      }
+    }
+  }
+
+  rtc_update();
+}
+
+uint8_t gnss_time_utc_us(uint64_t sys_us, int64_t *utc_us) {
+  if (!synced) {
+    return 0;
+  }
+  *utc_us = to_utc(sys_us);
+  return 1;
+}
+
+const gnss_time_stats_t *gnss_time_get_stats(void) { return &stats; }
@@ -11,191 +11,29 @@
 #include "bno085_runner.h"
 #include "can.h"
 #include "diagnostics.h"
+#include "gnss_time.h"
+#include "isotp.h"
+#include "logger.h"
 #include "rtc.h"
 #include "runcam_hal_uart.h"
 #include "scheduler.h"
 #include "sd.h"
+#include "storage.h"
+#include "systime.h"
 #include "telemetry.h"
+#include "time_sync.h"
 #include "ublox_hal_uart.h"
 #include "ws2812b_hal_pwm.h"
 #include "xbee_api_hal_uart.h"
 
 #include "configuration.h"
 
-/** Private variables. ********************************************************/
-
-FRESULT file_result = FR_NOT_READY;
-FATFS SDFatFs; // Not following snake case conventions here, see below.
-// TODO: Still evaluating if fatfs.c/h implementation of `FATFS SDFatFs;` should
-//  be used instead.
-
-uint8_t xbee_sensor_data_transmit_index = 0;
-uint8_t can_sensor_data_transmit_index = 0;
-
-/** Private functions. ********************************************************/
-
-void micro_sd_init(void) {
-  UINT bytes_written;
-
-  // Note: array lengths here are char count + 1 (null terminator).
-  char file_name[8] = "log.txt";
-  char data[16] = "Logging started";
-
-  // Initialize SD card and run checks.
-  sdio_mount_sd(&file_result, &SDFatFs);
-  if (file_result == FR_OK) {
-    sdio_set_file_name(file_name);
-    sdio_open_write_mode_sd_file(&file_result, file_name);
-    if (file_result == FR_OK) {
-      sdio_write_sd_file(&file_result, (void *)data, strlen(data),
-                         &bytes_written);
-      if (file_result == FR_OK && bytes_written > 0) {
-        sdio_close_sd_card_file(&file_result);
-      } else {
-        // TODO:Error handling for bytes not written or file_result not OK.
-      }
-    } else {
-      // TODO:Error handling for file open fails.
-    }
-  } else {
-    // TODO:Error handling for SD card mount fails.
-  }
-}
-
-void micro_sd_deinit() { sdio_unmount_sd(&file_result, &SDFatFs); }
-
-void transmit_sensor_data(char *data) {
-  xbee_send(XBEE_DESTINATION_64, XBEE_DESTINATION_16, (const uint8_t *)data,
-            strlen(data), 0);
-}
-
-/**
- * @brief Sequential sensor data transmission manager.
- */
-void sequential_transmit_sensor_data(void) {
-  char data[256];
-  char time_str[9] = {0};  // "HH:MM:SS\0".
-  char date_str[11] = {0}; // "DD-MM-YYYY\0".
-
-  // Reset index if out of bounds.
-  if (xbee_sensor_data_transmit_index < 0 ||
-      xbee_sensor_data_transmit_index > 8) {
-    xbee_sensor_data_transmit_index = 0;
-  }
-
-  // TODO: Implement centralized time metric/system and diagnostics.
-  switch (xbee_sensor_data_transmit_index) {
-  case 0:
-    sprintf(data, "temp=%f,baro=%f,f=%u", bmp390_temperature, bmp390_pressure,
-            bmp390_fault_count);
-    break;
-  case 1:
-    sprintf(data, "w=%f,i=%f,j=%f,k=%f,f=%u", bno085_quaternion_real,
-            bno085_quaternion_i, bno085_quaternion_j, bno085_quaternion_k,
-            bno085_fault_count);
-    break;
-  case 2:
-    sprintf(data, "accuracy_rad=%f,accuracy_deg=%f",
-            bno085_quaternion_accuracy_rad, bno085_quaternion_accuracy_deg);
-    break;
-  case 3:
-    sprintf(data, "gyro_x=%f,gyro_y=%f,gyro_z=%f", bno085_gyro_x, bno085_gyro_y,
-            bno085_gyro_z);
-    break;
-  case 4:
-    sprintf(data, "accel_x=%f,accel_y=%f,accel_z=%f", bno085_accel_x,
-            bno085_accel_y, bno085_accel_z);
-    break;
-  case 5:
-    sprintf(data, "lin_accel_x=%f,lin_accel_y=%f,lin_accel_z=%f",
-            bno085_lin_accel_x, bno085_lin_accel_y, bno085_lin_accel_z);
-    break;
-  case 6:
-    sprintf(data, "gravity_x=%f,gravity_y=%f,gravity_z=%f", bno085_gravity_x,
-            bno085_gravity_y, bno085_gravity_z);
-    break;
-  case 7:
-    if ((gps_data.lat_dir == 'N') || (gps_data.lat_dir == 'S')) {
-      // If direction data is not empty, transmit as expected.
-      sprintf(data, "altitude=%f,lat=%f_%c,long=%f_%c", gps_data.altitude_m,
-              gps_data.latitude, gps_data.lat_dir, gps_data.longitude,
-              gps_data.lon_dir);
-    } else {
-      // If direction data is empty (error/initializing), transmit zeros.
-      sprintf(data, "altitude=%f,lat=%f_%c,long=%f_%c", gps_data.altitude_m,
-              gps_data.latitude, '0', gps_data.longitude, '0');
-    }
-    break;
-  case 8:
-    // Fetch the current RTC time and date.
-    get_time_date(time_str, date_str);
-    // Format string to "datetime=01-04-2002 14:59:59".
-    sprintf(data, "datetime=%s %s", date_str, time_str);
-  default:
-    xbee_sensor_data_transmit_index = 0;
-    break; // Unknown index.
-  }
-
-  // Transmit the data after forming the string.
-  transmit_sensor_data(data);
-
-  // Increment the index and wrap around.
-  xbee_sensor_data_transmit_index = (xbee_sensor_data_transmit_index + 1) % 9;
-}
-
-void sequential_can_transmit(void) {
-  // Reset index if out of bounds.
-  if (can_sensor_data_transmit_index < 0 ||
-      can_sensor_data_transmit_index > 10) {
-    can_sensor_data_transmit_index = 0;
-  }
-
-  switch (can_sensor_data_transmit_index) {
-  case 0:
-    can_tx_state();
-    break;
-  case 1:
-    can_tx_barometric();
-    break;
-  case 2:
-    can_tx_gps1();
-    break;
-  case 3:
-    can_tx_gps2();
-    break;
-  case 4:
-    can_tx_gps3();
-    break;
-  case 5:
-    can_tx_imu1();
-    break;
-  case 6:
-    can_tx_imu2();
-    break;
-  case 7:
-    can_tx_imu3();
-    break;
-  case 8:
-    can_tx_imu4();
-    break;
-  case 9:
-    can_tx_imu5();
-    break;
-  case 10:
-    can_tx_rtc();
-    break;
-  default:
-    can_sensor_data_transmit_index = 0;
-    break; // Unknown index.
-  }
-
-  // Increment the index and wrap around.
-  can_sensor_data_transmit_index = (can_sensor_data_transmit_index + 1) % 11;
-}
-
 /** Public functions. *********************************************************/
 
 void nerve_init(void) {
+  // System time, every timestamp (sensors, CAN, log records) is taken from it.
+  systime_init();
+
   // Low level peripherals.
   can_init();
 
@@ -206,8 +44,9 @@ void nerve_init(void) {
   }
   ws2812b_update();
 
-  // On-board NVM.
-  micro_sd_init();
+  // On-board NVM, the SD card is mounted in the background (storage_process),
+  // records are buffered in RAM until then.
+  storage_init();
 
   // RTC.
 #ifdef NERVE_RTC_SET_FLAG
@@ -247,10 +86,20 @@ void nerve_init(void) {
 
   // Scheduler.
   scheduler_init(); // Initialize scheduler.
+  scheduler_add_task(can_rx_process, 1);
+  scheduler_add_task(can_monitor_update, CAN_MONITOR_PERIOD_MS);
+  scheduler_add_task(isotp_process, 1);
+  time_sync_init();
+  scheduler_add_task(time_sync_process, TIME_SYNC_TICK_MS);
+  gnss_time_init();
+  scheduler_add_task(gnss_time_process, GNSS_TIME_PROCESS_PERIOD_MS);
   scheduler_add_task(bmp390_get_data, 10);
-  scheduler_add_task(sequential_transmit_sensor_data, 50);
+  scheduler_add_task(xbee_tx_telemetry, TELEMETRY_XBEE_PERIOD_MS);
+  scheduler_add_task(storage_process, STORAGE_PROCESS_PERIOD_MS);
+  scheduler_add_task(logger_process, LOG_PROCESS_PERIOD_MS);
 
 #ifndef NERVE_DEBUG_FULL_CAN_TELEMETRY
-  scheduler_add_task(sequential_can_transmit, 10);
+  telemetry_init();
+  scheduler_add_task(can_tx_telemetry_due, TELEMETRY_CAN_TICK_MS);
 #endif
 }
@@ -0,0 +1,339 @@
+/*******************************************************************************
+ * @file isotp.c
+ * @brief ISO-TP (ISO 15765-2) transport layer over the CAN driver.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "isotp.h"
+#include "can.h"
+#include "can_nerve.h"
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+// Protocol control information (PCI) frame types, upper nibble of byte 0.
+#define ISOTP_PCI_SF 0x00 // Single frame.
+#define ISOTP_PCI_FF 0x10 // First frame.
+#define ISOTP_PCI_CF 0x20 // Consecutive frame.
+#define ISOTP_PCI_FC 0x30 // Flow control.
+
+// Flow control flow status.
+#define ISOTP_FS_CTS 0   // Continue to send.
+#define ISOTP_FS_WAIT 1  // Wait.
+#define ISOTP_FS_OVFLW 2 // Overflow, abort.
+
+#define ISOTP_FRAME_SIZE 8 // Classic CAN, all frames padded to 8 bytes.
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Enumeration for the ISO-TP transmit state.
+ */
+typedef enum {
+  ISOTP_TX_IDLE = 0,    // No transmission.
+  ISOTP_TX_WAIT_FC,     // First frame or block sent, waiting flow control.
+  ISOTP_TX_CONSECUTIVE, // Sending consecutive frames.
+} isotp_tx_state_t;
+
+/**
+ * @brief Struct holding the ISO-TP transmit session.
+ */
+typedef struct {
+  isotp_tx_state_t state; // Transmit state.
+  const uint8_t *data;    // Caller owned message data.
+  uint16_t length;        // Message length.
+  uint16_t offset;        // Next byte to send.
+  uint8_t sequence;       // Next consecutive frame sequence number (0-15).
+  uint8_t block_size;     // Receiver block size (0: no limit).
+  uint8_t block_left;     // Consecutive frames left in the current block.
+  uint8_t stmin_ms;       // Receiver minimum separation time (ms).
+  uint8_t wait_count;     // Consecutive flow control waits received.
+  uint32_t next_ms;       // Earliest time of the next consecutive frame.
+  uint32_t deadline_ms;   // Flow control (N_Bs) deadline.
+} isotp_tx_t;
+
+/**
+ * @brief Struct holding the ISO-TP receive session.
+ */
+typedef struct {
+  uint8_t active;       // Reassembly in progress.
+  uint16_t length;      // Message length from the first frame.
+  uint16_t offset;      // Bytes received.
+  uint8_t sequence;     // Expected consecutive frame sequence number.
+  uint8_t block_count;  // Consecutive frames received in the current block.
+  uint32_t deadline_ms; // Consecutive frame (N_Cr) deadline.
+  uint8_t buffer[ISOTP_RX_BUFFER_SIZE]; // Reassembly buffer.
+} isotp_rx_t;
+
+/** Private variables. ********************************************************/
+
+static isotp_tx_t tx = {0};
+static isotp_rx_t rx = {0};
+static isotp_stats_t stats = {0};
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Queue one padded ISO-TP frame on the CAN TX queue.
+ */
+static HAL_StatusTypeDef send_frame(const uint8_t *pci, uint8_t pci_length,
+                                    const uint8_t *payload,
+                                    uint8_t payload_length) {
+  uint8_t frame[ISOTP_FRAME_SIZE];
+
+  memset(frame, ISOTP_PADDING, sizeof(frame));
+  memcpy(frame, pci, pci_length);
+  memcpy(&frame[pci_length], payload, payload_length);
+  return can_send_raw(&ISOTP_CAN_HANDLE,
+                      dbc_messages[DBC_MESSAGE_ISOTP_RESPONSE].message_id,
+                      ISOTP_FRAME_SIZE, frame);
+}
+
+/**
+ * @brief Send a flow control frame.
+ */
+static void send_flow_control(uint8_t flow_status) {
+  const uint8_t pci[3] = {ISOTP_PCI_FC | flow_status, ISOTP_RX_BLOCK_SIZE,
+                          ISOTP_RX_STMIN};
+  send_frame(pci, sizeof(pci), 0, 0);
+}
+
+/**
+ * @brief Convert a received raw STmin to milliseconds.
+ *
+ * 100-900 us values (0xF1-0xF9) round up to the 1 ms task resolution, reserved
+ * values are treated as the maximum (127 ms) as required by ISO 15765-2.
+ */
+static uint8_t stmin_to_ms(uint8_t stmin) {
+  if (stmin <= 0x7F) {
+    return stmin;
+  }
+  if (stmin >= 0xF1 && stmin <= 0xF9) {
+    return 1;
+  }
+  return 0x7F;
+}
+
+/**
+ * @brief Abort the transmit session.
+ */
+static void tx_abort(void) {
+  tx.state = ISOTP_TX_IDLE;
+  stats.tx_errors++;
+}
+
+/**
+ * @brief Abort the receive session.
+ */
+static void rx_abort(void) {
+  rx.active = 0;
+  stats.rx_errors++;
+}
+
+/**
+ * @brief Handle a received flow control frame.
+ */
+static void on_flow_control(const uint8_t *data, uint32_t now_ms) {
+  if (tx.state != ISOTP_TX_WAIT_FC) {
+    return; // Unexpected, ignored.
+  }
+
+  switch (data[0] & 0x0F) {
+  case ISOTP_FS_CTS:
+    tx.block_size = data[1];
+    tx.block_left = data[1];
+    tx.stmin_ms = stmin_to_ms(data[2]);
+    tx.wait_count = 0;
+    tx.next_ms = now_ms;
+    tx.state = ISOTP_TX_CONSECUTIVE;
+    break;
+  case ISOTP_FS_WAIT:
+    if (++tx.wait_count > ISOTP_MAX_WFT) {
+      tx_abort();
+    } else {
+      tx.deadline_ms = now_ms + ISOTP_TIMEOUT_MS;
+    }
+    break;
+  case ISOTP_FS_OVFLW:
+  default:
+    tx_abort();
+    break;
+  }
+}
+
+/**
+ * @brief Handle a received first frame.
+ */
+static void on_first_frame(const uint8_t *data, uint32_t now_ms) {
+  const uint16_t length = (uint16_t)(((data[0] & 0x0F) << 8) | data[1]);
+
+  if (rx.active) {
+    rx_abort(); // A new first frame replaces the reception in progress.
+  }
+  if (length < ISOTP_FRAME_SIZE) {
+    return; // Invalid, single frame length.
+  }
+  if (length > ISOTP_RX_BUFFER_SIZE) {
+    send_flow_control(ISOTP_FS_OVFLW);
+    stats.rx_errors++;
+    return;
+  }
+
+  rx.active = 1;
+  rx.length = length;
+  rx.offset = ISOTP_FRAME_SIZE - 2;
+  rx.sequence = 1;
+  rx.block_count = 0;
+  rx.deadline_ms = now_ms + ISOTP_TIMEOUT_MS;
+  memcpy(rx.buffer, &data[2], ISOTP_FRAME_SIZE - 2);
+  send_flow_control(ISOTP_FS_CTS);
+}
+
+/**
+ * @brief Handle a received consecutive frame.
+ */
+static void on_consecutive_frame(const uint8_t *data, uint32_t now_ms) {
+  if (!rx.active) {
+    return; // Unexpected, ignored.
+  }
+  if ((data[0] & 0x0F) != rx.sequence) {
+    rx_abort(); // Lost or reordered frame.
+    return;
+  }
+
+  uint16_t chunk = rx.length - rx.offset;
+  if (chunk > ISOTP_FRAME_SIZE - 1) {
+    chunk = ISOTP_FRAME_SIZE - 1;
+  }
+  memcpy(&rx.buffer[rx.offset], &data[1], chunk);
+  rx.offset += chunk;
+  rx.sequence = (rx.sequence + 1) & 0x0F;
+  rx.deadline_ms = now_ms + ISOTP_TIMEOUT_MS;
+
+  if (rx.offset >= rx.length) {
+    rx.active = 0;
+    stats.rx_messages++;
+    isotp_rx_complete(rx.buffer, rx.length);
+  } else if (ISOTP_RX_BLOCK_SIZE != 0 &&
+             ++rx.block_count >= ISOTP_RX_BLOCK_SIZE) {
+    rx.block_count = 0;
+    send_flow_control(ISOTP_FS_CTS);
+  }
+}
+
+/** Generated DBC receive handler (overwriting weak default). *****************/
+
+void can_rx_isotp_request(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  const uint32_t now_ms = HAL_GetTick();
+  (void)header;
+
+  switch (data[0] & 0xF0) {
+  case ISOTP_PCI_SF: {
+    const uint8_t length = data[0] & 0x0F;
+    if (length >= 1 && length <= ISOTP_FRAME_SIZE - 1) {
+      if (rx.active) {
+        rx_abort(); // A new single frame replaces the reception in progress.
+      }
+      stats.rx_messages++;
+      isotp_rx_complete(&data[1], length);
+    }
+    break;
+  }
+  case ISOTP_PCI_FF:
+    on_first_frame(data, now_ms);
+    break;
+  case ISOTP_PCI_CF:
+    on_consecutive_frame(data, now_ms);
+    break;
+  case ISOTP_PCI_FC:
+    on_flow_control(data, now_ms);
+    break;
+  default:
+    break; // Unknown frame type, ignored.
+  }
+}
+
+/** Public functions. *********************************************************/
+
+HAL_StatusTypeDef isotp_send(const uint8_t *data, uint16_t length) {
+  if (tx.state != ISOTP_TX_IDLE) {
+    return HAL_BUSY;
+  }
+  if (length == 0 || length > 0x0FFF) {
+    return HAL_ERROR;
+  }
+
+  if (length <= ISOTP_FRAME_SIZE - 1) {
+    const uint8_t pci = ISOTP_PCI_SF | (uint8_t)length;
+    const HAL_StatusTypeDef status = send_frame(&pci, 1, data, length);
+    if (status == HAL_OK) {
+      stats.tx_messages++;
+    }
+    return status;
+  }
+
+  const uint8_t pci[2] = {ISOTP_PCI_FF | (uint8_t)(length >> 8),
+                          (uint8_t)length};
+  if (send_frame(pci, sizeof(pci), data, ISOTP_FRAME_SIZE - 2) != HAL_OK) {
+    return HAL_ERROR;
+  }
+
+  tx.data = data;
+  tx.length = length;
+  tx.offset = ISOTP_FRAME_SIZE - 2;
+  tx.sequence = 1;
+  tx.wait_count = 0;
+  tx.deadline_ms = HAL_GetTick() + ISOTP_TIMEOUT_MS;
+  tx.state = ISOTP_TX_WAIT_FC;
+  return HAL_OK;
+}
+
+uint8_t isotp_tx_busy(void) { return tx.state != ISOTP_TX_IDLE; }
+
+void isotp_process(void) {
+  const uint32_t now_ms = HAL_GetTick();
+
+  // Timeouts.
+  if (tx.state == ISOTP_TX_WAIT_FC &&
+      (int32_t)(now_ms - tx.deadline_ms) >= 0) {
+    tx_abort(); // N_Bs.
+  }
+  if (rx.active && (int32_t)(now_ms - rx.deadline_ms) >= 0) {
+    rx_abort(); // N_Cr.
+  }
+
+  // Consecutive frames, paced by STmin, block size and the TX queue space.
+  while (tx.state == ISOTP_TX_CONSECUTIVE &&
+         (int32_t)(now_ms - tx.next_ms) >= 0 &&
+         can_tx_queue_free(&ISOTP_CAN_HANDLE) > ISOTP_TX_QUEUE_RESERVE) {
+    uint16_t chunk = tx.length - tx.offset;
+    if (chunk > ISOTP_FRAME_SIZE - 1) {
+      chunk = ISOTP_FRAME_SIZE - 1;
+    }
+    const uint8_t pci = ISOTP_PCI_CF | tx.sequence;
+    if (send_frame(&pci, 1, &tx.data[tx.offset], (uint8_t)chunk) != HAL_OK) {
+      break; // Retried on the next call.
+    }
+    tx.offset += chunk;
+    tx.sequence = (tx.sequence + 1) & 0x0F;
+
+    if (tx.offset >= tx.length) {
+      tx.state = ISOTP_TX_IDLE;
+      stats.tx_messages++;
+    } else if (tx.block_size != 0 && --tx.block_left == 0) {
+      tx.deadline_ms = now_ms + ISOTP_TIMEOUT_MS;
+      tx.state = ISOTP_TX_WAIT_FC;
+    } else if (tx.stmin_ms != 0) {
+      tx.next_ms = now_ms + tx.stmin_ms;
+    }
+  }
+}
+
+__weak void isotp_rx_complete(const uint8_t *data, uint16_t length) {
+  (void)data;
+  (void)length;
+}
+
+const isotp_stats_t *isotp_get_stats(void) { return &stats; }
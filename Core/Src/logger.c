@@ -0,0 +1,1471 @@
+/*******************************************************************************
+ * @file logger.c
+ * @brief Binary flight logger on the SD card.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "logger.h"
+#include "crc.h"
+#include "diskio.h"
+#include "rtc.h"
+#include "sd.h"
+#include "sd_diskio.h"
+#include "systime.h"
+#include "ublox_hal_uart.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+#define LOG_SECTOR_SIZE 512 // SD card block size.
+#define LOG_BUFFER_SECTORS (LOG_BUFFER_SIZE / LOG_SECTOR_SIZE)
+#define LOG_SCHEMA_SECTORS (LOG_SCHEMA_BLOCK_SIZE / LOG_SECTOR_SIZE)
+
+#if (LOG_BUFFER_SIZE % LOG_SECTOR_SIZE) != 0
+#error "LOG_BUFFER_SIZE must be a multiple of the 512 B sector."
+#endif
+#if LOG_BUFFER_COUNT < 2 || LOG_BUFFER_COUNT > 0xFF
+#error "LOG_BUFFER_COUNT must be 2 to 255 blocks."
+#endif
+#if (LOG_PREALLOCATE_SIZE % LOG_BUFFER_SIZE) != 0
+#error "LOG_PREALLOCATE_SIZE must be a multiple of LOG_BUFFER_SIZE."
+#endif
+#if LOG_ALLOCATION_STEP == 0
+#error "LOG_ALLOCATION_STEP must be at least one cluster (bytes)."
+#endif
+#if LOG_BUFFER_SIZE > 0xFFFF || LOG_BUFFER_SECTORS > 0xFF
+#error "LOG_BUFFER_SIZE does not fit the block header length and sectors."
+#endif
+#if (LOG_SCHEMA_BLOCK_SIZE % LOG_SECTOR_SIZE) != 0 ||                          \
+    LOG_SCHEMA_BLOCK_SIZE > LOG_BUFFER_SIZE
+#error "LOG_SCHEMA_BLOCK_SIZE must be a sector multiple up to LOG_BUFFER_SIZE."
+#endif
+
+#define LOG_INDEX_BLOCKS (LOG_INDEX_INTERVAL / LOG_BUFFER_SIZE)
+#define LOG_INDEX_ENTRIES (2 * LOG_INDEX_BLOCKS) // Room while delayed.
+
+#if (LOG_INDEX_INTERVAL % LOG_BUFFER_SIZE) != 0 || LOG_INDEX_BLOCKS < 1
+#error "LOG_INDEX_INTERVAL must be a multiple of LOG_BUFFER_SIZE."
+#endif
+
+#define LOG_VARINT_MAX_SIZE 5 // uint32_t, 7 bits per byte.
+#define LOG_CODEC_MAX_SIZE (LOG_CODEC_MAX_FIELDS * LOG_VARINT_MAX_SIZE)
+
+#define LOG_SESSION_SIZE 24      // Session directory name, with suffix.
+#define LOG_SESSION_SUFFIXES 100 // Suffixes tried (_1 to _99).
+#define LOG_PATH_SIZE 48         // Session directory and 8.3 file name.
+#define LOG_INDEX_TEMP_NAME "SESSIONS.TMP"
+#define LOG_RETRY_PERIOD_MS 1000 // Failed file pre-creation retried after.
+
+// Fast seek table (DWORDs) of a file being released, up to 7 fragments.
+#define LOG_LINKMAP_SIZE 16
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Struct describing a record type payload (schema record).
+ *
+ * The format uses Python struct syntax so a host decoder can unpack any record
+ * type from the schema alone. Streams with codec fields are compressed, their
+ * payload is only float fields, each a fixed point value with q fraction bits.
+ */
+typedef struct {
+  const char *name;                // Record name.
+  const char *format;              // Payload format (Python struct, LE).
+  const char *fields;              // Comma separated field names.
+  uint8_t codec_fields;            // Compressed float fields, 0 for raw.
+  uint8_t q[LOG_CODEC_MAX_FIELDS]; // Fraction bits per field.
+} log_record_schema_t;
+
+/**
+ * @brief Enumeration for the log file slot states.
+ */
+typedef enum {
+  LOG_FILE_CLOSED = 0, // Free.
+  LOG_FILE_OPENING,    // Next file created, pre-allocated in the background.
+  LOG_FILE_READY,      // Pre-created next file (schema block written).
+  LOG_FILE_ACTIVE,     // Current file.
+  LOG_FILE_CLOSING,    // Previous file, closed in the background.
+  LOG_FILE_RELEASING   // Footer written, unused space released (background).
+} log_file_state_t;
+
+/**
+ * @brief Enumeration for the logger_start_step phases, one step each.
+ */
+typedef enum {
+  LOG_START_IDLE = 0, // Not starting.
+  LOG_START_RESUME,   // Next file of the suspended session.
+  LOG_START_PRUNE,    // Delete old sessions below LOG_MIN_FREE_BYTES.
+  LOG_START_COMPACT,  // Rewrite the index without the deleted sessions.
+  LOG_START_SESSION,  // Create and index the session directory.
+  LOG_START_CREATE,   // Create the first file of the session.
+  LOG_START_OPEN      // Pre-allocate the first file and write its schema.
+} log_start_phase_t;
+
+/**
+ * @brief Struct holding one open log file.
+ */
+typedef struct {
+  FIL file;
+  log_file_state_t state;
+  uint16_t index;        // LOG_FILE_NAME index in the session.
+  uint32_t log_id;       // Block header log identifier (created systime_us32).
+  uint32_t sequence;     // Next block sequence.
+  uint32_t bytes;        // File size (blocks written).
+  uint8_t raw;           // Streaming to the pre-allocated sectors.
+  DWORD clusters;        // Contiguous clusters allocated while opening.
+  DWORD raw_start;       // First sector of the pre-allocated file.
+  DWORD raw_sector;      // Next sector to write.
+  DWORD raw_end;         // End of the pre-allocated file (sector).
+  uint32_t index_offset; // Last index block, 0 if none.
+  uint8_t entry_count;   // Data blocks written since the last index block.
+  log_index_entry_t entries[LOG_INDEX_ENTRIES];
+  uint32_t entry_us[LOG_INDEX_ENTRIES]; // First record timestamps.
+  DWORD linkmap[LOG_LINKMAP_SIZE];       // Fast seek table, 0 if none yet.
+} log_file_t;
+
+/** Private variables. ********************************************************/
+
+// BNO085 reports are fixed point (SH-2 reference manual Q points).
+static const log_record_schema_t schema[LOG_RECORD_TYPE_COUNT] = {
+    [LOG_RECORD_IMU_QUATERNION] = {"imu_quaternion", "<5f",
+                                   "i,j,k,real,accuracy_rad", 5,
+                                   {14, 14, 14, 14, 12}},
+    [LOG_RECORD_IMU_GYRO] = {"imu_gyro", "<3f", "x,y,z", 3, {9, 9, 9}},
+    [LOG_RECORD_IMU_ACCEL] = {"imu_accel", "<3f", "x,y,z", 3, {8, 8, 8}},
+    [LOG_RECORD_IMU_LIN_ACCEL] = {"imu_lin_accel", "<3f", "x,y,z", 3,
+                                  {8, 8, 8}},
+    [LOG_RECORD_IMU_GRAVITY] = {"imu_gravity", "<3f", "x,y,z", 3, {8, 8, 8}},
+    [LOG_RECORD_BAROMETRIC] = {"barometric", "<2f", "pressure,temperature"},
+    [LOG_RECORD_GPS] = {"gps", "<7fBB2x",
+                        "latitude,longitude,altitude_m,geoid_sep_m,"
+                        "speed_knots,course_deg,hdop,position_fix,satellites"},
+    [LOG_RECORD_CAN_FRAME] = {"can_frame", "<HBB8s", "std_id,flags,dlc,data"},
+    [LOG_RECORD_INDEX] = {"index", "<IB3x", "previous,footer"},
+    [LOG_RECORD_INDEX_ENTRY] = {"index_entry", "<II", "sequence,offset"},
+    [LOG_RECORD_GNSS_TIME] = {"gnss_time", "<qIiiB3x",
+                              "utc_us,sys_us,drift_ppb,offset_us,source"},
+    [LOG_RECORD_RTC_TIME] = {"rtc_time", "<qIi", "epoch_us,sys_us,step_us"},
+};
+
+// Ring of blocks, producers (thread and interrupts, IRQs masked) fill one
+// while the sealed blocks before it are written in order, the oldest by SDIO
+// DMA. Sealed blocks wait in RAM while suspended. The index block follows, so
+// both are in the write-behind region.
+static struct {
+  uint8_t buffers[LOG_BUFFER_COUNT][LOG_BUFFER_SIZE];
+  uint8_t index_block[LOG_SECTOR_SIZE];
+} dma __attribute__((aligned(4)));
+static volatile uint8_t fill = 0;          // Block producers append to.
+static volatile uint32_t fill_length = 0;  // Bytes in the fill block.
+static volatile uint8_t sealed = 0;        // Sealed blocks, not written.
+static volatile uint32_t sealed_bytes = 0; // Bytes in the sealed blocks.
+static uint8_t oldest = 0;                 // Oldest sealed block.
+static volatile uint32_t sealed_length[LOG_BUFFER_COUNT];
+static volatile uint32_t first_us[LOG_BUFFER_COUNT]; // First record per block.
+static volatile uint32_t fill_ms = 0;     // First record time of fill block.
+static volatile uint32_t fill_serial = 0; // Fill blocks started.
+static uint8_t writing = 0;               // Oldest block write in flight.
+static uint32_t write_start_ms = 0;
+static log_file_t *index_writing = NULL; // Index block write in flight.
+static uint32_t index_writing_offset = 0;
+
+// Current file and the previous (closing) or next (ready) file. With the index
+// file or a session directory, at most 3 objects are open (_FS_LOCK).
+static log_file_t files[2];
+static uint8_t current = 0;
+static uint16_t next_index = 0;    // Next LOG_FILE_NAME index.
+static uint32_t file_start_ms = 0; // Current file start.
+static uint8_t open_failed = 0;    // Next file pre-creation failed.
+static uint32_t open_failed_ms = 0;
+static uint8_t schema_block[LOG_SCHEMA_BLOCK_SIZE] __attribute__((aligned(4)));
+
+_Static_assert(LOG_BLOCK_HEADER_SIZE + LOG_RECORD_HEADER_SIZE +
+                       sizeof(log_index_t) +
+                       LOG_INDEX_ENTRIES * (LOG_RECORD_HEADER_SIZE +
+                                            sizeof(log_index_entry_t)) <=
+                   LOG_SECTOR_SIZE,
+               "Index block entries do not fit one sector.");
+
+// Sessions, the oldest are deleted one file per background step.
+static char session[LOG_SESSION_SIZE];       // Current session directory.
+static char prune_session[LOG_SESSION_SIZE]; // Session being deleted.
+static uint8_t prune_done = 0;               // Nothing left to delete.
+static char prune_path[LOG_PATH_SIZE];       // File being deleted.
+static uint8_t prune_open = 0;               // prune_file being released.
+static FIL prune_file;
+static DWORD prune_linkmap[LOG_LINKMAP_SIZE]; // prune_file fast seek table.
+static FIL index_file;
+static FILINFO info; // Large with LFN, kept off the stack.
+
+// Compression, fixed point values of the previous record per stream and the
+// fill block (fill_serial) they are in.
+static int32_t codec_previous[LOG_RECORD_TYPE_COUNT][LOG_CODEC_MAX_FIELDS];
+static uint32_t codec_serial[LOG_RECORD_TYPE_COUNT];
+static uint8_t uncompressed[LOG_RECORD_TYPE_COUNT]; // logger_set_compression.
+
+static volatile uint8_t active = 0; // Records buffered.
+static uint8_t online = 0;          // Files open on the mounted card.
+static log_start_phase_t start_phase = LOG_START_IDLE;
+static uint32_t dirty_bytes = 0; // Written with f_write since the last sync.
+static logger_stats_t stats = {0};
+static logger_stream_stats_t stream_stats[LOG_RECORD_TYPE_COUNT];
+
+_Static_assert(LOG_RECORD_TYPE_COUNT <= LOG_RECORD_COMPRESSED,
+               "Record types overlap the compressed flag.");
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Copy bytes into the fill block (caller ensures space).
+ */
+static void buffer_put(const void *data, uint32_t length) {
+  memcpy(&dma.buffers[fill][fill_length], data, length);
+  fill_length += length;
+}
+
+/**
+ * @brief Check if a block is free to fill after sealing the fill block.
+ */
+static uint8_t buffer_free(void) { return sealed < LOG_BUFFER_COUNT - 1; }
+
+/**
+ * @brief Seal the fill block and fill the next (IRQs masked, buffer_free).
+ */
+static void buffer_seal(void) {
+  sealed_length[fill] = fill_length;
+  sealed_bytes += fill_length;
+  sealed++;
+  fill = (uint8_t)((fill + 1) % LOG_BUFFER_COUNT);
+  fill_length = LOG_BLOCK_HEADER_SIZE; // Header written when queued.
+  fill_serial++;                       // Compression starts over.
+}
+
+/**
+ * @brief Release the oldest sealed block once written (or discarded).
+ */
+static void buffer_release(void) {
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  sealed_bytes -= sealed_length[oldest];
+  oldest = (uint8_t)((oldest + 1) % LOG_BUFFER_COUNT);
+  sealed--; // Producers may fill it again.
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Empty the ring, no record buffered (not active).
+ */
+static void buffer_reset(void) {
+  fill = 0;
+  fill_length = LOG_BLOCK_HEADER_SIZE;
+  fill_serial++; // No stream compressed against a previous session.
+  sealed = 0;
+  sealed_bytes = 0;
+  oldest = 0;
+  writing = 0;
+  index_writing = NULL;
+}
+
+/**
+ * @brief Append a varint (7 bits per byte, low first, high bit continues).
+ *
+ * @return Bytes used after the varint.
+ */
+static uint8_t varint_put(uint8_t *out, uint8_t length, uint32_t value) {
+  while (value >= 0x80) {
+    out[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = (uint8_t)value;
+  return length;
+}
+
+/**
+ * @brief Encode a stream record against the previous one in the fill block
+ * (IRQs masked): per field, fixed point delta, zigzag then varint.
+ *
+ * @param fixed Fixed point values, kept by codec_commit once buffered.
+ * @param out Encoded payload (LOG_CODEC_MAX_SIZE).
+ *
+ * @return Encoded length, 0 to store the record raw (no codec, disabled or a
+ * value not exact in fixed point).
+ */
+static uint8_t codec_encode(log_record_type_t type, const void *payload,
+                            uint8_t length, int32_t *fixed, uint8_t *out) {
+  if (!LOG_COMPRESSION || type >= LOG_RECORD_TYPE_COUNT || uncompressed[type]) {
+    return 0;
+  }
+  const log_record_schema_t *record = &schema[type];
+  if (record->codec_fields == 0 ||
+      length != record->codec_fields * sizeof(float)) {
+    return 0;
+  }
+
+  const uint8_t first = (codec_serial[type] != fill_serial);
+  uint8_t encoded = 0;
+  for (uint8_t i = 0; i < record->codec_fields; i++) {
+    float value;
+    memcpy(&value, (const uint8_t *)payload + i * sizeof(float), sizeof(value));
+
+    // Power of 2 scale, exact unless out of range or finer than q bits.
+    const float scaled = value * (float)(1UL << record->q[i]);
+    if (!(scaled >= -2147483648.0f && scaled < 2147483648.0f)) {
+      return 0; // Out of range or NaN.
+    }
+    fixed[i] = (int32_t)scaled;
+    if ((float)fixed[i] != scaled) {
+      return 0;
+    }
+
+    // Wrapping delta, the decoder wraps the same way.
+    const uint32_t delta =
+        (uint32_t)fixed[i] - (first ? 0 : (uint32_t)codec_previous[type][i]);
+    const uint32_t zigzag = (delta << 1) ^ (0U - (delta >> 31));
+    encoded = varint_put(out, encoded, zigzag);
+  }
+  return encoded;
+}
+
+/**
+ * @brief Keep the values of a buffered compressed record (IRQs masked).
+ */
+static void codec_commit(log_record_type_t type, const int32_t *fixed) {
+  memcpy(codec_previous[type], fixed,
+         schema[type].codec_fields * sizeof(int32_t));
+  codec_serial[type] = fill_serial;
+}
+
+/**
+ * @brief Write a block header (CRC over the used bytes).
+ */
+static void block_header(uint8_t *block, uint32_t length, uint8_t sectors,
+                         uint32_t block_sequence, uint32_t block_log_id) {
+  log_block_header_t header = {
+      .magic = LOG_BLOCK_MAGIC,
+      .version = LOG_FILE_VERSION,
+      .sectors = sectors,
+      .length = (uint16_t)length,
+      .sequence = block_sequence,
+      .log_id = block_log_id,
+      .crc = 0,
+  };
+
+  memcpy(block, &header, sizeof(header));
+  header.crc = crc32(block, length);
+  memcpy(&block[offsetof(log_block_header_t, crc)], &header.crc,
+         sizeof(header.crc));
+}
+
+/**
+ * @brief Write the header of the oldest sealed block for the current file.
+ */
+static uint8_t *block_finish(uint8_t slot) {
+  uint8_t *block = dma.buffers[slot];
+  block_header(block, sealed_length[slot], LOG_BUFFER_SECTORS,
+               files[current].sequence++, files[current].log_id);
+  return block;
+}
+
+/**
+ * @brief Append one record to a block built in place (caller ensures space).
+ *
+ * @return Bytes used after the record.
+ */
+static uint32_t record_put(uint8_t *block, uint32_t length,
+                           log_record_type_t type, const void *payload,
+                           uint8_t size, uint32_t timestamp_us) {
+  block[length] = (uint8_t)type;
+  block[length + 1] = size;
+  memcpy(&block[length + 2], &timestamp_us, sizeof(timestamp_us));
+  memcpy(&block[length + LOG_RECORD_HEADER_SIZE], payload, size);
+  return length + LOG_RECORD_HEADER_SIZE + size;
+}
+
+/**
+ * @brief Build the schema block (sequence 0), a schema record per record type.
+ */
+static void schema_build(uint32_t block_log_id) {
+  const uint32_t timestamp_us = systime_us32();
+  uint32_t length = LOG_BLOCK_HEADER_SIZE;
+
+  memset(schema_block, 0, sizeof(schema_block));
+
+  // Payload: type (1 byte), then "name;format;fields" and ";q,q,..." for a
+  // compressed stream (not terminated).
+  for (uint8_t type = 1; type < LOG_RECORD_TYPE_COUNT; type++) {
+    const uint32_t text = length + LOG_RECORD_HEADER_SIZE + 1;
+    if (text >= sizeof(schema_block)) {
+      break;
+    }
+    char *text_start = (char *)&schema_block[text];
+    const uint32_t text_size = sizeof(schema_block) - text;
+    int text_length =
+        snprintf(text_start, text_size, "%s;%s;%s", schema[type].name,
+                 schema[type].format, schema[type].fields);
+    for (uint8_t i = 0; i < schema[type].codec_fields && text_length >= 0 &&
+                        text_length < (int)text_size;
+         i++) {
+      text_length +=
+          snprintf(&text_start[text_length], text_size - (uint32_t)text_length,
+                   "%c%u", (i == 0) ? ';' : ',', (unsigned)schema[type].q[i]);
+    }
+    if (text_length < 0 || text_length >= (int)text_size ||
+        text_length > 0xFE) {
+      continue; // Does not fit, LOG_SCHEMA_BLOCK_SIZE too small.
+    }
+
+    schema_block[length] = LOG_RECORD_SCHEMA;
+    schema_block[length + 1] = (uint8_t)(text_length + 1);
+    memcpy(&schema_block[length + 2], &timestamp_us, sizeof(timestamp_us));
+    schema_block[length + LOG_RECORD_HEADER_SIZE] = type;
+    length = text + (uint32_t)text_length;
+  }
+  block_header(schema_block, length, LOG_SCHEMA_SECTORS, 0, block_log_id);
+}
+
+/**
+ * @brief Write bytes to the log file.
+ *
+ * Returns once the DMA is started for whole buffers (write-behind), blocks for
+ * anything else (partial buffer on stop).
+ */
+static uint8_t write_file(log_file_t *log_file, const uint8_t *data,
+                          uint32_t length) {
+  UINT bytes_written = 0;
+
+  if (f_write(&log_file->file, data, length, &bytes_written) != FR_OK ||
+      bytes_written != length) {
+    stats.write_errors++; // Data discarded, logging continues.
+    return 0;
+  }
+  stats.bytes += bytes_written;
+  dirty_bytes += bytes_written;
+  log_file->bytes += bytes_written;
+  return 1;
+}
+
+/**
+ * @brief Check if the log file is fully pre-allocated.
+ */
+static uint8_t preallocated(const log_file_t *log_file) {
+  const FSIZE_t cluster_bytes =
+      (FSIZE_t)log_file->file.obj.fs->csize * LOG_SECTOR_SIZE;
+  return (FSIZE_t)log_file->clusters * cluster_bytes >= LOG_PREALLOCATE_SIZE;
+}
+
+/**
+ * @brief Pre-allocate the next LOG_ALLOCATION_STEP bytes (at least one
+ * cluster) of the log file, f_lseek past the end allocating one cluster.
+ *
+ * The clusters follow the contiguous free area found by f_expand (file_create),
+ * each is checked to be the next one so the file is one sector range.
+ *
+ * @return 1 if contiguous so far, 0 to use f_write.
+ */
+static uint8_t preallocate_step(log_file_t *log_file) {
+  FIL *file = &log_file->file;
+  const FSIZE_t cluster_bytes = (FSIZE_t)file->obj.fs->csize * LOG_SECTOR_SIZE;
+
+  for (FSIZE_t step = 0; step < LOG_ALLOCATION_STEP && !preallocated(log_file);
+       step += cluster_bytes) {
+    // On a full card f_lseek stops short, the cluster is then not the next.
+    if (f_lseek(file, (log_file->clusters + 1) * cluster_bytes) != FR_OK ||
+        file->clust != file->obj.sclust + log_file->clusters) {
+      return 0;
+    }
+    log_file->clusters++;
+  }
+
+  // Recorded in the directory entry each step, so a crash leaves the
+  // allocation to the file (no lost clusters).
+  return f_sync(file) == FR_OK;
+}
+
+/**
+ * @brief Set the fast seek table of a file, so f_lseek no longer walks its
+ * cluster chain from the start.
+ *
+ * A contiguous file (clusters from sclust) needs no FAT access, any other file
+ * has its chain walked once (CREATE_LINKMAP). With more fragments than the
+ * table holds, the file keeps the normal seek.
+ */
+static void linkmap_create(FIL *file, DWORD *linkmap, DWORD clusters) {
+  linkmap[0] = LOG_LINKMAP_SIZE;
+  file->cltbl = linkmap;
+  if (clusters > 0) {
+    linkmap[1] = clusters;
+    linkmap[2] = file->obj.sclust;
+    linkmap[3] = 0;
+  } else if (f_lseek(file, CREATE_LINKMAP) != FR_OK) {
+    file->cltbl = NULL; // Normal seek.
+  }
+}
+
+/**
+ * @brief Release the clusters of a file above size, at most LOG_ALLOCATION_STEP
+ * bytes from its end (f_truncate), bounding the FAT updates.
+ *
+ * The first step walks the cluster chain once into the fast seek table
+ * (linkmap, linkmap_create), the seeks back from the end then read no FAT.
+ *
+ * @return FR_OK if released (done once f_size is size), else the FatFs error.
+ */
+static FRESULT truncate_step(FIL *file, DWORD *linkmap, FSIZE_t size) {
+  FSIZE_t keep = size;
+
+  if (linkmap[0] == 0 && f_size(file) > size) {
+    linkmap_create(file, linkmap, 0);
+    return FR_OK;
+  }
+  if (f_size(file) > size + LOG_ALLOCATION_STEP) {
+    keep = f_size(file) - LOG_ALLOCATION_STEP;
+  }
+  FRESULT result = f_lseek(file, keep);
+  if (result == FR_OK) {
+    result = f_truncate(file);
+  }
+  if (result == FR_OK) {
+    result = f_sync(file); // Size recorded with the FAT, no lost clusters.
+  }
+  return result;
+}
+
+/**
+ * @brief Stop raw streaming, the file position is moved after the streamed
+ * data for f_write (blocking, walks the cluster chain).
+ */
+static void raw_stop(log_file_t *log_file) {
+  if (!log_file->raw) {
+    return;
+  }
+  log_file->raw = 0;
+  if (f_lseek(&log_file->file,
+              (FSIZE_t)(log_file->raw_sector - log_file->raw_start) *
+                  LOG_SECTOR_SIZE) != FR_OK) {
+    stats.write_errors++;
+  }
+}
+
+/**
+ * @brief Write whole blocks, returns once the DMA is started for the logging
+ * buffers (write-behind), blocks for any other block.
+ *
+ * Streamed straight to the next pre-allocated sectors (disk_write, no FAT
+ * access), or appended with f_write once the pre-allocated file is full.
+ *
+ * @return 1 if written (or in flight), otherwise 0 (discarded).
+ */
+static uint8_t write_block(log_file_t *log_file, const uint8_t *data,
+                           uint32_t sectors) {
+  if (log_file->raw && log_file->raw_sector + sectors > log_file->raw_end) {
+    raw_stop(log_file); // Pre-allocated file full, continue appending.
+  }
+  if (!log_file->raw) {
+    return write_file(log_file, data, sectors * LOG_SECTOR_SIZE);
+  }
+
+  if (disk_write(log_file->file.obj.fs->drv, data, log_file->raw_sector,
+                 sectors) != RES_OK) {
+    stats.write_errors++;
+    return 0;
+  }
+  log_file->raw_sector += sectors;
+  stats.bytes += sectors * LOG_SECTOR_SIZE;
+  log_file->bytes += sectors * LOG_SECTOR_SIZE;
+  return 1;
+}
+
+/**
+ * @brief Add a written data block to the next index block.
+ */
+static void index_add(log_file_t *log_file, uint32_t block_sequence,
+                      uint32_t offset, uint32_t timestamp_us) {
+  if (log_file->entry_count >= LOG_INDEX_ENTRIES) {
+    return; // Index block delayed, the index gets sparser.
+  }
+  log_index_entry_t *entry = &log_file->entries[log_file->entry_count];
+  entry->sequence = block_sequence;
+  entry->offset = offset;
+  log_file->entry_us[log_file->entry_count++] = timestamp_us;
+}
+
+/**
+ * @brief Write an index block (one sector) with the entries added since the
+ * previous one, returns once the DMA is started (write-behind, the chain
+ * points to it once completed).
+ *
+ * @param footer 1 for the last index block of the file (closing).
+ */
+static void index_write(log_file_t *log_file, uint8_t footer) {
+  const log_index_t index = {.previous = log_file->index_offset,
+                             .footer = footer};
+  const uint32_t offset = log_file->bytes;
+
+  memset(dma.index_block, 0, sizeof(dma.index_block));
+  uint32_t length =
+      record_put(dma.index_block, LOG_BLOCK_HEADER_SIZE, LOG_RECORD_INDEX,
+                 &index, sizeof(index), systime_us32());
+  for (uint8_t i = 0; i < log_file->entry_count; i++) {
+    length = record_put(dma.index_block, length, LOG_RECORD_INDEX_ENTRY,
+                        &log_file->entries[i], sizeof(log_index_entry_t),
+                        log_file->entry_us[i]);
+  }
+  block_header(dma.index_block, length, 1, log_file->sequence++,
+               log_file->log_id);
+
+  // Entries of a failed write are lost, the chain skips the block.
+  log_file->entry_count = 0;
+  if (write_block(log_file, dma.index_block, 1)) {
+    index_writing = log_file; // Chained in write_completed.
+    index_writing_offset = offset;
+  }
+}
+
+/**
+ * @brief Create the next log file of the session and find a contiguous free
+ * area for its pre-allocation (f_expand, reads the FAT only).
+ *
+ * @return FR_OK if created (LOG_FILE_OPENING), else the FatFs error.
+ */
+static FRESULT file_create(log_file_t *log_file) {
+  char path[LOG_PATH_SIZE];
+
+  snprintf(path, sizeof(path), "%s/" LOG_FILE_NAME, session,
+           (unsigned)next_index);
+  const FRESULT result =
+      f_open(&log_file->file, path, FA_CREATE_NEW | FA_WRITE);
+  if (result != FR_OK) {
+    return result;
+  }
+  log_file->index = next_index++;
+
+  log_file->log_id = systime_us32();
+  log_file->sequence = 1; // Block 0 is the schema block.
+  log_file->bytes = LOG_SCHEMA_BLOCK_SIZE;
+  log_file->index_offset = 0;
+  log_file->entry_count = 0;
+  log_file->clusters = 0;
+  log_file->linkmap[0] = 0;
+  log_file->raw = (LOG_PREALLOCATE_SIZE > 0 &&
+                   f_expand(&log_file->file, LOG_PREALLOCATE_SIZE, 0) == FR_OK);
+  log_file->state = LOG_FILE_OPENING;
+  return FR_OK;
+}
+
+/**
+ * @brief One step opening a created log file: pre-allocate the next
+ * LOG_ALLOCATION_STEP bytes, or once done, start the file with its schema
+ * block (LOG_FILE_READY).
+ *
+ * @return FR_OK if opening or ready, else the FatFs error (file closed).
+ */
+static FRESULT file_open_step(log_file_t *log_file) {
+  FIL *file = &log_file->file;
+  FRESULT result = FR_OK;
+  UINT bytes_written = 0;
+
+  if (log_file->raw && !preallocated(log_file)) {
+    log_file->raw = preallocate_step(log_file); // Else f_write, in place.
+    return FR_OK;
+  }
+
+  schema_build(log_file->log_id);
+  if (log_file->raw) {
+    const FATFS *fs = file->obj.fs;
+    log_file->raw_start =
+        fs->database + (DWORD)fs->csize * (file->obj.sclust - 2);
+    log_file->raw_sector = log_file->raw_start;
+    log_file->raw_end =
+        log_file->raw_start + LOG_PREALLOCATE_SIZE / LOG_SECTOR_SIZE;
+    if (disk_write(fs->drv, schema_block, log_file->raw_sector,
+                   LOG_SCHEMA_SECTORS) != RES_OK) {
+      result = FR_DISK_ERR;
+    }
+    log_file->raw_sector += LOG_SCHEMA_SECTORS;
+  } else {
+    // Any clusters already allocated are overwritten, released on close.
+    result = f_lseek(file, 0);
+    if (result == FR_OK) {
+      result = f_write(file, schema_block, sizeof(schema_block),
+                       &bytes_written);
+    }
+    if (result == FR_OK && bytes_written != sizeof(schema_block)) {
+      result = FR_DENIED; // Card full.
+    }
+    if (result == FR_OK) {
+      result = f_sync(file);
+    }
+  }
+
+  if (result != FR_OK) {
+    f_close(file);
+    log_file->state = LOG_FILE_CLOSED;
+    return result;
+  }
+  log_file->state = LOG_FILE_READY;
+  return FR_OK;
+}
+
+/**
+ * @brief Create, pre-allocate and start the next log file of the session with
+ * its schema block (blocking, logger_start).
+ *
+ * @return FR_OK if ready, else the FatFs error.
+ */
+static FRESULT file_open(log_file_t *log_file) {
+  FRESULT result = file_create(log_file);
+
+  while (result == FR_OK && log_file->state == LOG_FILE_OPENING) {
+    result = file_open_step(log_file);
+  }
+  return result;
+}
+
+/**
+ * @brief One step closing a log file: write its footer (last index block),
+ * then release the unused pre-allocated space LOG_ALLOCATION_STEP bytes at a
+ * time from the end and close it (LOG_FILE_CLOSED).
+ */
+static void file_close_step(log_file_t *log_file) {
+  FIL *file = &log_file->file;
+
+  if (log_file->state != LOG_FILE_RELEASING) {
+    // Still contiguous, the seek after the footer reads no FAT.
+    index_write(log_file, 1);
+    if (log_file->raw) {
+      linkmap_create(file, log_file->linkmap, log_file->clusters);
+    }
+    raw_stop(log_file);
+    log_file->bytes = (uint32_t)f_tell(file); // Logged size, kept.
+    log_file->state = LOG_FILE_RELEASING;
+    return;
+  }
+
+  const FRESULT result =
+      truncate_step(file, log_file->linkmap, log_file->bytes);
+  if (result == FR_OK && f_size(file) > log_file->bytes) {
+    return; // More to release.
+  }
+  const FRESULT close_result = f_close(file);
+  if (result != FR_OK || close_result != FR_OK) {
+    stats.write_errors++;
+  }
+  log_file->state = LOG_FILE_CLOSED;
+}
+
+/**
+ * @brief Close a log file with its footer (last index block), releasing the
+ * unused pre-allocated space (blocking, logger_stop).
+ */
+static void file_close(log_file_t *log_file) {
+  while (log_file->state != LOG_FILE_CLOSED) {
+    file_close_step(log_file);
+  }
+}
+
+/**
+ * @brief Make the ready file the current one, previous file closed later.
+ */
+static void file_start(uint8_t slot) {
+  if (slot != current) {
+    files[current].state = LOG_FILE_CLOSING;
+    current = slot;
+  }
+  files[current].state = LOG_FILE_ACTIVE;
+  file_start_ms = HAL_GetTick();
+  dirty_bytes = 0;
+  prune_done = 0; // Free space checked again.
+  stats.files++;
+}
+
+/**
+ * @brief Switch to the pre-created next file once the current one reached
+ * LOG_ROTATE_SIZE or LOG_ROTATE_PERIOD_MS (before queuing a block).
+ */
+static void rotate(void) {
+  const uint8_t next = current ^ 1;
+
+  if (files[next].state != LOG_FILE_READY) {
+    return; // Not ready yet, the current file keeps growing.
+  }
+  if ((LOG_ROTATE_SIZE > 0 &&
+       files[current].bytes + LOG_BUFFER_SIZE > (uint32_t)LOG_ROTATE_SIZE) ||
+      (LOG_ROTATE_PERIOD_MS > 0 &&
+       HAL_GetTick() - file_start_ms >= LOG_ROTATE_PERIOD_MS)) {
+    file_start(next);
+  }
+}
+
+/**
+ * @brief Get the free space on the card (cached by FatFs after the first call).
+ *
+ * @return Free bytes, UINT64_MAX if unknown.
+ */
+static uint64_t free_bytes(void) {
+  DWORD clusters = 0;
+  FATFS *fs = NULL;
+
+  if (f_getfree("", &clusters, &fs) != FR_OK) {
+    return UINT64_MAX; // Never delete on an error.
+  }
+  return (uint64_t)clusters * fs->csize * LOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief Read one index line (session directory), without line ending.
+ *
+ * @return 1 if read, 0 at the end of the index.
+ */
+static uint8_t index_read(char *line, int size) {
+  if (f_gets(line, size, &index_file) == NULL) {
+    return 0;
+  }
+  line[strcspn(line, "\r\n")] = '\0';
+  return 1;
+}
+
+/**
+ * @brief Check if an index line names an existing session directory.
+ */
+static uint8_t session_exists(const char *name) {
+  return name[0] != '\0' && f_stat(name, &info) == FR_OK &&
+         (info.fattrib & AM_DIR) != 0;
+}
+
+/**
+ * @brief Find the oldest existing session (first in the index), other than
+ * the current one, into prune_session.
+ *
+ * @return 1 if found, otherwise 0.
+ */
+static uint8_t find_oldest_session(void) {
+  char line[LOG_SESSION_SIZE];
+  uint8_t found = 0;
+
+  if (f_open(&index_file, LOG_INDEX_FILE_NAME, FA_READ) != FR_OK) {
+    return 0;
+  }
+  while (!found && index_read(line, sizeof(line))) {
+    if (strcmp(line, session) != 0 && session_exists(line)) {
+      memcpy(prune_session, line, sizeof(prune_session));
+      found = 1;
+    }
+  }
+  f_close(&index_file);
+  return found;
+}
+
+/**
+ * @brief Release one LOG_ALLOCATION_STEP of the file being deleted (from its
+ * end), then delete it once empty.
+ *
+ * @return FR_OK if released or deleted, else the FatFs error.
+ */
+static FRESULT prune_file_step(void) {
+  FRESULT result = truncate_step(&prune_file, prune_linkmap, 0);
+
+  if (result == FR_OK && f_size(&prune_file) > 0) {
+    return FR_OK; // More to release.
+  }
+  const FRESULT close_result = f_close(&prune_file);
+  prune_open = 0;
+  result = (result != FR_OK) ? result : close_result;
+  if (result == FR_OK) {
+    result = f_unlink(prune_path); // Empty, no clusters left to free.
+  }
+  if (result == FR_OK) {
+    stats.deleted++;
+  }
+  return result;
+}
+
+/**
+ * @brief Delete the oldest session one step at a time while the free space is
+ * below LOG_MIN_FREE_BYTES: each file released from its end
+ * (LOG_ALLOCATION_STEP per step) then deleted, then the emptied directory.
+ *
+ * @return 1 if something was deleted (or attempted), 0 if nothing to do.
+ */
+static uint8_t prune_step(void) {
+  DIR dir;
+  FRESULT result = FR_OK;
+
+  if (prune_open) {
+    result = prune_file_step();
+  } else if (prune_done || free_bytes() >= LOG_MIN_FREE_BYTES) {
+    return 0;
+  } else if (prune_session[0] == '\0' && !find_oldest_session()) {
+    prune_done = 1; // Only the current session left.
+    return 0;
+  } else {
+    result = f_opendir(&dir, prune_session);
+    if (result == FR_OK) {
+      result = f_readdir(&dir, &info);
+      f_closedir(&dir);
+    }
+    if (result == FR_OK && info.fname[0] != '\0') {
+      // 8.3 name, only set apart from the long name if there is one.
+      snprintf(prune_path, sizeof(prune_path), "%s/%s", prune_session,
+               (info.altname[0] != '\0') ? info.altname : info.fname);
+      result = f_open(&prune_file, prune_path, FA_OPEN_EXISTING | FA_WRITE);
+      prune_open = (result == FR_OK);
+      prune_linkmap[0] = 0;
+    } else if (result == FR_OK) {
+      result = f_unlink(prune_session); // Emptied, index updated on next start.
+      prune_session[0] = '\0';
+    }
+  }
+
+  if (result != FR_OK) {
+    stats.write_errors++;
+    prune_session[0] = '\0';
+    prune_done = 1; // Retried after the next rotation.
+  }
+  return 1;
+}
+
+/**
+ * @brief Rewrite the index without the deleted sessions (blocking, start).
+ */
+static void index_compact(void) {
+  FIL *temp = &files[1].file; // Free until the first file is pre-created.
+  char line[LOG_SESSION_SIZE];
+
+  // Interrupted rewrite.
+  if (f_stat(LOG_INDEX_FILE_NAME, &info) == FR_NO_FILE) {
+    f_rename(LOG_INDEX_TEMP_NAME, LOG_INDEX_FILE_NAME);
+  }
+
+  if (f_open(&index_file, LOG_INDEX_FILE_NAME, FA_READ) != FR_OK) {
+    return;
+  }
+  if (f_open(temp, LOG_INDEX_TEMP_NAME, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+    f_close(&index_file);
+    return;
+  }
+  int result = 0;
+  while (result >= 0 && index_read(line, sizeof(line))) {
+    if (session_exists(line)) {
+      result = f_puts(line, temp);
+      if (result >= 0) {
+        result = f_puts("\n", temp);
+      }
+    }
+  }
+  f_close(&index_file);
+  if (f_close(temp) == FR_OK && result >= 0 &&
+      f_unlink(LOG_INDEX_FILE_NAME) == FR_OK) {
+    f_rename(LOG_INDEX_TEMP_NAME, LOG_INDEX_FILE_NAME);
+  }
+}
+
+/**
+ * @brief Format the session name from the RTC, else GPS, date and time.
+ */
+static void session_name(char *name, uint32_t size) {
+  RTC_DateTypeDef date;
+  RTC_TimeTypeDef time;
+
+  if (get_date_time(&date, &time)) {
+    snprintf(name, size, LOG_SESSION_NAME, 2000U + date.Year,
+             (unsigned)date.Month, (unsigned)date.Date, (unsigned)time.Hours,
+             (unsigned)time.Minutes, (unsigned)time.Seconds);
+    return;
+  }
+
+  // GPS time is parsed in the UART interrupt.
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  const ublox_data_t gps = gps_data;
+  __set_PRIMASK(primask);
+
+  if (gps.year != 0) {
+    snprintf(name, size, LOG_SESSION_NAME, 2000U + gps.year,
+             (unsigned)gps.month, (unsigned)gps.day, (unsigned)gps.hour,
+             (unsigned)gps.minute, (unsigned)gps.second);
+  } else {
+    snprintf(name, size, "%s", LOG_SESSION_NO_TIME);
+  }
+}
+
+/**
+ * @brief Create and index the session directory.
+ *
+ * @return FR_OK if created, else the FatFs error.
+ */
+static FRESULT session_create(void) {
+  char name[LOG_SESSION_SIZE - 3]; // Room for the suffix.
+
+  session_name(name, sizeof(name));
+  snprintf(session, sizeof(session), "%s", name);
+  FRESULT result = f_mkdir(session);
+  for (uint8_t i = 1; i < LOG_SESSION_SUFFIXES && result == FR_EXIST; i++) {
+    snprintf(session, sizeof(session), "%s_%u", name, (unsigned)i);
+    result = f_mkdir(session);
+  }
+  if (result != FR_OK) {
+    return result;
+  }
+
+  // Listed in start order, the oldest session is deleted first.
+  result = f_open(&index_file, LOG_INDEX_FILE_NAME, FA_OPEN_APPEND | FA_WRITE);
+  if (result == FR_OK) {
+    if (f_puts(session, &index_file) < 0 || f_puts("\n", &index_file) < 0) {
+      result = FR_DISK_ERR;
+    }
+    const FRESULT close_result = f_close(&index_file);
+    result = (result != FR_OK) ? result : close_result;
+  }
+  return result;
+}
+
+/**
+ * @brief One background step with no write in flight: close the previous
+ * file, write an index block, delete an old session file or pre-create the
+ * next file (each split in bounded steps).
+ */
+static void background_step(void) {
+  log_file_t *other = &files[current ^ 1];
+
+  if (other->state == LOG_FILE_CLOSING || other->state == LOG_FILE_RELEASING) {
+    file_close_step(other);
+    return;
+  }
+  if (files[current].entry_count >= LOG_INDEX_BLOCKS) {
+    index_write(&files[current], 0);
+    return;
+  }
+  if (prune_step()) {
+    return;
+  }
+  if (other->state == LOG_FILE_OPENING) {
+    open_failed = (file_open_step(other) != FR_OK);
+  } else if (other->state == LOG_FILE_CLOSED &&
+             (LOG_ROTATE_SIZE > 0 || LOG_ROTATE_PERIOD_MS > 0) &&
+             (!open_failed ||
+              HAL_GetTick() - open_failed_ms >= LOG_RETRY_PERIOD_MS)) {
+    open_failed = (file_create(other) != FR_OK);
+  } else {
+    return;
+  }
+  if (open_failed) {
+    open_failed_ms = HAL_GetTick();
+    stats.write_errors++;
+  }
+}
+
+/**
+ * @brief Write the oldest sealed block to the current file and index it,
+ * returns once the DMA is started.
+ *
+ * Whole blocks keep the file position sector aligned, so FatFs passes the
+ * block straight to SD_write (no copy) and it returns once DMA started.
+ *
+ * @return 1 if the write is in flight, otherwise 0 (discarded).
+ */
+static uint8_t write_sealed(void) {
+  log_file_t *log_file = &files[current];
+  const uint32_t offset = log_file->bytes;
+  const uint8_t slot = oldest;
+  uint8_t *block = block_finish(slot);
+
+  if (!write_block(log_file, block, LOG_BUFFER_SECTORS)) {
+    return 0;
+  }
+  index_add(log_file, log_file->sequence - 1, offset, first_us[slot]);
+  stats.blocks++;
+  return 1;
+}
+
+/**
+ * @brief Release the buffer in flight once its write completed, or chain the
+ * index block in flight.
+ *
+ * @return 1 if no write is in flight, otherwise 0.
+ */
+static uint8_t write_completed(void) {
+  if (!writing && index_writing == NULL) {
+    return 1;
+  }
+
+  const DRESULT result = SD_WriteBehindStatus();
+  if (result == RES_NOTRDY) {
+    return 0;
+  }
+  if (index_writing != NULL) {
+    if (result == RES_OK) {
+      index_writing->index_offset = index_writing_offset;
+    } else {
+      stats.write_errors++; // Skipped by the chain.
+    }
+    index_writing = NULL;
+    return 1;
+  }
+  if (result != RES_OK) {
+    stats.write_errors++;
+    if (!sdio_card_detected()) {
+      writing = 0; // Card removed, block written again after logger_start.
+      return 1;
+    }
+  }
+
+  const uint32_t elapsed_ms = HAL_GetTick() - write_start_ms;
+  if (elapsed_ms > stats.write_ms_max) {
+    stats.write_ms_max = elapsed_ms;
+  }
+  writing = 0;
+  buffer_release();
+  return 1;
+}
+
+/**
+ * @brief Forget the session, the next start is a new session.
+ */
+static void session_reset(void) {
+  session[0] = '\0';
+  prune_session[0] = '\0';
+  prune_done = 0;
+}
+
+/**
+ * @brief Abandon a start in progress (logger_start_step), open files closed by
+ * the caller or dropped with the mount.
+ */
+static void start_cancel(void) {
+  start_phase = LOG_START_IDLE;
+  files[0].state = LOG_FILE_CLOSED;
+  prune_open = 0;
+}
+
+/**
+ * @brief Start logging to the ready first file, buffered records first.
+ */
+static void go_online(void) {
+  current = 0;
+  files[1].state = LOG_FILE_CLOSED;
+  file_start(0);
+  open_failed = 0;
+  if (!active) {
+    buffer_reset();
+  }
+  writing = 0;
+  index_writing = NULL;
+  SD_SetWriteBehindRegion(&dma, sizeof(dma));
+  online = 1;
+  active = 1;
+}
+
+/** Public functions. *********************************************************/
+
+void logger_init(void) {
+  if (active) {
+    return;
+  }
+  buffer_reset();
+  active = 1;
+}
+
+uint8_t logger_start_step(FRESULT *result) {
+  *result = FR_OK;
+  if (online) {
+    return 1;
+  }
+
+  // Never overwrite a previous log, each start is a new session directory,
+  // a suspended session continues with its next file if still there.
+  if (start_phase == LOG_START_IDLE) {
+    if (active && session[0] != '\0') {
+      start_phase = LOG_START_RESUME;
+    } else {
+      session_reset();
+      start_phase = LOG_START_PRUNE;
+    }
+  }
+
+  switch (start_phase) {
+  case LOG_START_RESUME:
+    // Old sessions were pruned and the index compacted when it started.
+    if (file_create(&files[0]) == FR_OK) {
+      start_phase = LOG_START_OPEN;
+    } else {
+      session_reset(); // Gone (e.g. another card), a new session.
+      start_phase = LOG_START_PRUNE;
+    }
+    break;
+
+  case LOG_START_PRUNE:
+    if (!prune_step()) {
+      start_phase = LOG_START_COMPACT;
+    }
+    break;
+
+  case LOG_START_COMPACT:
+    index_compact();
+    start_phase = LOG_START_SESSION;
+    break;
+
+  case LOG_START_SESSION:
+    *result = session_create();
+    next_index = 0;
+    start_phase = LOG_START_CREATE;
+    break;
+
+  case LOG_START_CREATE:
+    *result = file_create(&files[0]);
+    start_phase = LOG_START_OPEN;
+    break;
+
+  case LOG_START_OPEN:
+  default:
+    *result = file_open_step(&files[0]);
+    if (*result == FR_OK && files[0].state == LOG_FILE_READY) {
+      start_phase = LOG_START_IDLE;
+      go_online();
+      return 1;
+    }
+    break;
+  }
+
+  if (*result != FR_OK) {
+    start_phase = LOG_START_IDLE;
+    return 1;
+  }
+  return 0;
+}
+
+FRESULT logger_start(void) {
+  FRESULT result = FR_OK;
+
+  while (!logger_start_step(&result)) {
+  }
+  return result;
+}
+
+void logger_stop(void) {
+  if (!active) {
+    return;
+  }
+  active = 0; // No more records.
+  if (!online) {
+    // Buffered records discarded, a start in progress abandoned.
+    if (files[0].state == LOG_FILE_OPENING) {
+      f_close(&files[0].file);
+    }
+    if (prune_open) {
+      f_close(&prune_file);
+    }
+    start_cancel();
+    return;
+  }
+  online = 0;
+
+  // Wait for the write in flight, then flush in order (blocking).
+  while (!write_completed()) {
+  }
+  SD_SetWriteBehindRegion(NULL, 0);
+  raw_stop(&files[current]);
+  while (sealed > 0 || fill_length > LOG_BLOCK_HEADER_SIZE) {
+    if (fill_length > LOG_BLOCK_HEADER_SIZE && buffer_free()) {
+      buffer_seal();
+    }
+    write_sealed();
+    buffer_release();
+  }
+
+  // Release the unused pre-allocated space, an unused next file is deleted.
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    if (files[slot].state == LOG_FILE_OPENING ||
+        files[slot].state == LOG_FILE_READY) {
+      char path[LOG_PATH_SIZE];
+      snprintf(path, sizeof(path), "%s/" LOG_FILE_NAME, session,
+               (unsigned)files[slot].index);
+      f_close(&files[slot].file);
+      f_unlink(path);
+      files[slot].state = LOG_FILE_CLOSED;
+    } else if (files[slot].state != LOG_FILE_CLOSED) {
+      file_close(&files[slot]);
+    }
+  }
+  if (prune_open) {
+    f_close(&prune_file); // Partly released, deleted first next time.
+    prune_open = 0;
+  }
+}
+
+void logger_suspend(void) {
+  if (!online) {
+    start_cancel(); // Files dropped with the mount.
+    return;
+  }
+  online = 0;
+
+  // The block in flight stays sealed, written again after logger_start. The
+  // file objects are dropped with the mount, nothing is closed.
+  writing = 0;
+  index_writing = NULL;
+  SD_SetWriteBehindRegion(NULL, 0);
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    files[slot].state = LOG_FILE_CLOSED;
+    files[slot].raw = 0;
+  }
+  prune_open = 0;
+  stats.suspends++;
+}
+
+uint8_t logger_active(void) { return active; }
+
+uint8_t logger_write(log_record_type_t type, const void *payload,
+                     uint8_t length) {
+  return logger_write_at(type, payload, length, systime_us32());
+}
+
+uint8_t logger_write_at(log_record_type_t type, const void *payload,
+                        uint8_t length, uint32_t timestamp_us) {
+  const uint32_t start_cycles = DWT->CYCCNT;
+  uint8_t header[LOG_RECORD_HEADER_SIZE];
+  uint8_t encoded[LOG_CODEC_MAX_SIZE];
+  int32_t fixed[LOG_CODEC_MAX_FIELDS];
+  uint8_t buffered = 0;
+
+  // Mask interrupts, records are also written from interrupts (GPS).
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  uint8_t encoded_length = codec_encode(type, payload, length, fixed, encoded);
+  uint32_t size =
+      LOG_RECORD_HEADER_SIZE + (encoded_length ? encoded_length : length);
+
+  // Records never span blocks, seal the fill block if the next is free.
+  if (active && fill_length + size > LOG_BUFFER_SIZE && buffer_free()) {
+    buffer_seal();
+    if (encoded_length) {
+      // First of the stream in the new block.
+      encoded_length = codec_encode(type, payload, length, fixed, encoded);
+      size =
+          LOG_RECORD_HEADER_SIZE + (encoded_length ? encoded_length : length);
+    }
+  }
+
+  const uint32_t used = fill_length + sealed_bytes;
+  if (!active) {
+    // Not logging.
+  } else if (fill_length + size > LOG_BUFFER_SIZE) {
+    stats.dropped++;
+  } else {
+    if (fill_length == LOG_BLOCK_HEADER_SIZE) {
+      fill_ms = HAL_GetTick();
+      first_us[fill] = timestamp_us;
+    }
+    header[0] = (uint8_t)type | (encoded_length ? LOG_RECORD_COMPRESSED : 0);
+    header[1] = encoded_length ? encoded_length : length;
+    memcpy(&header[2], &timestamp_us, sizeof(timestamp_us));
+
+    buffer_put(header, sizeof(header));
+    buffer_put(encoded_length ? encoded : payload, header[1]);
+    if (encoded_length) {
+      codec_commit(type, fixed);
+    }
+
+    stats.records++;
+    if (used + size > stats.high_water) {
+      stats.high_water = used + size;
+    }
+    buffered = 1;
+  }
+
+  if (buffered && type < LOG_RECORD_TYPE_COUNT) {
+    logger_stream_stats_t *stream = &stream_stats[type];
+    stream->records++;
+    stream->compressed += (encoded_length != 0);
+    stream->raw_bytes += LOG_RECORD_HEADER_SIZE + length;
+    stream->bytes += size;
+    const uint32_t cycles = DWT->CYCCNT - start_cycles;
+    stream->cycles += cycles;
+    if (cycles > stream->cycles_max) {
+      stream->cycles_max = cycles;
+    }
+  }
+
+  __set_PRIMASK(primask);
+  return buffered;
+}
+
+void logger_process(void) {
+  if (!online) {
+    return; // Suspended, full blocks are sealed by the producers.
+  }
+  const uint32_t start_us = systime_us32();
+
+  if (!write_completed()) {
+    return; // DMA or card busy, checked again next period.
+  }
+  if (!sdio_card_detected()) {
+    return; // Card removed, blocks kept until suspended (storage_process).
+  }
+
+  // Bound the data lost on a power loss, write a partial block after a while.
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (buffer_free() && fill_length > LOG_BLOCK_HEADER_SIZE &&
+      HAL_GetTick() - fill_ms >= LOG_FLUSH_PERIOD_MS) {
+    buffer_seal();
+  }
+  __set_PRIMASK(primask);
+
+  if (sealed > 0) {
+    rotate();
+    write_start_ms = HAL_GetTick();
+    if (write_sealed()) {
+      writing = 1;
+    } else {
+      buffer_release(); // Discarded.
+    }
+    const uint32_t queue_us = systime_us32() - start_us;
+    if (queue_us > stats.queue_us_max) {
+      stats.queue_us_max = queue_us;
+    }
+  } else if (dirty_bytes >= LOG_SYNC_DIRTY_BYTES) {
+    // Only with no write in flight, f_sync would wait for it. Raw streaming
+    // changes no file system metadata and never adds dirty bytes.
+    dirty_bytes = 0;
+    stats.syncs++;
+    if (f_sync(&files[current].file) != FR_OK) {
+      stats.write_errors++;
+    }
+  } else {
+    background_step();
+  }
+
+  const uint32_t elapsed_us = systime_us32() - start_us;
+  if (elapsed_us > stats.call_us_max) {
+    stats.call_us_max = elapsed_us;
+  }
+}
+
+const logger_stats_t *logger_get_stats(void) {
+  // Log blocks are word aligned, any sector here is a regression elsewhere.
+  UINT reads = 0;
+  UINT writes = 0;
+  SD_GetScratchCount(&reads, &writes);
+  stats.unaligned = reads + writes;
+  stats.raw = files[current].raw;
+  stats.online = online;
+  stats.pending = sealed;
+  return &stats;
+}
+
+const logger_stream_stats_t *logger_get_stream_stats(log_record_type_t type) {
+  return (type < LOG_RECORD_TYPE_COUNT) ? &stream_stats[type] : NULL;
+}
+
+uint8_t logger_set_compression(log_record_type_t type, uint8_t enable) {
+  if (type >= LOG_RECORD_TYPE_COUNT || schema[type].codec_fields == 0) {
+    return 0;
+  }
+  uncompressed[type] = !enable;
+  return 1;
+}
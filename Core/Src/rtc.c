@@ -6,9 +6,53 @@
 
 /** Includes. *****************************************************************/
 
-#include <stdio.h>
-
 #include "rtc.h"
+#include "logger.h"
+#include "systime.h"
+
+/** Definitions. **************************************************************/
+
+#define SECONDS_PER_DAY 86400
+#define US_PER_S 1000000LL
+
+/** Private variables. ********************************************************/
+
+// Sub-second time, anchor_epoch_us at system time anchor_sys_us.
+static uint8_t anchored = 0;
+static int64_t anchor_epoch_us = 0;
+static uint64_t anchor_sys_us = 0;
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Days since 1970-01-01 of a proleptic Gregorian date.
+ */
+static int32_t days_from_civil(int32_t year, uint32_t month, uint32_t day) {
+  year -= month <= 2;
+  const int32_t era = (year >= 0 ? year : year - 399) / 400;
+  // Year of era, month from March (0), day of year and day of era.
+  const uint32_t yoe = (uint32_t)(year - era * 400);
+  const uint32_t mp = month > 2 ? month - 3 : month + 9;
+  const uint32_t doy = (153 * mp + 2) / 5 + day - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+/**
+ * @brief Proleptic Gregorian date of a day count since 1970-01-01.
+ */
+static void civil_from_days(int32_t days, int32_t *year, uint8_t *month,
+                            uint8_t *day) {
+  days += 719468;
+  const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const uint32_t doe = (uint32_t)(days - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  *day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+  *month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+  *year = (int32_t)yoe + era * 400 + (*month <= 2);
+}
 
 /** Public functions. *********************************************************/
 
@@ -22,7 +66,7 @@ void set_date(uint8_t year, uint8_t month, uint8_t date, uint8_t day) {
     // TODO: Error handler.
   }
 
-  HAL_RTCEx_BKUPWrite(&hrtc, RTC_BKP_DR1, 0x2345); // Backup register.
+  HAL_RTCEx_BKUPWrite(&hrtc, RTC_BKP_DR1, RTC_SET_MARKER); // Backup register.
 }
 
 void set_time(uint8_t hours, uint8_t minutes, uint8_t seconds) {
@@ -35,17 +79,84 @@ void set_time(uint8_t hours, uint8_t minutes, uint8_t seconds) {
   }
 }
 
-void get_time_date(char *time, char *date) {
-  RTC_DateTypeDef gDate;
-  RTC_TimeTypeDef gTime;
+uint8_t get_date_time(RTC_DateTypeDef *date, RTC_TimeTypeDef *time) {
+  // Time first, reading the date unlocks the shadow registers.
+  HAL_RTC_GetTime(&hrtc, time, RTC_FORMAT_BIN);
+  HAL_RTC_GetDate(&hrtc, date, RTC_FORMAT_BIN);
+  return HAL_RTCEx_BKUPRead(&hrtc, RTC_BKP_DR1) == RTC_SET_MARKER;
+}
+
+uint8_t get_epoch_us(int64_t *epoch_us) {
+  RTC_DateTypeDef date;
+  RTC_TimeTypeDef time;
+
+  const uint64_t sys_us = systime_us();
+  if (!get_date_time(&date, &time)) {
+    return 0;
+  }
+
+  // RTC_SSR counts down from SynchPrediv (SecondFraction), the time is within
+  // the count read.
+  const uint32_t counts = time.SecondFraction + 1;
+  const int64_t count_us = US_PER_S / counts;
+  const int64_t rtc_us =
+      date_time_to_epoch(&date, &time) * US_PER_S +
+      (int64_t)(time.SecondFraction - time.SubSeconds) * US_PER_S / counts;
+
+  const int64_t predicted_us =
+      anchored ? anchor_epoch_us + (int64_t)(sys_us - anchor_sys_us)
+               : rtc_us + count_us / 2;
+  int64_t now_us = predicted_us;
+  if (now_us < rtc_us) {
+    now_us = rtc_us;
+  } else if (now_us >= rtc_us + count_us) {
+    now_us = rtc_us + count_us - 1;
+  }
+
+  if (!anchored || now_us != predicted_us) {
+    int64_t step_us = now_us - predicted_us;
+    if (step_us > INT32_MAX || step_us < -INT32_MAX) {
+      step_us = step_us > 0 ? INT32_MAX : -INT32_MAX;
+    }
+    const log_rtc_time_t record = {
+        .epoch_us = now_us,
+        .sys_us = (uint32_t)sys_us,
+        .step_us = (int32_t)step_us,
+    };
+    logger_write(LOG_RECORD_RTC_TIME, &record, sizeof(record));
+
+    anchored = 1;
+    anchor_epoch_us = now_us;
+    anchor_sys_us = sys_us;
+  }
+
+  *epoch_us = now_us;
+  return 1;
+}
+
+int64_t date_time_to_epoch(const RTC_DateTypeDef *date,
+                           const RTC_TimeTypeDef *time) {
+  const int32_t days =
+      days_from_civil(2000 + date->Year, date->Month, date->Date);
+  return (int64_t)days * SECONDS_PER_DAY + time->Hours * 3600 +
+         time->Minutes * 60 + time->Seconds;
+}
+
+void epoch_to_date_time(int64_t seconds, RTC_DateTypeDef *date,
+                        RTC_TimeTypeDef *time) {
+  int32_t days = (int32_t)(seconds / SECONDS_PER_DAY);
+  int32_t second_of_day = (int32_t)(seconds % SECONDS_PER_DAY);
+  if (second_of_day < 0) {
+    second_of_day += SECONDS_PER_DAY;
+    days--;
+  }
 
-  // Get the date and time.
-  HAL_RTC_GetTime(&hrtc, &gTime, RTC_FORMAT_BIN);
-  HAL_RTC_GetDate(&hrtc, &gDate, RTC_FORMAT_BIN);
+  int32_t year;
+  civil_from_days(days, &year, &date->Month, &date->Date);
+  date->Year = (uint8_t)(year - 2000);
+  date->WeekDay = (uint8_t)((days + 3) % 7 + 1); // 1970-01-01 was a Thursday.
 
-  // Format date and time.
-  snprintf(time, 9, "%02d:%02d:%02d", gTime.Hours, gTime.Minutes,
-           gTime.Seconds);
-  snprintf(date, 11, "%02d-%02d-%04d", gDate.Date, gDate.Month,
-           2000 + gDate.Year);
+  time->Hours = (uint8_t)(second_of_day / 3600);
+  time->Minutes = (uint8_t)(second_of_day / 60 % 60);
+  time->Seconds = (uint8_t)(second_of_day % 60);
 }
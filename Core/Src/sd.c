@@ -7,9 +7,180 @@
 /** Includes. *****************************************************************/
 
 #include "sd.h"
+#include "sd_diskio.h"
+
+/** Definitions. **************************************************************/
+
+#define SD_POWER_UP_DELAY_MS 2     // Card power-up before CMD0.
+#define SD_OP_COND_TIMEOUT_MS 1000 // ACMD41 ready within (SD spec 1 s).
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Enumeration for the card power-up steps (sdio_init_sd_step).
+ */
+typedef enum {
+  SD_POWER_UP_START = 0, // SDIO identification clock and power on.
+  SD_POWER_UP_IDLE,      // Power-up delay, then CMD0 and CMD8.
+  SD_POWER_UP_OP_COND,   // One CMD55 and ACMD41 per step until ready.
+  SD_POWER_UP_IDENTIFY,  // CMD2, CMD3, CMD9, CMD7, CMD16, transfer clock.
+  SD_POWER_UP_WIDE_BUS   // SDIO 4-bit bus.
+} sd_power_up_t;
+
+/** Public variables. *********************************************************/
 
 volatile int sd_write_counter;
 
+/** Private variables. ********************************************************/
+
+static sd_power_up_t power_up = SD_POWER_UP_START;
+static uint32_t power_up_ms = 0; // Start of the current timed step.
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Finish the card power-up with a result, the next step starts over.
+ *
+ * @return 1 (done).
+ */
+static uint8_t power_up_done(FRESULT *file_result, FRESULT result) {
+  *file_result = result;
+  power_up = SD_POWER_UP_START;
+  return 1;
+}
+
+/**
+ * @brief SDIO on with the identification clock (< 400 kHz), as HAL_SD_Init.
+ *
+ * @return HAL_SD_ERROR_NONE or the HAL SD error.
+ */
+static uint32_t power_up_start(SD_HandleTypeDef *h) {
+  SD_InitTypeDef init = h->Init;
+
+  if (h->State == HAL_SD_STATE_RESET) {
+    h->Lock = HAL_UNLOCKED;
+    HAL_SD_MspInit(h); // GPIO, clock, DMA and interrupts.
+  }
+  h->State = HAL_SD_STATE_BUSY;
+
+  init.ClockEdge = SDIO_CLOCK_EDGE_RISING;
+  init.ClockBypass = SDIO_CLOCK_BYPASS_DISABLE;
+  init.ClockPowerSave = SDIO_CLOCK_POWER_SAVE_DISABLE;
+  init.BusWide = SDIO_BUS_WIDE_1B;
+  init.HardwareFlowControl = SDIO_HARDWARE_FLOW_CONTROL_DISABLE;
+  init.ClockDiv = SDIO_INIT_CLK_DIV;
+  if (SDIO_Init(h->Instance, init) != HAL_OK) {
+    return HAL_SD_ERROR_GENERAL_UNKNOWN_ERR;
+  }
+  __HAL_SD_DISABLE(h);
+  (void)SDIO_PowerState_ON(h->Instance);
+  __HAL_SD_ENABLE(h);
+  return HAL_SD_ERROR_NONE;
+}
+
+/**
+ * @brief CMD0 and CMD8 (card version), as the HAL SD_PowerON.
+ *
+ * @return HAL_SD_ERROR_NONE or the HAL SD error.
+ */
+static uint32_t power_up_idle(SD_HandleTypeDef *h) {
+  uint32_t error = SDMMC_CmdGoIdleState(h->Instance);
+
+  if (error != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  if (SDMMC_CmdOperCond(h->Instance) != HAL_SD_ERROR_NONE) {
+    h->SdCard.CardVersion = CARD_V1_X; // No CMD8, back to idle.
+    return SDMMC_CmdGoIdleState(h->Instance);
+  }
+  h->SdCard.CardVersion = CARD_V2_X;
+  return HAL_SD_ERROR_NONE;
+}
+
+/**
+ * @brief One CMD55 and ACMD41 (operating condition), as the HAL SD_PowerON.
+ *
+ * @param ready Pointer set to 1 once the card finished its power-up.
+ *
+ * @return HAL_SD_ERROR_NONE or the HAL SD error.
+ */
+static uint32_t power_up_op_cond(SD_HandleTypeDef *h, uint8_t *ready) {
+  uint32_t error = SDMMC_CmdAppCommand(h->Instance, 0);
+
+  if (error != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  if (SDMMC_CmdAppOperCommand(h->Instance, SDMMC_VOLTAGE_WINDOW_SD |
+                                               SDMMC_HIGH_CAPACITY |
+                                               SD_SWITCH_1_8V_CAPACITY) !=
+      HAL_SD_ERROR_NONE) {
+    return HAL_SD_ERROR_UNSUPPORTED_FEATURE;
+  }
+
+  const uint32_t response = SDIO_GetResponse(h->Instance, SDIO_RESP1);
+  *ready = (uint8_t)(response >> 31);
+  if (*ready) {
+    h->SdCard.CardType = (response & SDMMC_HIGH_CAPACITY) == SDMMC_HIGH_CAPACITY
+                             ? CARD_SDHC_SDXC
+                             : CARD_SDSC;
+  }
+  return HAL_SD_ERROR_NONE;
+}
+
+/**
+ * @brief Identify and select the card, as the HAL SD_InitCard and
+ * HAL_SD_InitCard (CMD2, CMD3, CMD9, CMD7, transfer clock, CMD16).
+ *
+ * @return HAL_SD_ERROR_NONE or the HAL SD error.
+ */
+static uint32_t power_up_identify(SD_HandleTypeDef *h) {
+  HAL_SD_CardCSDTypeDef csd;
+  uint16_t rca = 1;
+  uint32_t error = SDMMC_CmdSendCID(h->Instance);
+
+  if (error != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  h->CID[0] = SDIO_GetResponse(h->Instance, SDIO_RESP1);
+  h->CID[1] = SDIO_GetResponse(h->Instance, SDIO_RESP2);
+  h->CID[2] = SDIO_GetResponse(h->Instance, SDIO_RESP3);
+  h->CID[3] = SDIO_GetResponse(h->Instance, SDIO_RESP4);
+
+  if ((error = SDMMC_CmdSetRelAdd(h->Instance, &rca)) != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  h->SdCard.RelCardAdd = rca;
+
+  error = SDMMC_CmdSendCSD(h->Instance, (uint32_t)rca << 16);
+  if (error != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  h->CSD[0] = SDIO_GetResponse(h->Instance, SDIO_RESP1);
+  h->CSD[1] = SDIO_GetResponse(h->Instance, SDIO_RESP2);
+  h->CSD[2] = SDIO_GetResponse(h->Instance, SDIO_RESP3);
+  h->CSD[3] = SDIO_GetResponse(h->Instance, SDIO_RESP4);
+  h->SdCard.Class = SDIO_GetResponse(h->Instance, SDIO_RESP2) >> 20;
+  if (HAL_SD_GetCardCSD(h, &csd) != HAL_OK) {
+    return HAL_SD_ERROR_UNSUPPORTED_FEATURE;
+  }
+
+  error = SDMMC_CmdSelDesel(h->Instance, (uint32_t)rca << 16);
+  if (error != HAL_SD_ERROR_NONE) {
+    return error;
+  }
+  (void)SDIO_Init(h->Instance, h->Init); // Transfer clock, 1-bit.
+
+  if ((error = SDMMC_CmdBlockLength(h->Instance, BLOCKSIZE)) !=
+      HAL_SD_ERROR_NONE) {
+    __HAL_SD_CLEAR_FLAG(h, SDIO_STATIC_FLAGS);
+    return error;
+  }
+  h->ErrorCode = HAL_SD_ERROR_NONE;
+  h->Context = SD_CONTEXT_NONE;
+  h->State = HAL_SD_STATE_READY;
+  return HAL_SD_ERROR_NONE;
+}
+
 /** Public functions. *********************************************************/
 
 uint8_t sdio_card_detected() {
@@ -27,28 +198,105 @@ DSTATUS sdio_disk_reinitialize(BYTE physical_drive_number) {
   return RES_OK;
 }
 
-void sdio_mount_sd(FRESULT *file_result, FATFS *SDFatFs) {
-  if (sdio_card_detected()) {               // Ensure card is detected.
-    if (HAL_SD_Init(&SDIO_HSD) != HAL_OK) { // Initialize SDIO 1-bit.
-      Error_Handler();
+uint8_t sdio_init_sd_step(FRESULT *file_result) {
+  SD_HandleTypeDef *h = &SDIO_HSD;
+  uint32_t error = HAL_SD_ERROR_NONE;
+  uint8_t ready = 0;
+
+  if (!sdio_card_detected()) { // Ensure card is detected.
+    return power_up_done(file_result, FR_NOT_READY);
+  }
+
+  switch (power_up) {
+  case SD_POWER_UP_START:
+    if ((error = power_up_start(h)) == HAL_SD_ERROR_NONE) {
+      power_up_ms = HAL_GetTick();
+      power_up = SD_POWER_UP_IDLE;
     }
+    break;
 
-    // Switch to SDIO 4-bit now that STM32 HAL hsd (SDIO_HSD) is initialized.
-    // Check successful 4-bit configuration.
-    if (HAL_SD_ConfigWideBusOperation(&SDIO_HSD, SDIO_BUS_WIDE_4B) != HAL_OK) {
-      Error_Handler();
+  case SD_POWER_UP_IDLE:
+    // Full ticks, as HAL_Delay.
+    if (HAL_GetTick() - power_up_ms <= SD_POWER_UP_DELAY_MS) {
+      return 0;
+    }
+    if ((error = power_up_idle(h)) == HAL_SD_ERROR_NONE) {
+      power_up_ms = HAL_GetTick();
+      power_up = SD_POWER_UP_OP_COND;
+    }
+    break;
+
+  case SD_POWER_UP_OP_COND:
+    if ((error = power_up_op_cond(h, &ready)) != HAL_SD_ERROR_NONE) {
+      break;
+    }
+    if (ready) {
+      power_up = SD_POWER_UP_IDENTIFY;
+    } else if (HAL_GetTick() - power_up_ms > SD_OP_COND_TIMEOUT_MS) {
+      error = HAL_SD_ERROR_INVALID_VOLTRANGE;
     }
-    // Reinitialize to ensure SD can be mounted several times.
-    sdio_disk_reinitialize(SDFatFs->drv);
+    break;
 
-    // Check mount success.
-    if ((*file_result = f_mount(SDFatFs, (TCHAR const *)SDPath, 0)) != FR_OK) {
-      fatfs_deinit();
-      *file_result = FR_DISK_ERR;
+  case SD_POWER_UP_IDENTIFY:
+    if ((error = power_up_identify(h)) == HAL_SD_ERROR_NONE) {
+      power_up = SD_POWER_UP_WIDE_BUS;
+    }
+    break;
+
+  case SD_POWER_UP_WIDE_BUS:
+  default:
+    // Switch to SDIO 4-bit now that STM32 HAL hsd (SDIO_HSD) is initialized.
+    if (HAL_SD_ConfigWideBusOperation(h, SDIO_BUS_WIDE_4B) != HAL_OK) {
+      return power_up_done(file_result, FR_DISK_ERR);
     }
-  } else {
-    *file_result = FR_NOT_READY;
+    return power_up_done(file_result, FR_OK);
   }
+
+  if (error != HAL_SD_ERROR_NONE) {
+    h->ErrorCode |= error;
+    h->State = HAL_SD_STATE_READY;
+    return power_up_done(file_result, FR_NOT_READY); // Not answering, retried.
+  }
+  return 0;
+}
+
+void sdio_init_sd(FRESULT *file_result) {
+  while (!sdio_init_sd_step(file_result)) {
+  }
+}
+
+void sdio_mount_volume_sd(FRESULT *file_result, FATFS *SDFatFs) {
+  // Reinitialize to ensure SD can be mounted several times.
+  sdio_disk_reinitialize(SDFatFs->drv);
+
+  // Check mount success, the volume is read now (not on first access). The
+  // driver stays linked for the next mount.
+  if ((*file_result = f_mount(SDFatFs, (TCHAR const *)SDPath, 1)) != FR_OK) {
+    f_mount(NULL, (TCHAR const *)SDPath, 0);
+  }
+}
+
+void sdio_mount_sd(FRESULT *file_result, FATFS *SDFatFs) {
+  sdio_init_sd(file_result);
+  if (*file_result == FR_OK) {
+    sdio_mount_volume_sd(file_result, SDFatFs);
+  }
+}
+
+void sdio_eject_sd(FATFS *SDFatFs) {
+  power_up = SD_POWER_UP_START;            // Power-up in progress dropped.
+  SD_AbortWriteBehind();                   // Transfer in flight dropped.
+  f_mount(NULL, (TCHAR const *)SDPath, 0); // Unregister only, no disk access.
+  HAL_SD_DeInit(&SDIO_HSD); // Power off, DMA stopped, re-initialized on mount.
+  sdio_disk_reinitialize(SDFatFs->drv);
+}
+
+uint8_t sdio_card_responding(void) {
+  const HAL_SD_CardStateTypeDef state = HAL_SD_GetCardState(&SDIO_HSD);
+
+  // 0 if CMD13 failed (no response, not a card state).
+  return state == HAL_SD_CARD_TRANSFER || state == HAL_SD_CARD_RECEIVING ||
+         state == HAL_SD_CARD_PROGRAMMING || state == HAL_SD_CARD_SENDING;
 }
 
 void sdio_unmount_sd(FRESULT *file_result, FATFS *SDFatFs) {
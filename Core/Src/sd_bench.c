@@ -0,0 +1,226 @@
+/*******************************************************************************
+ * @file sd_bench.c
+ * @brief SD card write throughput and latency benchmark.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "sd_bench.h"
+#include "can.h"
+#include "diskio.h"
+#include "ff_gen_drv.h"
+#include "sd_diskio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+#define SD_BENCH_SECTOR_SIZE 512 // SD card block size.
+
+/** Private variables. ********************************************************/
+
+static const char *const mode_names[SD_BENCH_MODE_COUNT] = {
+    [SD_BENCH_APPEND] = "append",
+    [SD_BENCH_PREALLOCATED] = "preallocated",
+    [SD_BENCH_RAW] = "raw",
+};
+
+static const char *const alignment_names[SD_BENCH_ALIGNMENT_COUNT] = {
+    [SD_BENCH_ALIGNED] = "aligned",
+    [SD_BENCH_FILE_OFFSET] = "file_offset",
+    [SD_BENCH_UNALIGNED_BUFFER] = "unaligned_buffer",
+};
+
+// One extra word for the unaligned buffer.
+static uint8_t buffer[SD_BENCH_MAX_WRITE + 4] __attribute__((aligned(4)));
+static uint32_t samples[SD_BENCH_MAX_SAMPLES];
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief qsort comparison for latency samples.
+ */
+static int compare_samples(const void *a, const void *b) {
+  const uint32_t x = *(const uint32_t *)a;
+  const uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Fill in the latency percentiles from the samples.
+ */
+static void set_percentiles(sd_bench_result_t *result) {
+  const uint32_t n = result->writes;
+
+  if (n == 0) {
+    return;
+  }
+  qsort(samples, n, sizeof(samples[0]), compare_samples);
+  result->p50_us = samples[(n - 1) * 50 / 100];
+  result->p90_us = samples[(n - 1) * 90 / 100];
+  result->p99_us = samples[(n - 1) * 99 / 100];
+  result->max_us = samples[n - 1];
+}
+
+/**
+ * @brief Check if a configuration is supported.
+ */
+static uint8_t supported(sd_bench_mode_t mode, sd_bench_alignment_t alignment,
+                         uint32_t size) {
+  if (size < 1 || size > SD_BENCH_MAX_WRITE ||
+      SD_BENCH_BYTES / size > SD_BENCH_MAX_SAMPLES) {
+    return 0;
+  }
+  if (alignment == SD_BENCH_UNALIGNED_BUFFER && !SD_BENCH_UNALIGNED_BUFFERS) {
+    return 0;
+  }
+  if (mode == SD_BENCH_RAW && (size % SD_BENCH_SECTOR_SIZE != 0 ||
+                               alignment == SD_BENCH_FILE_OFFSET)) {
+    return 0; // Whole sectors only.
+  }
+  return 1;
+}
+
+/**
+ * @brief Get the sectors copied through the sd_diskio scratch buffer.
+ */
+static uint32_t scratch_sectors(void) {
+  UINT reads = 0;
+  UINT writes = 0;
+  SD_GetScratchCount(&reads, &writes);
+  return reads + writes;
+}
+
+/**
+ * @brief Write and flush one formatted results row.
+ */
+static FRESULT write_row(FIL *file, const char *row) {
+  UINT written = 0;
+  const UINT length = (UINT)strlen(row);
+  FRESULT result = f_write(file, row, length, &written);
+
+  if (result == FR_OK && written != length) {
+    result = FR_DENIED; // Card full.
+  }
+  if (result == FR_OK) {
+    result = f_sync(file); // Keep completed rows if interrupted.
+  }
+  return result;
+}
+
+/** Public functions. *********************************************************/
+
+FRESULT sd_bench_config(sd_bench_mode_t mode, sd_bench_alignment_t alignment,
+                        uint32_t size, sd_bench_result_t *result) {
+  const uint8_t *data = &buffer[alignment == SD_BENCH_UNALIGNED_BUFFER ? 1 : 0];
+  const uint32_t writes = SD_BENCH_BYTES / size;
+  FIL file;
+  UINT written = 0;
+  DWORD sector = 0;
+
+  memset(result, 0, sizeof(*result));
+  if (!supported(mode, alignment, size)) {
+    return FR_INVALID_PARAMETER;
+  }
+  for (uint32_t i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = (uint8_t)i;
+  }
+
+  const uint32_t scratch_start = scratch_sectors();
+  f_unlink(SD_BENCH_DATA_FILE_NAME); // Left over if interrupted.
+  FRESULT res =
+      f_open(&file, SD_BENCH_DATA_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+  if (res != FR_OK) {
+    return res;
+  }
+
+  if (mode != SD_BENCH_APPEND) {
+    // Contiguous, the extra sector leaves room for the file offset.
+    res = f_expand(&file, SD_BENCH_BYTES + SD_BENCH_SECTOR_SIZE, 1);
+    if (res == FR_OK) {
+      res = f_sync(&file);
+    }
+    const FATFS *fs = file.obj.fs;
+    sector = fs->database + (DWORD)fs->csize * (file.obj.sclust - 2);
+  }
+  if (res == FR_OK && alignment == SD_BENCH_FILE_OFFSET) {
+    res = f_write(&file, data, 1, &written);
+  }
+
+  for (uint32_t i = 0; i < writes && res == FR_OK; i++) {
+    const uint32_t start_us = can_time_us();
+
+    if (mode == SD_BENCH_RAW) {
+      if (disk_write(file.obj.fs->drv, data, sector,
+                     size / SD_BENCH_SECTOR_SIZE) != RES_OK) {
+        res = FR_DISK_ERR;
+      }
+      sector += size / SD_BENCH_SECTOR_SIZE;
+    } else {
+      res = f_write(&file, data, size, &written);
+      if (res == FR_OK && written != size) {
+        res = FR_DENIED; // Card full.
+      }
+    }
+
+    samples[i] = can_time_us() - start_us;
+    result->total_us += samples[i];
+    result->writes++;
+    result->bytes += size;
+  }
+
+  const uint32_t close_start_us = can_time_us();
+  const FRESULT close_res = f_close(&file);
+  result->close_us = can_time_us() - close_start_us;
+  f_unlink(SD_BENCH_DATA_FILE_NAME);
+  result->scratch = scratch_sectors() - scratch_start;
+
+  set_percentiles(result);
+  return (res != FR_OK) ? res : close_res;
+}
+
+FRESULT sd_bench_run(void) {
+  FIL file;
+  char row[128];
+  sd_bench_result_t result;
+
+  FRESULT res = f_open(&file, SD_BENCH_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
+  if (res != FR_OK) {
+    return res;
+  }
+  res = write_row(&file, "mode,alignment,size,fs_tiny,writes,kb_s,p50_us,"
+                         "p90_us,p99_us,max_us,close_us,scratch,result\n");
+
+  for (uint8_t mode = 0; mode < SD_BENCH_MODE_COUNT; mode++) {
+    for (uint8_t alignment = 0; alignment < SD_BENCH_ALIGNMENT_COUNT;
+         alignment++) {
+      for (uint32_t size = SD_BENCH_MIN_WRITE;
+           size <= SD_BENCH_MAX_WRITE && res == FR_OK; size *= 2) {
+        if (!supported(mode, alignment, size)) {
+          continue;
+        }
+        const FRESULT bench = sd_bench_config(mode, alignment, size, &result);
+
+        uint32_t kb_s = 0; // kB/s (bytes per ms), integer only.
+        if (result.total_us > 0) {
+          kb_s = (uint32_t)((uint64_t)result.bytes * 1000 / result.total_us);
+        }
+        snprintf(row, sizeof(row),
+                 "%s,%s,%lu,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%d\n",
+                 mode_names[mode], alignment_names[alignment],
+                 (unsigned long)size, (unsigned)_FS_TINY,
+                 (unsigned long)result.writes, (unsigned long)kb_s,
+                 (unsigned long)result.p50_us, (unsigned long)result.p90_us,
+                 (unsigned long)result.p99_us, (unsigned long)result.max_us,
+                 (unsigned long)result.close_us,
+                 (unsigned long)result.scratch, (int)bench);
+        res = write_row(&file, row);
+      }
+    }
+  }
+
+  const FRESULT close_res = f_close(&file);
+  return (res != FR_OK) ? res : close_res;
+}
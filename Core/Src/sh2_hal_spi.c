@@ -11,6 +11,7 @@
 
 #include "sh2_hal_spi.h"
 #include "sh2_err.h"
+#include "systime.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -76,11 +77,12 @@ static void rstn_write_pin(const GPIO_PinState pin_state) {
 }
 
 /**
- * @brief Get the current time in us.
+ * @brief Get the current time in us (system time low 32 bits).
  *
- * NOTE: No timer overflow handling.
+ * The SH2 library extends it to its 64-bit sensor event timestamps (counting
+ * the wraps), so the low 32 bits of a sensor timestamp are system time.
  */
-static uint32_t time_now_us(void) { return __HAL_TIM_GET_COUNTER(&SH2_HTIM); }
+static uint32_t time_now_us(void) { return systime_us32(); }
 
 /**
  * @brief Run a dummy SPI operation for dummy SPI SCLK during initialization.
@@ -245,11 +247,6 @@ static int sh2_spi_hal_open(sh2_Hal_t *self) {
   }
   is_open = true; // Define open instance.
 
-  // Enable hardware (timer).
-  __HAL_TIM_ENABLE(&SH2_HTIM);
-  HAL_TIM_Base_Init(&SH2_HTIM);
-  HAL_TIM_Base_Start(&SH2_HTIM);
-
   // Initialize pin states.
   rstn_write_pin(GPIO_PIN_RESET); // Hold in reset.
   cs_write_pin(GPIO_PIN_SET);     // De-assert CS.
@@ -291,8 +288,6 @@ static void sh2_spi_hal_close(sh2_Hal_t *self) {
   rstn_write_pin(GPIO_PIN_RESET); // Pull reset low (reset).
   cs_write_pin(GPIO_PIN_SET);     // Pull CS high (no longer calling CS).
 
-  __HAL_TIM_DISABLE(&SH2_HTIM); // Disable the timer.
-
   is_open = false; // No longer open.
 }
 
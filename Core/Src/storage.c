@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * @file storage.c
+ * @brief Storage manager: SD card hot-plug, background remount and logging.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "storage.h"
+#include "fpu_bench.h"
+#include "logger.h"
+#include "sd.h"
+#include "sd_bench.h"
+#include "systime.h"
+
+#include "configuration.h"
+
+/** Private variables. ********************************************************/
+
+static FRESULT file_result = FR_NOT_READY;
+static FATFS SDFatFs; // Not following snake case conventions here (sd.h).
+
+static storage_stats_t stats = {0};
+static uint8_t card = 0;                     // Debounced card detect.
+static uint32_t card_same_ms = 0;            // Detect last read as card.
+static uint32_t fault_ms = 0;                // Card released after a failure.
+static uint32_t retry_ms = STORAGE_RETRY_MS; // Backoff before the next mount.
+static uint32_t write_errors = 0;            // Logger write errors checked.
+static uint8_t benched = 0;                  // Benchmarks run, first mount.
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Debounce card detect, a change is kept once held STORAGE_DEBOUNCE_MS.
+ *
+ * @return 1 if the debounced state changed, otherwise 0.
+ */
+static uint8_t debounce(uint32_t now_ms) {
+  if (sdio_card_detected() == card) {
+    card_same_ms = now_ms;
+    return 0;
+  }
+  if (now_ms - card_same_ms < STORAGE_DEBOUNCE_MS) {
+    return 0;
+  }
+  card ^= 1;
+  card_same_ms = now_ms;
+  return 1;
+}
+
+/**
+ * @brief Suspend logging and release the card without accessing it.
+ */
+static void release(void) {
+  logger_suspend(); // Records buffered in RAM.
+  sdio_eject_sd(&SDFatFs);
+}
+
+/**
+ * @brief Release the card after a failure, mounted again after retry_ms.
+ */
+static void fail(FRESULT result, uint32_t now_ms) {
+  release();
+  stats.last_error = result;
+  fault_ms = now_ms;
+  stats.state = STORAGE_FAULT;
+}
+
+/**
+ * @brief Run the enabled benchmarks (configuration.h, blocking).
+ *
+ * @return FR_OK if run (or none enabled), else the FatFs error.
+ */
+static FRESULT benchmark(void) {
+  FRESULT result = FR_OK;
+
+#ifdef NERVE_SD_BENCHMARK
+  result = sd_bench_run();
+#endif
+#ifdef NERVE_FPU_BENCHMARK
+  if (result == FR_OK) {
+    result = fpu_bench_run();
+  }
+#endif
+  return result;
+}
+
+/**
+ * @brief Step the state machine, one bounded step.
+ */
+static void step(uint32_t now_ms) {
+  switch (stats.state) {
+  case STORAGE_INIT:
+    if (!sdio_init_sd_step(&file_result)) {
+      break; // Card power-up, one step per call.
+    }
+    if (file_result == FR_OK) {
+      stats.state = STORAGE_MOUNT;
+    } else {
+      stats.failures++;
+      fail(file_result, now_ms);
+    }
+    break;
+
+  case STORAGE_MOUNT: {
+    const uint32_t start_us = systime_us32();
+    sdio_mount_volume_sd(&file_result, &SDFatFs); // Blocking, volume read.
+    const uint32_t elapsed_us = systime_us32() - start_us;
+    if (elapsed_us > stats.mount_us_max) {
+      stats.mount_us_max = elapsed_us;
+    }
+    if (file_result == FR_OK) {
+      stats.state = STORAGE_START;
+    } else {
+      stats.failures++;
+      fail(file_result, now_ms);
+    }
+    break;
+  }
+
+  case STORAGE_START:
+    if (!benched) {
+      benched = 1;
+      file_result = benchmark();
+    } else if (!logger_start_step(&file_result)) {
+      break; // Session and file creation, one step per call.
+    } else if (file_result == FR_OK) {
+      stats.mounts++;
+      retry_ms = STORAGE_RETRY_MS;
+      write_errors = logger_get_stats()->write_errors;
+      stats.state = STORAGE_MOUNTED;
+      break;
+    }
+    if (file_result != FR_OK) {
+      stats.failures++;
+      fail(file_result, now_ms);
+    }
+    break;
+
+  case STORAGE_MOUNTED: {
+    // Write errors also come from a full card or a failed file pre-creation,
+    // the card is only released if it no longer answers.
+    const uint32_t errors = logger_get_stats()->write_errors;
+    if (errors != write_errors) {
+      write_errors = errors;
+      if (!sdio_card_responding()) {
+        stats.faults++;
+        fail(FR_DISK_ERR, now_ms);
+      }
+    }
+    break;
+  }
+
+  case STORAGE_FAULT:
+    if (now_ms - fault_ms >= retry_ms) {
+      retry_ms = (retry_ms * 2 < STORAGE_RETRY_MAX_MS) ? retry_ms * 2
+                                                       : STORAGE_RETRY_MAX_MS;
+      stats.state = STORAGE_INIT;
+    }
+    break;
+
+  case STORAGE_ABSENT:
+  default:
+    break; // Waiting for a card.
+  }
+}
+
+/** Public functions. *********************************************************/
+
+void storage_init(void) {
+  logger_init(); // Records buffered until the card is mounted.
+  card = 0;      // Mounted once detected for STORAGE_DEBOUNCE_MS.
+  card_same_ms = HAL_GetTick();
+  stats.state = STORAGE_ABSENT;
+}
+
+void storage_process(void) {
+  const uint32_t now_ms = HAL_GetTick();
+  const uint32_t start_us = systime_us32();
+
+  if (debounce(now_ms)) {
+    if (card) {
+      stats.insertions++;
+      retry_ms = STORAGE_RETRY_MS;
+      stats.state = STORAGE_INIT;
+    } else {
+      stats.removals++;
+      if (stats.state != STORAGE_ABSENT) {
+        release();
+      }
+      stats.state = STORAGE_ABSENT;
+    }
+  } else {
+    step(now_ms);
+  }
+
+  const uint32_t elapsed_us = systime_us32() - start_us;
+  if (elapsed_us > stats.call_us_max) {
+    stats.call_us_max = elapsed_us;
+  }
+}
+
+void storage_deinit(void) {
+  logger_stop(); // Flush and close the flight log.
+  if (stats.state == STORAGE_START || stats.state == STORAGE_MOUNTED) {
+    sdio_unmount_sd(&file_result, &SDFatFs);
+  }
+}
+
+const storage_stats_t *storage_get_stats(void) { return &stats; }
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * @file systime.c
+ * @brief System time: 64-bit monotonic 1 us time base shared by all modules.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "systime.h"
+#include "core_cm4.h" // Include core definitions for DWT.
+#include "main.h"
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Halt unless the low word timer counts at SYSTIME_TICK_HZ.
+ *
+ * APB1 timers are clocked at twice PCLK1 when APB1 is divided, a clock tree
+ * change without a matching prescaler would silently rescale every timestamp.
+ */
+static void check_rate(void) {
+  uint32_t timer_hz = HAL_RCC_GetPCLK1Freq();
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+    timer_hz *= 2;
+  }
+  if (timer_hz != SYSTIME_TICK_HZ * (SYSTIME_HTIM.Instance->PSC + 1)) {
+    Error_Handler();
+  }
+}
+
+/** Public functions. *********************************************************/
+
+void systime_init(void) {
+  check_rate();
+
+  // Enable DWT and the cycle counter (cycle profiling, not a time base).
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  __HAL_TIM_DISABLE(&SYSTIME_HTIM);
+  __HAL_TIM_DISABLE(&SYSTIME_HIGH_HTIM);
+
+  // Low word: TRGO on update (overflow).
+  TIM_MasterConfigTypeDef master = {0};
+  master.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  HAL_TIMEx_MasterConfigSynchronization(&SYSTIME_HTIM, &master);
+
+  // High word: one count per low word overflow, no prescaler (the generated
+  // 1 us configuration is replaced, PSC loaded by the update event).
+  TIM_SlaveConfigTypeDef slave = {0};
+  slave.SlaveMode = TIM_SLAVEMODE_EXTERNAL1;
+  slave.InputTrigger = TIM_TS_ITR0;
+  HAL_TIM_SlaveConfigSynchro(&SYSTIME_HIGH_HTIM, &slave);
+  __HAL_TIM_SET_PRESCALER(&SYSTIME_HIGH_HTIM, 0);
+  HAL_TIM_GenerateEvent(&SYSTIME_HIGH_HTIM, TIM_EVENTSOURCE_UPDATE);
+
+  __HAL_TIM_SET_COUNTER(&SYSTIME_HIGH_HTIM, 0);
+  __HAL_TIM_SET_COUNTER(&SYSTIME_HTIM, 0);
+  HAL_TIM_Base_Start(&SYSTIME_HIGH_HTIM);
+  HAL_TIM_Base_Start(&SYSTIME_HTIM);
+}
+
+uint64_t systime_us(void) {
+  uint32_t low;
+  uint32_t high;
+  uint32_t check;
+
+  // The high word counts a few timer clocks after the low word reads 0, so a
+  // low word of 0 is read again (at most 1 us). Otherwise the high word read
+  // between two low word reads without an overflow belongs to both.
+  do {
+    low = __HAL_TIM_GET_COUNTER(&SYSTIME_HTIM);
+    high = __HAL_TIM_GET_COUNTER(&SYSTIME_HIGH_HTIM);
+    check = __HAL_TIM_GET_COUNTER(&SYSTIME_HTIM);
+  } while (low == 0 || check < low);
+
+  return ((uint64_t)high << 32) | low;
+}
+
+uint32_t systime_us32(void) { return __HAL_TIM_GET_COUNTER(&SYSTIME_HTIM); }
@@ -7,6 +7,8 @@
 /** Includes. *****************************************************************/
 
 #include "telemetry.h"
+#include <stdbool.h>
+#include <string.h>
 #include "bmp390_runner.h"
 #include "bno085_runner.h"
 #include "can.h"
@@ -14,125 +16,346 @@
 #include "diagnostics.h"
 #include "rtc.h"
 #include "ublox_hal_uart.h"
+#include "xbee_api_hal_uart.h"
 
-/** Public functions. *********************************************************/
+#include "configuration.h"
+
+/** Definitions. **************************************************************/
+
+// Telemetry signal source initializers.
+#define SRC(type, value) {TELEMETRY_##type, (const void *)&(value)}
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Enumeration for telemetry signal source data types.
+ */
+typedef enum {
+  TELEMETRY_ZERO = 0,  // No source, raw value 0.
+  TELEMETRY_FLOAT,     // float physical value.
+  TELEMETRY_UINT8,     // uint8_t physical value.
+  TELEMETRY_UINT16,    // uint16_t physical value.
+  TELEMETRY_ENUM,      // enum (int sized) physical value.
+  TELEMETRY_RAW_UINT8, // uint8_t already in raw CAN units.
+  TELEMETRY_RAW_UINT32 // uint32_t already in raw CAN units.
+} telemetry_source_type_t;
+
+/**
+ * @brief Struct defining the source of one CAN signal value.
+ */
+typedef struct {
+  telemetry_source_type_t type; // Source data type.
+  const void *value;            // Pointer to the live source value.
+} telemetry_source_t;
+
+/**
+ * @brief Struct defining a CAN telemetry message.
+ *
+ * References the const DBC descriptor in flash by index, the sources are in
+ * the same order as the descriptor signals.
+ */
+typedef struct {
+  uint8_t message_index; // Index into dbc_messages[] (DBC_MESSAGE_*).
+  void (*prepare)(void); // Optional source refresh before encoding.
+  telemetry_source_t sources[MAX_SIGNALS_PER_MESSAGE]; // Signal sources.
+} telemetry_can_message_t;
+
+/** Public variables. *********************************************************/
+
+uint32_t telemetry_can_tx_cycles_last = 0;
+uint32_t telemetry_can_tx_cycles_max = 0;
+
+/** Private variables. ********************************************************/
+
+static uint8_t rtc_state;        // 1 if the RTC was set.
+static uint32_t rtc_epoch_s;     // RTC Unix time (s).
+static uint16_t rtc_millisecond; // RTC millisecond of the second.
 
-void can_tx_state(void) {
-  can_message_t state_msg = dbc_messages[0];
-  uint32_t state_sigs[1] = {0}; // TODO: Hardcoded.
-  can_send_message_raw32(&hcan1, &state_msg, state_sigs);
+static can_bus_status_t can_status[2]; // Index 0: CAN1, index 1: CAN2.
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Refresh the RTC time sources (sub-second, see get_epoch_us).
+ */
+static void prepare_rtc(void) {
+  int64_t epoch_us = 0;
+
+  rtc_state = get_epoch_us(&epoch_us);
+  rtc_epoch_s = (uint32_t)(epoch_us / 1000000);
+  rtc_millisecond = (uint16_t)(epoch_us % 1000000 / 1000);
 }
 
-void can_tx_barometric(void) {
-  can_message_t pressure_msg = dbc_messages[1];
-  uint32_t pressure_sigs[3] = {0};
-  const float pressure_source_sigs[3] = {bmp390_pressure, bmp390_temperature,
-                                         (float)bmp390_fault_count};
-  for (int i = 0; i < pressure_msg.signal_count; ++i) {
-    pressure_sigs[i] =
-        float_to_raw(pressure_source_sigs[i], &pressure_msg.signals[i]);
-  }
-  can_send_message_raw32(&hcan1, &pressure_msg, pressure_sigs);
+/**
+ * @brief Refresh the CAN1 bus monitor sources.
+ */
+static void prepare_can1_status(void) {
+  can_status[0] = *can_get_bus_status(&hcan1);
+}
+
+/**
+ * @brief Refresh the CAN2 bus monitor sources.
+ */
+static void prepare_can2_status(void) {
+  can_status[1] = *can_get_bus_status(&hcan2);
 }
 
-void can_tx_gps1(void) {
-  can_message_t gps1_msg = dbc_messages[2];
-  uint32_t gps1_sigs[2] = {0};
-  const float gps1_source_sigs[2] = {gps_data.latitude, gps_data.longitude};
-  for (int i = 0; i < gps1_msg.signal_count; ++i) {
-    gps1_sigs[i] = float_to_raw(gps1_source_sigs[i], &gps1_msg.signals[i]);
+/**
+ * @brief Encode a source value into raw CAN units for its signal.
+ */
+static uint32_t encode_source(const telemetry_source_t *source,
+                              const can_signal_t *signal) {
+  switch (source->type) {
+  case TELEMETRY_FLOAT:
+    return float_to_raw(*(const float *)source->value, signal);
+  case TELEMETRY_UINT8:
+    return float_to_raw((float)*(const uint8_t *)source->value, signal);
+  case TELEMETRY_UINT16:
+    return float_to_raw((float)*(const uint16_t *)source->value, signal);
+  case TELEMETRY_ENUM:
+    return float_to_raw((float)*(const int *)source->value, signal);
+  case TELEMETRY_RAW_UINT8:
+    return *(const uint8_t *)source->value;
+  case TELEMETRY_RAW_UINT32:
+    return *(const uint32_t *)source->value;
+  case TELEMETRY_ZERO:
+  default:
+    return 0;
   }
-  can_send_message_raw32(&hcan1, &gps1_msg, gps1_sigs);
 }
 
-void can_tx_gps2(void) {
-  can_message_t gps2_msg = dbc_messages[3];
-  uint32_t gps2_sigs[5] = {0};
-  const float gps2_source_sigs[5] = {gps_data.speed_knots, gps_data.course_deg,
-                                     gps_data.position_fix, gps_data.satellites,
-                                     gps_data.hdop};
-  for (int i = 0; i < gps2_msg.signal_count; ++i) {
-    gps2_sigs[i] = float_to_raw(gps2_source_sigs[i], &gps2_msg.signals[i]);
+/**
+ * @brief Table-driven encode of one telemetry message into raw signal values.
+ */
+static void encode(const telemetry_can_message_t *telemetry,
+                   uint32_t raw[MAX_SIGNALS_PER_MESSAGE]) {
+  const can_message_t *msg = &dbc_messages[telemetry->message_index];
+
+  if (telemetry->prepare) {
+    telemetry->prepare();
+  }
+  for (uint8_t i = 0; i < msg->signal_count; i++) {
+    raw[i] = encode_source(&telemetry->sources[i], &msg->signals[i]);
   }
-  can_send_message_raw32(&hcan1, &gps2_msg, gps2_sigs);
 }
 
-void can_tx_gps3(void) {
-  can_message_t gps3_msg = dbc_messages[4];
-  uint32_t gps3_sigs[3] = {0};
-  const float gps3_source_sigs[3] = {gps_data.altitude_m, gps_data.geoid_sep_m,
-                                     (float)gps_fault_count};
-  for (int i = 0; i < gps3_msg.signal_count; ++i) {
-    gps3_sigs[i] = float_to_raw(gps3_source_sigs[i], &gps3_msg.signals[i]);
+/**
+ * @brief Record the DWT cycles spent on one telemetry message.
+ */
+static void record_tx_cycles(uint32_t start_cyc) {
+  telemetry_can_tx_cycles_last = DWT->CYCCNT - start_cyc;
+  if (telemetry_can_tx_cycles_last > telemetry_can_tx_cycles_max) {
+    telemetry_can_tx_cycles_max = telemetry_can_tx_cycles_last;
   }
-  can_send_message_raw32(&hcan1, &gps3_msg, gps3_sigs);
 }
 
-void can_tx_imu1(void) {
-  can_message_t imu1_msg = dbc_messages[5];
-  uint32_t imu1_sigs[4] = {0};
-  const float imu1_source_sigs[4] = {bno085_quaternion_i, bno085_quaternion_j,
-                                     bno085_quaternion_k,
-                                     bno085_quaternion_real};
-  for (int i = 0; i < imu1_msg.signal_count; ++i) {
-    imu1_sigs[i] = float_to_raw(imu1_source_sigs[i], &imu1_msg.signals[i]);
+/** Telemetry CAN message table. **********************************************/
+
+// The DBC state message is not sent, there is no system state source yet.
+static const telemetry_can_message_t telemetry_can_messages[] = {
+    {DBC_MESSAGE_BAROMETRIC,
+     0,
+     {SRC(FLOAT, bmp390_pressure), SRC(FLOAT, bmp390_temperature),
+      SRC(UINT8, bmp390_fault_count)}},
+    {DBC_MESSAGE_GPS1,
+     0,
+     {SRC(FLOAT, gps_data.latitude), SRC(FLOAT, gps_data.longitude)}},
+    {DBC_MESSAGE_GPS2,
+     0,
+     {SRC(FLOAT, gps_data.speed_knots), SRC(FLOAT, gps_data.course_deg),
+      SRC(ENUM, gps_data.position_fix), SRC(UINT8, gps_data.satellites),
+      SRC(FLOAT, gps_data.hdop)}},
+    {DBC_MESSAGE_GPS3,
+     0,
+     {SRC(FLOAT, gps_data.altitude_m), SRC(FLOAT, gps_data.geoid_sep_m),
+      SRC(UINT8, gps_fault_count)}},
+    {DBC_MESSAGE_IMU1,
+     0,
+     {SRC(FLOAT, bno085_quaternion_i), SRC(FLOAT, bno085_quaternion_j),
+      SRC(FLOAT, bno085_quaternion_k), SRC(FLOAT, bno085_quaternion_real)}},
+    {DBC_MESSAGE_IMU2,
+     0,
+     {SRC(FLOAT, bno085_gyro_x), SRC(FLOAT, bno085_gyro_y),
+      SRC(FLOAT, bno085_gyro_z)}},
+    {DBC_MESSAGE_IMU3,
+     0,
+     {SRC(FLOAT, bno085_accel_x), SRC(FLOAT, bno085_accel_y),
+      SRC(FLOAT, bno085_accel_z)}},
+    {DBC_MESSAGE_IMU4,
+     0,
+     {SRC(FLOAT, bno085_lin_accel_x), SRC(FLOAT, bno085_lin_accel_y),
+      SRC(FLOAT, bno085_lin_accel_z)}},
+    {DBC_MESSAGE_IMU5,
+     0,
+     {SRC(FLOAT, bno085_gravity_x), SRC(FLOAT, bno085_gravity_y),
+      SRC(FLOAT, bno085_gravity_z)}},
+    {DBC_MESSAGE_IMU6,
+     0,
+     {SRC(FLOAT, bno085_quaternion_accuracy_rad),
+      SRC(UINT8, bno085_fault_count)}},
+    {DBC_MESSAGE_RTC,
+     prepare_rtc,
+     {SRC(RAW_UINT8, rtc_state), SRC(RAW_UINT32, rtc_epoch_s),
+      SRC(UINT16, rtc_millisecond)}},
+    {DBC_MESSAGE_CAN1_STATUS,
+     prepare_can1_status,
+     {SRC(UINT16, can_status[0].tx_fps), SRC(UINT16, can_status[0].rx_fps),
+      SRC(FLOAT, can_status[0].bus_load_percent),
+      SRC(UINT8, can_status[0].tec), SRC(UINT8, can_status[0].rec),
+      SRC(ENUM, can_status[0].error_state),
+      SRC(UINT8, can_status[0].last_error_code),
+      SRC(UINT16, can_status[0].bus_off_count)}},
+    {DBC_MESSAGE_CAN2_STATUS,
+     prepare_can2_status,
+     {SRC(UINT16, can_status[1].tx_fps), SRC(UINT16, can_status[1].rx_fps),
+      SRC(FLOAT, can_status[1].bus_load_percent),
+      SRC(UINT8, can_status[1].tec), SRC(UINT8, can_status[1].rec),
+      SRC(ENUM, can_status[1].error_state),
+      SRC(UINT8, can_status[1].last_error_code),
+      SRC(UINT16, can_status[1].bus_off_count)}},
+};
+
+/** Telemetry CAN TX scheduler. ***********************************************/
+
+#define TELEMETRY_CAN_MESSAGE_COUNT                                            \
+  (sizeof(telemetry_can_messages) / sizeof(telemetry_can_messages[0]))
+
+// Per message TX scheduler state.
+static uint32_t telemetry_next_ms[TELEMETRY_CAN_MESSAGE_COUNT];
+static uint32_t telemetry_last_sent_ms[TELEMETRY_CAN_MESSAGE_COUNT];
+static uint32_t telemetry_last_raw[TELEMETRY_CAN_MESSAGE_COUNT]
+                                  [MAX_SIGNALS_PER_MESSAGE];
+static bool telemetry_sent[TELEMETRY_CAN_MESSAGE_COUNT];
+
+// Next telemetry message sent over XBee.
+static uint8_t xbee_next = 0;
+
+/**
+ * @brief Transmit encoded telemetry and record it as last sent.
+ */
+static void transmit(uint8_t i, const uint32_t raw[MAX_SIGNALS_PER_MESSAGE],
+                     uint32_t now_ms) {
+  can_send_message(&dbc_messages[telemetry_can_messages[i].message_index], raw);
+  memcpy(telemetry_last_raw[i], raw, sizeof(telemetry_last_raw[i]));
+  telemetry_last_sent_ms[i] = now_ms;
+  telemetry_sent[i] = true;
+}
+
+/**
+ * @brief Check if a cyclic message is due and advance its next send time.
+ *
+ * Missed periods are skipped while keeping the planned phase offset.
+ */
+static bool cyclic_due(uint8_t i, const can_message_t *msg, uint32_t now_ms) {
+  if ((msg->send_type != CAN_SEND_CYCLIC &&
+       msg->send_type != CAN_SEND_CYCLIC_AND_ON_CHANGE) ||
+      msg->cycle_time_ms == 0 ||
+      (int32_t)(now_ms - telemetry_next_ms[i]) < 0) {
+    return false;
   }
-  can_send_message_raw32(&hcan1, &imu1_msg, imu1_sigs);
+
+  telemetry_next_ms[i] +=
+      ((now_ms - telemetry_next_ms[i]) / msg->cycle_time_ms + 1) *
+      msg->cycle_time_ms;
+  return true;
 }
 
-void can_tx_imu2(void) {
-  can_message_t imu2_msg = dbc_messages[6];
-  uint32_t imu2_sigs[3] = {0};
-  const float imu2_source_sigs[3] = {bno085_gyro_x, bno085_gyro_y,
-                                     bno085_gyro_z};
-  for (int i = 0; i < imu2_msg.signal_count; ++i) {
-    imu2_sigs[i] = float_to_raw(imu2_source_sigs[i], &imu2_msg.signals[i]);
+/**
+ * @brief Check if encoded on-change data should be sent now.
+ */
+static bool changed_due(uint8_t i, const can_message_t *msg,
+                        const uint32_t raw[MAX_SIGNALS_PER_MESSAGE],
+                        uint32_t now_ms) {
+  if (!telemetry_sent[i]) {
+    return true;
+  }
+  if (now_ms - telemetry_last_sent_ms[i] < msg->min_interval_ms) {
+    return false;
   }
-  can_send_message_raw32(&hcan1, &imu2_msg, imu2_sigs);
+  return memcmp(raw, telemetry_last_raw[i], sizeof(telemetry_last_raw[i])) !=
+         0;
 }
 
-void can_tx_imu3(void) {
-  can_message_t imu3_msg = dbc_messages[7];
-  uint32_t imu3_sigs[3] = {0};
-  const float imu3_source_sigs[3] = {bno085_accel_x, bno085_accel_y,
-                                     bno085_accel_z};
-  for (int i = 0; i < imu3_msg.signal_count; ++i) {
-    imu3_sigs[i] = float_to_raw(imu3_source_sigs[i], &imu3_msg.signals[i]);
+/** Public functions. *********************************************************/
+
+void telemetry_init(void) {
+  const uint32_t now_ms = HAL_GetTick();
+
+  for (uint8_t i = 0; i < TELEMETRY_CAN_MESSAGE_COUNT; i++) {
+    telemetry_next_ms[i] =
+        now_ms + dbc_messages[telemetry_can_messages[i].message_index]
+                     .start_delay_ms;
+    telemetry_sent[i] = false;
   }
-  can_send_message_raw32(&hcan1, &imu3_msg, imu3_sigs);
 }
 
-void can_tx_imu4(void) {
-  can_message_t imu4_msg = dbc_messages[8];
-  uint32_t imu4_sigs[3] = {0};
-  const float imu4_source_sigs[3] = {bno085_lin_accel_x, bno085_lin_accel_y,
-                                     bno085_lin_accel_z};
-  for (int i = 0; i < imu4_msg.signal_count; ++i) {
-    imu4_sigs[i] = float_to_raw(imu4_source_sigs[i], &imu4_msg.signals[i]);
+void can_tx_telemetry(uint8_t message_index) {
+  for (uint8_t i = 0; i < TELEMETRY_CAN_MESSAGE_COUNT; i++) {
+    if (telemetry_can_messages[i].message_index == message_index) {
+      const uint32_t start_cyc = DWT->CYCCNT;
+      uint32_t raw[MAX_SIGNALS_PER_MESSAGE] = {0};
+
+      encode(&telemetry_can_messages[i], raw);
+      transmit(i, raw, HAL_GetTick());
+      record_tx_cycles(start_cyc);
+      return;
+    }
   }
-  can_send_message_raw32(&hcan1, &imu4_msg, imu4_sigs);
 }
 
-void can_tx_imu5(void) {
-  can_message_t imu5_msg = dbc_messages[9];
-  uint32_t imu5_sigs[3] = {0};
-  const float imu5_source_sigs[3] = {bno085_gravity_x, bno085_gravity_y,
-                                     bno085_gravity_z};
-  for (int i = 0; i < imu5_msg.signal_count; ++i) {
-    imu5_sigs[i] = float_to_raw(imu5_source_sigs[i], &imu5_msg.signals[i]);
+void can_tx_telemetry_due(void) {
+  const uint32_t now_ms = HAL_GetTick();
+
+  for (uint8_t i = 0; i < TELEMETRY_CAN_MESSAGE_COUNT; i++) {
+    const can_message_t *msg =
+        &dbc_messages[telemetry_can_messages[i].message_index];
+    const bool on_change = msg->send_type == CAN_SEND_ON_CHANGE ||
+                           msg->send_type == CAN_SEND_CYCLIC_AND_ON_CHANGE;
+    const bool cyclic = cyclic_due(i, msg, now_ms);
+
+    if (!cyclic && !on_change) {
+      continue;
+    }
+
+    const uint32_t start_cyc = DWT->CYCCNT;
+    uint32_t raw[MAX_SIGNALS_PER_MESSAGE] = {0};
+
+    encode(&telemetry_can_messages[i], raw);
+    if (cyclic || changed_due(i, msg, raw, now_ms)) {
+      transmit(i, raw, now_ms);
+    }
+    record_tx_cycles(start_cyc);
   }
-  can_send_message_raw32(&hcan1, &imu5_msg, imu5_sigs);
 }
 
-void can_tx_rtc(void) {
-  can_message_t rtc_msg = dbc_messages[11];
-  // Get the date and time.
-  RTC_DateTypeDef date;
-  RTC_TimeTypeDef time;
-  HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
-  HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
-  uint32_t rtc_sigs[8] = {
-      0,          date.Year,    date.Month,  date.Date, date.WeekDay,
-      time.Hours, time.Minutes, time.Seconds}; // TODO: Hardcoded state.
-  can_send_message_raw32(&hcan1, &rtc_msg, rtc_sigs);
+void xbee_tx_telemetry(void) {
+  uint8_t payload[TELEMETRY_XBEE_PAYLOAD_SIZE];
+  size_t length = 0;
+
+  // Round robin from the message after the last one sent, each at most once.
+  for (uint8_t n = 0; n < TELEMETRY_CAN_MESSAGE_COUNT; n++) {
+    const telemetry_can_message_t *telemetry =
+        &telemetry_can_messages[xbee_next];
+    const can_message_t *msg = &dbc_messages[telemetry->message_index];
+    if (length + 2 + msg->dlc > sizeof(payload)) {
+      break;
+    }
+
+    uint32_t raw[MAX_SIGNALS_PER_MESSAGE] = {0};
+    uint8_t data[8];
+    encode(telemetry, raw);
+    can_pack_message_raw32(msg, raw, data);
+
+    // Frame: standard ID (bits 0-10) and DLC (bits 12-15), then the payload.
+    const uint16_t header = (uint16_t)(msg->message_id | (msg->dlc << 12));
+    payload[length++] = (uint8_t)(header & 0xFF);
+    payload[length++] = (uint8_t)(header >> 8);
+    memcpy(&payload[length], data, msg->dlc);
+    length += msg->dlc;
+
+    xbee_next = (xbee_next + 1) % TELEMETRY_CAN_MESSAGE_COUNT;
+  }
+
+  xbee_send(XBEE_DESTINATION_64, XBEE_DESTINATION_16, payload,
+            (uint16_t)length, 0);
 }
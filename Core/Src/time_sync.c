@@ -0,0 +1,127 @@
+/*******************************************************************************
+ * @file time_sync.c
+ * @brief Two-step CAN time synchronization master.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "time_sync.h"
+#include "can.h"
+#include "can_nerve.h"
+
+/** Definitions. **************************************************************/
+
+// time_sync signal indices, in DBC order.
+#define SIGNAL_TYPE 0
+#define SIGNAL_SEQUENCE 1
+#define SIGNAL_COARSE_US 2
+#define SIGNAL_PRECISE_US 3
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Enumeration for the time sync state.
+ */
+typedef enum {
+  TIME_SYNC_IDLE = 0,    // Waiting for the next period.
+  TIME_SYNC_SYNC_QUEUED, // SYNC queued, waiting for its transmit time.
+  TIME_SYNC_SYNC_SENT,   // SYNC transmitted, FOLLOW_UP to be queued.
+} time_sync_state_t;
+
+/** Private variables. ********************************************************/
+
+static volatile time_sync_state_t state = TIME_SYNC_IDLE;
+static volatile uint32_t sync_tx_us = 0; // Written by the TX interrupt only.
+static uint32_t sync_queued_us = 0;
+static uint32_t next_ms = 0;
+static uint8_t sequence = 0;
+static time_sync_stats_t stats = {0};
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Queue one time sync frame.
+ */
+static HAL_StatusTypeDef send(uint8_t type, uint32_t time_us) {
+  uint32_t raw[MAX_SIGNALS_PER_MESSAGE] = {0};
+
+  raw[SIGNAL_TYPE] = type;
+  raw[SIGNAL_SEQUENCE] = sequence;
+  raw[type == TIME_SYNC_TYPE_SYNC ? SIGNAL_COARSE_US : SIGNAL_PRECISE_US] =
+      time_us;
+  return can_send_message_raw32(&TIME_SYNC_CAN_HANDLE,
+                                &dbc_messages[DBC_MESSAGE_TIME_SYNC], raw);
+}
+
+/** CAN TX complete hook (overwriting weak default). **************************/
+
+void can_tx_complete(const CAN_HandleTypeDef *h_can_x, uint32_t std_id,
+                     const uint8_t *data, uint32_t timestamp_us) {
+  const can_message_t *msg = &dbc_messages[DBC_MESSAGE_TIME_SYNC];
+
+  if (h_can_x != &TIME_SYNC_CAN_HANDLE || state != TIME_SYNC_SYNC_QUEUED ||
+      std_id != msg->message_id) {
+    return;
+  }
+
+  // FOLLOW_UP shares the ID and a SYNC missed earlier may still be queued (kept
+  // over bus-off recovery), only the queued SYNC completes the first step.
+  if (can_signal_raw(&msg->signals[SIGNAL_TYPE], data) == TIME_SYNC_TYPE_SYNC &&
+      can_signal_raw(&msg->signals[SIGNAL_SEQUENCE], data) == sequence) {
+    sync_tx_us = timestamp_us;
+    state = TIME_SYNC_SYNC_SENT;
+  }
+}
+
+/** Public functions. *********************************************************/
+
+void time_sync_init(void) {
+  next_ms = HAL_GetTick() + dbc_messages[DBC_MESSAGE_TIME_SYNC].start_delay_ms;
+  state = TIME_SYNC_IDLE;
+}
+
+void time_sync_process(void) {
+  const can_message_t *msg = &dbc_messages[DBC_MESSAGE_TIME_SYNC];
+  const uint32_t now_ms = HAL_GetTick();
+
+  // Second step, the exact SYNC transmit time.
+  if (state == TIME_SYNC_SYNC_SENT) {
+    const uint32_t tx_us = sync_tx_us;
+    if (send(TIME_SYNC_TYPE_FOLLOW_UP, tx_us) == HAL_OK) {
+      stats.follow_ups++;
+      stats.last_sync_us = tx_us;
+      stats.tx_latency_us = tx_us - sync_queued_us;
+      sequence = (sequence + 1) & 0x0F;
+      state = TIME_SYNC_IDLE;
+    }
+  }
+
+  if (msg->cycle_time_ms == 0 || (int32_t)(now_ms - next_ms) < 0) {
+    return;
+  }
+  next_ms += ((now_ms - next_ms) / msg->cycle_time_ms + 1) * msg->cycle_time_ms;
+
+  if (state == TIME_SYNC_SYNC_QUEUED) {
+    // SYNC not sent for a whole period (bus-off or dropped), skip it.
+    stats.missed++;
+    sequence = (sequence + 1) & 0x0F;
+    state = TIME_SYNC_IDLE;
+    return;
+  }
+  if (state != TIME_SYNC_IDLE) {
+    return; // FOLLOW_UP not queued yet, retried on the next call.
+  }
+
+  // First step, SYNC with the coarse time. Set the state first, the TX
+  // interrupt may complete the frame before can_send_message_raw32 returns.
+  sync_queued_us = can_time_us();
+  state = TIME_SYNC_SYNC_QUEUED;
+  if (send(TIME_SYNC_TYPE_SYNC, sync_queued_us) == HAL_OK) {
+    stats.syncs++;
+  } else {
+    state = TIME_SYNC_IDLE;
+  }
+}
+
+const time_sync_stats_t *time_sync_get_stats(void) { return &stats; }
@@ -7,6 +7,9 @@
 /** Includes. *****************************************************************/
 
 #include "ublox_hal_uart.h"
+#include "gnss_time.h"
+#include "logger.h"
+#include "systime.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -15,6 +18,7 @@
 
 #include "configuration.h"
 #ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
+#include "can_nerve.h"
 #include "telemetry.h"
 #endif
 
@@ -23,6 +27,9 @@
 #define GNGGA_TOKEN_COUNT 15 // GGA index [0..14], exclude checksum and return.
 #define GNRMC_TOKEN_COUNT 14 // RMC index [0..13], exclude checksum and return.
 
+// Decimal field fraction digits kept (10^7 scale), exact in a float.
+#define NMEA_FRACTION_SCALE 10000000U
+
 /** Private variables. ********************************************************/
 
 // Buffer for UART reception.
@@ -37,6 +44,13 @@ static bool ublox_in_sentence = false;
 static uint8_t sentence_start_index = 0;
 static uint8_t sentence_end_index = 0;
 
+// Sentence start timing, from the line idle time of the bytes received.
+static uint32_t rx_idle_us = 0;        // Line idle detected (systime_us32).
+static uint16_t rx_remaining = 0;      // Bytes to process, this one included.
+static bool rx_timed = false;          // Processing bytes of an IDLE event.
+static uint32_t sentence_start_us = 0; // '$' start bit (systime_us32).
+static bool sentence_timed = false;    // sentence_start_us is valid.
+
 /** Private functions. ********************************************************/
 
 /**
@@ -44,6 +58,118 @@ static uint8_t sentence_end_index = 0;
  */
 void ublox_error_handler(void) { gps_fault(); }
 
+/**
+ * @brief Parse a NMEA UTC time "hhmmss.ss" into GPS data.
+ *
+ * Integer parse, exact fractional seconds (a float holds hhmmss to ~0.01 s).
+ *
+ * @param token UTC time token.
+ * @param data GPS data to update.
+ */
+static void parse_utc_time(const char *token, ublox_data_t *data) {
+  uint32_t hhmmss = 0;
+  uint16_t millisecond = 0;
+  const char *c = token;
+
+  while (*c >= '0' && *c <= '9') {
+    hhmmss = hhmmss * 10 + (uint32_t)(*c++ - '0');
+  }
+  if (*c == '.') {
+    c++;
+    for (uint16_t scale = 100; scale > 0; scale /= 10) {
+      if (*c < '0' || *c > '9') {
+        break;
+      }
+      millisecond += (uint16_t)(*c++ - '0') * scale;
+    }
+  }
+
+  data->hour = (uint8_t)(hhmmss / 10000);
+  data->minute = (uint8_t)(hhmmss / 100 % 100);
+  data->second = (uint8_t)(hhmmss % 100);
+  data->millisecond = millisecond;
+}
+
+/**
+ * @brief Parse an unsigned NMEA decimal field "ddd.ddd".
+ *
+ * Integer parse, no double precision library math (strtof converts through
+ * strtod, software floating point). Fraction digits past NMEA_FRACTION_SCALE
+ * are skipped.
+ *
+ * @param token Decimal field.
+ * @param whole Pointer to the integer part.
+ * @param fraction Pointer to the fraction part (1 / scale units).
+ * @param scale Pointer to the fraction scale (10^fraction digits).
+ *
+ * @return true if at least one digit was parsed, otherwise false.
+ */
+static bool parse_decimal(const char *token, uint32_t *whole,
+                          uint32_t *fraction, uint32_t *scale) {
+  const char *c = token;
+  bool digits = false;
+
+  *whole = 0;
+  *fraction = 0;
+  *scale = 1;
+  while (*c >= '0' && *c <= '9') {
+    *whole = *whole * 10 + (uint32_t)(*c++ - '0');
+    digits = true;
+  }
+  if (*c == '.') {
+    c++;
+    while (*c >= '0' && *c <= '9') {
+      if (*scale < NMEA_FRACTION_SCALE) {
+        *fraction = *fraction * 10 + (uint32_t)(*c - '0');
+        *scale *= 10;
+      }
+      c++;
+      digits = true;
+    }
+  }
+  return digits;
+}
+
+/**
+ * @brief Parse a signed NMEA decimal field, single precision only.
+ *
+ * @param token Decimal field.
+ * @param value Pointer to the value, unchanged if the field is empty.
+ *
+ * @return true if parsed, otherwise false.
+ */
+static bool parse_float(const char *token, float *value) {
+  const bool negative = (*token == '-');
+  uint32_t whole;
+  uint32_t fraction;
+  uint32_t scale;
+
+  if (!parse_decimal(negative ? token + 1 : token, &whole, &fraction, &scale)) {
+    return false;
+  }
+  const float magnitude = (float)whole + (float)fraction / (float)scale;
+  *value = negative ? -magnitude : magnitude;
+  return true;
+}
+
+/**
+ * @brief Log the current GPS data.
+ */
+static void log_gps_data(void) {
+  const log_gps_t record = {
+      .latitude = gps_data.latitude,
+      .longitude = gps_data.longitude,
+      .altitude_m = gps_data.altitude_m,
+      .geoid_sep_m = gps_data.geoid_sep_m,
+      .speed_knots = gps_data.speed_knots,
+      .course_deg = gps_data.course_deg,
+      .hdop = gps_data.hdop,
+      .position_fix = (uint8_t)gps_data.position_fix,
+      .satellites = gps_data.satellites,
+  };
+  logger_write(LOG_RECORD_GPS, &record, sizeof(record));
+}
+
 /**
  * @brief Given the three NMEA fix‐flags (status, quality, pos_mode), determine
  *        which of the 10 possible nmea_position_fix_t types.
@@ -113,10 +239,13 @@ nmea_position_fix_t classify_position_fix(const nmea_fix_flags_t *flags) {
  * @return Converted decimal degrees measurement.
  */
 float to_decimal_deg(const char *coordinate, const char direction) {
-  // Parse the degrees and minutes.
-  float value = strtof(coordinate, NULL);
-  int degrees = (int)(value / 100);
-  float minutes = value - (float)(degrees * 100);
+  // Parse the degrees and minutes (integer, minutes exact to 7 decimals).
+  uint32_t whole;
+  uint32_t fraction;
+  uint32_t scale;
+  parse_decimal(coordinate, &whole, &fraction, &scale);
+  const uint32_t degrees = whole / 100;
+  const float minutes = (float)(whole % 100) + (float)fraction / (float)scale;
 
   // Convert to decimal degrees.
   float decimal_degrees = (float)degrees + (minutes / 60.0f);
@@ -251,6 +380,7 @@ static int nmea_split_preserve_empty(char *sentence, char *tokens[],
 /** @brief Parse GNGGA fields.
  *
  * @param sentence Pointer to a null-terminated NMEA sentence string.
+ * @param data GPS data to update.
  *
  * @return bool
  * @retval == true -> All values seem valid.
@@ -277,7 +407,7 @@ static int nmea_split_preserve_empty(char *sentence, char *tokens[],
  * tokens[15] = checksum      (hexadecimal string with leading '*').
  * tokens[16] = CRLF          (character).
  */
-static bool parse_gngga(const char *sentence) {
+static bool parse_gngga(const char *sentence, ublox_data_t *data) {
   // 1) Copy into a local buffer for strtok_r.
   char buf[UBLOX_RX_BUFFER_SIZE];
   size_t len = strnlen(sentence, sizeof(buf) - 1);
@@ -307,55 +437,41 @@ static bool parse_gngga(const char *sentence) {
   char *endptr = NULL;
 
   // 4) Time "hhmmss.ss".
-  //    Convert to hh/mm/ss integers. Ignore fractional seconds.
-  float utc_raw = strtof(tokens[1], NULL); // Convert "hhmmss.ss".
-  uint8_t hh = (uint8_t)(utc_raw / 10000.0f);
-  uint8_t mm = (uint8_t)((utc_raw - ((float)hh * 10000.0f)) / 100.0f);
-  uint8_t ss =
-      (uint8_t)(utc_raw - ((float)hh * 10000.0f) - ((float)mm * 100.0f));
-  gps_data.hour = hh;
-  gps_data.minute = mm;
-  gps_data.second = ss;
+  parse_utc_time(tokens[1], data);
 
   // 5) Latitude.
   //    tokens[2] = ddmm.mmmmm (string).
   //    tokens[3] = 'N' or 'S'.
-  gps_data.latitude = to_decimal_deg(tokens[2], tokens[3][0]);
-  gps_data.lat_dir = tokens[3][0];
+  data->latitude = to_decimal_deg(tokens[2], tokens[3][0]);
+  data->lat_dir = tokens[3][0];
 
   // 6) Longitude.
   //    tokens[4] = dddmm.mmmmm (string).
   //    tokens[5] = 'E' or 'W'.
-  gps_data.longitude = to_decimal_deg(tokens[4], tokens[5][0]);
-  gps_data.lon_dir = tokens[5][0];
+  data->longitude = to_decimal_deg(tokens[4], tokens[5][0]);
+  data->lon_dir = tokens[5][0];
 
   // 7) Fix quality.
-  gps_data.position_flags.quality = (unsigned)strtoul(tokens[6], &endptr, 10);
+  data->position_flags.quality = (unsigned)strtoul(tokens[6], &endptr, 10);
   if (endptr == tokens[6])
     return false;
 
   // 8) Number of satellites.
-  gps_data.satellites = (unsigned)strtoul(tokens[7], &endptr, 10);
+  data->satellites = (unsigned)strtoul(tokens[7], &endptr, 10);
   if (endptr == tokens[7])
     return false;
 
   // 9) Horizontal Dilution of Precision (HDOP).
-  gps_data.hdop = strtof(tokens[8], &endptr);
+  parse_float(tokens[8], &data->hdop);
 
   // 10) Altitude (m).
-  gps_data.altitude_m = strtof(tokens[9], &endptr);
+  parse_float(tokens[9], &data->altitude_m);
 
   // 11) Geoid separation (m).
-  gps_data.geoid_sep_m = strtof(tokens[11], &endptr);
+  parse_float(tokens[11], &data->geoid_sep_m);
 
   // 12) Update position fix classification.
-  gps_data.position_fix = classify_position_fix(&gps_data.position_flags);
-
-#ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-  can_tx_gps1();
-  can_tx_gps2();
-  can_tx_gps3();
-#endif
+  data->position_fix = classify_position_fix(&data->position_flags);
 
   return true;
 }
@@ -364,6 +480,7 @@ static bool parse_gngga(const char *sentence) {
  * @brief Parse GNRMC fields.
  *
  * @param sentence Pointer to a null-terminated NMEA sentence string.
+ * @param data GPS data to update.
  *
  * @return == true -> All values seem valid.
  * @return == false -> At least 1 value seems invalid.
@@ -388,7 +505,7 @@ static bool parse_gngga(const char *sentence) {
  * tokens[14] = checksum      (hexadecimal string with leading '*').
  * tokens[15] = CRLF          (character).
  */
-static bool parse_gnrmc(const char *sentence) {
+static bool parse_gnrmc(const char *sentence, ublox_data_t *data) {
   // 1) Copy into a local buffer for strtok_r.
   char buf[UBLOX_RX_BUFFER_SIZE];
   size_t len = strnlen(sentence, sizeof(buf) - 1);
@@ -419,19 +536,11 @@ static bool parse_gnrmc(const char *sentence) {
   char *endptr = NULL;
 
   // 4) Time "hhmmss.ss".
-  //    Convert to hh/mm/ss integers. Ignore fractional seconds.
-  float utc_raw = strtof(tokens[1], NULL); // Convert "hhmmss.ss".
-  uint8_t hh = (uint8_t)(utc_raw / 10000.0f);
-  uint8_t mm = (uint8_t)((utc_raw - ((float)hh * 10000.0f)) / 100.0f);
-  uint8_t ss =
-      (uint8_t)(utc_raw - ((float)hh * 10000.0f) - ((float)mm * 100.0f));
-  gps_data.hour = hh;
-  gps_data.minute = mm;
-  gps_data.second = ss;
+  parse_utc_time(tokens[1], data);
 
   // 5) Status.
   char status = tokens[2][0];
-  gps_data.position_flags.status = status;
+  data->position_flags.status = status;
   if (status != 'A' && status != 'V') {
     return false;
   }
@@ -439,27 +548,22 @@ static bool parse_gnrmc(const char *sentence) {
   // 6) Latitude.
   //    tokens[3] = ddmm.mmmmm (string).
   //    tokens[4] = 'N' or 'S'.
-  gps_data.latitude = to_decimal_deg(tokens[3], tokens[4][0]);
-  gps_data.lat_dir = tokens[4][0];
+  data->latitude = to_decimal_deg(tokens[3], tokens[4][0]);
+  data->lat_dir = tokens[4][0];
 
   // 7) Longitude.
   //    tokens[5] = dddmm.mmmmm (string).
   //    tokens[6] = 'E' or 'W'.
-  gps_data.longitude = to_decimal_deg(tokens[5], tokens[6][0]);
-  gps_data.lon_dir = tokens[6][0];
+  data->longitude = to_decimal_deg(tokens[5], tokens[6][0]);
+  data->lon_dir = tokens[6][0];
 
   // 8) Speed over ground (knots).
-  float speed_kn = strtof(tokens[7], &endptr);
-  if (endptr == tokens[7]) {
+  if (!parse_float(tokens[7], &data->speed_knots)) {
     return false;
   }
-  gps_data.speed_knots = speed_kn;
 
-  // 9) Course over ground (degrees).
-  float course_deg = strtof(tokens[8], &endptr);
-  if (endptr != tokens[8]) {
-    gps_data.course_deg = course_deg;
-  }
+  // 9) Course over ground (degrees), empty when not moving.
+  parse_float(tokens[8], &data->course_deg);
 
   // 10) Date "ddmmyy".
   int date_raw = (int)strtol(tokens[9], &endptr, 10);
@@ -469,51 +573,27 @@ static bool parse_gnrmc(const char *sentence) {
   uint8_t day = (uint8_t)(date_raw / 10000);
   uint8_t month = (uint8_t)((date_raw - (day * 10000)) / 100);
   uint8_t year = (uint8_t)(date_raw - (day * 10000) - (month * 100));
-  gps_data.day = day;
-  gps_data.month = month;
-  gps_data.year = year; // 2 digit year ("00" = 2000, "23" = 2023, etc).
+  data->day = day;
+  data->month = month;
+  data->year = year; // 2 digit year ("00" = 2000, "23" = 2023, etc).
 
   // 11) Position mode indicator (optional-only NMEA 2.3+).
   if (tokens[12]) {
-    gps_data.position_flags.pos_mode = tokens[12][0];
+    data->position_flags.pos_mode = tokens[12][0];
   }
 
   // 12) Navigation status (optional-only NMEA 4.10+).
   // TODO: Skipped implementation.
   //  if (tokens[13]) {
-  //    gps_data.nav_status = tokens[13][0];
+  //    data->nav_status = tokens[13][0];
   //  }
 
   // 13) Update position fix classification.
-  gps_data.position_fix = classify_position_fix(&gps_data.position_flags);
-
-#ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
-  can_tx_gps1();
-  can_tx_gps2();
-  can_tx_gps3();
-#endif
+  data->position_fix = classify_position_fix(&data->position_flags);
 
   return true;
 }
 
-/**
- * @brief Top‑level sentence dispatcher.
- *
- * @param sentence NMEA sentence to process.
- */
-static void parse_nmea_sentence(const char *sentence) {
-  if (strncmp(sentence, "$GNGGA", 6) == 0) { // Handle GNGGA sentence.
-    if (!validate_nmea_checksum(sentence) || !parse_gngga(sentence)) {
-      ublox_error_handler();
-    }
-  } else if (strncmp(sentence, "$GNRMC", 6) == 0) { // Handle GNRMC sentence.
-    if (!validate_nmea_checksum(sentence) || !parse_gnrmc(sentence)) {
-      ublox_error_handler();
-    }
-  }
-  // Ignore other sentence types.
-}
-
 /**
  * @brief Process u-blox UART NEMA sentence byte.
  *
@@ -525,6 +605,11 @@ static void ublox_process_byte(uint8_t byte, size_t parse_index) {
     if (!ublox_in_sentence && byte == '$') { // Start of new sentence.
       ublox_in_sentence = true;
       sentence_start_index = parse_index;
+      // The '$' and the bytes after it, then one idle frame (10 bit UART).
+      sentence_timed = rx_timed;
+      sentence_start_us =
+          rx_idle_us - (uint32_t)((uint64_t)(rx_remaining + 1) * 10 *
+                                  1000000 / UBLOX_HUART.Init.BaudRate);
       return;
     }
 
@@ -545,7 +630,7 @@ static void ublox_process_byte(uint8_t byte, size_t parse_index) {
       }
       sentence[len] = '\0'; // Null‑terminate.
 
-      parse_nmea_sentence(sentence); // Parse the extracted sentence.
+      ublox_parse_sentence(sentence); // Parse the extracted sentence.
 
       // Reset for next sentence.
       ublox_in_sentence = false;
@@ -573,17 +658,66 @@ void USART2_IRQHandler_ublox(UART_HandleTypeDef *huart) {
     // Check how many bytes have been written by DMA since last time.
     uint16_t pos = UBLOX_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(huart->hdmarx);
 
+    // Time the bytes from the line going idle after the last one.
+    rx_idle_us = systime_us32();
+    rx_remaining =
+        (pos - ublox_rx_index + UBLOX_RX_BUFFER_SIZE) % UBLOX_RX_BUFFER_SIZE;
+    rx_timed = true;
+
     // Process every new byte in order.
     while (ublox_rx_index != pos) {
       uint8_t b = ublox_rx_dma_buffer[ublox_rx_index];
       ublox_process_byte(b, ublox_rx_index);
       ublox_rx_index = (ublox_rx_index + 1) % UBLOX_RX_BUFFER_SIZE;
+      rx_remaining--;
     }
+    rx_timed = false;
   }
 }
 
 /** Public functions. *********************************************************/
 
+ublox_sentence_t ublox_parse_nmea(const char *sentence, ublox_data_t *data) {
+  if (strncmp(sentence, "$GNGGA", 6) == 0) { // Handle GNGGA sentence.
+    if (!validate_nmea_checksum(sentence) || !parse_gngga(sentence, data)) {
+      return UBLOX_SENTENCE_INVALID;
+    }
+    return UBLOX_SENTENCE_GGA;
+  }
+  if (strncmp(sentence, "$GNRMC", 6) == 0) { // Handle GNRMC sentence.
+    if (!validate_nmea_checksum(sentence) || !parse_gnrmc(sentence, data)) {
+      return UBLOX_SENTENCE_INVALID;
+    }
+    return UBLOX_SENTENCE_RMC;
+  }
+  return UBLOX_SENTENCE_IGNORED; // Ignore other sentence types.
+}
+
+void ublox_parse_sentence(const char *sentence) {
+  const ublox_sentence_t parsed = ublox_parse_nmea(sentence, &gps_data);
+
+  if (parsed == UBLOX_SENTENCE_INVALID) {
+    ublox_error_handler();
+    return;
+  }
+  if (parsed == UBLOX_SENTENCE_IGNORED) {
+    return;
+  }
+  log_gps_data();
+
+  // GNSS time sync point (valid fix, sentence start timed).
+  if (parsed == UBLOX_SENTENCE_RMC && gps_data.position_flags.status == 'A' &&
+      sentence_timed) {
+    gnss_time_nmea(&gps_data, sentence_start_us);
+  }
+
+#ifdef NERVE_DEBUG_FULL_CAN_TELEMETRY
+  can_tx_telemetry(DBC_MESSAGE_GPS1);
+  can_tx_telemetry(DBC_MESSAGE_GPS2);
+  can_tx_telemetry(DBC_MESSAGE_GPS3);
+#endif
+}
+
 void ublox_init(void) {
   // Ensure the u-blox module is not in reset state.
   HAL_GPIO_WritePin(UBLOX_RESETN_PORT, UBLOX_RESETN_PIN, GPIO_PIN_SET);
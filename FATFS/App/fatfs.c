@@ -34,6 +34,9 @@ void MX_FATFS_Init(void)
 
   /* USER CODE BEGIN Init */
   /* additional user code for init */
+  /* SD_Driver wrapped with write-behind (sd_diskio.c last section) */
+  FATFS_UnLinkDriver(SDPath);
+  retSD = FATFS_LinkDriver(&SD_AppDriver, SDPath);
   /* USER CODE END Init */
 }
 
@@ -253,6 +253,16 @@ void HAL_SD_RxCpltCallback(SD_HandleTypeDef *hsd)
 }
 
 /* USER CODE BEGIN CallBacksSection_C */
+/**
+  * @brief Error callback (DMA or SDIO transfer error)
+  * @param hsd: SD handle
+  * @retval None
+  */
+void HAL_SD_ErrorCallback(SD_HandleTypeDef *hsd)
+{
+  BSP_SD_ErrorCallback();
+}
+
 /**
   * @brief BSP SD Abort callback
   * @retval None
@@ -281,6 +291,16 @@ __weak void BSP_SD_WriteCpltCallback(void)
 __weak void BSP_SD_ReadCpltCallback(void)
 {
 
+}
+
+/**
+  * @brief BSP transfer error callback
+  * @retval None
+  * @note empty (up to the user to fill it in or to remove it if useless)
+  */
+__weak void BSP_SD_ErrorCallback(void)
+{
+
 }
 /* USER CODE END CallBacksSection_C */
 #endif
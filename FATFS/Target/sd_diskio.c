@@ -22,6 +22,7 @@
 
 /* USER CODE BEGIN firstSection */
 /* can be used to modify / undefine following code or add new definitions */
+#include <stddef.h>
 /* USER CODE END firstSection*/
 
 /* Includes ------------------------------------------------------------------*/
@@ -49,7 +50,8 @@
  * BSP_SD_Init() elsewhere in the application.
  */
 /* USER CODE BEGIN disableSDInit */
-/* #define DISABLE_SD_INIT */
+/* Initialized (4-bit bus) by sdio_init_sd(), the storage manager */
+#define DISABLE_SD_INIT
 /* USER CODE END disableSDInit */
 
 /*
@@ -68,7 +70,12 @@
 * transfer data
 */
 /* USER CODE BEGIN enableScratchBuffer */
-/* #define ENABLE_SCRATCH_BUFFER */
+/*
+ * Enabled: the SDIO DMA streams use word transfers, an unaligned buffer would
+ * be silently shifted. The scratch path costs one command per sector and a
+ * copy, the sectors taking it are counted (SD_GetScratchCount()).
+ */
+#define ENABLE_SCRATCH_BUFFER
 /* USER CODE END enableScratchBuffer */
 
 /* Private variables ---------------------------------------------------------*/
@@ -111,6 +118,74 @@ const Diskio_drvTypeDef  SD_Driver =
 
 /* USER CODE BEGIN beforeFunctionSection */
 /* can be used to modify / undefine following code or add new code */
+
+/*
+ * Lowered to 1 sec (write busy is at most 500 ms), a failing card is released
+ * by the storage manager instead of stalling the caller
+ */
+#undef SD_TIMEOUT
+#define SD_TIMEOUT 1 * 1000
+
+/*
+ * Write-behind: SD_AppWrite() returns as soon as the DMA is started for
+ * buffers inside the region set by SD_SetWriteBehindRegion() (the caller keeps
+ * them untouched until SD_WriteBehindStatus() reports completion). Completion
+ * is signalled by BSP_SD_WriteCpltCallback(), any other disk access waits for
+ * it. The generated functions below are left unchanged, SD_AppDriver (last
+ * section) wraps them and is linked instead of SD_Driver (MX_FATFS_Init()).
+ */
+static const BYTE *WriteBehindStart = NULL;
+static UINT WriteBehindSize = 0;
+static volatile uint8_t WriteBehindPending = 0;
+static volatile uint8_t TransferError = 0;
+static uint8_t WriteBehindFailed = 0;
+static uint32_t WriteBehindTick = 0;
+
+/* Sectors copied through the scratch buffer (unaligned buffers) */
+static UINT ScratchReads = 0;
+static UINT ScratchWrites = 0;
+
+/* FatFs sector buffers (FATFS and FIL structs are word aligned) never take the
+   scratch path */
+_Static_assert(offsetof(FATFS, win) % 4 == 0, "FATFS win[] not word aligned");
+#if !_FS_TINY
+_Static_assert(offsetof(FIL, buf) % 4 == 0, "FIL buf[] not word aligned");
+#endif
+
+/**
+  * @brief  Checks the write-behind transfer, completed once the DMA is done
+  *         (callback) and the card finished programming
+  * @retval 1 if in progress, 0 otherwise (a failure is latched)
+  */
+static uint8_t SD_WriteBehindBusy(void)
+{
+  if (WriteBehindPending)
+  {
+    if (TransferError || ((HAL_GetTick() - WriteBehindTick) >= SD_TIMEOUT) ||
+        (BSP_SD_IsDetected() != SD_PRESENT))
+    {
+      WriteBehindFailed = 1;
+    }
+    else if ((WriteStatus == 0) || (BSP_SD_GetCardState() != SD_TRANSFER_OK))
+    {
+      return 1;
+    }
+    WriteBehindPending = 0;
+    WriteStatus = 0;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Blocks until the write-behind transfer completed (other accesses)
+  * @retval None
+  */
+static void SD_WaitWriteBehind(void)
+{
+  while (SD_WriteBehindBusy())
+  {
+  }
+}
 /* USER CODE END beforeFunctionSection */
 
 /* Private functions ---------------------------------------------------------*/
@@ -507,13 +582,203 @@ void BSP_SD_ReadCpltCallback(void)
 void BSP_SD_AbortCallback(void)
 {
 }
+*/
 
+/**
+  * @brief Transfer error callback (fails the write-behind transfer)
+  * @retval None
+  */
 void BSP_SD_ErrorCallback(void)
 {
+  TransferError = 1;
 }
-*/
 /* USER CODE END ErrorAbortCallbacks */
 
 /* USER CODE BEGIN lastSection */
 /* can be used to modify / undefine previous code or add new code */
+
+/**
+  * @brief  Reads Sector(s), after the write-behind transfer
+  * @param  lun : not used
+  * @param  *buff: Data buffer to store read data
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to read (1..128)
+  * @retval DRESULT: Operation result
+  */
+static DRESULT SD_AppRead(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+  /* Card removed, fail now instead of waiting for the timeout */
+  if (BSP_SD_IsDetected() != SD_PRESENT)
+  {
+    return RES_ERROR;
+  }
+  SD_WaitWriteBehind();
+
+#if defined(ENABLE_SCRATCH_BUFFER)
+  if ((size_t)buff & 0x3)
+  {
+    ScratchReads += count;
+  }
+#endif
+  return SD_read(lun, buff, sector, count);
+}
+
+#if _USE_WRITE == 1
+/**
+  * @brief  Writes Sector(s), returning once the DMA is started for buffers
+  *         inside the write-behind region
+  * @param  lun : not used
+  * @param  *buff: Data to be written
+  * @param  sector: Sector address (LBA)
+  * @param  count: Number of sectors to write (1..128)
+  * @retval DRESULT: Operation result
+  */
+static DRESULT SD_AppWrite(BYTE lun, const BYTE *buff, DWORD sector,
+                           UINT count)
+{
+  DRESULT res = RES_OK;
+  UINT i;
+
+  /* Card removed, fail now instead of waiting for the timeout */
+  if (BSP_SD_IsDetected() != SD_PRESENT)
+  {
+    return RES_ERROR;
+  }
+  SD_WaitWriteBehind();
+
+#if defined(ENABLE_SCRATCH_BUFFER)
+  if ((size_t)buff & 0x3)
+  {
+    /* One sector per call, SD_write() waits for the card to finish
+       programming the previous one before the next command */
+    for (i = 0; (i < count) && (res == RES_OK); i++)
+    {
+      ScratchWrites++;
+      res = SD_write(lun, buff + i * BLOCKSIZE, sector + i, 1);
+    }
+    return res;
+  }
+#endif
+
+  if ((buff < WriteBehindStart) ||
+      (buff + count * BLOCKSIZE > WriteBehindStart + WriteBehindSize))
+  {
+    return SD_write(lun, buff, sector, count);
+  }
+
+  WriteStatus = 0;
+  TransferError = 0;
+  if ((SD_CheckStatusWithTimeout(SD_TIMEOUT) < 0) ||
+      (BSP_SD_WriteBlocks_DMA((uint32_t*)buff, (uint32_t)sector,
+                              count) != MSD_OK))
+  {
+    return RES_ERROR;
+  }
+
+  /* Completed in SD_WriteBehindBusy(), the caller owns the buffer */
+  WriteBehindTick = HAL_GetTick();
+  WriteBehindPending = 1;
+  return res;
+}
+#endif /* _USE_WRITE == 1 */
+
+#if _USE_IOCTL == 1
+/**
+  * @brief  I/O control operation, CTRL_SYNC waits for the write-behind
+  *         transfer
+  * @param  lun : not used
+  * @param  cmd: Control code
+  * @param  *buff: Buffer to send/receive control data
+  * @retval DRESULT: Operation result
+  */
+static DRESULT SD_AppIoctl(BYTE lun, BYTE cmd, void *buff)
+{
+  if (cmd == CTRL_SYNC)
+  {
+    SD_WaitWriteBehind();
+  }
+  return SD_ioctl(lun, cmd, buff);
+}
+#endif /* _USE_IOCTL == 1 */
+
+/* SD_Driver with write-behind, removed card detection and scratch counting */
+const Diskio_drvTypeDef SD_AppDriver =
+{
+  SD_initialize,
+  SD_status,
+  SD_AppRead,
+#if  _USE_WRITE == 1
+  SD_AppWrite,
+#endif /* _USE_WRITE == 1 */
+
+#if  _USE_IOCTL == 1
+  SD_AppIoctl,
+#endif /* _USE_IOCTL == 1 */
+};
+
+/**
+  * @brief  Sets the buffer region written behind (SD_AppWrite() returns once
+  *         the DMA is started)
+  * @param  start: Region start, NULL to disable write-behind
+  * @param  size: Region size (bytes)
+  * @retval None
+  */
+void SD_SetWriteBehindRegion(const void *start, UINT size)
+{
+  WriteBehindStart = (const BYTE *)start;
+  WriteBehindSize = (start != NULL) ? size : 0;
+}
+
+/**
+  * @brief  Drops the write-behind transfer without waiting for it (card
+  *         removed or failing, the SDIO is de-initialized by the caller)
+  * @retval None
+  */
+void SD_AbortWriteBehind(void)
+{
+  WriteBehindPending = 0;
+  WriteBehindFailed = 0;
+  TransferError = 0;
+  WriteStatus = 0;
+  ReadStatus = 0;
+  Stat = STA_NOINIT;
+}
+
+/**
+  * @brief  Gets the write-behind transfer status, without blocking
+  * @retval DRESULT: RES_OK if none pending (buffer free), RES_NOTRDY if in
+  *         progress, RES_ERROR if it failed or timed out (cleared on read)
+  */
+DRESULT SD_WriteBehindStatus(void)
+{
+  if (SD_WriteBehindBusy())
+  {
+    return RES_NOTRDY;
+  }
+  if (WriteBehindFailed)
+  {
+    WriteBehindFailed = 0;
+    return RES_ERROR;
+  }
+  return RES_OK;
+}
+
+/**
+  * @brief  Gets the number of sectors copied through the scratch buffer
+  *         (unaligned buffers, one DMA transfer per sector)
+  * @param  reads: Sectors read, NULL if not needed
+  * @param  writes: Sectors written, NULL if not needed
+  * @retval None
+  */
+void SD_GetScratchCount(UINT *reads, UINT *writes)
+{
+  if (reads != NULL)
+  {
+    *reads = ScratchReads;
+  }
+  if (writes != NULL)
+  {
+    *writes = ScratchWrites;
+  }
+}
 /* USER CODE END lastSection */
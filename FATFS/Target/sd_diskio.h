@@ -36,6 +36,12 @@ extern const Diskio_drvTypeDef  SD_Driver;
 
 /* USER CODE BEGIN lastSection */
 /* can be used to modify / undefine previous code or add new definitions */
+extern const Diskio_drvTypeDef  SD_AppDriver;
+
+void SD_SetWriteBehindRegion(const void *start, UINT size);
+void SD_AbortWriteBehind(void);
+DRESULT SD_WriteBehindStatus(void);
+void SD_GetScratchCount(UINT *reads, UINT *writes);
 /* USER CODE END lastSection */
 
 #endif /* __SD_DISKIO_H */
@@ -3,6 +3,17 @@
 Parse a DBC file and auto-generates a header file with static definitions of CAN
 bus messages and their signals (based on C based type definitions).
 
+Also plans the bxCAN hardware acceptance filter banks for all messages received
+by this node and reports the plan coverage and false-accept rate.
+
+Reads the GenMsgCycleTime, GenMsgSendType, GenMsgDelayTime (minimum on-change
+interval) and GenMsgStartDelayTime (phase offset) message attributes. Phase
+offsets not set in the DBC are planned to spread periodic bus load. The
+NerveRedundant attribute selects messages mirrored on both CAN buses.
+
+Supports signed, IEEE float (SIG_VALTYPE_) and multiplexed (M/m<value>) signals
+and value tables (VAL_).
+
 Follows clang-format style with 2-space indents.
 
 Usage:
@@ -18,6 +29,8 @@ Usage:
 import re
 import sys
 import argparse
+from functools import reduce
+from math import gcd
 
 
 def parse_dbc(filename: str):
@@ -30,13 +43,13 @@ def parse_dbc(filename: str):
     bo_pattern = re.compile(r"^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\S+)")
 
     # Regex to match a signal (SG_ line):
-    # Format: SG_ <signal_name> : <start_bit>|<bit_length>@<byte_order><sign> (<scale>,<offset>) [<min>|<max>] "<unit>" <receiver>
+    # Format: SG_ <signal_name> [M|m<value>] : <start_bit>|<bit_length>@<byte_order><sign> (<scale>,<offset>) [<min>|<max>] "<unit>" <receiver>
 
     number = r"[-+]?(?:\d*\.\d+|\d+)(?:[eE][-+]?\d+)?"
     # Account for numbers with "e" for scientific notation.
 
     sg_pattern = re.compile(
-        rf"^\s*SG_\s+(\w+)\s*:\s*"
+        rf"^\s*SG_\s+(\w+)\s*(M|m\d+M?)?\s*:\s*"
         rf"(\d+)\|(\d+)@(\d)([+-])\s*"
         rf"\(\s*({number})\s*,\s*({number})\s*\)\s*"
         rf"\[\s*({number})\s*\|\s*({number})\s*\]\s*"
@@ -72,9 +85,10 @@ def parse_dbc(filename: str):
                 m = sg_pattern.match(line)
                 if m:
                     signal_name = m.group(1)
-                    start_bit = int(m.group(2))
-                    bit_length = int(m.group(3))
-                    dbc_byte_order = int(m.group(4))
+                    mux = m.group(2)
+                    start_bit = int(m.group(3))
+                    bit_length = int(m.group(4))
+                    dbc_byte_order = int(m.group(5))
                     # DBC: 1 = Intel (little-endian), 0 = Motorola (big-endian).
 
                     # Map DBC byte order to C based enum:
@@ -86,24 +100,42 @@ def parse_dbc(filename: str):
                     else:
                         byte_order = "CAN_BIG_ENDIAN"
 
-                    # The group 5 (sign) is typically '+', assume '+'.
-                    scale = float(m.group(6))
-                    offset = float(m.group(7))
-                    min_value = float(m.group(8))
-                    max_value = float(m.group(9))
-                    unit = m.group(10)  # Can be an empty string.
-                    receiver = m.group(11)
+                    # Multiplexer switch (M) or multiplexed signal (m<value>).
+                    if mux is None:
+                        mux_type, mux_value = "CAN_MUX_NONE", 0
+                    elif mux == "M":
+                        mux_type, mux_value = "CAN_MUX_SWITCH", 0
+                    elif mux.endswith("M"):
+                        fail(f"Extended multiplexing unsupported: {line}")
+                    else:
+                        mux_type, mux_value = "CAN_MUX_MULTIPLEXED", int(
+                            mux[1:]
+                        )
+
+                    is_signed = 1 if m.group(6) == "-" else 0
+                    scale = float(m.group(7))
+                    offset = float(m.group(8))
+                    min_value = float(m.group(9))
+                    max_value = float(m.group(10))
+                    unit = m.group(11)  # Can be an empty string.
+                    receivers = m.group(12).split(",")
 
                     signal = {
                         "name": signal_name,
                         "start_bit": start_bit,
                         "bit_length": bit_length,
                         "byte_order": byte_order,
+                        "is_signed": is_signed,
+                        "value_type": "CAN_VALUE_INTEGER",
+                        "mux_type": mux_type,
+                        "mux_value": mux_value,
                         "scale": scale,
                         "offset": offset,
                         "min_value": min_value,
                         "max_value": max_value,
                         "unit": unit,
+                        "receivers": receivers,
+                        "values": [],
                     }
                     current_msg["signals"].append(signal)
                 else:
@@ -114,13 +146,467 @@ def parse_dbc(filename: str):
     return messages
 
 
-def generate_source(messages, output_filename: str):
+# Must match MAX_SIGNALS_PER_MESSAGE in can.h.
+MAX_SIGNALS_PER_MESSAGE = 16
+
+# DBC SIG_VALTYPE_ values mapped to the C can_value_type_t.
+VALUE_TYPES = {
+    0: "CAN_VALUE_INTEGER",
+    1: "CAN_VALUE_FLOAT32",
+    2: "CAN_VALUE_FLOAT64",
+}
+
+
+def fail(message: str):
+    """Print an error and exit."""
+    print(message, file=sys.stderr)
+    sys.exit(1)
+
+
+def parse_signal_extras(filename: str, messages):
+    """Parse SIG_VALTYPE_ (IEEE float) and VAL_ (value tables) lines."""
+    valtype_pattern = re.compile(
+        r"^SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:?\s*(\d+)\s*;"
+    )
+    val_pattern = re.compile(r"^VAL_\s+(\d+)\s+(\w+)\s+(.*);")
+    entry_pattern = re.compile(r'(-?\d+)\s+"([^"]*)"')
+
+    signals = {}
+    for msg in messages:
+        for sig in msg["signals"]:
+            signals[(msg["id"], sig["name"])] = sig
+
+    with open(filename, "r") as f:
+        for line in f:
+            line = line.strip()
+            m = valtype_pattern.match(line)
+            if m:
+                sig = signals.get((int(m.group(1)), m.group(2)))
+                if sig is not None:
+                    sig["value_type"] = VALUE_TYPES[int(m.group(3))]
+                continue
+            m = val_pattern.match(line)
+            if m:
+                sig = signals.get((int(m.group(1)), m.group(2)))
+                if sig is not None:
+                    sig["values"] = sorted(
+                        (int(value), description)
+                        for value, description in entry_pattern.findall(
+                            m.group(3)
+                        )
+                    )
+
+
+def validate_messages(messages, node: str):
+    """Check messages against the limits of the C implementation."""
+    for msg in messages:
+        signals = msg["signals"]
+        if len(signals) > MAX_SIGNALS_PER_MESSAGE:
+            fail(
+                f"{msg['name']} has {len(signals)} signals, "
+                f"MAX_SIGNALS_PER_MESSAGE is {MAX_SIGNALS_PER_MESSAGE}."
+            )
+        switches = [s for s in signals if s["mux_type"] == "CAN_MUX_SWITCH"]
+        multiplexed = [
+            s for s in signals if s["mux_type"] == "CAN_MUX_MULTIPLEXED"
+        ]
+        if len(switches) > 1 or (multiplexed and not switches):
+            fail(f"{msg['name']} needs exactly one multiplexer switch (M).")
+        for sig in signals:
+            value_type = sig["value_type"]
+            if value_type == "CAN_VALUE_FLOAT32" and sig["bit_length"] != 32:
+                fail(f"{sig['name']} IEEE float signal must be 32 bits.")
+            if value_type == "CAN_VALUE_FLOAT64" and sig["bit_length"] != 64:
+                fail(f"{sig['name']} IEEE double signal must be 64 bits.")
+            if (
+                sig["bit_length"] > 32
+                and msg["transmitter"] == node
+                and msg["send_type"] != "CAN_SEND_NONE"
+            ):
+                print(
+                    f"Warning: {sig['name']} is scheduled but over 32 bits, "
+                    "raw32 encoding is unsupported.",
+                    file=sys.stderr,
+                )
+
+
+def value_table_name(msg, sig) -> str:
+    """Name of the generated value table of a signal."""
+    return "value_table_{0}_{1}".format(msg["name"], sig["name"])
+
+
+# DBC GenMsgSendType enum labels mapped to the C can_send_type_t.
+SEND_TYPES = {
+    "Cyclic": "CAN_SEND_CYCLIC",
+    "OnChange": "CAN_SEND_ON_CHANGE",
+    "CyclicAndOnChange": "CAN_SEND_CYCLIC_AND_ON_CHANGE",
+    "NoMsgSendType": "CAN_SEND_NONE",
+}
+CYCLIC_SEND_TYPES = ("CAN_SEND_CYCLIC", "CAN_SEND_CYCLIC_AND_ON_CHANGE")
+
+# Message attribute name to message dict key.
+MESSAGE_ATTRIBUTES = {
+    "GenMsgCycleTime": "cycle_time",
+    "GenMsgSendType": "send_type",
+    "GenMsgDelayTime": "min_interval",
+    "GenMsgStartDelayTime": "start_delay",
+    "NerveRedundant": "redundant",
+}
+
+
+def parse_attribute_value(value: str, enum_labels):
+    """Convert a BA_ or BA_DEF_DEF_ value to an int or an enum label."""
+    value = value.strip()
+    if value.startswith('"'):
+        return value.strip('"')
+    number = int(float(value))
+    if enum_labels is not None:
+        return enum_labels[number]
+    return number
+
+
+def parse_attributes(filename: str, messages):
+    """Parse BA_DEF_, BA_DEF_DEF_ and BA_ message attributes into messages."""
+    ba_def_pattern = re.compile(r'^BA_DEF_\s+BO_\s+"(\w+)"\s+(\w+)\s*(.*);')
+    ba_def_def_pattern = re.compile(r'^BA_DEF_DEF_\s+"(\w+)"\s+(.+?)\s*;')
+    ba_pattern = re.compile(r'^BA_\s+"(\w+)"\s+BO_\s+(\d+)\s+(.+?)\s*;')
+
+    enums = {}  # Attribute name to enum labels (None for non-enum).
+    defaults = {"GenMsgSendType": "NoMsgSendType", "NerveRedundant": "No"}
+    values = {}  # (attribute name, message ID) to value.
+    with open(filename, "r") as f:
+        for line in f:
+            line = line.strip()
+            m = ba_def_pattern.match(line)
+            if m:
+                labels = None
+                if m.group(2) == "ENUM":
+                    labels = re.findall(r'"([^"]*)"', m.group(3))
+                enums[m.group(1)] = labels
+                continue
+            m = ba_def_def_pattern.match(line)
+            if m:
+                name = m.group(1)
+                defaults[name] = parse_attribute_value(m.group(2), None)
+                continue
+            m = ba_pattern.match(line)
+            if m:
+                name = m.group(1)
+                values[(name, int(m.group(2)))] = parse_attribute_value(
+                    m.group(3), enums.get(name)
+                )
+
+    for msg in messages:
+        for name, key in MESSAGE_ATTRIBUTES.items():
+            msg[key] = values.get((name, msg["id"]), defaults.get(name, 0))
+        msg["explicit_start_delay"] = (
+            "GenMsgStartDelayTime",
+            msg["id"],
+        ) in values
+        msg["redundant"] = 1 if msg["redundant"] == "Yes" else 0
+        label = msg["send_type"]
+        if label not in SEND_TYPES:
+            print(
+                f"Unknown GenMsgSendType {label} for {msg['name']}, "
+                "using NoMsgSendType.",
+                file=sys.stderr,
+            )
+            label = "NoMsgSendType"
+        msg["send_type"] = SEND_TYPES[label]
+
+
+def is_periodic(msg, node: str) -> bool:
+    """Check if a message is transmitted periodically by the given node."""
+    return (
+        msg["transmitter"] == node
+        and msg["send_type"] in CYCLIC_SEND_TYPES
+        and msg["cycle_time"] > 0
+    )
+
+
+def frame_bits(dlc: int) -> int:
+    """Worst case standard data frame length in bits including bit stuffing."""
+    stuffed = 34 + 8 * dlc  # SOF through CRC are subject to stuffing.
+    return stuffed + (stuffed - 1) // 4 + 13  # CRC delim, ACK, EOF, IFS.
+
+
+def plan_phases(messages, node: str, hyperperiod_limit: int):
+    """Plan 1 ms phase offsets for periodic messages to flatten bus load.
+
+    Messages are placed tightest period first, each at the offset minimizing
+    the peak frames per 1 ms slot over the hyperperiod (least common multiple
+    of all periods, capped at hyperperiod_limit).
+    """
+    periodic = [msg for msg in messages if is_periodic(msg, node)]
+    if not periodic:
+        return []
+    hyperperiod = reduce(
+        lambda a, b: a * b // gcd(a, b), [m["cycle_time"] for m in periodic]
+    )
+    hyperperiod = min(hyperperiod, hyperperiod_limit)
+    load = [0] * hyperperiod
+
+    def slots(offset, period):
+        return range(offset % hyperperiod, hyperperiod, period)
+
+    # Explicit DBC start delays are fixed, plan the remainder around them.
+    for msg in periodic:
+        if msg["explicit_start_delay"]:
+            for slot in slots(msg["start_delay"], msg["cycle_time"]):
+                load[slot] += 1
+    planned = [msg for msg in periodic if not msg["explicit_start_delay"]]
+    for msg in sorted(planned, key=lambda m: (m["cycle_time"], m["id"])):
+        period = msg["cycle_time"]
+        best = min(
+            range(min(period, hyperperiod)),
+            key=lambda offset: (
+                max(load[slot] for slot in slots(offset, period)),
+                sum(load[slot] for slot in slots(offset, period)),
+                offset,
+            ),
+        )
+        msg["start_delay"] = best
+        for slot in slots(best, period):
+            load[slot] += 1
+    return load
+
+
+def report_schedule(messages, node: str, load, bitrate):
+    """Print the periodic TX schedule and estimated bus load."""
+    periodic = [msg for msg in messages if is_periodic(msg, node)]
+    bits_per_s = sum(
+        frame_bits(msg["dlc"]) * 1000 / msg["cycle_time"] for msg in periodic
+    )
+    print(f"CAN TX schedule ({len(periodic)} periodic messages):")
+    for msg in sorted(periodic, key=lambda m: (m["start_delay"], m["id"])):
+        print(
+            f"  0x{msg['id']:03X} {msg['name']}: {msg['cycle_time']} ms, "
+            f"phase {msg['start_delay']} ms."
+        )
+    print(f"CAN TX peak frames per 1 ms slot: {max(load, default=0)}.")
+    print(
+        f"CAN TX periodic bus load: {bits_per_s / bitrate * 100:.1f} % "
+        f"at {bitrate} bit/s (worst case bit stuffing)."
+    )
+
+
+def is_rx_message(msg, node: str) -> bool:
+    """Check if a message is received (not transmitted) by the given node."""
+    if msg["transmitter"] == node:
+        return False
+    return any(node in sig["receivers"] for sig in msg["signals"])
+
+
+def rx_handler_name(msg) -> str:
+    """Name of the generated receive handler for a message."""
+    return "can_rx_{0}".format(msg["name"])
+
+
+# bxCAN 16-bit filter layout: STID[10:0] << 5 | RTR << 4 | IDE << 3 | EXID.
+# RTR and IDE are always masked in so only standard ID data frames match.
+STD_ID_BITS = 11
+STD_ID_SPACE = 1 << STD_ID_BITS
+STD_ID_FULL_MASK = STD_ID_SPACE - 1
+FILTER_RTR_IDE_MASK = 0x18
+
+
+def filter_word(value: int) -> int:
+    """Convert a standard 11-bit ID (or mask) to a 16-bit filter word."""
+    return (value & STD_ID_FULL_MASK) << 5
+
+
+def entry_size(entry) -> int:
+    """Number of standard IDs accepted by an (ID, mask) filter entry."""
+    _, mask = entry
+    return 1 << (STD_ID_BITS - bin(mask & STD_ID_FULL_MASK).count("1"))
+
+
+def merge_entries(a, b):
+    """Smallest single (ID, mask) filter entry accepting both entries."""
+    mask = a[1] & b[1] & ~(a[0] ^ b[0]) & STD_ID_FULL_MASK
+    return a[0] & mask, mask
+
+
+def pack_entries(entries):
+    """Split entries into ID list and ID mask banks using the fewest banks.
+
+    Exact IDs are packed 4 per list bank and masked entries 2 per mask bank.
+    Left over exact IDs may instead fill mask bank slots as full-mask pairs.
+
+    Returns:
+        Tuple of (list mode IDs, mask mode (ID, mask) pairs).
+    """
+    exact = sorted(e[0] for e in entries if e[1] == STD_ID_FULL_MASK)
+    masked = sorted(e for e in entries if e[1] != STD_ID_FULL_MASK)
+
+    best_k = 0
+    best_banks = None
+    for k in range(len(exact) + 1):  # k exact IDs moved into mask slots.
+        banks = (len(exact) - k + 3) // 4 + (len(masked) + k + 1) // 2
+        if best_banks is None or banks < best_banks:
+            best_k, best_banks = k, banks
+
+    list_ids = exact[: len(exact) - best_k]
+    mask_pairs = masked + [
+        (x, STD_ID_FULL_MASK) for x in exact[len(list_ids) :]
+    ]
+    return list_ids, sorted(mask_pairs)
+
+
+def banks_required(entries) -> int:
+    """16-bit banks needed to hold all (ID, mask) filter entries."""
+    list_ids, mask_pairs = pack_entries(entries)
+    return (len(list_ids) + 3) // 4 + (len(mask_pairs) + 1) // 2
+
+
+def plan_filters(messages, node: str, bank_budget: int):
+    """Plan bxCAN 16-bit filter banks for all messages received by the node.
+
+    Exact IDs are packed 4 per bank in ID list mode (see pack_entries). If the
+    bank budget is exceeded, the pair of entries whose merge accepts the fewest
+    IDs is merged into an ID mask entry (2 per bank) until the plan fits. Banks
+    are ordered by their lowest (highest priority) ID, the first half assigned
+    to FIFO0 and the rest to FIFO1 so low priority traffic cannot overrun high
+    priority frames.
+    """
+    entries = []
+    for msg in messages:
+        if is_rx_message(msg, node):
+            entry = (msg["id"] & STD_ID_FULL_MASK, STD_ID_FULL_MASK)
+            if entry not in entries:
+                entries.append(entry)
+
+    while banks_required(entries) > bank_budget and len(entries) > 1:
+        best = None
+        for i in range(len(entries)):
+            for j in range(i + 1, len(entries)):
+                merged = merge_entries(entries[i], entries[j])
+                cost = (entry_size(merged), merged[0])
+                if best is None or cost < best[0]:
+                    best = (cost, i, j, merged)
+        _, i, j, merged = best
+        entries = [e for k, e in enumerate(entries) if k not in (i, j)]
+        # Drop any entries now fully covered by the merged entry.
+        entries = [e for e in entries if merge_entries(e, merged) != merged]
+        entries.append(merged)
+
+    exact, masked = pack_entries(entries)
+
+    banks = []
+    for i in range(0, len(exact), 4):
+        ids = exact[i : i + 4]
+        ids += [ids[-1]] * (4 - len(ids))  # Pad unused slots with duplicates.
+        banks.append(
+            {
+                "mode": "CAN_FILTERMODE_IDLIST",
+                "lowest_id": ids[0],
+                "entries": [(x, STD_ID_FULL_MASK) for x in ids],
+                "words": [filter_word(x) for x in ids],
+            }
+        )
+    for i in range(0, len(masked), 2):
+        pairs = masked[i : i + 2]
+        pairs += [pairs[-1]] * (2 - len(pairs))
+        words = []
+        for filter_id, mask in pairs:
+            words += [filter_word(filter_id), filter_word(mask)]
+            words[-1] |= FILTER_RTR_IDE_MASK
+        banks.append(
+            {
+                "mode": "CAN_FILTERMODE_IDMASK",
+                "lowest_id": pairs[0][0],
+                "entries": pairs,
+                "words": words,
+            }
+        )
+
+    banks.sort(key=lambda bank: bank["lowest_id"])
+    fifo0_count = (len(banks) + 1) // 2
+    for i, bank in enumerate(banks):
+        bank["fifo"] = (
+            "CAN_FILTER_FIFO0" if i < fifo0_count else "CAN_FILTER_FIFO1"
+        )
+    return banks
+
+
+def accepted_ids(banks):
+    """Set of standard IDs accepted by the (ID, mask) entries of all banks."""
+    accepted = set()
+    for bank in banks:
+        for filter_id, mask in bank["entries"]:
+            for std_id in range(STD_ID_SPACE):
+                if std_id & mask == filter_id & mask:
+                    accepted.add(std_id)
+    return accepted
+
+
+def filter_quality(messages, node: str, banks):
+    """Filter plan coverage and false-accept rate over all std IDs.
+
+    Returns:
+        Tuple of (coverage, unwanted IDs accepted, false-accept rate).
+    """
+    wanted = set(
+        msg["id"] & STD_ID_FULL_MASK
+        for msg in messages
+        if is_rx_message(msg, node)
+    )
+    accepted = accepted_ids(banks)
+
+    coverage = len(wanted & accepted) / len(wanted) if wanted else 1.0
+    false_accepts = len(accepted - wanted)
+    false_accept_rate = false_accepts / (STD_ID_SPACE - len(wanted))
+    return coverage, false_accepts, false_accept_rate
+
+
+def report_filters(messages, node: str, banks):
+    """Print filter plan coverage and false-accept rate over all std IDs."""
+    coverage, false_accepts, false_accept_rate = filter_quality(
+        messages, node, banks
+    )
+
+    print(f"CAN filter banks per bus: {len(banks)}.")
+    for i, bank in enumerate(banks):
+        ids = ", ".join(
+            f"0x{filter_id:03X}/0x{mask:03X}"
+            for filter_id, mask in bank["entries"]
+        )
+        print(f"  Bank {i}: {bank['mode']}, {bank['fifo']}: {ids}.")
+    print(f"CAN filter coverage: {coverage * 100:.1f} %.")
+    print(
+        f"CAN filter false-accept rate: {false_accept_rate * 100:.2f} % "
+        f"({false_accepts} unwanted IDs accepted)."
+    )
+
+
+def generate_source(messages, output_filename: str, node: str, banks):
     """Generate source file with extern array of CAN message definitions."""
     with open(f"{output_filename}.c", "w") as out:
         out.write(
             "/** Auto-generated CAN message definitions from DBC file. */\n\n"
         )
         out.write(f'#include "{output_filename}.h"\n\n')
+        for msg in messages:
+            for sig in msg["signals"]:
+                if not sig["values"]:
+                    continue
+                out.write(
+                    "static const can_value_description_t {0}[] = {{\n".format(
+                        value_table_name(msg, sig)
+                    )
+                )
+                for value, description in sig["values"]:
+                    out.write(f'    {{{value}, "{description}"}},\n')
+                out.write("};\n\n")
+        for msg in messages:
+            if is_rx_message(msg, node):
+                out.write(
+                    "__weak void {0}(CAN_RxHeaderTypeDef *header, "
+                    "uint8_t *data) {{\n".format(rx_handler_name(msg))
+                )
+                out.write("  (void)header;\n")
+                out.write("  (void)data;\n")
+                out.write("}\n\n")
         out.write("const can_message_t dbc_messages[] = {\n")
         for msg in messages:
             out.write("    {\n")
@@ -128,8 +614,24 @@ def generate_source(messages, output_filename: str):
             out.write("        .message_id = {0},\n".format(msg["id"]))
             out.write("        .id_mask = 0xFFFFFFFF,\n")
             out.write("        .dlc = {0},\n".format(msg["dlc"]))
-            out.write("        .rx_handler = 0,\n")
+            if is_rx_message(msg, node):
+                out.write(
+                    "        .rx_handler = {0},\n".format(rx_handler_name(msg))
+                )
+            else:
+                out.write("        .rx_handler = 0,\n")
             out.write("        .tx_handler = 0,\n")
+            out.write("        .send_type = {0},\n".format(msg["send_type"]))
+            out.write(
+                "        .cycle_time_ms = {0},\n".format(msg["cycle_time"])
+            )
+            out.write(
+                "        .start_delay_ms = {0},\n".format(msg["start_delay"])
+            )
+            out.write(
+                "        .min_interval_ms = {0},\n".format(msg["min_interval"])
+            )
+            out.write("        .redundant = {0},\n".format(msg["redundant"]))
             out.write(
                 "        .signal_count = {0},\n".format(len(msg["signals"]))
             )
@@ -154,6 +656,26 @@ def generate_source(messages, output_filename: str):
                         sig["byte_order"]
                     )
                 )
+                out.write(
+                    "                    .is_signed = {0},\n".format(
+                        sig["is_signed"]
+                    )
+                )
+                out.write(
+                    "                    .value_type = {0},\n".format(
+                        sig["value_type"]
+                    )
+                )
+                out.write(
+                    "                    .mux_type = {0},\n".format(
+                        sig["mux_type"]
+                    )
+                )
+                out.write(
+                    "                    .mux_value = {0},\n".format(
+                        sig["mux_value"]
+                    )
+                )
                 out.write(
                     "                    .scale = {0}f,\n".format(sig["scale"])
                 )
@@ -172,16 +694,44 @@ def generate_source(messages, output_filename: str):
                         sig["max_value"]
                     )
                 )
+                if sig["values"]:
+                    out.write(
+                        "                    .value_table = {0},\n".format(
+                            value_table_name(msg, sig)
+                        )
+                    )
+                    out.write(
+                        "                    .value_count = {0},\n".format(
+                            len(sig["values"])
+                        )
+                    )
                 out.write("                },\n")
             out.write("            },\n")
             out.write("    },\n")
         out.write("};\n\n")
         out.write(
-            "const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);\n"
+            "const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);\n\n"
         )
+        out.write("const can_filter_bank_t dbc_filter_banks[] = {\n")
+        for bank in banks:
+            words = [f"0x{word:04X}" for word in bank["words"]]
+            out.write("    {\n")
+            out.write("        .filter_mode = {0},\n".format(bank["mode"]))
+            out.write("        .filter_fifo = {0},\n".format(bank["fifo"]))
+            out.write("        .filter_id_low = {0},\n".format(words[0]))
+            out.write("        .filter_mask_id_low = {0},\n".format(words[1]))
+            out.write("        .filter_id_high = {0},\n".format(words[2]))
+            out.write("        .filter_mask_id_high = {0},\n".format(words[3]))
+            out.write("    },\n")
+        if not banks:
+            out.write(
+                "    {0}, // No received messages, all frames rejected.\n"
+            )
+        out.write("};\n\n")
+        out.write(f"const int dbc_filter_bank_count = {len(banks)};\n")
 
 
-def generate_header(output_filename: str):
+def generate_header(messages, output_filename: str, node: str):
     """Generate header file with appropriate extern definitions."""
     with open(f"{output_filename}.h", "w") as out:
         out.write(
@@ -190,8 +740,25 @@ def generate_header(output_filename: str):
         out.write(f"#ifndef {output_filename.upper()}_H\n")
         out.write(f"#define {output_filename.upper()}_H\n\n")
         out.write('#include "can.h"\n\n')
+        # Indices into dbc_messages[] to reference descriptors by name.
+        for i, msg in enumerate(messages):
+            out.write(
+                "#define DBC_MESSAGE_{0} {1}\n".format(msg["name"].upper(), i)
+            )
+        out.write("\n")
         out.write("extern const can_message_t dbc_messages[];\n")
         out.write("extern const int dbc_message_count;\n\n")
+        out.write("extern const can_filter_bank_t dbc_filter_banks[];\n")
+        out.write("extern const int dbc_filter_bank_count;\n\n")
+        rx_messages = [msg for msg in messages if is_rx_message(msg, node)]
+        for msg in rx_messages:
+            out.write(
+                "void {0}(CAN_RxHeaderTypeDef *header, uint8_t *data);\n".format(
+                    rx_handler_name(msg)
+                )
+            )
+        if rx_messages:
+            out.write("\n")
         out.write(f"#endif // {output_filename.upper()}_H\n")
 
 
@@ -202,6 +769,29 @@ def main():
     )
     parser.add_argument("dbc_file", help="Path to the input DBC file")
     parser.add_argument("output_file", help="Path to the output header file")
+    parser.add_argument(
+        "--node",
+        default="nerve",
+        help="DBC node (BU_) name of this device, used to find RX messages",
+    )
+    parser.add_argument(
+        "--filter-banks",
+        type=int,
+        default=14,
+        help="bxCAN filter banks available per bus (CAN_FILTER_SLAVE_START_BANK)",
+    )
+    parser.add_argument(
+        "--bitrate",
+        type=int,
+        default=500000,
+        help="CAN bus bitrate (bit/s) used for the bus load estimate",
+    )
+    parser.add_argument(
+        "--hyperperiod-limit",
+        type=int,
+        default=60000,
+        help="Maximum TX phase planning window (ms)",
+    )
     args = parser.parse_args()
 
     # Parse DBC.
@@ -210,9 +800,26 @@ def main():
         print("No messages found in the DBC file.", file=sys.stderr)
         sys.exit(1)
 
+    # Parse signal value types, value tables and message attributes.
+    parse_signal_extras(args.dbc_file, messages)
+    parse_attributes(args.dbc_file, messages)
+    validate_messages(messages, args.node)
+
+    # Plan periodic TX phase offsets.
+    load = plan_phases(messages, args.node, args.hyperperiod_limit)
+
+    # Plan hardware acceptance filters for received messages.
+    banks = plan_filters(messages, args.node, args.filter_banks)
+
     # Generate header and source file.
-    generate_header(args.output_file)
-    generate_source(messages, args.output_file)
+    generate_header(messages, args.output_file, args.node)
+    generate_source(messages, args.output_file, args.node, banks)
+
+    # Report acceptance filter quality.
+    report_filters(messages, args.node, banks)
+
+    # Report the periodic TX schedule.
+    report_schedule(messages, args.node, load, args.bitrate)
 
     # Output message.
     print(f'Files generated: "{args.output_file}.h", "{args.output_file}.c".')
@@ -0,0 +1,152 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#include "float.h"
+
+__weak void can_rx_float_double(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+__weak void can_rx_float_motorola(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+const can_message_t dbc_messages[] = {
+    {
+        .name = "float_intel",
+        .message_id = 784,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 20,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 2,
+        .signals =
+            {
+                {
+                    .name = "float_a",
+                    .start_bit = 0,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_FLOAT32,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -1000000.0f,
+                    .max_value = 1000000.0f,
+                },
+                {
+                    .name = "float_b_scaled",
+                    .start_bit = 32,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_FLOAT32,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 2.0f,
+                    .offset = 1.0f,
+                    .min_value = -1000000.0f,
+                    .max_value = 1000000.0f,
+                },
+            },
+    },
+    {
+        .name = "float_double",
+        .message_id = 785,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = can_rx_float_double,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 1,
+        .signals =
+            {
+                {
+                    .name = "float_double",
+                    .start_bit = 0,
+                    .bit_length = 64,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_FLOAT64,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -1000000000.0f,
+                    .max_value = 1000000000.0f,
+                },
+            },
+    },
+    {
+        .name = "float_motorola",
+        .message_id = 786,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 6,
+        .rx_handler = can_rx_float_motorola,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 2,
+        .signals =
+            {
+                {
+                    .name = "float_be",
+                    .start_bit = 7,
+                    .bit_length = 32,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_FLOAT32,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -1000000.0f,
+                    .max_value = 1000000.0f,
+                },
+                {
+                    .name = "float_be_integer",
+                    .start_bit = 39,
+                    .bit_length = 16,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 65535.0f,
+                },
+            },
+    },
+};
+
+const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);
+
+const can_filter_bank_t dbc_filter_banks[] = {
+    {
+        .filter_mode = CAN_FILTERMODE_IDLIST,
+        .filter_fifo = CAN_FILTER_FIFO0,
+        .filter_id_low = 0x6220,
+        .filter_mask_id_low = 0x6240,
+        .filter_id_high = 0x6240,
+        .filter_mask_id_high = 0x6240,
+    },
+};
+
+const int dbc_filter_bank_count = 1;
@@ -0,0 +1,21 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#ifndef FLOAT_H
+#define FLOAT_H
+
+#include "can.h"
+
+#define DBC_MESSAGE_FLOAT_INTEL 0
+#define DBC_MESSAGE_FLOAT_DOUBLE 1
+#define DBC_MESSAGE_FLOAT_MOTOROLA 2
+
+extern const can_message_t dbc_messages[];
+extern const int dbc_message_count;
+
+extern const can_filter_bank_t dbc_filter_banks[];
+extern const int dbc_filter_bank_count;
+
+void can_rx_float_double(CAN_RxHeaderTypeDef *header, uint8_t *data);
+void can_rx_float_motorola(CAN_RxHeaderTypeDef *header, uint8_t *data);
+
+#endif // FLOAT_H
@@ -0,0 +1,214 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#include "multiplexed.h"
+
+__weak void can_rx_mux_motorola(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+const can_message_t dbc_messages[] = {
+    {
+        .name = "mux_intel",
+        .message_id = 800,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 50,
+        .start_delay_ms = 5,
+        .min_interval_ms = 0,
+        .redundant = 1,
+        .signal_count = 7,
+        .signals =
+            {
+                {
+                    .name = "mux_page",
+                    .start_bit = 0,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_SWITCH,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 2.0f,
+                },
+                {
+                    .name = "mux_p0_voltage",
+                    .start_bit = 8,
+                    .bit_length = 16,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 0,
+                    .scale = 0.001f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 65.535f,
+                },
+                {
+                    .name = "mux_p0_current",
+                    .start_bit = 24,
+                    .bit_length = 16,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 0,
+                    .scale = 0.01f,
+                    .offset = 0.0f,
+                    .min_value = -327.68f,
+                    .max_value = 327.67f,
+                },
+                {
+                    .name = "mux_p1_temperature",
+                    .start_bit = 8,
+                    .bit_length = 16,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 1,
+                    .scale = 0.1f,
+                    .offset = -40.0f,
+                    .min_value = -3316.8f,
+                    .max_value = 3236.7f,
+                },
+                {
+                    .name = "mux_p1_float",
+                    .start_bit = 24,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_FLOAT32,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 1,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -1000000.0f,
+                    .max_value = 1000000.0f,
+                },
+                {
+                    .name = "mux_p2_state",
+                    .start_bit = 8,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 2,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "mux_counter",
+                    .start_bit = 56,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+            },
+    },
+    {
+        .name = "mux_motorola",
+        .message_id = 801,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = can_rx_mux_motorola,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 4,
+        .signals =
+            {
+                {
+                    .name = "mux_mode",
+                    .start_bit = 7,
+                    .bit_length = 4,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_SWITCH,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 15.0f,
+                },
+                {
+                    .name = "mux_mode0_raw",
+                    .start_bit = 3,
+                    .bit_length = 12,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "mux_mode1_angle",
+                    .start_bit = 23,
+                    .bit_length = 16,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 1,
+                    .scale = 0.01f,
+                    .offset = 0.0f,
+                    .min_value = -327.68f,
+                    .max_value = 327.67f,
+                },
+                {
+                    .name = "mux_mode1_flag",
+                    .start_bit = 39,
+                    .bit_length = 1,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_MULTIPLEXED,
+                    .mux_value = 1,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 1.0f,
+                },
+            },
+    },
+};
+
+const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);
+
+const can_filter_bank_t dbc_filter_banks[] = {
+    {
+        .filter_mode = CAN_FILTERMODE_IDLIST,
+        .filter_fifo = CAN_FILTER_FIFO0,
+        .filter_id_low = 0x6420,
+        .filter_mask_id_low = 0x6420,
+        .filter_id_high = 0x6420,
+        .filter_mask_id_high = 0x6420,
+    },
+};
+
+const int dbc_filter_bank_count = 1;
@@ -0,0 +1,19 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#ifndef MULTIPLEXED_H
+#define MULTIPLEXED_H
+
+#include "can.h"
+
+#define DBC_MESSAGE_MUX_INTEL 0
+#define DBC_MESSAGE_MUX_MOTOROLA 1
+
+extern const can_message_t dbc_messages[];
+extern const int dbc_message_count;
+
+extern const can_filter_bank_t dbc_filter_banks[];
+extern const int dbc_filter_bank_count;
+
+void can_rx_mux_motorola(CAN_RxHeaderTypeDef *header, uint8_t *data);
+
+#endif // MULTIPLEXED_H
@@ -0,0 +1,172 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#include "signed.h"
+
+__weak void can_rx_signed_motorola(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+const can_message_t dbc_messages[] = {
+    {
+        .name = "signed_intel",
+        .message_id = 768,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_CYCLIC,
+        .cycle_time_ms = 100,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 4,
+        .signals =
+            {
+                {
+                    .name = "signed_s8",
+                    .start_bit = 0,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -128.0f,
+                    .max_value = 127.0f,
+                },
+                {
+                    .name = "signed_s12_scaled",
+                    .start_bit = 8,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.5f,
+                    .offset = -10.0f,
+                    .min_value = -1034.0f,
+                    .max_value = 1013.5f,
+                },
+                {
+                    .name = "signed_u12",
+                    .start_bit = 20,
+                    .bit_length = 12,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 4095.0f,
+                },
+                {
+                    .name = "signed_s32",
+                    .start_bit = 32,
+                    .bit_length = 32,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.001f,
+                    .offset = 0.0f,
+                    .min_value = -2147483.648f,
+                    .max_value = 2147483.647f,
+                },
+            },
+    },
+    {
+        .name = "signed_motorola",
+        .message_id = 769,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 8,
+        .rx_handler = can_rx_signed_motorola,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 4,
+        .signals =
+            {
+                {
+                    .name = "signed_m16",
+                    .start_bit = 7,
+                    .bit_length = 16,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 0.01f,
+                    .offset = 0.0f,
+                    .min_value = -327.68f,
+                    .max_value = 327.67f,
+                },
+                {
+                    .name = "signed_m5",
+                    .start_bit = 20,
+                    .bit_length = 5,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -16.0f,
+                    .max_value = 15.0f,
+                },
+                {
+                    .name = "signed_m_unsigned",
+                    .start_bit = 31,
+                    .bit_length = 8,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                },
+                {
+                    .name = "signed_m24_offset",
+                    .start_bit = 39,
+                    .bit_length = 24,
+                    .byte_order = CAN_BIG_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1e-06f,
+                    .offset = -1.0f,
+                    .min_value = -9.388608f,
+                    .max_value = 7.388607f,
+                },
+            },
+    },
+};
+
+const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);
+
+const can_filter_bank_t dbc_filter_banks[] = {
+    {
+        .filter_mode = CAN_FILTERMODE_IDLIST,
+        .filter_fifo = CAN_FILTER_FIFO0,
+        .filter_id_low = 0x6020,
+        .filter_mask_id_low = 0x6020,
+        .filter_id_high = 0x6020,
+        .filter_mask_id_high = 0x6020,
+    },
+};
+
+const int dbc_filter_bank_count = 1;
@@ -0,0 +1,142 @@
+/** Auto-generated CAN message definitions from DBC file. */
+
+#include "value_tables.h"
+
+static const can_value_description_t value_table_values_status_values_mode[] = {
+    {0, "idle"},
+    {1, "armed"},
+    {2, "flight"},
+    {15, "invalid"},
+};
+
+static const can_value_description_t value_table_values_status_values_level[] = {
+    {-128, "min"},
+    {-1, "low"},
+    {0, "zero"},
+    {127, "max"},
+};
+
+static const can_value_description_t value_table_values_command_values_command[] = {
+    {0, "none"},
+    {1, "arm"},
+    {2, "disarm"},
+};
+
+__weak void can_rx_values_command(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+}
+
+const can_message_t dbc_messages[] = {
+    {
+        .name = "values_status",
+        .message_id = 816,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 2,
+        .rx_handler = 0,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_ON_CHANGE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 100,
+        .redundant = 0,
+        .signal_count = 3,
+        .signals =
+            {
+                {
+                    .name = "values_mode",
+                    .start_bit = 0,
+                    .bit_length = 4,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 15.0f,
+                    .value_table = value_table_values_status_values_mode,
+                    .value_count = 4,
+                },
+                {
+                    .name = "values_fault",
+                    .start_bit = 4,
+                    .bit_length = 4,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 15.0f,
+                },
+                {
+                    .name = "values_level",
+                    .start_bit = 8,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 1,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = -128.0f,
+                    .max_value = 127.0f,
+                    .value_table = value_table_values_status_values_level,
+                    .value_count = 4,
+                },
+            },
+    },
+    {
+        .name = "values_command",
+        .message_id = 817,
+        .id_mask = 0xFFFFFFFF,
+        .dlc = 1,
+        .rx_handler = can_rx_values_command,
+        .tx_handler = 0,
+        .send_type = CAN_SEND_NONE,
+        .cycle_time_ms = 0,
+        .start_delay_ms = 0,
+        .min_interval_ms = 0,
+        .redundant = 0,
+        .signal_count = 1,
+        .signals =
+            {
+                {
+                    .name = "values_command",
+                    .start_bit = 0,
+                    .bit_length = 8,
+                    .byte_order = CAN_LITTLE_ENDIAN,
+                    .is_signed = 0,
+                    .value_type = CAN_VALUE_INTEGER,
+                    .mux_type = CAN_MUX_NONE,
+                    .mux_value = 0,
+                    .scale = 1.0f,
+                    .offset = 0.0f,
+                    .min_value = 0.0f,
+                    .max_value = 255.0f,
+                    .value_table = value_table_values_command_values_command,
+                    .value_count = 3,
+                },
+            },
+    },
+};
+
+const int dbc_message_count = sizeof(dbc_messages) / sizeof(dbc_messages[0]);
+
+const can_filter_bank_t dbc_filter_banks[] = {
+    {
+        .filter_mode = CAN_FILTERMODE_IDLIST,
+        .filter_fifo = CAN_FILTER_FIFO0,
+        .filter_id_low = 0x6620,
+        .filter_mask_id_low = 0x6620,
+        .filter_id_high = 0x6620,
+        .filter_mask_id_high = 0x6620,
+    },
+};
+
+const int dbc_filter_bank_count = 1;
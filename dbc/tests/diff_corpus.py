@@ -0,0 +1,128 @@
+"""Regression diff of generate_can_defs.py over the DBC corpus.
+
+Each corpus/<name>.dbc is generated (node nerve, default options) into a
+temporary directory and the <name>.c, <name>.h and generator report
+(<name>.txt, stdout then stderr) are diffed against corpus/expected. The
+corpus covers signed (Intel and Motorola), IEEE float and double, multiplexed
+and value table signals.
+
+Usage:
+    ```shell
+    python3 dbc/tests/diff_corpus.py  # Diff, exit 1 on any difference.
+    python3 dbc/tests/diff_corpus.py --update  # Accept the new outputs.
+    ```
+"""
+
+import argparse
+import difflib
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+GENERATOR = os.path.join(TESTS_DIR, "..", "generate_can_defs.py")
+CORPUS_DIR = os.path.join(TESTS_DIR, "corpus")
+EXPECTED_DIR = os.path.join(CORPUS_DIR, "expected")
+
+OUTPUT_EXTENSIONS = (".c", ".h", ".txt")
+
+
+def corpus_names():
+    """Base names of the corpus DBC files, sorted."""
+    return sorted(
+        os.path.splitext(os.path.basename(path))[0]
+        for path in glob.glob(os.path.join(CORPUS_DIR, "*.dbc"))
+    )
+
+
+def generate(name: str):
+    """Run the generator on a corpus DBC, returns {extension: text}."""
+    dbc_file = os.path.join(CORPUS_DIR, f"{name}.dbc")
+    with tempfile.TemporaryDirectory() as work_dir:
+        # Relative output name, as the #include and guard use it verbatim.
+        result = subprocess.run(
+            [sys.executable, GENERATOR, dbc_file, name],
+            cwd=work_dir,
+            capture_output=True,
+            text=True,
+        )
+        outputs = {".txt": result.stdout + result.stderr}
+        if result.returncode != 0:
+            outputs[".txt"] += f"Exit code {result.returncode}.\n"
+            return outputs
+        for extension in (".c", ".h"):
+            with open(os.path.join(work_dir, name + extension)) as f:
+                outputs[extension] = f.read()
+    return outputs
+
+
+def expected(name: str):
+    """Read the expected outputs of a corpus DBC, returns {extension: text}."""
+    outputs = {}
+    for extension in OUTPUT_EXTENSIONS:
+        path = os.path.join(EXPECTED_DIR, name + extension)
+        if os.path.exists(path):
+            with open(path) as f:
+                outputs[extension] = f.read()
+    return outputs
+
+
+def corpus_diff(name: str) -> str:
+    """Unified diff of the expected and generated outputs, empty if equal."""
+    old = expected(name)
+    new = generate(name)
+    diff = []
+    for extension in OUTPUT_EXTENSIONS:
+        filename = f"expected/{name}{extension}"
+        diff.extend(
+            difflib.unified_diff(
+                old.get(extension, "").splitlines(keepends=True),
+                new.get(extension, "").splitlines(keepends=True),
+                fromfile=filename,
+                tofile=f"generated/{name}{extension}",
+            )
+        )
+    return "".join(diff)
+
+
+def update(name: str):
+    """Overwrite the expected outputs of a corpus DBC."""
+    for extension, text in generate(name).items():
+        with open(os.path.join(EXPECTED_DIR, name + extension), "w") as f:
+            f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Diff generate_can_defs.py outputs over the DBC corpus."
+    )
+    parser.add_argument(
+        "--update",
+        action="store_true",
+        help="Overwrite the expected outputs with the generated ones",
+    )
+    args = parser.parse_args()
+
+    changed = 0
+    for name in corpus_names():
+        if args.update:
+            update(name)
+            print(f"{name}: updated.")
+            continue
+        diff = corpus_diff(name)
+        if diff:
+            changed += 1
+            print(f"{name}: differs.")
+            sys.stdout.write(diff)
+        else:
+            print(f"{name}: OK.")
+
+    if changed:
+        print(f"{changed} corpus DBC outputs differ, review and --update.")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,35 @@
+"""Host regression test of generate_can_defs.py over the DBC corpus.
+
+See diff_corpus.py, regenerate the expected outputs with its --update option
+after an intended generator change.
+
+Usage:
+    ```shell
+    python3 -m unittest discover -s dbc/tests  # From the repo root.
+    ```
+"""
+
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import diff_corpus  # noqa: E402
+
+
+class CorpusTest(unittest.TestCase):
+    def test_corpus_present(self):
+        self.assertEqual(
+            diff_corpus.corpus_names(),
+            ["float", "multiplexed", "signed", "value_tables"],
+        )
+
+    def test_outputs_match_expected(self):
+        for name in diff_corpus.corpus_names():
+            with self.subTest(dbc=name):
+                self.assertEqual(diff_corpus.corpus_diff(name), "")
+
+
+if __name__ == "__main__":
+    unittest.main()
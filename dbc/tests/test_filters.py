@@ -0,0 +1,139 @@
+"""Host tests of the bxCAN acceptance filter planner in generate_can_defs.py.
+
+filter_budget.dbc has 61 receive IDs (16 ID list banks), a run of 32
+consecutive IDs and 29 scattered ones, exceeding the default 14 bank budget.
+
+Usage:
+    ```shell
+    python3 -m unittest discover -s dbc/tests  # From the repo root.
+    ```
+"""
+
+import os
+import sys
+import unittest
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(TESTS_DIR))
+
+import generate_can_defs as gen  # noqa: E402
+
+NODE = "nerve"
+NERVE_DBC = os.path.join(TESTS_DIR, "..", "can_nerve.dbc")
+BUDGET_DBC = os.path.join(TESTS_DIR, "filter_budget.dbc")
+
+# bxCAN 16-bit filter bits of a received frame (RTR and IDE, standard ID).
+FRAME_RTR = 0x10
+
+
+def load(filename: str):
+    """Parse a DBC as the generator does before planning."""
+    messages = gen.parse_dbc(filename)
+    gen.parse_signal_extras(filename, messages)
+    gen.parse_attributes(filename, messages)
+    gen.validate_messages(messages, NODE)
+    return messages
+
+
+def rx_ids(messages):
+    """Standard IDs received by the node."""
+    return set(
+        msg["id"] & gen.STD_ID_FULL_MASK
+        for msg in messages
+        if gen.is_rx_message(msg, NODE)
+    )
+
+
+def hardware_accepts(bank, frame_word: int) -> bool:
+    """Model of one 16-bit bxCAN bank matching a received frame word."""
+    words = bank["words"]
+    if bank["mode"] == "CAN_FILTERMODE_IDLIST":
+        return frame_word in words
+    return any(
+        (frame_word ^ words[i]) & words[i + 1] == 0 for i in range(0, 4, 2)
+    )
+
+
+def hardware_accepted_ids(banks, rtr: bool = False):
+    """Standard IDs passed by the filter register words (not the entries)."""
+    accepted = set()
+    for std_id in range(gen.STD_ID_SPACE):
+        frame_word = gen.filter_word(std_id) | (FRAME_RTR if rtr else 0)
+        if any(hardware_accepts(bank, frame_word) for bank in banks):
+            accepted.add(std_id)
+    return accepted
+
+
+class FilterPlanTest(unittest.TestCase):
+    def check_plan(self, messages, budget: int):
+        """Common checks of a plan, returns (banks, quality)."""
+        banks = gen.plan_filters(messages, NODE, budget)
+        quality = gen.filter_quality(messages, NODE, banks)
+        wanted = rx_ids(messages)
+
+        self.assertLessEqual(len(banks), budget)
+        self.assertEqual(quality[0], 1.0)  # Coverage, nothing wanted lost.
+        self.assertEqual(hardware_accepted_ids(banks), gen.accepted_ids(banks))
+        self.assertLessEqual(wanted, gen.accepted_ids(banks))
+        self.assertEqual(hardware_accepted_ids(banks, rtr=True), set())
+
+        # Lowest IDs (highest priority) first, first half to FIFO0.
+        lowest = [bank["lowest_id"] for bank in banks]
+        self.assertEqual(lowest, sorted(lowest))
+        fifo0 = [bank["fifo"] == "CAN_FILTER_FIFO0" for bank in banks]
+        self.assertEqual(fifo0.count(True), (len(banks) + 1) // 2)
+        self.assertEqual(fifo0, sorted(fifo0, reverse=True))
+        return banks, quality
+
+    def test_nerve_dbc_exact(self):
+        messages = load(NERVE_DBC)
+        banks, quality = self.check_plan(messages, 14)
+
+        self.assertTrue(
+            all(bank["mode"] == "CAN_FILTERMODE_IDLIST" for bank in banks)
+        )
+        self.assertEqual(quality[1], 0)
+
+    def test_id_list_within_budget(self):
+        messages = load(BUDGET_DBC)
+        self.assertEqual(len(rx_ids(messages)), 61)
+        banks, quality = self.check_plan(messages, 16)
+
+        self.assertTrue(
+            all(bank["mode"] == "CAN_FILTERMODE_IDLIST" for bank in banks)
+        )
+        self.assertEqual(quality[1], 0)
+        self.assertNotIn(0x100, gen.accepted_ids(banks))  # Transmitted only.
+
+    def test_mask_fallback_over_budget(self):
+        messages = load(BUDGET_DBC)
+        banks, quality = self.check_plan(messages, 14)
+
+        modes = [bank["mode"] for bank in banks]
+        self.assertIn("CAN_FILTERMODE_IDMASK", modes)
+        self.assertIn("CAN_FILTERMODE_IDLIST", modes)
+        # The consecutive run merges with few extra IDs.
+        self.assertLessEqual(quality[1], 8)
+        self.assertLess(quality[2], 0.005)
+
+    def test_false_accepts_grow_as_budget_shrinks(self):
+        messages = load(BUDGET_DBC)
+        previous = 0
+        for budget in (16, 14, 8, 4, 2, 1):
+            with self.subTest(budget=budget):
+                _, quality = self.check_plan(messages, budget)
+                self.assertGreaterEqual(quality[1], previous)
+                previous = quality[1]
+
+    def test_no_rx_messages(self):
+        messages = [
+            msg for msg in load(NERVE_DBC) if not gen.is_rx_message(msg, NODE)
+        ]
+        banks = gen.plan_filters(messages, NODE, 14)
+
+        self.assertEqual(banks, [])
+        self.assertEqual(gen.filter_quality(messages, NODE, banks)[0], 1.0)
+
+
+if __name__ == "__main__":
+    unittest.main()
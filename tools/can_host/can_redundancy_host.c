@@ -0,0 +1,346 @@
+/*******************************************************************************
+ * @file can_redundancy_host.c
+ * @brief Host test of the dual bus redundancy (NERVE_CAN_REDUNDANCY) of can.c.
+ *
+ * Runs Core/Src/can.c unchanged on simulated CAN1 and CAN2 (can_sim.c), with a
+ * remote node sending the redundant command_a message (0x201) every 1 ms on
+ * both buses, the CAN2 copy 200 us after the CAN1 copy. can_rx_process runs
+ * every 1 ms and can_monitor_update every CAN_MONITOR_PERIOD_MS, as scheduled
+ * by init.c. Scenarios, in order (can.c state carries over):
+ *     1. Mirrored TX: a redundant message is queued and sent on both buses.
+ *     2. Dedup: each mirrored command_a is dispatched once, skew measured.
+ *     3. No dedup: copies outside CAN_REDUNDANCY_DEDUP_US, with different data
+ *        or from the same bus are all dispatched.
+ *     4. Silent bus failover: CAN1 stops receiving, the primary bus moves to
+ *        CAN2 after CAN_REDUNDANCY_SILENT_MS and stays there when CAN1 returns.
+ *     5. Bus-off failover: CAN2 goes bus-off, the primary bus moves to CAN1
+ *        within one monitor period, CAN2 recovers and requeues its mailboxes.
+ *
+ * Build and run (from the repository root):
+ *     gcc -O2 -DNERVE_CAN_REDUNDANCY -Itools/can_host -ICore/Inc \
+ *         tools/can_host/can_redundancy_host.c tools/can_host/can_sim.c \
+ *         Core/Src/can.c Core/Src/can_nerve.c Core/Src/diagnostics.c \
+ *         -o can_redundancy_host
+ *     ./can_redundancy_host
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "can.h"
+#include "can_nerve.h"
+#include "can_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef NERVE_CAN_REDUNDANCY
+#error "Build with -DNERVE_CAN_REDUNDANCY."
+#endif
+
+/** Definitions. **************************************************************/
+
+#define ID_COMMAND_A 0x201 // Redundant, received.
+#define ID_RAW_TX 0x123    // Raw frame queued on CAN2 before bus-off.
+
+#define MIRROR_SKEW_US 200 // CAN2 copy after the CAN1 copy.
+
+#define BUS_BOTH 0x3 // Traffic on CAN1 (bit 0) and CAN2 (bit 1).
+#define BUS_CAN1 0x1
+#define BUS_CAN2 0x2
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);                 \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/** Private variables. ********************************************************/
+
+static uint32_t handled = 0;        // command_a frames dispatched.
+static uint32_t remote_counter = 0; // Payload of the remote command_a.
+static uint64_t switch_us = 0;      // Time of the last primary bus switch.
+static int failures = 0;
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Receive a command_a frame on a bus, RX interrupt without latency.
+ */
+static void receive(uint8_t bus, uint32_t counter) {
+  can_sim_frame_t frame = {.std_id = ID_COMMAND_A, .dlc = 8};
+
+  memcpy(frame.data, &counter, sizeof(counter));
+  can_sim_receive(bus, &frame);
+  can_sim_run_irqs(bus);
+}
+
+/**
+ * @brief End a 1 ms step: RX process task, monitor task every period.
+ */
+static void tick(void) {
+  const uint8_t primary = can_redundancy_get_stats()->primary_bus;
+
+  can_rx_process();
+  if (HAL_GetTick() % CAN_MONITOR_PERIOD_MS == 0) {
+    can_monitor_update();
+    if (can_redundancy_get_stats()->primary_bus != primary) {
+      switch_us = can_sim_time_us();
+    }
+  }
+}
+
+/**
+ * @brief Run the remote node traffic for some time.
+ *
+ * @param ms Milliseconds.
+ * @param buses Buses carrying the traffic (BUS_* bits).
+ */
+static void run_ms(uint32_t ms, uint8_t buses) {
+  for (uint32_t i = 0; i < ms; i++) {
+    remote_counter++;
+    if (buses & BUS_CAN1) {
+      receive(0, remote_counter);
+    }
+    can_sim_advance_us(MIRROR_SKEW_US);
+    if (buses & BUS_CAN2) {
+      receive(1, remote_counter);
+    }
+    can_sim_advance_us(1000 - MIRROR_SKEW_US);
+    tick();
+  }
+}
+
+/**
+ * @brief Transmit all loaded mailboxes of a bus.
+ *
+ * @return Frames with the given ID transmitted.
+ */
+static uint32_t transmit_all(uint8_t bus, uint32_t std_id) {
+  can_sim_frame_t frame;
+  uint32_t count = 0;
+
+  while (can_sim_transmit(bus, &frame)) {
+    count += frame.std_id == std_id ? 1 : 0;
+  }
+  return count;
+}
+
+/**
+ * @brief Print the redundancy statistics.
+ */
+static void report(void) {
+  const can_redundancy_stats_t *r = can_redundancy_get_stats();
+
+  printf("  primary CAN%u, ok %u/%u, mirrored %u, duplicates %u, "
+         "skew %u us (max %u)\n",
+         r->primary_bus + 1, r->bus_ok[0], r->bus_ok[1], r->mirrored,
+         r->duplicates, r->skew_us_last, r->skew_us_max);
+  printf("  failovers %u, failover time %u ms (max %u)\n", r->failovers,
+         r->failover_time_ms_last, r->failover_time_ms_max);
+}
+
+/**
+ * @brief Scenario 1: a redundant message is mirrored on both buses.
+ */
+static void scenario_mirrored_tx(void) {
+  static const uint32_t values[MAX_SIGNALS_PER_MESSAGE] = {0};
+  const can_message_t *state = &dbc_messages[DBC_MESSAGE_STATE];
+  const can_message_t *barometric = &dbc_messages[DBC_MESSAGE_BAROMETRIC];
+  const uint32_t mirrored = can_redundancy_get_stats()->mirrored;
+
+  printf("1. Mirrored TX\n");
+  run_ms(100, BUS_BOTH);
+  CHECK(state->redundant && !barometric->redundant);
+  CHECK(can_send_message(state, values) == HAL_OK);
+  report();
+
+  CHECK(can_redundancy_get_stats()->mirrored == mirrored + 1);
+  CHECK(transmit_all(0, state->message_id) == 1);
+  CHECK(transmit_all(1, state->message_id) == 1);
+
+  // Non-redundant messages on the primary bus only.
+  CHECK(can_send_message(barometric, values) == HAL_OK);
+  CHECK(transmit_all(0, barometric->message_id) == 1);
+  CHECK(transmit_all(1, barometric->message_id) == 0);
+  CHECK(can_redundancy_get_stats()->mirrored == mirrored + 1);
+}
+
+/**
+ * @brief Scenario 2: mirrored copies within the window are dispatched once.
+ */
+static void scenario_dedup(void) {
+  const can_redundancy_stats_t *r = can_redundancy_get_stats();
+  const uint32_t duplicates = r->duplicates;
+  const uint32_t handled_start = handled;
+
+  printf("2. Dedup (1 s, copies %u us apart)\n", MIRROR_SKEW_US);
+  run_ms(1000, BUS_BOTH);
+  report();
+
+  CHECK(handled - handled_start == 1000);
+  CHECK(r->duplicates - duplicates == 1000);
+  CHECK(r->skew_us_last == MIRROR_SKEW_US);
+  CHECK(r->skew_us_max == MIRROR_SKEW_US);
+  CHECK(r->bus_ok[0] && r->bus_ok[1]);
+  CHECK(r->failovers == 0);
+}
+
+/**
+ * @brief Scenario 3: copies that are not mirrors of each other are kept.
+ */
+static void scenario_no_dedup(void) {
+  const can_redundancy_stats_t *r = can_redundancy_get_stats();
+  const uint32_t duplicates = r->duplicates;
+  const uint32_t handled_start = handled;
+
+  printf("3. No dedup (late, different data, same bus)\n");
+  // Late: the CAN2 copy after the window.
+  receive(0, 0xA0000001U);
+  can_sim_advance_us(CAN_REDUNDANCY_DEDUP_US + 1000);
+  receive(1, 0xA0000001U);
+  tick();
+  can_sim_advance_us(10000);
+
+  // Different data within the window.
+  receive(0, 0xA0000002U);
+  can_sim_advance_us(MIRROR_SKEW_US);
+  receive(1, 0xA0000003U);
+  tick();
+  can_sim_advance_us(10000);
+
+  // Same bus twice within the window.
+  receive(0, 0xA0000004U);
+  can_sim_advance_us(MIRROR_SKEW_US);
+  receive(0, 0xA0000004U);
+  tick();
+  can_sim_advance_us(10000);
+  report();
+
+  CHECK(handled - handled_start == 6);
+  CHECK(r->duplicates == duplicates);
+}
+
+/**
+ * @brief Scenario 4: the primary bus (CAN1) stops receiving.
+ */
+static void scenario_silent_failover(void) {
+  const can_redundancy_stats_t *r = can_redundancy_get_stats();
+  const uint32_t handled_start = handled;
+
+  printf("4. Silent bus failover (CAN1 stops receiving)\n");
+  run_ms(100, BUS_BOTH);
+  CHECK(r->primary_bus == 0);
+
+  const uint64_t last_rx_us = can_sim_time_us() - 1000;
+  run_ms(CAN_REDUNDANCY_SILENT_MS - 2 * CAN_MONITOR_PERIOD_MS, BUS_CAN2);
+  CHECK(r->primary_bus == 0 && r->failovers == 0); // Not silent yet.
+  run_ms(4 * CAN_MONITOR_PERIOD_MS, BUS_CAN2);
+  report();
+
+  const uint64_t detect_us = switch_us - last_rx_us;
+  printf("  switched %u us after the last CAN1 frame\n", (uint32_t)detect_us);
+  CHECK(r->primary_bus == 1);
+  CHECK(r->failovers == 1);
+  CHECK(!r->bus_ok[0] && r->bus_ok[1]);
+  CHECK(r->failover_time_ms_last >= CAN_REDUNDANCY_SILENT_MS);
+  CHECK(r->failover_time_ms_last <
+        CAN_REDUNDANCY_SILENT_MS + CAN_MONITOR_PERIOD_MS);
+  CHECK(detect_us >= CAN_REDUNDANCY_SILENT_MS * 1000U);
+  CHECK(detect_us <= (CAN_REDUNDANCY_SILENT_MS + 2 * CAN_MONITOR_PERIOD_MS) *
+                         1000U);
+  CHECK(handled - handled_start ==
+        100 + CAN_REDUNDANCY_SILENT_MS + 2 * CAN_MONITOR_PERIOD_MS);
+
+  // Non-redundant messages follow the primary bus.
+  static const uint32_t values[MAX_SIGNALS_PER_MESSAGE] = {0};
+  const can_message_t *barometric = &dbc_messages[DBC_MESSAGE_BAROMETRIC];
+  const can_message_t *state = &dbc_messages[DBC_MESSAGE_STATE];
+  const uint32_t mirrored = r->mirrored;
+  CHECK(can_send_message(barometric, values) == HAL_OK);
+  CHECK(transmit_all(0, barometric->message_id) == 0);
+  CHECK(transmit_all(1, barometric->message_id) == 1);
+
+  // Redundant messages only on the healthy bus, not counted as mirrored.
+  CHECK(can_send_message(state, values) == HAL_OK);
+  CHECK(transmit_all(0, state->message_id) == 0);
+  CHECK(transmit_all(1, state->message_id) == 1);
+  CHECK(r->mirrored == mirrored);
+
+  // CAN1 returns, no fail back.
+  run_ms(100, BUS_BOTH);
+  CHECK(r->bus_ok[0] && r->bus_ok[1]);
+  CHECK(r->primary_bus == 1);
+}
+
+/**
+ * @brief Scenario 5: the primary bus (CAN2) goes bus-off.
+ */
+static void scenario_bus_off_failover(void) {
+  const can_redundancy_stats_t *r = can_redundancy_get_stats();
+  const can_tx_stats_t *tx = can_tx_get_stats(&hcan2);
+  const can_bus_status_t *can2 = can_get_bus_status(&hcan2);
+  const uint32_t starts = can_sim_starts(1);
+  const uint32_t requeued = tx->requeued;
+  const uint16_t bus_off_count = can2->bus_off_count;
+  static const uint8_t raw[8] = {0};
+
+  printf("5. Bus-off failover (CAN2 bus-off)\n");
+  run_ms(3, BUS_BOTH); // Between monitor updates.
+
+  // A frame stuck in a CAN2 mailbox, then bus-off.
+  CHECK(can_send_raw(&hcan2, ID_RAW_TX, 8, raw) == HAL_OK);
+  const uint64_t fault_us = can_sim_time_us();
+  can_sim_set_esr(1, CAN_ESR_BOFF | (255U << CAN_ESR_TEC_Pos));
+  run_ms(CAN_MONITOR_PERIOD_MS, BUS_CAN1);
+  report();
+
+  const uint64_t detect_us = switch_us - fault_us;
+  printf("  switched %u us after bus-off\n", (uint32_t)detect_us);
+  CHECK(r->primary_bus == 0);
+  CHECK(r->failovers == 2);
+  CHECK(!r->bus_ok[1]);
+  CHECK(r->failover_time_ms_last <= CAN_MONITOR_PERIOD_MS);
+  CHECK(detect_us <= CAN_MONITOR_PERIOD_MS * 1000U);
+  CHECK(r->failover_time_ms_max >= CAN_REDUNDANCY_SILENT_MS);
+  CHECK(can2->bus_off_count == bus_off_count + 1);
+  CHECK(can2->error_state == CAN_BUS_OFF);
+
+  // Recovery after the first backoff, the aborted mailbox is requeued.
+  run_ms(CAN_BUS_OFF_BACKOFF_MIN_MS + CAN_MONITOR_PERIOD_MS, BUS_CAN1);
+  can_sim_run_irqs(1);
+  CHECK(can_sim_starts(1) == starts + 1);
+  CHECK(tx->requeued == requeued + 1);
+  CHECK(transmit_all(1, ID_RAW_TX) == 1);
+
+  run_ms(100, BUS_BOTH);
+  CHECK(can2->error_state == CAN_ERROR_ACTIVE);
+  CHECK(r->bus_ok[0] && r->bus_ok[1]);
+  CHECK(r->primary_bus == 0);
+  CHECK(r->failovers == 2);
+}
+
+/** User implementations of the generated RX handlers (overwriting weak). *****/
+
+void can_rx_command_a(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  (void)data;
+  handled++;
+}
+
+/** Public functions. *********************************************************/
+
+int main(void) {
+  can_sim_init(CAN_SIM_BITRATE);
+  can_init();
+
+  scenario_mirrored_tx();
+  scenario_dedup();
+  scenario_no_dedup();
+  scenario_silent_failover();
+  scenario_bus_off_failover();
+
+  printf(failures ? "FAILED (%d)\n" : "PASSED\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+/*******************************************************************************
+ * @file can_rx_stress.c
+ * @brief Host stress test of the CAN RX path (rx_fifo_drain, can_rx_process).
+ *
+ * Runs Core/Src/can.c unchanged on simulated CAN1 and CAN2 (can_sim.c) with
+ * back-to-back 8 byte frames on both buses at 1 Mbit/s (one frame per 111 us
+ * per bus). Accepted frames carry their bus and a per bus sequence number,
+ * checked in order by the RX handlers. Three scenarios:
+ *     1. Keeping up: RX interrupt per frame, can_rx_process every 1 ms. Nothing
+ *        lost, all frames dispatched in order.
+ *     2. Stalled consumer: can_rx_process stopped for 20 ms. The RX ring fills
+ *        and counts the newest frames as ring_overflow, the rest in order.
+ *     3. Interrupt latency: RX interrupt every 4th frame. The 3 frame hardware
+ *        FIFO overruns once per interrupt, counted as fifo_overrun.
+ *
+ * Build and run (from the repository root):
+ *     gcc -O2 -Itools/can_host -ICore/Inc tools/can_host/can_rx_stress.c \
+ *         tools/can_host/can_sim.c Core/Src/can.c Core/Src/can_nerve.c \
+ *         Core/Src/diagnostics.c -o can_rx_stress
+ *     ./can_rx_stress
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "can.h"
+#include "can_nerve.h"
+#include "can_sim.h"
+#include "diagnostics.h"
+#include <stdio.h>
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+#define ID_COMMAND_A 0x201     // Received, FIFO0 (DLC 8).
+#define ID_ISOTP_REQUEST 0x7E0 // Received, FIFO0 (DLC 8).
+#define ID_UNWANTED 0x300      // Not received, rejected by the filters.
+
+#define STALL_MS 20 // Scenario 2 consumer stall.
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);                 \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Struct holding the traffic and handler tallies of a scenario.
+ */
+typedef struct {
+  uint32_t injected;        // Frames put on both buses.
+  uint32_t accepted;        // Frames passed by the filters.
+  uint32_t handled;         // Frames seen by the RX handlers.
+  uint32_t out_of_order;    // Frames older than the previous one of the bus.
+  uint32_t gaps;            // Frames not following the previous one directly.
+  int64_t last_sequence[2]; // Previous handled sequence number per bus.
+  uint32_t next_sequence[2]; // Next injected sequence number per bus.
+} tally_t;
+
+/**
+ * @brief Struct holding the RX statistics at the start of a scenario.
+ */
+typedef struct {
+  can_rx_stats_t rx;
+  uint32_t fifo_lost[2];
+  uint32_t faults;
+} baseline_t;
+
+/** Private variables. ********************************************************/
+
+static tally_t tally;
+static int failures = 0;
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Check the bus and sequence number of a handled frame.
+ */
+static void handle(const uint8_t *data) {
+  const uint8_t bus = data[0];
+  uint32_t sequence;
+
+  memcpy(&sequence, &data[1], sizeof(sequence));
+  tally.handled++;
+  if ((int64_t)sequence <= tally.last_sequence[bus]) {
+    tally.out_of_order++;
+  } else if ((int64_t)sequence != tally.last_sequence[bus] + 1) {
+    tally.gaps++;
+  }
+  tally.last_sequence[bus] = sequence;
+}
+
+/**
+ * @brief Put one frame on a bus, numbered if the filters accept it.
+ */
+static void inject(uint8_t bus, uint32_t std_id) {
+  can_sim_frame_t frame = {.std_id = std_id, .dlc = 8};
+
+  frame.data[0] = bus;
+  memcpy(&frame.data[1], &tally.next_sequence[bus], sizeof(uint32_t));
+  tally.injected++;
+  if (can_sim_receive(bus, &frame) != CAN_SIM_FILTERED) {
+    tally.accepted++;
+    tally.next_sequence[bus]++;
+  }
+}
+
+/**
+ * @brief Start a scenario: reset the tallies and take the counter baseline.
+ */
+static void scenario_start(const char *name, baseline_t *base) {
+  printf("%s\n", name);
+  memset(&tally, 0, sizeof(tally));
+  tally.last_sequence[0] = -1;
+  tally.last_sequence[1] = -1;
+  base->rx = *can_rx_get_stats();
+  base->fifo_lost[0] = can_sim_fifo_lost(0);
+  base->fifo_lost[1] = can_sim_fifo_lost(1);
+  base->faults = can_fault_count;
+}
+
+/**
+ * @brief Run back-to-back traffic on both buses.
+ *
+ * @param frames Frames per bus.
+ * @param wanted_only 1 for received IDs only, 0 to mix in unwanted IDs.
+ * @param isr_every Frames per bus between RX interrupts.
+ * @param stall_until_ms can_rx_process not called before this HAL tick.
+ */
+static void run_traffic(uint32_t frames, uint8_t wanted_only,
+                        uint32_t isr_every, uint32_t stall_until_ms) {
+  static const uint32_t mixed[3] = {ID_COMMAND_A, ID_UNWANTED,
+                                    ID_ISOTP_REQUEST};
+  static const uint32_t wanted[2] = {ID_COMMAND_A, ID_ISOTP_REQUEST};
+  uint32_t last_ms = HAL_GetTick();
+
+  for (uint32_t i = 0; i < frames; i++) {
+    can_sim_advance_us(can_sim_frame_us(8));
+    for (uint8_t bus = 0; bus < 2; bus++) {
+      inject(bus, wanted_only ? wanted[i % 2] : mixed[i % 3]);
+    }
+    if ((i + 1) % isr_every == 0) {
+      can_sim_run_irqs(0);
+      can_sim_run_irqs(1);
+    }
+
+    const uint32_t now_ms = HAL_GetTick();
+    if (now_ms != last_ms && now_ms >= stall_until_ms) {
+      last_ms = now_ms;
+      can_rx_process();
+    }
+  }
+
+  // Drain what is left.
+  can_sim_run_irqs(0);
+  can_sim_run_irqs(1);
+  can_rx_process();
+}
+
+/**
+ * @brief Print the RX statistics of a scenario.
+ */
+static void report(const baseline_t *base) {
+  const can_rx_stats_t *rx = can_rx_get_stats();
+
+  printf("  injected %u, accepted %u, received %u, dispatched %u\n",
+         tally.injected, tally.accepted, rx->received - base->rx.received,
+         rx->dispatched - base->rx.dispatched);
+  printf("  ring_overflow %u, fifo_overrun %u (frames lost %u), "
+         "high_water %u, gaps %u\n",
+         rx->ring_overflow - base->rx.ring_overflow,
+         rx->fifo_overrun - base->rx.fifo_overrun,
+         can_sim_fifo_lost(0) + can_sim_fifo_lost(1) - base->fifo_lost[0] -
+             base->fifo_lost[1],
+         rx->high_water, tally.gaps);
+}
+
+/**
+ * @brief Scenario 1: the consumer and interrupts keep up with both buses.
+ */
+static void scenario_keeping_up(void) {
+  baseline_t base;
+  scenario_start("1. Keeping up (1 s, interrupt per frame)", &base);
+  run_traffic(1000000U / can_sim_frame_us(8), 0, 1, 0);
+  report(&base);
+
+  const can_rx_stats_t *rx = can_rx_get_stats();
+  CHECK(tally.accepted == tally.injected * 2 / 3);
+  CHECK(rx->received - base.rx.received == tally.accepted);
+  CHECK(rx->dispatched - base.rx.dispatched == tally.accepted);
+  CHECK(rx->ring_overflow == base.rx.ring_overflow);
+  CHECK(rx->fifo_overrun == base.rx.fifo_overrun);
+  CHECK(can_fault_count == base.faults);
+  CHECK(tally.handled == tally.accepted);
+  CHECK(tally.out_of_order == 0);
+  CHECK(tally.gaps == 0);
+  CHECK(rx->high_water < CAN_RX_RING_SIZE / 2);
+}
+
+/**
+ * @brief Scenario 2: the consumer stalls, the RX ring overflows.
+ */
+static void scenario_stalled_consumer(void) {
+  baseline_t base;
+  scenario_start("2. Stalled consumer (20 ms)", &base);
+  const uint32_t frames = 2 * STALL_MS * 1000U / can_sim_frame_us(8);
+  run_traffic(frames, 1, 1, HAL_GetTick() + STALL_MS);
+  report(&base);
+
+  const can_rx_stats_t *rx = can_rx_get_stats();
+  const uint32_t received = rx->received - base.rx.received;
+  const uint32_t ring_overflow = rx->ring_overflow - base.rx.ring_overflow;
+  CHECK(tally.accepted == tally.injected);
+  CHECK(ring_overflow > 0);
+  CHECK(received + ring_overflow == tally.accepted);
+  CHECK(rx->dispatched - base.rx.dispatched == received);
+  CHECK(rx->fifo_overrun == base.rx.fifo_overrun);
+  CHECK(can_fault_count == base.faults);
+  CHECK(rx->high_water == CAN_RX_RING_SIZE);
+  CHECK(tally.handled == received);
+  CHECK(tally.out_of_order == 0);
+  CHECK(tally.gaps > 0 && tally.gaps <= ring_overflow);
+}
+
+/**
+ * @brief Scenario 3: the RX interrupt is late, the hardware FIFOs overrun.
+ */
+static void scenario_interrupt_latency(void) {
+  baseline_t base;
+  scenario_start("3. Interrupt latency (4 frames, 100 ms)", &base);
+  const uint32_t frames = 100000U / can_sim_frame_us(8) / 4 * 4;
+  run_traffic(frames, 1, 4, 0);
+  report(&base);
+
+  const can_rx_stats_t *rx = can_rx_get_stats();
+  const uint32_t fifo_overrun = rx->fifo_overrun - base.rx.fifo_overrun;
+  const uint32_t fifo_lost = can_sim_fifo_lost(0) + can_sim_fifo_lost(1) -
+                             base.fifo_lost[0] - base.fifo_lost[1];
+  const uint32_t received = rx->received - base.rx.received;
+  // One frame overwritten per bus and interrupt, one error interrupt each.
+  CHECK(fifo_lost == 2 * frames / 4);
+  CHECK(fifo_overrun == fifo_lost);
+  CHECK(can_fault_count - base.faults == fifo_overrun);
+  CHECK(received + fifo_lost == tally.accepted);
+  CHECK(rx->dispatched - base.rx.dispatched == received);
+  CHECK(rx->ring_overflow == base.rx.ring_overflow);
+  CHECK(tally.handled == received);
+  CHECK(tally.out_of_order == 0);
+  CHECK(tally.gaps == fifo_lost);
+}
+
+/** User implementations of the generated RX handlers (overwriting weak). *****/
+
+void can_rx_command_a(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  handle(data);
+}
+
+void can_rx_isotp_request(CAN_RxHeaderTypeDef *header, uint8_t *data) {
+  (void)header;
+  handle(data);
+}
+
+/** Public functions. *********************************************************/
+
+int main(void) {
+  can_sim_init(CAN_SIM_BITRATE);
+  can_init();
+
+  scenario_keeping_up();
+  scenario_stalled_consumer();
+  scenario_interrupt_latency();
+
+  printf(failures ? "FAILED (%d)\n" : "PASSED\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/*******************************************************************************
+ * @file can_sim.c
+ * @brief Simulated bxCAN peripherals (CAN1 and CAN2) for host tests of can.c.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "can_sim.h"
+#include "logger.h"
+#include "systime.h"
+#include <string.h>
+
+/** Definitions. **************************************************************/
+
+#define SIM_FILTER_BANKS 28     // bxCAN banks shared by CAN1 and CAN2.
+#define SIM_PCLK1_HZ 45000000U  // APB1 clock.
+#define SIM_TQ_PER_BIT 15U      // 1 sync, 12 segment 1, 2 segment 2.
+#define SIM_CORE_HZ 180000000U  // SystemCoreClock (DWT cycles).
+#define SIM_FRAME_WORD_SHIFT 5U // 16-bit filter word, STID[10:0] << 5.
+
+/** Private types. ************************************************************/
+
+/**
+ * @brief Struct holding a configured 16-bit filter bank.
+ */
+typedef struct {
+  uint8_t active;    // Configured and enabled.
+  uint32_t mode;     // CAN_FILTERMODE_IDLIST or CAN_FILTERMODE_IDMASK.
+  uint32_t fifo;     // CAN_FILTER_FIFO0 or CAN_FILTER_FIFO1.
+  uint16_t words[4]; // ID low, mask ID low, ID high, mask ID high.
+} sim_filter_bank_t;
+
+/**
+ * @brief Struct holding a TX mailbox.
+ */
+typedef struct {
+  uint8_t used;           // Frame loaded.
+  uint8_t aborting;       // Abort requested, callback pending.
+  can_sim_frame_t frame;  // Loaded frame.
+} sim_mailbox_t;
+
+/**
+ * @brief Struct holding the state of one simulated bus.
+ */
+typedef struct {
+  can_sim_frame_t fifo[2][CAN_SIM_FIFO_DEPTH]; // RX FIFOs, oldest first.
+  uint8_t fifo_level[2];                       // Frames in each RX FIFO.
+  uint32_t fifo_lost;                          // Frames overwritten.
+  uint32_t error_pending;                      // HAL_CAN_ERROR_* bits.
+  sim_mailbox_t mailbox[CAN_TX_MAILBOX_COUNT]; // TX mailboxes.
+  uint8_t started;                             // HAL_CAN_Start called.
+  uint32_t starts;                             // HAL_CAN_Start calls.
+} sim_bus_t;
+
+/** Public variables. *********************************************************/
+
+CAN_HandleTypeDef hcan1;
+CAN_HandleTypeDef hcan2;
+
+CAN_TypeDef can_sim_instances[2];
+DWT_Type can_sim_dwt;
+uint32_t SystemCoreClock = SIM_CORE_HZ;
+
+/** Private variables. ********************************************************/
+
+static CAN_HandleTypeDef *const handles[2] = {&hcan1, &hcan2};
+static sim_bus_t sim_buses[2];
+static sim_filter_bank_t filter_banks[SIM_FILTER_BANKS];
+static uint32_t slave_start_bank = SIM_FILTER_BANKS;
+static uint64_t now_us = 0;
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Get the simulated bus of a CAN handle.
+ */
+static sim_bus_t *bus_of(const CAN_HandleTypeDef *hcan) {
+  return &sim_buses[hcan->Instance == CAN2 ? 1 : 0];
+}
+
+/**
+ * @brief Match a frame against the filter banks of a bus, as bxCAN does.
+ *
+ * @return FIFO index, or -1 if rejected.
+ */
+static int filter_match(uint8_t bus, uint32_t std_id) {
+  const uint16_t word = (uint16_t)((std_id & 0x7FFU) << SIM_FRAME_WORD_SHIFT);
+  const uint32_t first = bus == 0 ? 0 : slave_start_bank;
+  const uint32_t last = bus == 0 ? slave_start_bank : SIM_FILTER_BANKS;
+
+  for (uint32_t b = first; b < last; b++) {
+    const sim_filter_bank_t *bank = &filter_banks[b];
+    if (!bank->active) {
+      continue;
+    }
+    if (bank->mode == CAN_FILTERMODE_IDLIST) {
+      for (uint8_t i = 0; i < 4; i++) {
+        if (word == bank->words[i]) {
+          return (int)bank->fifo;
+        }
+      }
+    } else {
+      for (uint8_t i = 0; i < 4; i += 2) {
+        if (((word ^ bank->words[i]) & bank->words[i + 1]) == 0) {
+          return (int)bank->fifo;
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+/** Public functions. *********************************************************/
+
+void can_sim_init(uint32_t bitrate) {
+  memset(sim_buses, 0, sizeof(sim_buses));
+  memset(filter_banks, 0, sizeof(filter_banks));
+  for (uint8_t b = 0; b < 2; b++) {
+    handles[b]->Instance = &can_sim_instances[b];
+    handles[b]->Init.Prescaler = SIM_PCLK1_HZ / (SIM_TQ_PER_BIT * bitrate);
+    handles[b]->Init.TimeSeg1 = 11U << CAN_BTR_TS1_Pos; // 12 time quanta.
+    handles[b]->Init.TimeSeg2 = 1U << CAN_BTR_TS2_Pos;  // 2 time quanta.
+    handles[b]->ErrorCode = 0;
+    can_sim_instances[b].ESR = 0;
+  }
+}
+
+void can_sim_advance_us(uint32_t us) {
+  now_us += us;
+  can_sim_dwt.CYCCNT = (uint32_t)(now_us * (SystemCoreClock / 1000000U));
+}
+
+uint64_t can_sim_time_us(void) { return now_us; }
+
+uint32_t can_sim_frame_us(uint8_t dlc) {
+  // SOF, ID, RTR, IDE, r0, DLC, data, CRC, delimiters, ACK, EOF, IFS.
+  return (47U + 8U * dlc) * (1000000U / CAN_SIM_BITRATE);
+}
+
+can_sim_rx_t can_sim_receive(uint8_t bus, const can_sim_frame_t *frame) {
+  sim_bus_t *sim = &sim_buses[bus];
+  const int fifo = filter_match(bus, frame->std_id);
+
+  if (fifo < 0 || !sim->started) {
+    return CAN_SIM_FILTERED;
+  }
+  if (sim->fifo_level[fifo] == CAN_SIM_FIFO_DEPTH) {
+    // FIFO not locked (ReceiveFifoLocked = DISABLE), last frame overwritten.
+    sim->fifo[fifo][CAN_SIM_FIFO_DEPTH - 1] = *frame;
+    sim->fifo_lost++;
+    sim->error_pending |= fifo == 0 ? HAL_CAN_ERROR_RX_FOV0
+                                    : HAL_CAN_ERROR_RX_FOV1;
+    return CAN_SIM_OVERRUN;
+  }
+  sim->fifo[fifo][sim->fifo_level[fifo]++] = *frame;
+  return fifo == 0 ? CAN_SIM_FIFO0 : CAN_SIM_FIFO1;
+}
+
+uint8_t can_sim_irq_pending(uint8_t bus) {
+  const sim_bus_t *sim = &sim_buses[bus];
+
+  if (sim->fifo_level[0] || sim->fifo_level[1] || sim->error_pending) {
+    return 1;
+  }
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if (sim->mailbox[m].aborting) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void can_sim_run_irqs(uint8_t bus) {
+  static void (*const abort_callbacks[CAN_TX_MAILBOX_COUNT])(
+      CAN_HandleTypeDef *) = {HAL_CAN_TxMailbox0AbortCallback_can,
+                              HAL_CAN_TxMailbox1AbortCallback_can,
+                              HAL_CAN_TxMailbox2AbortCallback_can};
+  CAN_HandleTypeDef *hcan = handles[bus];
+  sim_bus_t *sim = &sim_buses[bus];
+
+  // NVIC order: RX0, RX1, SCE (error), TX.
+  if (sim->fifo_level[0]) {
+    HAL_CAN_RxFifo0MsgPendingCallback_can(hcan);
+  }
+  if (sim->fifo_level[1]) {
+    HAL_CAN_RxFifo1MsgPendingCallback_can(hcan);
+  }
+  if (sim->error_pending) {
+    hcan->ErrorCode |= sim->error_pending;
+    sim->error_pending = 0;
+    HAL_CAN_ErrorCallback_can(hcan);
+  }
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if (sim->mailbox[m].aborting) {
+      sim->mailbox[m].used = 0;
+      sim->mailbox[m].aborting = 0;
+      abort_callbacks[m](hcan);
+    }
+  }
+}
+
+uint8_t can_sim_transmit(uint8_t bus, can_sim_frame_t *frame) {
+  static void (*const complete_callbacks[CAN_TX_MAILBOX_COUNT])(
+      CAN_HandleTypeDef *) = {HAL_CAN_TxMailbox0CompleteCallback_can,
+                              HAL_CAN_TxMailbox1CompleteCallback_can,
+                              HAL_CAN_TxMailbox2CompleteCallback_can};
+  sim_bus_t *sim = &sim_buses[bus];
+  int8_t next = -1;
+
+  // Lowest ID first (TransmitFifoPriority = DISABLE).
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if (sim->mailbox[m].used && !sim->mailbox[m].aborting &&
+        (next < 0 ||
+         sim->mailbox[m].frame.std_id < sim->mailbox[next].frame.std_id)) {
+      next = (int8_t)m;
+    }
+  }
+  if (next < 0) {
+    return 0;
+  }
+  if (frame) {
+    *frame = sim->mailbox[next].frame;
+  }
+  sim->mailbox[next].used = 0;
+  complete_callbacks[next](handles[bus]);
+  return 1;
+}
+
+void can_sim_set_esr(uint8_t bus, uint32_t esr) {
+  can_sim_instances[bus].ESR = esr;
+}
+
+uint32_t can_sim_fifo_lost(uint8_t bus) { return sim_buses[bus].fifo_lost; }
+
+uint32_t can_sim_starts(uint8_t bus) { return sim_buses[bus].starts; }
+
+/** Simulated STM32 HAL. ******************************************************/
+
+uint32_t HAL_GetTick(void) { return (uint32_t)(now_us / 1000U); }
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) { return SIM_PCLK1_HZ; }
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan,
+                                       const CAN_FilterTypeDef *filter) {
+  (void)hcan; // Banks are shared, CAN2 uses those from the slave start bank.
+  if (filter->FilterBank >= SIM_FILTER_BANKS ||
+      filter->FilterScale != CAN_FILTERSCALE_16BIT) {
+    return HAL_ERROR;
+  }
+  sim_filter_bank_t *bank = &filter_banks[filter->FilterBank];
+
+  slave_start_bank = filter->SlaveStartFilterBank;
+  bank->active = filter->FilterActivation == CAN_FILTER_ENABLE;
+  bank->mode = filter->FilterMode;
+  bank->fifo = filter->FilterFIFOAssignment;
+  bank->words[0] = (uint16_t)filter->FilterIdLow;
+  bank->words[1] = (uint16_t)filter->FilterMaskIdLow;
+  bank->words[2] = (uint16_t)filter->FilterIdHigh;
+  bank->words[3] = (uint16_t)filter->FilterMaskIdHigh;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan) {
+  sim_bus_t *sim = bus_of(hcan);
+
+  sim->started = 1;
+  sim->starts++;
+  hcan->Instance->ESR = 0; // Bus-off left, error counters cleared.
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan) {
+  bus_of(hcan)->started = 0;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan,
+                                               uint32_t its) {
+  (void)hcan;
+  (void)its; // All interrupts delivered by can_sim_run_irqs.
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan,
+                                       const CAN_TxHeaderTypeDef *header,
+                                       const uint8_t data[],
+                                       uint32_t *mailbox) {
+  sim_bus_t *sim = bus_of(hcan);
+
+  if (!sim->started) {
+    return HAL_ERROR;
+  }
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if (!sim->mailbox[m].used) {
+      sim->mailbox[m].used = 1;
+      sim->mailbox[m].frame.std_id = header->StdId;
+      sim->mailbox[m].frame.dlc = (uint8_t)header->DLC;
+      memcpy(sim->mailbox[m].frame.data, data, header->DLC);
+      *mailbox = CAN_TX_MAILBOX0 << m;
+      return HAL_OK;
+    }
+  }
+  return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef *hcan,
+                                         uint32_t mailboxes) {
+  sim_bus_t *sim = bus_of(hcan);
+
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    if ((mailboxes & (CAN_TX_MAILBOX0 << m)) && sim->mailbox[m].used) {
+      sim->mailbox[m].aborting = 1; // Abort callback on the next interrupt.
+    }
+  }
+  return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan) {
+  const sim_bus_t *sim = bus_of(hcan);
+  uint32_t free_level = 0;
+
+  for (uint8_t m = 0; m < CAN_TX_MAILBOX_COUNT; m++) {
+    free_level += sim->mailbox[m].used ? 0 : 1;
+  }
+  return free_level;
+}
+
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef *hcan,
+                                       uint32_t fifo,
+                                       CAN_RxHeaderTypeDef *header,
+                                       uint8_t data[]) {
+  sim_bus_t *sim = bus_of(hcan);
+
+  if (sim->fifo_level[fifo] == 0) {
+    return HAL_ERROR;
+  }
+  const can_sim_frame_t *frame = &sim->fifo[fifo][0];
+  memset(header, 0, sizeof(*header));
+  header->StdId = frame->std_id;
+  header->IDE = CAN_ID_STD;
+  header->RTR = CAN_RTR_DATA;
+  header->DLC = frame->dlc;
+  memcpy(data, frame->data, 8);
+
+  sim->fifo_level[fifo]--;
+  memmove(&sim->fifo[fifo][0], &sim->fifo[fifo][1],
+          sim->fifo_level[fifo] * sizeof(can_sim_frame_t));
+  return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetRxFifoFillLevel(const CAN_HandleTypeDef *hcan,
+                                    uint32_t fifo) {
+  return bus_of(hcan)->fifo_level[fifo];
+}
+
+/** Simulated system time and logger. *****************************************/
+
+uint32_t systime_us32(void) { return (uint32_t)now_us; }
+
+uint8_t logger_write_at(log_record_type_t type, const void *payload,
+                        uint8_t length, uint32_t timestamp_us) {
+  (void)type;
+  (void)payload;
+  (void)length;
+  (void)timestamp_us;
+  return 1;
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * @file can_sim.h
+ * @brief Simulated bxCAN peripherals (CAN1 and CAN2) for host tests of can.c.
+ *
+ * Each bus has the 16-bit acceptance filter banks configured by can_init, two
+ * 3 frame RX FIFOs (not locked: a 4th frame overwrites the last one, with an
+ * overrun error) and 3 TX mailboxes. Interrupts are delivered when the test
+ * calls can_sim_run_irqs, so interrupt latency is under test control. Time is
+ * simulated (us), driving HAL_GetTick, systime_us32 and the DWT cycle counter.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__CAN_SIM_H
+#define NERVE__CAN_SIM_H
+
+/** Includes. *****************************************************************/
+
+#include "can.h"
+#include <stdint.h>
+
+/** Definitions. **************************************************************/
+
+#define CAN_SIM_FIFO_DEPTH 3     // bxCAN RX FIFO depth (frames).
+#define CAN_SIM_BITRATE 1000000U // Simulated bus rate (bit/s), 1 us per bit.
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Enumeration for the can_sim_receive results.
+ */
+typedef enum {
+  CAN_SIM_FILTERED = 0, // Rejected by the acceptance filters.
+  CAN_SIM_FIFO0,        // Stored in FIFO0.
+  CAN_SIM_FIFO1,        // Stored in FIFO1.
+  CAN_SIM_OVERRUN       // FIFO full, the last stored frame was overwritten.
+} can_sim_rx_t;
+
+/**
+ * @brief Struct holding a simulated CAN frame.
+ */
+typedef struct {
+  uint32_t std_id; // Standard CAN ID.
+  uint8_t dlc;     // Data Length Code.
+  uint8_t data[8]; // Payload.
+} can_sim_frame_t;
+
+/** Public functions. *********************************************************/
+
+/**
+ * @brief Set up both buses, before can_init (can.c state is not reset).
+ *
+ * @param bitrate Nominal bitrate of the hcan1 and hcan2 bit timing, a divisor
+ *                of 3 MHz (15 time quanta of a 45 MHz clock).
+ */
+void can_sim_init(uint32_t bitrate);
+
+/**
+ * @brief Advance the simulated time.
+ *
+ * @param us Microseconds.
+ */
+void can_sim_advance_us(uint32_t us);
+
+/**
+ * @brief Get the simulated time.
+ *
+ * @return Microseconds since can_sim_init.
+ */
+uint64_t can_sim_time_us(void);
+
+/**
+ * @brief Bus time of an unstuffed standard data frame and interframe space.
+ *
+ * @param dlc Data Length Code.
+ *
+ * @return Microseconds at CAN_SIM_BITRATE.
+ */
+uint32_t can_sim_frame_us(uint8_t dlc);
+
+/**
+ * @brief Complete the reception of a frame on a bus (filters, then FIFOs).
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ * @param frame Received frame.
+ *
+ * @return Where the frame went.
+ */
+can_sim_rx_t can_sim_receive(uint8_t bus, const can_sim_frame_t *frame);
+
+/**
+ * @brief Check if a bus has an interrupt pending.
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ *
+ * @return 1 if FIFO messages, an error or a TX abort are pending.
+ */
+uint8_t can_sim_irq_pending(uint8_t bus);
+
+/**
+ * @brief Run the pending interrupts of a bus (RX FIFO, error, TX abort).
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ */
+void can_sim_run_irqs(uint8_t bus);
+
+/**
+ * @brief Transmit the highest priority loaded TX mailbox of a bus.
+ *
+ * Runs the mailbox complete interrupt, which refills it from the TX queue.
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ * @param frame Transmitted frame, NULL if not needed.
+ *
+ * @return 1 if a frame was transmitted, 0 if no mailbox is loaded.
+ */
+uint8_t can_sim_transmit(uint8_t bus, can_sim_frame_t *frame);
+
+/**
+ * @brief Set the error status register of a bus (bus-off, error counters).
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ * @param esr CAN_ESR value.
+ */
+void can_sim_set_esr(uint8_t bus, uint32_t esr);
+
+/**
+ * @brief Get the frames overwritten in the RX FIFOs of a bus (overruns).
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ *
+ * @return Frames lost in hardware.
+ */
+uint32_t can_sim_fifo_lost(uint8_t bus);
+
+/**
+ * @brief Get the controller starts of a bus (can_init, bus-off recovery).
+ *
+ * @param bus Bus index, 0: CAN1, 1: CAN2.
+ *
+ * @return HAL_CAN_Start calls.
+ */
+uint32_t can_sim_starts(uint8_t bus);
+
+#endif
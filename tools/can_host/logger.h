@@ -0,0 +1,27 @@
+/*******************************************************************************
+ * @file logger.h
+ * @brief Host stand-in for Core/Inc/logger.h, CAN frame records only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__LOGGER_H
+#define NERVE__LOGGER_H
+
+#include <stdint.h>
+
+typedef enum { LOG_RECORD_CAN_FRAME = 8 } log_record_type_t; // Same value.
+
+typedef struct {
+  uint16_t std_id;
+  uint8_t flags;
+  uint8_t dlc;
+  uint8_t data[8];
+} log_can_frame_t;
+
+#define LOG_CAN_FLAG_CAN2 0x01
+#define LOG_CAN_FLAG_TX 0x02
+
+uint8_t logger_write_at(log_record_type_t type, const void *payload,
+                        uint8_t length, uint32_t timestamp_us);
+
+#endif
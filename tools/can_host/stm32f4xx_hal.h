@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32 HAL (bxCAN, DWT and core intrinsics).
+ *
+ * Only the types, registers and constants used by Core/Src/can.c and the
+ * generated can_nerve.c, values as in the STM32F4 HAL and CMSIS headers. The
+ * peripherals are simulated by can_sim.c.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__STM32F4XX_HAL_H
+#define NERVE__STM32F4XX_HAL_H
+
+#include <stdint.h>
+
+#define __weak __attribute__((weak))
+#define __IO volatile
+
+typedef enum {
+  HAL_OK = 0x00U,
+  HAL_ERROR = 0x01U,
+  HAL_BUSY = 0x02U,
+  HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+/** Cortex-M4 core. ***********************************************************/
+
+typedef struct {
+  __IO uint32_t CYCCNT; // Simulated time (us) times SystemCoreClock.
+} DWT_Type;
+
+extern DWT_Type can_sim_dwt;
+#define DWT (&can_sim_dwt)
+
+extern uint32_t SystemCoreClock;
+
+// Single core, interrupts run when the simulation calls them.
+#define __DMB() __sync_synchronize()
+#define __disable_irq() ((void)0)
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+
+/** bxCAN. ********************************************************************/
+
+typedef struct {
+  __IO uint32_t ESR; // Error status register.
+} CAN_TypeDef;
+
+extern CAN_TypeDef can_sim_instances[2];
+#define CAN1 (&can_sim_instances[0])
+#define CAN2 (&can_sim_instances[1])
+
+#define CAN_ESR_EWGF_Pos (0U)
+#define CAN_ESR_EWGF (0x1UL << CAN_ESR_EWGF_Pos)
+#define CAN_ESR_EPVF_Pos (1U)
+#define CAN_ESR_EPVF (0x1UL << CAN_ESR_EPVF_Pos)
+#define CAN_ESR_BOFF_Pos (2U)
+#define CAN_ESR_BOFF (0x1UL << CAN_ESR_BOFF_Pos)
+#define CAN_ESR_LEC_Pos (4U)
+#define CAN_ESR_LEC (0x7UL << CAN_ESR_LEC_Pos)
+#define CAN_ESR_TEC_Pos (16U)
+#define CAN_ESR_TEC (0xFFUL << CAN_ESR_TEC_Pos)
+#define CAN_ESR_REC_Pos (24U)
+#define CAN_ESR_REC (0xFFUL << CAN_ESR_REC_Pos)
+
+#define CAN_BTR_TS1_Pos (16U)
+#define CAN_BTR_TS2_Pos (20U)
+#define CAN_BS1_15TQ (0xEUL << CAN_BTR_TS1_Pos)
+#define CAN_BS2_2TQ (0x1UL << CAN_BTR_TS2_Pos)
+
+typedef struct {
+  uint32_t Prescaler;
+  uint32_t TimeSeg1;
+  uint32_t TimeSeg2;
+} CAN_InitTypeDef;
+
+typedef struct {
+  CAN_TypeDef *Instance;
+  CAN_InitTypeDef Init;
+  __IO uint32_t ErrorCode;
+} CAN_HandleTypeDef;
+
+typedef struct {
+  uint32_t FilterIdHigh;
+  uint32_t FilterIdLow;
+  uint32_t FilterMaskIdHigh;
+  uint32_t FilterMaskIdLow;
+  uint32_t FilterFIFOAssignment;
+  uint32_t FilterBank;
+  uint32_t FilterMode;
+  uint32_t FilterScale;
+  uint32_t FilterActivation;
+  uint32_t SlaveStartFilterBank;
+} CAN_FilterTypeDef;
+
+typedef struct {
+  uint32_t StdId;
+  uint32_t ExtId;
+  uint32_t IDE;
+  uint32_t RTR;
+  uint32_t DLC;
+} CAN_TxHeaderTypeDef;
+
+typedef struct {
+  uint32_t StdId;
+  uint32_t ExtId;
+  uint32_t IDE;
+  uint32_t RTR;
+  uint32_t DLC;
+  uint32_t Timestamp;
+  uint32_t FilterMatchIndex;
+} CAN_RxHeaderTypeDef;
+
+#define HAL_CAN_ERROR_RX_FOV0 (0x00000200U)
+#define HAL_CAN_ERROR_RX_FOV1 (0x00000400U)
+#define HAL_CAN_ERROR_TX_ALST0 (0x00000800U)
+#define HAL_CAN_ERROR_TX_TERR0 (0x00001000U)
+#define HAL_CAN_ERROR_TX_ALST1 (0x00002000U)
+#define HAL_CAN_ERROR_TX_TERR1 (0x00004000U)
+#define HAL_CAN_ERROR_TX_ALST2 (0x00008000U)
+#define HAL_CAN_ERROR_TX_TERR2 (0x00010000U)
+
+#define CAN_FILTERMODE_IDMASK (0x00000000U)
+#define CAN_FILTERMODE_IDLIST (0x00000001U)
+#define CAN_FILTERSCALE_16BIT (0x00000000U)
+#define CAN_FILTER_ENABLE (0x00000001U)
+#define CAN_FILTER_FIFO0 (0x00000000U)
+#define CAN_FILTER_FIFO1 (0x00000001U)
+#define CAN_ID_STD (0x00000000U)
+#define CAN_RTR_DATA (0x00000000U)
+#define CAN_RX_FIFO0 (0x00000000U)
+#define CAN_RX_FIFO1 (0x00000001U)
+#define CAN_TX_MAILBOX0 (0x00000001U)
+#define CAN_TX_MAILBOX1 (0x00000002U)
+#define CAN_TX_MAILBOX2 (0x00000004U)
+
+#define CAN_IT_TX_MAILBOX_EMPTY (0x00000001U)
+#define CAN_IT_RX_FIFO0_MSG_PENDING (0x00000002U)
+#define CAN_IT_RX_FIFO0_OVERRUN (0x00000008U)
+#define CAN_IT_RX_FIFO1_MSG_PENDING (0x00000010U)
+#define CAN_IT_RX_FIFO1_OVERRUN (0x00000040U)
+
+/** HAL functions (can_sim.c). ************************************************/
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan,
+                                       const CAN_FilterTypeDef *filter);
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan,
+                                               uint32_t its);
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan,
+                                       const CAN_TxHeaderTypeDef *header,
+                                       const uint8_t data[],
+                                       uint32_t *mailbox);
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef *hcan,
+                                         uint32_t mailboxes);
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef *hcan,
+                                       uint32_t fifo,
+                                       CAN_RxHeaderTypeDef *header,
+                                       uint8_t data[]);
+uint32_t HAL_CAN_GetRxFifoFillLevel(const CAN_HandleTypeDef *hcan,
+                                    uint32_t fifo);
+
+#endif
@@ -0,0 +1,5 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal_can.h
+ * @brief Host stand-in, the bxCAN HAL is declared in stm32f4xx_hal.h.
+ *******************************************************************************
+ */
@@ -0,0 +1,5 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal_rtc.h
+ * @brief Host stand-in (included by configuration.h), nothing used.
+ *******************************************************************************
+ */
@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal_tim.h
+ * @brief Host stand-in (included by systime.h), handles declared only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__STM32F4XX_HAL_TIM_H
+#define NERVE__STM32F4XX_HAL_TIM_H
+
+typedef struct {
+  int unused;
+} TIM_HandleTypeDef;
+
+#endif
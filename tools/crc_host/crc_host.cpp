@@ -0,0 +1,252 @@
+/*******************************************************************************
+ * @file crc_host.cpp
+ * @brief Host known answer and split update test of crc.c.
+ *
+ * Runs Core/Src/crc.c unchanged (compiled as C++ for the simulated CRC unit
+ * registers, see stm32f4xx_hal.h) and checks:
+ *     - The catalogue check values of "123456789": CRC-32/ISO-HDLC CBF43926,
+ *       CRC-16/CCITT-FALSE 29B1, CRC-8/DVB-S2 BC (table and software paths).
+ *     - CRC-32 known answers (zlib) of buffers taking the hardware unit path.
+ *     - All lengths 0 to 300 at each alignment against bitwise references,
+ *       the hardware and software CRC-32 paths agreeing.
+ *     - Updates split at every position matching the whole buffer CRC.
+ *
+ * Build and run (from the repository root):
+ *     g++ -std=c++17 -O2 -Itools/crc_host -ICore/Inc -x c++ Core/Src/crc.c \
+ *         -x none tools/crc_host/crc_host.cpp -o crc_host
+ *     ./crc_host
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "crc.h"
+#include <cstdio>
+#include <cstring>
+
+/** Definitions. **************************************************************/
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      std::printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);            \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+#define SWEEP_LENGTH 300 // Longest buffer of the length sweep.
+#define SPLIT_LENGTH 200 // Buffer split at every position.
+
+/** Private variables. ********************************************************/
+
+static const uint8_t check_string[] = "123456789"; // Catalogue check input.
+static const size_t check_length = 9;
+
+static uint32_t crc_sim_register = 0xFFFFFFFF; // CRC unit data register.
+static int failures = 0;
+
+/** Public variables. *********************************************************/
+
+CRC_TypeDef crc_sim;
+uint32_t crc_sim_clock_enables = 0;
+uint32_t crc_sim_words = 0;
+
+/** Simulated CRC unit. *******************************************************/
+
+// MSB first CRC-32 (polynomial 0x04C11DB7) of one word, as the STM32F4 unit.
+CrcSimData &CrcSimData::operator=(uint32_t word) {
+  crc_sim_register ^= word;
+  for (int i = 0; i < 32; i++) {
+    crc_sim_register = (crc_sim_register & 0x80000000U)
+                           ? (crc_sim_register << 1) ^ 0x04C11DB7U
+                           : crc_sim_register << 1;
+  }
+  crc_sim_words++;
+  return *this;
+}
+
+CrcSimData::operator uint32_t() const { return crc_sim_register; }
+
+CrcSimControl &CrcSimControl::operator=(uint32_t value) {
+  if (value & CRC_CR_RESET) {
+    crc_sim_register = 0xFFFFFFFF;
+  }
+  return *this;
+}
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Bitwise CRC-32/ISO-HDLC (reflected 0xEDB88320, init and xor out ~0).
+ */
+static uint32_t ref_crc32(const uint8_t *data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 1U) ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+/**
+ * @brief Bitwise CRC-16/CCITT-FALSE (0x1021, init 0xFFFF).
+ */
+static uint16_t ref_crc16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc ^= (uint16_t)(*data++ << 8);
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U)
+                            : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Bitwise CRC-8/DVB-S2 (0xD5, init 0).
+ */
+static uint8_t ref_crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+  while (length--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ 0xD5U) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Fill a buffer with a reproducible pseudo random pattern.
+ */
+static void fill_pattern(uint8_t *data, size_t length) {
+  uint32_t state = 0x12345678;
+  for (size_t i = 0; i < length; i++) {
+    state = state * 1664525U + 1013904223U; // Numerical Recipes LCG.
+    data[i] = (uint8_t)(state >> 24);
+  }
+}
+
+/**
+ * @brief Catalogue check values of "123456789", software and table paths.
+ */
+static void test_check_values(void) {
+  std::printf("Check values (\"123456789\")\n");
+  const uint32_t words = crc_sim_words;
+
+  CHECK(crc32(check_string, check_length) == 0xCBF43926U);
+  CHECK(crc32_update(0, check_string, check_length) == 0xCBF43926U);
+  CHECK(crc32_sw_update(0, check_string, check_length) == 0xCBF43926U);
+  CHECK(crc16_ccitt(check_string, check_length) == 0x29B1U);
+  CHECK(crc16_ccitt_update(CRC16_CCITT_INIT, check_string, check_length) ==
+        0x29B1U);
+  CHECK(crc8_dvb_s2(check_string, check_length) == 0xBCU);
+
+  uint8_t crc8 = 0;
+  for (size_t i = 0; i < check_length; i++) {
+    crc8 = crc8_dvb_s2_update(crc8, check_string[i]);
+  }
+  CHECK(crc8 == 0xBCU);
+  CHECK(crc_sim_words == words); // Under CRC32_HW_MIN_LENGTH, software only.
+}
+
+/**
+ * @brief CRC-32 known answers through the simulated hardware unit.
+ */
+static void test_hardware_path(void) {
+  std::printf("CRC-32 hardware unit path (>= %d bytes)\n",
+              CRC32_HW_MIN_LENGTH);
+  uint8_t repeated[8 * 9];
+  uint8_t zeros[64] = {0};
+  uint8_t ones[64];
+
+  for (size_t i = 0; i < sizeof(repeated); i++) {
+    repeated[i] = check_string[i % check_length];
+  }
+  std::memset(ones, 0xFF, sizeof(ones));
+
+  const uint32_t words = crc_sim_words;
+  CHECK(crc32(repeated, sizeof(repeated)) == 0x8811A440U); // zlib.crc32.
+  CHECK(crc_sim_words - words == sizeof(repeated) / 4);
+  CHECK(crc32(zeros, sizeof(zeros)) == 0x758D6336U);
+  CHECK(crc32(ones, sizeof(ones)) == 0x0F6187BAU);
+  CHECK(crc32_sw_update(0, repeated, sizeof(repeated)) == 0x8811A440U);
+  CHECK(crc_sim_words - words == (sizeof(repeated) + 2 * 64) / 4);
+  CHECK(crc_sim_clock_enables == 1); // Enabled once, on first use.
+}
+
+/**
+ * @brief All lengths at each alignment against the bitwise references.
+ */
+static void test_length_sweep(void) {
+  std::printf("Lengths 0 to %d at alignments 0 to 3\n", SWEEP_LENGTH);
+  uint8_t buffer[SWEEP_LENGTH + 3];
+  int mismatches = 0;
+
+  fill_pattern(buffer, sizeof(buffer));
+  for (size_t align = 0; align < 4; align++) {
+    const uint8_t *data = buffer + align;
+    for (size_t length = 0; length <= SWEEP_LENGTH; length++) {
+      const uint32_t expected32 = ref_crc32(data, length);
+      mismatches += crc32(data, length) != expected32;
+      mismatches += crc32_sw_update(0, data, length) != expected32;
+      mismatches += crc16_ccitt(data, length) != ref_crc16(data, length);
+      mismatches += crc8_dvb_s2(data, length) != ref_crc8(data, length);
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+/**
+ * @brief Updates split at every position match the whole buffer CRC.
+ */
+static void test_split_updates(void) {
+  std::printf("Split updates (%d bytes, every split)\n", SPLIT_LENGTH);
+  uint8_t data[SPLIT_LENGTH];
+  int mismatches = 0;
+
+  fill_pattern(data, sizeof(data));
+  const uint32_t whole32 = crc32(data, sizeof(data));
+  const uint16_t whole16 = crc16_ccitt(data, sizeof(data));
+  const uint8_t whole8 = crc8_dvb_s2(data, sizeof(data));
+
+  for (size_t split = 0; split <= sizeof(data); split++) {
+    const size_t rest = sizeof(data) - split;
+
+    // Hardware then software path (split >= CRC32_HW_MIN_LENGTH).
+    uint32_t crc32_value = crc32_update(0, data, split);
+    crc32_value = crc32_update(crc32_value, data + split, rest);
+    mismatches += crc32_value != whole32;
+
+    crc32_value = crc32_sw_update(0, data, split);
+    crc32_value = crc32_sw_update(crc32_value, data + split, rest);
+    mismatches += crc32_value != whole32;
+
+    uint16_t crc16_value = crc16_ccitt_update(CRC16_CCITT_INIT, data, split);
+    crc16_value = crc16_ccitt_update(crc16_value, data + split, rest);
+    mismatches += crc16_value != whole16;
+
+    uint8_t crc8_value = crc8_dvb_s2(data, split);
+    for (size_t i = split; i < sizeof(data); i++) {
+      crc8_value = crc8_dvb_s2_update(crc8_value, data[i]);
+    }
+    mismatches += crc8_value != whole8;
+  }
+  CHECK(whole32 == ref_crc32(data, sizeof(data)));
+  CHECK(mismatches == 0);
+}
+
+/** Public functions. *********************************************************/
+
+int main() {
+  test_check_values();
+  test_hardware_path();
+  test_length_sweep();
+  test_split_updates();
+
+  std::printf(failures ? "FAILED (%d)\n" : "PASSED\n", failures);
+  return failures ? 1 : 0;
+}
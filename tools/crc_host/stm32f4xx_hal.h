@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32 HAL (CRC unit and core intrinsics).
+ *
+ * Only what Core/Src/crc.c uses. The CRC unit data and control registers are
+ * C++ proxies so that writes run the simulated unit (crc_host.cpp), crc.c is
+ * compiled as C++ for this.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__STM32F4XX_HAL_H
+#define NERVE__STM32F4XX_HAL_H
+
+#ifndef __cplusplus
+#error "Compile Core/Src/crc.c as C++ (-x c++) with this stand-in."
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Cortex-M4 core. ***********************************************************/
+
+/**
+ * @brief Reverse the bit order of a word (RBIT instruction).
+ */
+static inline uint32_t __RBIT(uint32_t value) {
+  uint32_t result = 0;
+  for (int i = 0; i < 32; i++) {
+    result = (result << 1) | ((value >> i) & 1U);
+  }
+  return result;
+}
+
+/** CRC unit. *****************************************************************/
+
+/**
+ * @brief CRC_DR proxy, a write feeds one word, a read returns the CRC.
+ */
+struct CrcSimData {
+  CrcSimData &operator=(uint32_t word);
+  operator uint32_t() const;
+};
+
+/**
+ * @brief CRC_CR proxy, writing CRC_CR_RESET resets the CRC to 0xFFFFFFFF.
+ */
+struct CrcSimControl {
+  CrcSimControl &operator=(uint32_t value);
+};
+
+typedef struct {
+  CrcSimData DR;
+  CrcSimControl CR;
+} CRC_TypeDef;
+
+extern CRC_TypeDef crc_sim;
+extern uint32_t crc_sim_clock_enables; // __HAL_RCC_CRC_CLK_ENABLE calls.
+extern uint32_t crc_sim_words;         // Words written to CRC_DR.
+
+#define CRC (&crc_sim)
+#define CRC_CR_RESET (0x1UL)
+#define __HAL_RCC_CRC_CLK_ENABLE() (crc_sim_clock_enables++)
+
+#endif
@@ -0,0 +1,155 @@
+"""CRC lookup table generator for Core/Src/crc.c.
+
+Generate the CRC-8/DVB-S2 table and the CRC-16/CCITT-FALSE and CRC-32/ISO-HDLC
+slice-by-4 tables (4 x 256, index [k] holds the CRC of a byte followed by k
+zero bytes) as C source, formatted as in crc.c (clang-format).
+
+Usage:
+    ```shell
+    python3 tools/crc_tables.py  # Print the tables.
+    python3 tools/crc_tables.py --check Core/Src/crc.c  # Exit 1 if differs.
+    ```
+"""
+
+import argparse
+import sys
+
+CRC8_POLY = 0xD5  # CRC-8/DVB-S2, MSB first.
+CRC16_POLY = 0x1021  # CRC-16/CCITT-FALSE, MSB first.
+CRC32_POLY = 0xEDB88320  # CRC-32/ISO-HDLC, reflected (LSB first).
+
+SLICES = 4
+
+
+def crc_msb_table(poly: int, width: int):
+    """Table of the MSB first CRC of each byte value (no init, no xor out)."""
+    top = 1 << (width - 1)
+    mask = (1 << width) - 1
+    table = []
+    for byte in range(256):
+        crc = byte << (width - 8)
+        for _ in range(8):
+            crc = ((crc << 1) ^ poly) if crc & top else (crc << 1)
+        table.append(crc & mask)
+    return table
+
+
+def crc_lsb_table(poly: int):
+    """Table of the reflected CRC of each byte value (no init, no xor out)."""
+    table = []
+    for byte in range(256):
+        crc = byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ poly if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+def slice_msb_tables(table, width: int):
+    """Slice-by-4 tables of an MSB first CRC, [k] adds k zero bytes."""
+    mask = (1 << width) - 1
+    tables = [table]
+    for _ in range(1, SLICES):
+        previous = tables[-1]
+        tables.append(
+            [
+                ((crc << 8) & mask) ^ table[crc >> (width - 8)]
+                for crc in previous
+            ]
+        )
+    return tables
+
+
+def slice_lsb_tables(table):
+    """Slice-by-4 tables of a reflected CRC, [k] adds k zero bytes."""
+    tables = [table]
+    for _ in range(1, SLICES):
+        previous = tables[-1]
+        tables.append([(crc >> 8) ^ table[crc & 0xFF] for crc in previous])
+    return tables
+
+
+# Values per line as laid out by clang-format in crc.c, by hex digits.
+PER_LINE = {2: 12, 4: 8, 8: 6}
+
+
+def format_values(values, digits: int, indent: int):
+    """Comma separated hex values, PER_LINE values per line."""
+    per_line = PER_LINE[digits]
+    lines = []
+    for i in range(0, len(values), per_line):
+        chunk = values[i : i + per_line]
+        lines.append(
+            " " * indent + " ".join(f"0x{value:0{digits}X}," for value in chunk)
+        )
+    return lines
+
+
+def c_table(ctype: str, name: str, tables, digits: int):
+    """C definition of a table, or of an array of slice-by-4 tables."""
+    if len(tables) == 1:
+        lines = [f"static const {ctype} {name}[256] = {{"]
+        lines += format_values(tables[0], digits, 4)
+    else:
+        lines = [f"static const {ctype} {name}[{len(tables)}][256] = {{"]
+        for table in tables:
+            lines.append("    {")
+            lines += format_values(table, digits, 8)
+            lines.append("    },")
+    lines.append("};")
+    return lines
+
+
+def generate():
+    """C source of all CRC tables, as in the crc.c private variables."""
+    crc8 = crc_msb_table(CRC8_POLY, 8)
+    crc16 = slice_msb_tables(crc_msb_table(CRC16_POLY, 16), 16)
+    crc32 = slice_lsb_tables(crc_lsb_table(CRC32_POLY))
+
+    lines = [
+        "// Generated with the polynomials below, index [k] holds the CRC of"
+        " a byte",
+        "// followed by k zero bytes (slice-by-4).",
+        "",
+        f"// CRC-8/DVB-S2, polynomial 0x{CRC8_POLY:02X} (MSB first).",
+    ]
+    lines += c_table("uint8_t", "crc8_dvb_s2_table", [crc8], 2)
+    lines += [
+        "",
+        f"// CRC-16/CCITT-FALSE, polynomial 0x{CRC16_POLY:04X} (MSB first).",
+    ]
+    lines += c_table("uint16_t", "crc16_ccitt_table", crc16, 4)
+    lines += [
+        "",
+        "// CRC-32/ISO-HDLC, reflected polynomial"
+        f" 0x{CRC32_POLY:08X} (LSB first).",
+    ]
+    lines += c_table("uint32_t", "crc32_table", crc32, 8)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate the crc.c CRC lookup tables."
+    )
+    parser.add_argument(
+        "--check",
+        metavar="CRC_C",
+        help="Check the tables in this file instead of printing them",
+    )
+    args = parser.parse_args()
+
+    tables = generate()
+    if not args.check:
+        sys.stdout.write(tables)
+        return
+
+    with open(args.check, "r") as f:
+        if tables not in f.read():
+            print(f"{args.check}: CRC tables differ from the generated ones.")
+            sys.exit(1)
+    print(f"{args.check}: CRC tables match.")
+
+
+if __name__ == "__main__":
+    main()
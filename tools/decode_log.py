@@ -0,0 +1,264 @@
+"""Binary flight log (LOGnnn.BIN) decoder.
+
+Decode a flight log written by logger.c into one CSV file per record type.
+Record types are described by the schema records at the start of the log
+(name, Python struct format and field names), so new record types need no
+decoder change.
+
+File layout (little endian), a sequence of sector aligned blocks:
+    - Block header: magic "NLOG", version (uint8), block size in 512 B
+      sectors (uint8), bytes used (uint16), sequence (uint32), log id
+      (uint32), CRC-32 of the used bytes with this field 0 (uint32).
+    - Records, never spanning blocks: type (uint8), payload length (uint8),
+      timestamp (uint32 us, systime_us32), payload. Type 0 is a schema record
+      (first block).
+    - Padding up to the block size.
+
+Compressed records (type | 0x80) are decompressed with the fraction bits of
+their schema record: per float field a varint, the zigzag encoded delta of the
+fixed point value to the previous record of the type in the same block (0 for
+the first).
+
+Index blocks (one sector, "index" and "index_entry" records) list the data
+block offsets for log_reader and decode like any other record type.
+
+Every CSV has a utc_us column (us since 1970-01-01 UTC): the timestamp
+converted with the latest "gnss_time" record (GNSS time sync point and drift,
+gnss_time.c), else the latest "rtc_time" record (RTC sub-second time anchor,
+rtc.c). Empty before the first of either.
+
+Only blocks with a valid CRC and the log id of the first block are decoded,
+in sequence order. After a power loss (pre-allocated file or torn block) the
+invalid and stale blocks are skipped, see recover_log.py.
+
+Usage:
+    ```shell
+    python3 decode_log.py path/to/LOG000.BIN path/to/output_dir  # Unix.
+    ```
+
+    ```shell
+    py decode_log.py path/to/LOG000.BIN path/to/output_dir  # WindowsOS.
+    ```
+"""
+
+import argparse
+import collections
+import csv
+import os
+import struct
+import sys
+import zlib
+
+BLOCK_HEADER = struct.Struct("<4sBBHIII")
+RECORD_HEADER = struct.Struct("<BBI")
+LOG_BLOCK_MAGIC = b"NLOG"
+LOG_FILE_VERSIONS = (2, 3)
+LOG_RECORD_SCHEMA = 0
+LOG_RECORD_COMPRESSED = 0x80
+SECTOR_SIZE = 512
+CRC_OFFSET = BLOCK_HEADER.size - 4
+
+Block = collections.namedtuple(
+    "Block", ["offset", "sequence", "log_id", "data", "records"]
+)
+
+
+def parse_schema(payload: bytes):
+    """Parse a schema record payload into (type, name, struct, fields, q).
+
+    q lists the fraction bits per field of a compressed type, else is empty.
+    """
+    name, fmt, fields, *codec = payload[1:].decode("ascii").split(";")
+    q = [int(bits) for bits in codec[0].split(",")] if codec else []
+    return payload[0], name, struct.Struct(fmt), fields.split(","), q
+
+
+def decompress(payload: bytes, q, previous):
+    """Decompress a record payload, previous fixed point values updated.
+
+    Returns the raw payload (little endian floats), else None if malformed.
+    """
+    values = []
+    offset = 0
+    for i, bits in enumerate(q):
+        zigzag = 0
+        shift = 0
+        while True:
+            if offset >= len(payload) or shift > 28:
+                return None
+            byte = payload[offset]
+            offset += 1
+            zigzag |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                break
+        delta = (zigzag >> 1) ^ -(zigzag & 1)
+        previous[i] = (previous[i] + delta) & 0xFFFFFFFF
+        fixed = (
+            previous[i] - (1 << 32) if previous[i] >= 1 << 31 else previous[i]
+        )
+        values.append(fixed / (1 << bits))
+    if offset != len(payload):
+        return None
+    return struct.pack(f"<{len(values)}f", *values)
+
+
+def read_block(data: bytes, offset: int):
+    """Return the valid block at offset, else None."""
+    if offset + BLOCK_HEADER.size > len(data):
+        return None
+    magic, version, sectors, length, sequence, log_id, crc = (
+        BLOCK_HEADER.unpack_from(data, offset)
+    )
+    size = sectors * SECTOR_SIZE
+    if (
+        magic != LOG_BLOCK_MAGIC
+        or version not in LOG_FILE_VERSIONS
+        or not BLOCK_HEADER.size <= length <= size
+        or offset + length > len(data)
+    ):
+        return None
+
+    used = bytearray(data[offset : offset + length])
+    used[CRC_OFFSET : CRC_OFFSET + 4] = bytes(4)
+    if zlib.crc32(used) != crc:
+        return None
+
+    block = data[offset : offset + size].ljust(size, b"\0")
+    return Block(
+        offset, sequence, log_id, block, block[BLOCK_HEADER.size : length]
+    )
+
+
+def read_blocks(data: bytes):
+    """Return the valid blocks of the log in sequence order.
+
+    Scans every sector, so a torn or corrupted block only loses itself. The
+    log id is taken from the first valid block, blocks of another log (stale
+    pre-allocated sectors) are ignored.
+    """
+    blocks = {}
+    log_id = None
+    offset = 0
+    while offset < len(data):
+        block = read_block(data, offset)
+        if block is None:
+            offset += SECTOR_SIZE
+            continue
+        if log_id is None:
+            log_id = block.log_id
+        if block.log_id == log_id:
+            blocks.setdefault(block.sequence, block)
+        offset += len(block.data)
+    return [blocks[sequence] for sequence in sorted(blocks)]
+
+
+def missing_sequences(blocks):
+    """Return the number of blocks missing between the first and last."""
+    if not blocks:
+        return 0
+    return blocks[-1].sequence - blocks[0].sequence + 1 - len(blocks)
+
+
+def decode(blocks):
+    """Yield (name, fields, timestamp_us, values) for each data record."""
+    schemas = {}
+    for block in blocks:
+        records = block.records
+        offset = 0
+        previous = {}  # Compression state, per block.
+        while offset + RECORD_HEADER.size <= len(records):
+            record_type, length, timestamp_us = RECORD_HEADER.unpack_from(
+                records, offset
+            )
+            offset += RECORD_HEADER.size
+            payload = records[offset : offset + length]
+            offset += length
+
+            if record_type & LOG_RECORD_COMPRESSED:
+                record_type &= ~LOG_RECORD_COMPRESSED
+                if record_type not in schemas or not schemas[record_type][3]:
+                    continue
+                q = schemas[record_type][3]
+                state = previous.setdefault(record_type, [0] * len(q))
+                payload = decompress(payload, q, state)
+                if payload is None:
+                    continue
+                length = len(payload)
+
+            if record_type == LOG_RECORD_SCHEMA:
+                schema_type, name, layout, fields, q = parse_schema(payload)
+                schemas[schema_type] = (name, layout, fields, q)
+            elif record_type in schemas:
+                name, layout, fields, _ = schemas[record_type]
+                if length == layout.size:
+                    values = [
+                        v.hex() if isinstance(v, bytes) else v
+                        for v in layout.unpack(payload)
+                    ]
+                    yield name, fields, timestamp_us, values
+
+
+def to_utc_us(timestamp_us: int, utc_us: int, sys_us: int, drift_ppb=0):
+    """Convert a record timestamp to UTC from a time record (UTC at sys_us)."""
+    elapsed_us = (timestamp_us - sys_us) & 0xFFFFFFFF
+    if elapsed_us >= 1 << 31:
+        elapsed_us -= 1 << 32
+    return utc_us + elapsed_us - round(elapsed_us * drift_ppb / 1e9)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode a binary flight log into CSV files."
+    )
+    parser.add_argument("log_file", help="Input flight log (LOGnnn.BIN).")
+    parser.add_argument("output_dir", help="Output directory for CSV files.")
+    args = parser.parse_args()
+
+    with open(args.log_file, "rb") as f:
+        data = f.read()
+
+    blocks = read_blocks(data)
+    if not blocks:
+        print("Not a flight log (no valid block).")
+        sys.exit(1)
+    if blocks[0].sequence != 0:
+        print("First block (schema records) missing, see recover_log.py.")
+        sys.exit(1)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    files = {}
+    writers = {}
+    counts = {}
+    gnss = None  # Latest gnss_time record values.
+    rtc = None  # Latest rtc_time record values.
+    try:
+        for name, fields, timestamp_us, values in decode(blocks):
+            if name == "gnss_time":
+                gnss = values
+            elif name == "rtc_time":
+                rtc = values
+            if name not in writers:
+                path = os.path.join(args.output_dir, f"{name}.csv")
+                files[name] = open(path, "w", newline="")
+                writers[name] = csv.writer(files[name])
+                writers[name].writerow(["timestamp_us", "utc_us"] + fields)
+                counts[name] = 0
+            utc_us = ""
+            if gnss:
+                utc_us = to_utc_us(timestamp_us, gnss[0], gnss[1], gnss[2])
+            elif rtc:
+                utc_us = to_utc_us(timestamp_us, rtc[0], rtc[1])
+            writers[name].writerow([timestamp_us, utc_us] + values)
+            counts[name] += 1
+    finally:
+        for f in files.values():
+            f.close()
+
+    print(f"{len(blocks)} blocks, {missing_sequences(blocks)} missing.")
+    for name, count in sorted(counts.items()):
+        print(f"{name}: {count} records.")
+
+
+if __name__ == "__main__":
+    main()
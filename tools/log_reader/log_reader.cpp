@@ -0,0 +1,409 @@
+/*******************************************************************************
+ * @file log_reader.cpp
+ * @brief Host reader for binary flight logs (LOGnnn.BIN), seek by timestamp.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "log_reader.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nerve {
+
+/** Definitions. **************************************************************/
+
+namespace {
+
+constexpr char kBlockMagic[4] = {'N', 'L', 'O', 'G'}; // LOG_BLOCK_MAGIC.
+constexpr uint8_t kFileVersionMin = 2;                // Before compression.
+constexpr uint8_t kFileVersion = 3;                   // LOG_FILE_VERSION.
+constexpr std::size_t kSectorSize = 512;
+constexpr std::size_t kBlockHeaderSize = 20; // LOG_BLOCK_HEADER_SIZE.
+constexpr std::size_t kCrcOffset = 16;       // log_block_header_t crc.
+constexpr std::size_t kRecordHeaderSize = 6; // LOG_RECORD_HEADER_SIZE.
+constexpr uint8_t kSchemaType = 0;           // LOG_RECORD_SCHEMA.
+constexpr std::size_t kIndexSize = 8;        // sizeof(log_index_t).
+constexpr std::size_t kIndexEntrySize = 8;   // sizeof(log_index_entry_t).
+constexpr uint8_t kCompressed = 0x80;        // LOG_RECORD_COMPRESSED.
+constexpr std::size_t kCodecMaxFields = 32;  // Any schema, 4 B per field.
+
+/**
+ * @brief Struct holding one index entry before unwrapping.
+ */
+struct RawEntry {
+  uint32_t sequence;
+  std::size_t offset;
+  uint32_t timestamp_us;
+};
+
+uint16_t get_u16(const uint8_t *p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/**
+ * @brief CRC-32 (ISO-HDLC) update, as the STM32 CRC peripheral setup.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, std::size_t length) {
+  for (std::size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Decompress a record payload into little endian floats, previous
+ * fixed point values updated (zigzag varint deltas, see logger.h).
+ *
+ * @return Decompressed length, 0 if malformed.
+ */
+std::size_t decompress(const uint8_t *payload, std::size_t length,
+                       const std::vector<uint8_t> &q, uint32_t *previous,
+                       uint8_t *out) {
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < q.size(); i++) {
+    uint32_t zigzag = 0;
+    for (int shift = 0;; shift += 7) {
+      if (offset >= length || shift > 28) {
+        return 0;
+      }
+      const uint8_t byte = payload[offset++];
+      zigzag |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (byte < 0x80) {
+        break;
+      }
+    }
+    previous[i] += (zigzag >> 1) ^ (0u - (zigzag & 1u)); // Wrapping.
+    const float value = std::ldexp(
+        static_cast<float>(static_cast<int32_t>(previous[i])), -q[i]);
+    std::memcpy(&out[i * sizeof(value)], &value, sizeof(value));
+  }
+  return (offset == length) ? q.size() * sizeof(float) : 0;
+}
+
+/**
+ * @brief Call a function per record (type, timestamp, payload, length) of the
+ * record bytes of a block, stopping when it returns false.
+ */
+template <typename Function>
+void for_each_record(const uint8_t *records, std::size_t length,
+                     Function function) {
+  std::size_t offset = 0;
+  while (offset + kRecordHeaderSize <= length) {
+    const uint8_t type = records[offset];
+    const uint8_t size = records[offset + 1];
+    const uint32_t timestamp_us = get_u32(&records[offset + 2]);
+    offset += kRecordHeaderSize;
+    if (offset + size > length ||
+        !function(type, timestamp_us, &records[offset], size)) {
+      return;
+    }
+    offset += size;
+  }
+}
+
+} // namespace
+
+/** Public functions. *********************************************************/
+
+LogReader::LogReader(const std::string &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + path + ".");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    throw std::runtime_error("Empty or unreadable file " + path + ".");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping keeps the file.
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("Cannot map " + path + ".");
+  }
+  data_ = static_cast<const uint8_t *>(map);
+
+  try {
+    load_schema();
+  } catch (...) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    throw;
+  }
+  footer_ = load_footer();
+  if (!footer_) {
+    load_scan();
+  }
+}
+
+LogReader::~LogReader() { munmap(const_cast<uint8_t *>(data_), size_); }
+
+std::size_t LogReader::seek(uint64_t timestamp_us) const {
+  if (index_.empty()) {
+    return 0;
+  }
+  const auto next = std::upper_bound(
+      index_.begin(), index_.end(), timestamp_us,
+      [](uint64_t t, const LogIndexEntry &entry) {
+        return t < entry.timestamp_us;
+      });
+  // Start one block early, records may be slightly out of order.
+  const std::size_t position = static_cast<std::size_t>(next - index_.begin());
+  return (position > 1) ? position - 2 : 0;
+}
+
+void LogReader::read(
+    std::size_t position, uint64_t from_us,
+    const std::function<bool(const LogRecord &)> &callback) const {
+  bool more = true;
+  std::vector<std::array<uint32_t, kCodecMaxFields>> previous(schemas_.size());
+  uint8_t decompressed[kCodecMaxFields * sizeof(float)];
+
+  for (; position < index_.size() && more; position++) {
+    const LogIndexEntry &entry = index_[position];
+    Block block;
+    if (!block_at(entry.offset, block) || block.log_id != log_id_ ||
+        block.sequence != entry.sequence) {
+      continue;
+    }
+    // Compression starts over in each block.
+    for (auto &values : previous) {
+      values.fill(0);
+    }
+    // Unwrapped from the block's first record, within +-35 minutes.
+    const uint32_t base = static_cast<uint32_t>(entry.timestamp_us);
+    for_each_record(
+        block.records, block.length,
+        [&](uint8_t type, uint32_t timestamp_us, const uint8_t *payload,
+            uint8_t length) {
+          LogRecord record = {
+              type,
+              entry.timestamp_us +
+                  static_cast<int32_t>(timestamp_us - base),
+              payload, length};
+          if (type & kCompressed) {
+            record.type = type & ~kCompressed;
+            const std::vector<uint8_t> &q = schemas_[record.type].q;
+            const std::size_t size =
+                q.empty() ? 0
+                          : decompress(payload, length, q,
+                                       previous[record.type].data(),
+                                       decompressed);
+            if (size == 0) {
+              return true; // Malformed, skipped.
+            }
+            record.payload = decompressed;
+            record.length = static_cast<uint8_t>(size);
+          }
+          if (record.timestamp_us >= from_us) {
+            more = callback(record);
+          }
+          return more;
+        });
+  }
+}
+
+/** Private functions. ********************************************************/
+
+bool LogReader::block_at(std::size_t offset, Block &block) const {
+  if (offset + kBlockHeaderSize > size_) {
+    return false;
+  }
+  const uint8_t *header = &data_[offset];
+  const std::size_t size = header[5] * kSectorSize;
+  const std::size_t length = get_u16(&header[6]);
+  if (std::memcmp(header, kBlockMagic, sizeof(kBlockMagic)) != 0 ||
+      header[4] < kFileVersionMin || header[4] > kFileVersion ||
+      length < kBlockHeaderSize ||
+      length > size || offset + length > size_) {
+    return false;
+  }
+
+  const uint8_t zero[4] = {0, 0, 0, 0};
+  uint32_t crc = crc32_update(0xFFFFFFFFu, header, kCrcOffset);
+  crc = crc32_update(crc, zero, sizeof(zero));
+  crc = crc32_update(crc, &header[kCrcOffset + 4], length - kBlockHeaderSize);
+  if (~crc != get_u32(&header[kCrcOffset])) {
+    return false;
+  }
+
+  block.sequence = get_u32(&header[8]);
+  block.log_id = get_u32(&header[12]);
+  block.records = &header[kBlockHeaderSize];
+  block.length = length - kBlockHeaderSize;
+  block.size = size;
+  return true;
+}
+
+void LogReader::load_schema() {
+  Block block;
+  if (!block_at(0, block) || block.sequence != 0) {
+    throw std::runtime_error("First block (schema records) missing, see "
+                             "recover_log.py.");
+  }
+  log_id_ = block.log_id;
+  schemas_.assign(256, LogSchema());
+
+  // Payload: type (1 byte), then "name;format;fields" (not terminated).
+  for_each_record(
+      block.records, block.length,
+      [&](uint8_t type, uint32_t, const uint8_t *payload, uint8_t length) {
+        if (type != kSchemaType || length < 1) {
+          return true;
+        }
+        const std::string text(reinterpret_cast<const char *>(&payload[1]),
+                               length - 1u);
+        const std::size_t first = text.find(';');
+        const std::size_t second = text.find(';', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+          return true;
+        }
+        LogSchema &schema = schemas_[payload[0]];
+        schema.name = text.substr(0, first);
+        schema.format = text.substr(first + 1, second - first - 1);
+        const std::size_t third = text.find(';', second + 1);
+        schema.fields = text.substr(second + 1, third - second - 1);
+        // Compressed type: ";q,q,...", fraction bits per field.
+        for (std::size_t start = third; start != std::string::npos &&
+                                        schema.q.size() < kCodecMaxFields;
+             start = text.find(',', start + 1)) {
+          schema.q.push_back(
+              static_cast<uint8_t>(std::atoi(text.c_str() + start + 1)));
+        }
+        if (schema.name == "index") {
+          index_type_ = payload[0];
+        } else if (schema.name == "index_entry") {
+          index_entry_type_ = payload[0];
+        }
+        return true;
+      });
+}
+
+bool LogReader::load_footer() {
+  std::vector<RawEntry> entries;
+
+  if (index_type_ < 0 || index_entry_type_ < 0 || size_ % kSectorSize != 0 ||
+      size_ < 2 * kSectorSize) {
+    return false;
+  }
+
+  // The footer is the last sector, each index block points to the previous.
+  std::size_t offset = size_ - kSectorSize;
+  bool first = true;
+  while (true) {
+    Block block;
+    if (!block_at(offset, block) || block.log_id != log_id_ ||
+        block.length < kRecordHeaderSize + kIndexSize ||
+        block.records[0] != index_type_ || block.records[1] != kIndexSize) {
+      return false; // Broken chain, scanned instead.
+    }
+    const uint8_t *index = &block.records[kRecordHeaderSize];
+    if (first && index[4] != 1) {
+      return false; // Not closed.
+    }
+    first = false;
+
+    for_each_record(block.records, block.length,
+                    [&](uint8_t type, uint32_t timestamp_us,
+                        const uint8_t *payload, uint8_t length) {
+                      if (type == index_entry_type_ &&
+                          length == kIndexEntrySize) {
+                        entries.push_back({get_u32(payload),
+                                           get_u32(&payload[4]),
+                                           timestamp_us});
+                      }
+                      return true;
+                    });
+
+    const std::size_t previous = get_u32(index);
+    if (previous == 0) {
+      break;
+    }
+    if (previous >= offset) {
+      return false; // Always backwards, never loops.
+    }
+    offset = previous;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const RawEntry &a, const RawEntry &b) {
+              return a.sequence < b.sequence;
+            });
+  std::vector<uint32_t> timestamps;
+  index_.clear();
+  for (const RawEntry &entry : entries) {
+    // Offsets no longer hold in a rebuilt log (recover_log.py), scanned.
+    if (entry.offset + kBlockHeaderSize > size_ ||
+        std::memcmp(&data_[entry.offset], kBlockMagic, sizeof(kBlockMagic)) !=
+            0 ||
+        get_u32(&data_[entry.offset + 8]) != entry.sequence) {
+      return false;
+    }
+    index_.push_back({0, entry.sequence, entry.offset});
+    timestamps.push_back(entry.timestamp_us);
+  }
+  unwrap(timestamps);
+  return true;
+}
+
+void LogReader::load_scan() {
+  std::map<uint32_t, RawEntry> entries; // By sequence, first copy kept.
+
+  std::size_t offset = 0;
+  while (offset < size_) {
+    Block block;
+    if (!block_at(offset, block)) {
+      offset += kSectorSize;
+      continue;
+    }
+    // Data blocks only, skips the schema and index blocks.
+    if (block.log_id == log_id_ && block.sequence != 0 &&
+        block.length >= kRecordHeaderSize &&
+        block.records[0] != index_type_) {
+      entries.emplace(block.sequence,
+                      RawEntry{block.sequence, offset,
+                               get_u32(&block.records[2])});
+    }
+    offset += block.size;
+  }
+
+  std::vector<uint32_t> timestamps;
+  index_.clear();
+  for (const auto &item : entries) {
+    index_.push_back({0, item.second.sequence, item.second.offset});
+    timestamps.push_back(item.second.timestamp_us);
+  }
+  unwrap(timestamps);
+}
+
+void LogReader::unwrap(const std::vector<uint32_t> &timestamps) {
+  // Consecutive blocks are seconds apart, far below the 32 bit wrap.
+  uint64_t timestamp_us = timestamps.empty() ? 0 : timestamps[0];
+  for (std::size_t i = 0; i < index_.size(); i++) {
+    if (i > 0) {
+      timestamp_us += static_cast<int32_t>(timestamps[i] - timestamps[i - 1]);
+    }
+    index_[i].timestamp_us = timestamp_us;
+  }
+}
+
+} // namespace nerve
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * @file log_reader.h
+ * @brief Host reader for binary flight logs (LOGnnn.BIN), seek by timestamp.
+ *
+ * The log file is memory mapped and its index loaded from the footer (last
+ * index block, written by logger.c on close) by following the index block
+ * chain, only the index blocks and the data block headers are read. A log
+ * without a valid footer (power loss, rebuilt by recover_log.py) is indexed by
+ * scanning every sector, as decode_log.py. Seeking is a binary search of the
+ * index.
+ *
+ * Timestamps are systime_us32 (32 bit, wraps every ~71 minutes), unwrapped to
+ * 64 bit from the first indexed block. Compressed records are returned
+ * decompressed, as logged.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__LOG_READER_H
+#define NERVE__LOG_READER_H
+
+/** Includes. *****************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace nerve {
+
+/** Public types. *************************************************************/
+
+/**
+ * @brief Struct describing a record type (schema record).
+ */
+struct LogSchema {
+  std::string name;   // Record name, empty if not described.
+  std::string format; // Payload format (Python struct, little endian).
+  std::string fields; // Comma separated field names.
+  std::vector<uint8_t> q; // Fraction bits per field, compressed types only.
+};
+
+/**
+ * @brief Struct holding one record, the payload points into the mapped file
+ * (or, decompressed, is only valid during the read callback).
+ */
+struct LogRecord {
+  uint8_t type;          // log_record_type_t, compressed flag cleared.
+  uint64_t timestamp_us; // Unwrapped systime_us32.
+  const uint8_t *payload;
+  uint8_t length; // Payload length (bytes).
+};
+
+/**
+ * @brief Struct holding one index entry (data block).
+ */
+struct LogIndexEntry {
+  uint64_t timestamp_us; // First record timestamp, unwrapped.
+  uint32_t sequence;     // Block sequence number.
+  std::size_t offset;    // Block file offset (bytes).
+};
+
+/**
+ * @brief Memory mapped flight log with its block index.
+ */
+class LogReader {
+public:
+  /**
+   * @brief Map the log file and load its index.
+   *
+   * @param path Log file path.
+   *
+   * @throws std::runtime_error if the file cannot be mapped or has no valid
+   * schema block (see recover_log.py).
+   */
+  explicit LogReader(const std::string &path);
+  ~LogReader();
+
+  LogReader(const LogReader &) = delete;
+  LogReader &operator=(const LogReader &) = delete;
+
+  /**
+   * @brief Check if the index was loaded from the footer.
+   *
+   * @return true if the file was closed, false if indexed by a sector scan.
+   */
+  bool has_footer() const { return footer_; }
+
+  /**
+   * @brief Get the data block index, in sequence order.
+   */
+  const std::vector<LogIndexEntry> &index() const { return index_; }
+
+  /**
+   * @brief Get the record type descriptions, indexed by record type.
+   */
+  const std::vector<LogSchema> &schemas() const { return schemas_; }
+
+  /**
+   * @brief Find the data block to start reading from for a timestamp.
+   *
+   * O(log n): the block before the last block whose first record is not
+   * after the timestamp, records of a block may be slightly older than its
+   * first (events timestamped when they happened).
+   *
+   * @param timestamp_us Unwrapped systime_us32.
+   *
+   * @return Index position (index().size() if the log has no data block).
+   */
+  std::size_t seek(uint64_t timestamp_us) const;
+
+  /**
+   * @brief Read the data records from an index position on, in block order.
+   *
+   * Invalid blocks (torn, overwritten) are skipped.
+   *
+   * @param position Index position, usually from seek.
+   * @param from_us Records before this unwrapped timestamp are skipped.
+   * @param callback Called per record, returns false to stop.
+   */
+  void read(std::size_t position, uint64_t from_us,
+            const std::function<bool(const LogRecord &)> &callback) const;
+
+private:
+  struct Block {
+    uint32_t sequence;
+    uint32_t log_id;
+    const uint8_t *records; // After the header.
+    std::size_t length;     // Record bytes.
+    std::size_t size;       // Block size (bytes).
+  };
+
+  bool block_at(std::size_t offset, Block &block) const;
+  void load_schema();
+  bool load_footer();
+  void load_scan();
+  void unwrap(const std::vector<uint32_t> &timestamps);
+
+  const uint8_t *data_ = nullptr;
+  std::size_t size_ = 0;
+  uint32_t log_id_ = 0;
+  int index_type_ = -1;       // Schema type of "index".
+  int index_entry_type_ = -1; // Schema type of "index_entry".
+  bool footer_ = false;
+  std::vector<LogSchema> schemas_;
+  std::vector<LogIndexEntry> index_;
+};
+
+} // namespace nerve
+
+#endif
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * @file log_seek.cpp
+ * @brief Print the records of a flight log from a timestamp on (log_reader).
+ *
+ * Build and run (from the repository root):
+ *     g++ -std=c++17 -O2 tools/log_reader/log_reader.cpp \
+ *         tools/log_reader/log_seek.cpp -o log_seek
+ *     ./log_seek 20250101_120000/LOG000.BIN 5000000 20
+ *
+ * Prints the index summary, then COUNT (default 10) records at or after
+ * TIMESTAMP_US (unwrapped systime_us32) as timestamp_us, name and payload hex.
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "log_reader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+/** Public functions. *********************************************************/
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "Usage: %s LOG_FILE TIMESTAMP_US [COUNT]\n", argv[0]);
+    return 1;
+  }
+  const uint64_t timestamp_us = std::strtoull(argv[2], nullptr, 10);
+  unsigned long count = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 10;
+
+  try {
+    const nerve::LogReader log(argv[1]);
+    const auto &index = log.index();
+
+    std::fprintf(stderr, "%zu blocks indexed (%s)", index.size(),
+                 log.has_footer() ? "footer" : "scanned, no valid footer");
+    if (!index.empty()) {
+      std::fprintf(stderr, ", %llu to %llu us",
+                   static_cast<unsigned long long>(index.front().timestamp_us),
+                   static_cast<unsigned long long>(index.back().timestamp_us));
+    }
+    std::fprintf(stderr, ".\n");
+
+    log.read(log.seek(timestamp_us), timestamp_us,
+             [&](const nerve::LogRecord &record) {
+               const std::string &name = log.schemas()[record.type].name;
+               std::printf("%llu,%s,",
+                           static_cast<unsigned long long>(record.timestamp_us),
+                           name.empty() ? "unknown" : name.c_str());
+               for (uint8_t i = 0; i < record.length; i++) {
+                 std::printf("%02x", record.payload[i]);
+               }
+               std::printf("\n");
+               return --count > 0;
+             });
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+"""Binary flight log (LOGnnn.BIN) recovery.
+
+Rebuild a valid flight log from a damaged one, e.g. after a power loss: a file
+truncated or holding its whole pre-allocated size, torn blocks and stale
+sectors of a previous log. Every sector is scanned for blocks with a valid CRC
+and the log id of the first block, which are written out in sequence order.
+The recovered log is decoded with decode_log.py.
+
+Usage:
+    ```shell
+    python3 recover_log.py path/to/LOG000.BIN path/to/RECOVERED.BIN  # Unix.
+    ```
+
+    ```shell
+    py recover_log.py path/to/LOG000.BIN path/to/RECOVERED.BIN  # WindowsOS.
+    ```
+"""
+
+import argparse
+import sys
+
+from decode_log import missing_sequences, read_blocks
+
+
+def gaps(blocks):
+    """Yield (first, last) missing sequence ranges."""
+    for previous, block in zip(blocks, blocks[1:]):
+        if block.sequence != previous.sequence + 1:
+            yield previous.sequence + 1, block.sequence - 1
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Rebuild a valid flight log from a damaged one."
+    )
+    parser.add_argument("log_file", help="Damaged flight log (LOGnnn.BIN).")
+    parser.add_argument("output_file", help="Recovered flight log.")
+    args = parser.parse_args()
+
+    with open(args.log_file, "rb") as f:
+        data = f.read()
+
+    blocks = read_blocks(data)
+    if not blocks:
+        print("No valid block found.")
+        sys.exit(1)
+
+    with open(args.output_file, "wb") as f:
+        for block in blocks:
+            f.write(block.data)
+
+    recovered = sum(len(block.data) for block in blocks)
+    print(
+        f"Recovered {len(blocks)} blocks ({recovered} of {len(data)} bytes), "
+        f"sequence {blocks[0].sequence} to {blocks[-1].sequence}, "
+        f"{missing_sequences(blocks)} missing."
+    )
+    for first, last in gaps(blocks):
+        print(f"Missing blocks {first} to {last}.")
+    if blocks[0].sequence != 0:
+        print("First block (schema records) missing, log not decodable.")
+
+
+if __name__ == "__main__":
+    main()
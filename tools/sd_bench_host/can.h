@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * @file can.h
+ * @brief Host stand-in for Core/Inc/can.h, simulated microsecond time base.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__CAN_H
+#define NERVE__CAN_H
+
+#include <stdint.h>
+
+uint32_t can_time_us(void);
+
+#endif
@@ -0,0 +1,13 @@
+/*******************************************************************************
+ * @file ffconf.h
+ * @brief Target FatFs configuration, with the host benchmark overrides.
+ *******************************************************************************
+ */
+
+#include "../../FATFS/Target/ffconf.h"
+
+// Build with -DSD_BENCH_FS_TINY=0 or 1 to compare the FatFs sector buffers.
+#ifdef SD_BENCH_FS_TINY
+#undef _FS_TINY
+#define _FS_TINY SD_BENCH_FS_TINY
+#endif
@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * @file main.h
+ * @brief Host stand-in for Core/Inc/main.h (included by ffconf.h).
+ *******************************************************************************
+ */
+
+#ifndef NERVE__MAIN_H
+#define NERVE__MAIN_H
+
+#include <stdint.h>
+
+#endif
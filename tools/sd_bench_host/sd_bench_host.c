@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * @file sd_bench_host.c
+ * @brief Host build of sd_bench.c against a simulated SD card.
+ *
+ * Runs the on-target benchmark (Core/Src/sd_bench.c) and FatFs unchanged on a
+ * memory backed disk, with a simulated clock advanced by a simple SD card
+ * timing model. The model is not calibrated against a card: it shows the
+ * relative cost of the FatFs access patterns (extra commands, non-sequential
+ * FAT and directory writes, partial sectors) per configuration, the on-target
+ * benchmark gives the real numbers.
+ *
+ * Build and run (from the repository root), add -DSD_BENCH_FS_TINY=1 for the
+ * _FS_TINY configuration:
+ *     gcc -O2 -D__STM32F4_SD_H \
+ *         -Itools/sd_bench_host -ICore/Inc \
+ *         -IMiddlewares/Third_Party/FatFs/src \
+ *         tools/sd_bench_host/sd_bench_host.c Core/Src/sd_bench.c \
+ *         Middlewares/Third_Party/FatFs/src/ff.c \
+ *         Middlewares/Third_Party/FatFs/src/option/ccsbcs.c -o sd_bench_host
+ *     ./sd_bench_host > SDBENCH.CSV
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "can.h"
+#include "diskio.h"
+#include "ff.h"
+#include "sd_bench.h"
+#include "sd_diskio.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Definitions. **************************************************************/
+
+#define DISK_SECTOR_SIZE 512
+#define DISK_BYTES (4ULL * 1024 * 1024 * 1024) // Sparse, allocated on write.
+#define DISK_AU_SECTORS 8192                   // 4 MiB allocation unit.
+#define DISK_CLUSTER_BYTES 32768               // FAT32 cluster size.
+
+// SD card timing model (us), SDIO 4 bit at 24 MHz.
+#define MODEL_COMMAND_US 40          // Command and response.
+#define MODEL_BUS_BYTES_PER_US 12    // Data transfer.
+#define MODEL_READ_ACCESS_US 100     // Read access time.
+#define MODEL_PROGRAM_US 250         // Busy after each write command.
+#define MODEL_PROGRAM_SECTOR_US 20   // Busy per sector written.
+#define MODEL_NON_SEQUENTIAL_US 1500 // Write not following the previous one.
+#define MODEL_AU_CROSSING_US 20000   // Write entering a new allocation unit.
+
+/** Private variables. ********************************************************/
+
+static uint8_t *disk;
+static uint64_t now_us;
+static DWORD next_write_sector; // Sector following the previous write.
+static uint32_t commands;
+static UINT scratch_reads;  // Sectors read through the scratch buffer.
+static UINT scratch_writes; // Sectors written through the scratch buffer.
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Advance the clock for one write command.
+ */
+static void model_write(DWORD sector, UINT count) {
+  now_us += MODEL_COMMAND_US + MODEL_PROGRAM_US;
+  now_us += (uint64_t)count * DISK_SECTOR_SIZE / MODEL_BUS_BYTES_PER_US;
+  now_us += (uint64_t)count * MODEL_PROGRAM_SECTOR_US;
+
+  if (sector != next_write_sector) {
+    now_us += MODEL_NON_SEQUENTIAL_US;
+  }
+  if (sector / DISK_AU_SECTORS != (sector + count - 1) / DISK_AU_SECTORS ||
+      sector / DISK_AU_SECTORS != (next_write_sector - 1) / DISK_AU_SECTORS) {
+    now_us += MODEL_AU_CROSSING_US;
+  }
+  next_write_sector = sector + count;
+  commands++;
+}
+
+/** Public functions. *********************************************************/
+
+uint32_t can_time_us(void) { return (uint32_t)now_us; }
+
+DWORD get_fattime(void) {
+  return ((DWORD)(2025 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
+
+DSTATUS disk_initialize(BYTE pdrv) { return (pdrv == 0) ? 0 : STA_NOINIT; }
+
+DSTATUS disk_status(BYTE pdrv) { return (pdrv == 0) ? 0 : STA_NOINIT; }
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+  if (pdrv != 0 || (uint64_t)(sector + count) * DISK_SECTOR_SIZE > DISK_BYTES) {
+    return RES_PARERR;
+  }
+  memcpy(buff, &disk[(uint64_t)sector * DISK_SECTOR_SIZE],
+         count * DISK_SECTOR_SIZE);
+
+  // As sd_diskio.c, an unaligned buffer reads one sector per command.
+  const uint8_t unaligned = ((uintptr_t)buff % 4 != 0);
+  const UINT reads = unaligned ? count : 1;
+  for (UINT i = 0; i < reads; i++) {
+    now_us += MODEL_COMMAND_US + MODEL_READ_ACCESS_US;
+    commands++;
+  }
+  now_us += (uint64_t)count * DISK_SECTOR_SIZE / MODEL_BUS_BYTES_PER_US;
+  if (unaligned) {
+    scratch_reads += count;
+  }
+  return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+  if (pdrv != 0 || (uint64_t)(sector + count) * DISK_SECTOR_SIZE > DISK_BYTES) {
+    return RES_PARERR;
+  }
+  memcpy(&disk[(uint64_t)sector * DISK_SECTOR_SIZE], buff,
+         count * DISK_SECTOR_SIZE);
+
+  if ((uintptr_t)buff % 4 != 0) {
+    // As sd_diskio.c, an unaligned buffer writes one sector per command.
+    for (UINT i = 0; i < count; i++) {
+      model_write(sector + i, 1);
+    }
+    scratch_writes += count;
+  } else {
+    model_write(sector, count);
+  }
+  return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+  if (pdrv != 0) {
+    return RES_PARERR;
+  }
+  switch (cmd) {
+  case CTRL_SYNC:
+    return RES_OK;
+  case GET_SECTOR_COUNT:
+    *(DWORD *)buff = (DWORD)(DISK_BYTES / DISK_SECTOR_SIZE);
+    return RES_OK;
+  case GET_SECTOR_SIZE:
+    *(WORD *)buff = DISK_SECTOR_SIZE;
+    return RES_OK;
+  case GET_BLOCK_SIZE:
+    *(DWORD *)buff = DISK_AU_SECTORS;
+    return RES_OK;
+  default:
+    return RES_PARERR;
+  }
+}
+
+void SD_GetScratchCount(UINT *reads, UINT *writes) {
+  if (reads != NULL) {
+    *reads = scratch_reads;
+  }
+  if (writes != NULL) {
+    *writes = scratch_writes;
+  }
+}
+
+int main(void) {
+  static BYTE work[_MAX_SS];
+  static FATFS fs;
+  static FIL file;
+  char line[128];
+
+  disk = mmap(NULL, DISK_BYTES, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (disk == MAP_FAILED) {
+    fprintf(stderr, "Disk allocation failed.\n");
+    return 1;
+  }
+
+  FRESULT res = f_mkfs("", FM_FAT32, DISK_CLUSTER_BYTES, work, sizeof(work));
+  if (res == FR_OK) {
+    res = f_mount(&fs, "", 1);
+  }
+  if (res == FR_OK) {
+    commands = 0;
+    res = sd_bench_run();
+  }
+  if (res == FR_OK) {
+    res = f_open(&file, SD_BENCH_FILE_NAME, FA_READ);
+  }
+  if (res != FR_OK) {
+    fprintf(stderr, "Benchmark failed (FRESULT %d).\n", (int)res);
+    return 1;
+  }
+
+  while (f_gets(line, sizeof(line), &file) != NULL) {
+    fputs(line, stdout);
+  }
+  f_close(&file);
+
+  fprintf(stderr, "%lu commands, %lu + %lu scratch sectors (read + write).\n",
+          (unsigned long)commands, (unsigned long)scratch_reads,
+          (unsigned long)scratch_writes);
+  return 0;
+}
@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * @file sd_diskio.h
+ * @brief Host stand-in for FATFS/Target/sd_diskio.h, scratch path counters.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__SD_DISKIO_H
+#define NERVE__SD_DISKIO_H
+
+#include "ff.h"
+
+void SD_GetScratchCount(UINT *reads, UINT *writes);
+
+#endif
@@ -0,0 +1,12 @@
+/*******************************************************************************
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32 HAL (included by ffconf.h).
+ *******************************************************************************
+ */
+
+#ifndef NERVE__STM32F4XX_HAL_H
+#define NERVE__STM32F4XX_HAL_H
+
+#include <stdint.h>
+
+#endif
@@ -0,0 +1,15 @@
+/*******************************************************************************
+ * @file bmp390_runner.h
+ * @brief Host stand-in for Core/Inc/bmp390_runner.h, telemetry sources only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__BMP390_RUNNER_H
+#define NERVE__BMP390_RUNNER_H
+
+#include "diagnostics.h"
+
+extern float bmp390_temperature;
+extern float bmp390_pressure;
+
+#endif
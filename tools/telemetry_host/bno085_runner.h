@@ -0,0 +1,31 @@
+/*******************************************************************************
+ * @file bno085_runner.h
+ * @brief Host stand-in for Core/Inc/bno085_runner.h, telemetry sources only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__BNO085_RUNNER_H
+#define NERVE__BNO085_RUNNER_H
+
+#include "diagnostics.h"
+
+extern float bno085_quaternion_i;
+extern float bno085_quaternion_j;
+extern float bno085_quaternion_k;
+extern float bno085_quaternion_real;
+extern float bno085_quaternion_accuracy_rad;
+extern float bno085_quaternion_accuracy_deg;
+extern float bno085_gyro_x;
+extern float bno085_gyro_y;
+extern float bno085_gyro_z;
+extern float bno085_accel_x;
+extern float bno085_accel_y;
+extern float bno085_accel_z;
+extern float bno085_lin_accel_x;
+extern float bno085_lin_accel_y;
+extern float bno085_lin_accel_z;
+extern float bno085_gravity_x;
+extern float bno085_gravity_y;
+extern float bno085_gravity_z;
+
+#endif
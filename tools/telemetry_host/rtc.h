@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * @file rtc.h
+ * @brief Host stand-in for Core/Inc/rtc.h, get_epoch_us only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__RTC_H
+#define NERVE__RTC_H
+
+#include <stdint.h>
+
+uint8_t get_epoch_us(int64_t *epoch_us);
+
+#endif
@@ -0,0 +1,333 @@
+/*******************************************************************************
+ * @file telemetry_bench.c
+ * @brief Host benchmark of the table-driven CAN telemetry encoder.
+ *
+ * Runs Core/Src/telemetry.c, can.c and the generated can_nerve.c unchanged on
+ * the simulated CAN1 (tools/can_host/can_sim.c) and compares can_tx_telemetry
+ * against the previous per-message functions, reproduced below, which copied
+ * the whole can_message_t descriptor onto the stack on every call. Both paths
+ * encode the nine float sourced messages (barometric, gps1-3, imu1-5) from the
+ * same sensor values, the frames they queue are checked equal. Only the encode
+ * and queue calls are timed, the simulated bus is drained between rounds.
+ *
+ * Host timings only show the relative cost, telemetry_can_tx_cycles_last and
+ * telemetry_can_tx_cycles_max give the on-target DWT cycles.
+ *
+ * Build and run (from the repository root):
+ *     gcc -O2 -Itools/telemetry_host -Itools/can_host -ICore/Inc \
+ *         tools/telemetry_host/telemetry_bench.c tools/can_host/can_sim.c \
+ *         Core/Src/telemetry.c Core/Src/can.c Core/Src/can_nerve.c \
+ *         Core/Src/diagnostics.c -o telemetry_bench
+ *     ./telemetry_bench
+ *******************************************************************************
+ */
+
+/** Includes. *****************************************************************/
+
+#include "bmp390_runner.h"
+#include "bno085_runner.h"
+#include "can.h"
+#include "can_nerve.h"
+#include "can_sim.h"
+#include "telemetry.h"
+#include "ublox_hal_uart.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/** Definitions. **************************************************************/
+
+#define ROUNDS 200000
+#define MESSAGE_COUNT 9
+
+/** Public variables (telemetry sources). *************************************/
+
+float bmp390_temperature;
+float bmp390_pressure;
+
+float bno085_quaternion_i;
+float bno085_quaternion_j;
+float bno085_quaternion_k;
+float bno085_quaternion_real;
+float bno085_quaternion_accuracy_rad;
+float bno085_quaternion_accuracy_deg;
+float bno085_gyro_x;
+float bno085_gyro_y;
+float bno085_gyro_z;
+float bno085_accel_x;
+float bno085_accel_y;
+float bno085_accel_z;
+float bno085_lin_accel_x;
+float bno085_lin_accel_y;
+float bno085_lin_accel_z;
+float bno085_gravity_x;
+float bno085_gravity_y;
+float bno085_gravity_z;
+
+ublox_data_t gps_data;
+
+/** Private variables. ********************************************************/
+
+static const uint8_t bench_messages[MESSAGE_COUNT] = {
+    DBC_MESSAGE_BAROMETRIC, DBC_MESSAGE_GPS1, DBC_MESSAGE_GPS2,
+    DBC_MESSAGE_GPS3,       DBC_MESSAGE_IMU1, DBC_MESSAGE_IMU2,
+    DBC_MESSAGE_IMU3,       DBC_MESSAGE_IMU4, DBC_MESSAGE_IMU5};
+
+/** Host stubs. ***************************************************************/
+
+uint8_t get_epoch_us(int64_t *epoch_us) {
+  *epoch_us = 0;
+  return 0;
+}
+
+void xbee_send(uint64_t dest_addr, uint16_t dest_net_addr,
+               const uint8_t *payload, uint16_t payload_size,
+               uint8_t is_critical) {
+  (void)dest_addr;
+  (void)dest_net_addr;
+  (void)payload;
+  (void)payload_size;
+  (void)is_critical;
+}
+
+/** Previous per-message functions (descriptor copied per call). **************/
+
+static void old_can_tx_barometric(void) {
+  can_message_t pressure_msg = dbc_messages[DBC_MESSAGE_BAROMETRIC];
+  uint32_t pressure_sigs[3] = {0};
+  const float pressure_source_sigs[3] = {bmp390_pressure, bmp390_temperature,
+                                         (float)bmp390_fault_count};
+  for (int i = 0; i < pressure_msg.signal_count; ++i) {
+    pressure_sigs[i] =
+        float_to_raw(pressure_source_sigs[i], &pressure_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &pressure_msg, pressure_sigs);
+}
+
+static void old_can_tx_gps1(void) {
+  can_message_t gps1_msg = dbc_messages[DBC_MESSAGE_GPS1];
+  uint32_t gps1_sigs[2] = {0};
+  const float gps1_source_sigs[2] = {gps_data.latitude, gps_data.longitude};
+  for (int i = 0; i < gps1_msg.signal_count; ++i) {
+    gps1_sigs[i] = float_to_raw(gps1_source_sigs[i], &gps1_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &gps1_msg, gps1_sigs);
+}
+
+static void old_can_tx_gps2(void) {
+  can_message_t gps2_msg = dbc_messages[DBC_MESSAGE_GPS2];
+  uint32_t gps2_sigs[5] = {0};
+  const float gps2_source_sigs[5] = {gps_data.speed_knots, gps_data.course_deg,
+                                     gps_data.position_fix, gps_data.satellites,
+                                     gps_data.hdop};
+  for (int i = 0; i < gps2_msg.signal_count; ++i) {
+    gps2_sigs[i] = float_to_raw(gps2_source_sigs[i], &gps2_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &gps2_msg, gps2_sigs);
+}
+
+static void old_can_tx_gps3(void) {
+  can_message_t gps3_msg = dbc_messages[DBC_MESSAGE_GPS3];
+  uint32_t gps3_sigs[3] = {0};
+  const float gps3_source_sigs[3] = {gps_data.altitude_m, gps_data.geoid_sep_m,
+                                     (float)gps_fault_count};
+  for (int i = 0; i < gps3_msg.signal_count; ++i) {
+    gps3_sigs[i] = float_to_raw(gps3_source_sigs[i], &gps3_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &gps3_msg, gps3_sigs);
+}
+
+static void old_can_tx_imu1(void) {
+  can_message_t imu1_msg = dbc_messages[DBC_MESSAGE_IMU1];
+  uint32_t imu1_sigs[4] = {0};
+  const float imu1_source_sigs[4] = {bno085_quaternion_i, bno085_quaternion_j,
+                                     bno085_quaternion_k,
+                                     bno085_quaternion_real};
+  for (int i = 0; i < imu1_msg.signal_count; ++i) {
+    imu1_sigs[i] = float_to_raw(imu1_source_sigs[i], &imu1_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &imu1_msg, imu1_sigs);
+}
+
+static void old_can_tx_imu2(void) {
+  can_message_t imu2_msg = dbc_messages[DBC_MESSAGE_IMU2];
+  uint32_t imu2_sigs[3] = {0};
+  const float imu2_source_sigs[3] = {bno085_gyro_x, bno085_gyro_y,
+                                     bno085_gyro_z};
+  for (int i = 0; i < imu2_msg.signal_count; ++i) {
+    imu2_sigs[i] = float_to_raw(imu2_source_sigs[i], &imu2_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &imu2_msg, imu2_sigs);
+}
+
+static void old_can_tx_imu3(void) {
+  can_message_t imu3_msg = dbc_messages[DBC_MESSAGE_IMU3];
+  uint32_t imu3_sigs[3] = {0};
+  const float imu3_source_sigs[3] = {bno085_accel_x, bno085_accel_y,
+                                     bno085_accel_z};
+  for (int i = 0; i < imu3_msg.signal_count; ++i) {
+    imu3_sigs[i] = float_to_raw(imu3_source_sigs[i], &imu3_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &imu3_msg, imu3_sigs);
+}
+
+static void old_can_tx_imu4(void) {
+  can_message_t imu4_msg = dbc_messages[DBC_MESSAGE_IMU4];
+  uint32_t imu4_sigs[3] = {0};
+  const float imu4_source_sigs[3] = {bno085_lin_accel_x, bno085_lin_accel_y,
+                                     bno085_lin_accel_z};
+  for (int i = 0; i < imu4_msg.signal_count; ++i) {
+    imu4_sigs[i] = float_to_raw(imu4_source_sigs[i], &imu4_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &imu4_msg, imu4_sigs);
+}
+
+static void old_can_tx_imu5(void) {
+  can_message_t imu5_msg = dbc_messages[DBC_MESSAGE_IMU5];
+  uint32_t imu5_sigs[3] = {0};
+  const float imu5_source_sigs[3] = {bno085_gravity_x, bno085_gravity_y,
+                                     bno085_gravity_z};
+  for (int i = 0; i < imu5_msg.signal_count; ++i) {
+    imu5_sigs[i] = float_to_raw(imu5_source_sigs[i], &imu5_msg.signals[i]);
+  }
+  can_send_message_raw32(&hcan1, &imu5_msg, imu5_sigs);
+}
+
+static void (*const old_can_tx[MESSAGE_COUNT])(void) = {
+    old_can_tx_barometric, old_can_tx_gps1, old_can_tx_gps2,
+    old_can_tx_gps3,       old_can_tx_imu1, old_can_tx_imu2,
+    old_can_tx_imu3,       old_can_tx_imu4, old_can_tx_imu5};
+
+/** Private functions. ********************************************************/
+
+/**
+ * @brief Monotonic host time (ns).
+ */
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Set every telemetry source from the round number.
+ */
+static void set_sources(uint32_t round) {
+  const float x = (float)(round % 1000) * 0.001f;
+
+  bmp390_pressure = 95000.0f + 100.0f * x;
+  bmp390_temperature = 20.0f + x;
+  gps_data.latitude = 43.47f + x;
+  gps_data.longitude = -80.54f - x;
+  gps_data.speed_knots = 10.0f * x;
+  gps_data.course_deg = 360.0f * x;
+  gps_data.position_fix = round % 2 ? FIX_TYPE_GNSS_FIX : FIX_TYPE_UNDETERMINED;
+  gps_data.satellites = (uint8_t)(round % 20);
+  gps_data.hdop = 0.5f + x;
+  gps_data.altitude_m = 300.0f + 10.0f * x;
+  gps_data.geoid_sep_m = -35.0f + x;
+  bno085_quaternion_i = x;
+  bno085_quaternion_j = -x;
+  bno085_quaternion_k = 0.5f * x;
+  bno085_quaternion_real = 1.0f - x;
+  bno085_gyro_x = 2.0f * x;
+  bno085_gyro_y = -2.0f * x;
+  bno085_gyro_z = x;
+  bno085_accel_x = 9.81f * x;
+  bno085_accel_y = -9.81f * x;
+  bno085_accel_z = 9.81f;
+  bno085_lin_accel_x = x;
+  bno085_lin_accel_y = -x;
+  bno085_lin_accel_z = 0.1f * x;
+  bno085_gravity_x = 0.0f;
+  bno085_gravity_y = x;
+  bno085_gravity_z = 9.81f - x;
+}
+
+/**
+ * @brief Check two frames for the same ID, DLC and payload.
+ */
+static uint8_t same_frame(const can_sim_frame_t *a, const can_sim_frame_t *b) {
+  return a->std_id == b->std_id && a->dlc == b->dlc &&
+         memcmp(a->data, b->data, a->dlc) == 0;
+}
+
+/**
+ * @brief Transmit every queued CAN1 frame, returns the frame count.
+ */
+static uint8_t drain(can_sim_frame_t frames[MESSAGE_COUNT]) {
+  can_sim_frame_t frame;
+  uint8_t count = 0;
+
+  while (can_sim_transmit(0, &frame)) {
+    if (count < MESSAGE_COUNT) {
+      frames[count] = frame;
+    }
+    count++;
+  }
+  return count;
+}
+
+/** Main. *********************************************************************/
+
+int main(void) {
+  can_sim_frame_t old_frames[MESSAGE_COUNT];
+  can_sim_frame_t new_frames[MESSAGE_COUNT];
+  uint64_t old_ns = 0;
+  uint64_t new_ns = 0;
+  uint32_t mismatches = 0;
+
+  can_sim_init(CAN_SIM_BITRATE);
+  can_init();
+  telemetry_init();
+
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    set_sources(round);
+
+    // Alternate the order so neither path always runs on a warm cache.
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      const uint8_t old_path = (uint8_t)((round + pass) % 2);
+      const uint64_t start_ns = now_ns();
+
+      for (uint8_t m = 0; m < MESSAGE_COUNT; m++) {
+        if (old_path) {
+          old_can_tx[m]();
+        } else {
+          can_tx_telemetry(bench_messages[m]);
+        }
+      }
+      if (old_path) {
+        old_ns += now_ns() - start_ns;
+      } else {
+        new_ns += now_ns() - start_ns;
+      }
+      if (drain(old_path ? old_frames : new_frames) != MESSAGE_COUNT) {
+        mismatches++;
+      }
+    }
+
+    // Lowest ID first on both, same frames in the same order.
+    for (uint8_t m = 0; m < MESSAGE_COUNT; m++) {
+      if (!same_frame(&old_frames[m], &new_frames[m])) {
+        mismatches++;
+      }
+    }
+  }
+
+  const double messages = (double)ROUNDS * MESSAGE_COUNT;
+  const double old_per_msg = (double)old_ns / messages;
+  const double new_per_msg = (double)new_ns / messages;
+
+  printf("Telemetry CAN encode and queue, %u rounds of %u messages\n", ROUNDS,
+         MESSAGE_COUNT);
+  printf("  Descriptor copied per message: %zu bytes (can_message_t)\n",
+         sizeof(can_message_t));
+  printf("  Before (descriptor copy): %.1f ns/message\n", old_per_msg);
+  printf("  After (table-driven):     %.1f ns/message\n", new_per_msg);
+  printf("  Speedup: %.2fx\n", old_per_msg / new_per_msg);
+  printf("  Frame mismatches: %u\n", mismatches);
+
+  printf(mismatches == 0 ? "PASSED\n" : "FAILED\n");
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+/*******************************************************************************
+ * @file ublox_hal_uart.h
+ * @brief Host stand-in for Core/Inc/ublox_hal_uart.h, telemetry sources only.
+ *
+ * ublox_data_t holds only the fields telemetry.c reads, same names and types.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__UBLOX_HAL_UART_H
+#define NERVE__UBLOX_HAL_UART_H
+
+#include "diagnostics.h"
+
+typedef enum {
+  FIX_TYPE_UNDETERMINED = 0,
+  FIX_TYPE_GNSS_FIX = 7
+} nmea_position_fix_t;
+
+typedef struct {
+  nmea_position_fix_t position_fix;
+  float latitude;
+  float longitude;
+  float altitude_m;
+  float geoid_sep_m;
+  float speed_knots;
+  float course_deg;
+  uint8_t satellites;
+  float hdop;
+} ublox_data_t;
+
+extern ublox_data_t gps_data;
+
+#endif
@@ -0,0 +1,16 @@
+/*******************************************************************************
+ * @file xbee_api_hal_uart.h
+ * @brief Host stand-in for Core/Inc/xbee_api_hal_uart.h, xbee_send only.
+ *******************************************************************************
+ */
+
+#ifndef NERVE__XBEE_HAL_UART_H
+#define NERVE__XBEE_HAL_UART_H
+
+#include <stdint.h>
+
+void xbee_send(uint64_t dest_addr, uint16_t dest_net_addr,
+               const uint8_t *payload, uint16_t payload_size,
+               uint8_t is_critical);
+
+#endif